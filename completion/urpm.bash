@@ -137,7 +137,7 @@ _URPM_GLOBAL_FLAGS="--help -h --version -V --verbose -v --quiet -q \
 _URPM_DISPLAY_FLAGS="--json --flat --show-all"
 
 # debug_parent — inherited by install / download / update / upgrade.
-_URPM_DEBUG_FLAGS="--debug --watched"
+_URPM_DEBUG_FLAGS="--debug --watched --profile-resolve"
 
 # Real top-level commands, mirroring urpm/cli/main.py subparsers.
 # Phantom entries that existed in the old completion (kernel-keep,
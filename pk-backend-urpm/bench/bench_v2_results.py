@@ -0,0 +1,85 @@
+#!/usr/bin/python3
+"""Compare the JSON and typed (V2) result paths of the urpm D-Bus service.
+
+Times GetInstalledPackages vs GetInstalledPackagesV2 and SearchPackages vs
+SearchPackagesV2 against the running service on the system bus. Each
+sample covers the call and walking every record, which is what the
+PackageKit backend does on its side (json_parser vs g_variant_iter).
+
+Usage:
+    bench_v2_results.py [--runs N] [--pattern PATTERN]
+"""
+
+import argparse
+import json
+import statistics
+import sys
+import time
+
+import gi
+gi.require_version('Gio', '2.0')
+from gi.repository import Gio, GLib
+
+BUS_NAME = "org.mageia.Urpm.v1"
+OBJECT_PATH = "/org/mageia/Urpm/v1"
+INTERFACE_NAME = "org.mageia.Urpm.v1"
+
+
+def _call(bus, method, args):
+    return bus.call_sync(BUS_NAME, OBJECT_PATH, INTERFACE_NAME, method,
+                         args, None, Gio.DBusCallFlags.NONE, 120000, None)
+
+
+def _walk_json(reply):
+    packages = json.loads(reply.get_child_value(0).get_string())
+    return sum(1 for p in packages if p.get('name'))
+
+
+def _walk_typed(reply):
+    records = reply.get_child_value(0)
+    count = 0
+    for i in range(records.n_children()):
+        if records.get_child_value(i).get_child_value(0).get_string():
+            count += 1
+    return count
+
+
+def _bench(bus, label, method, args, walk, runs):
+    samples = []
+    count = 0
+    for _ in range(runs):
+        start = time.perf_counter()
+        reply = _call(bus, method, args)
+        count = walk(reply)
+        samples.append(time.perf_counter() - start)
+    print(f"{label:<32} {count:>6} pkgs  "
+          f"median {statistics.median(samples) * 1000:8.1f} ms  "
+          f"min {min(samples) * 1000:8.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--runs', type=int, default=10)
+    parser.add_argument('--pattern', default='lib')
+    args = parser.parse_args()
+
+    try:
+        bus = Gio.bus_get_sync(Gio.BusType.SYSTEM, None)
+    except GLib.Error as e:
+        print(f"Cannot connect to system bus: {e.message}", file=sys.stderr)
+        return 1
+
+    search_args = GLib.Variant('(sb)', (args.pattern, False))
+    _bench(bus, "GetInstalledPackages (JSON)", "GetInstalledPackages",
+           None, _walk_json, args.runs)
+    _bench(bus, "GetInstalledPackagesV2", "GetInstalledPackagesV2",
+           None, _walk_typed, args.runs)
+    _bench(bus, "SearchPackages (JSON)", "SearchPackages",
+           search_args, _walk_json, args.runs)
+    _bench(bus, "SearchPackagesV2", "SearchPackagesV2",
+           search_args, _walk_typed, args.runs)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
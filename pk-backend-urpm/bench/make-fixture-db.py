@@ -0,0 +1,140 @@
+#!/usr/bin/python3
+"""Build the packages.db fixture used by pk-backend-urpm-bench.
+
+The fixture holds a 'Core Release' media with the host's installed
+packages plus synthetic filler up to --packages rows, and a 'Core
+Updates' media carrying a newer release of every --update-every'th
+installed package, so get-updates has real work to do.  The names the
+replay file resolves and searches for are always present.
+
+Installed state still comes from the host rpmdb, which is why the
+installed packages are mirrored here: get-packages installed and
+get-updates then return the same shape of result on any machine.
+
+Usage:
+    make-fixture-db.py --output packages.db [--packages N] [--update-every N]
+"""
+
+import argparse
+import os
+import platform
+import subprocess
+import sys
+
+# Names the GNOME Software replay resolves and searches for
+DESKTOP_NAMES = [
+    'firefox', 'thunderbird', 'gimp', 'inkscape', 'vlc', 'libreoffice-writer',
+    'libreoffice-calc', 'gnome-shell', 'nautilus', 'gnome-software',
+    'gnome-terminal', 'evince', 'totem', 'rhythmbox', 'shotwell', 'gedit',
+    'firewalld', 'fish', 'filezilla', 'flatpak',
+]
+
+
+def _installed_packages():
+    """Return the host's installed packages, or [] without rpm."""
+    qf = '%{NAME}\t%{EPOCH}\t%{VERSION}\t%{RELEASE}\t%{ARCH}\t%{SUMMARY}\n'
+    try:
+        out = subprocess.run(['rpm', '-qa', '--qf', qf], capture_output=True,
+                             text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError):
+        return []
+
+    packages = []
+    for line in out.splitlines():
+        fields = line.split('\t')
+        if len(fields) != 6 or fields[4] == '(none)':
+            continue  # gpg-pubkey and friends
+        name, epoch, version, release, arch, summary = fields
+        packages.append(_package(name, version, release, arch, summary,
+                                 epoch=0 if epoch == '(none)' else int(epoch)))
+    return packages
+
+
+def _package(name, version, release, arch, summary, epoch=0):
+    return {
+        'name': name,
+        'epoch': epoch,
+        'version': version,
+        'release': release,
+        'arch': arch,
+        'nevra': f"{name}-{version}-{release}.{arch}",
+        'summary': summary,
+        'description': f"{summary}.\n\nFixture package for the backend benchmark.",
+        'group': 'System/Base',
+        'license': 'GPLv3+',
+        'url': f"https://example.org/{name}",
+        'filesize': 250000 + len(name) * 1000,
+        'size': 1000000 + len(name) * 4000,
+        'provides': [f"{name}[== {version}-{release}]"],
+        'requires': [],
+    }
+
+
+def _bump_release(release):
+    """Return a release string that sorts after release."""
+    head, dot, dist = release.partition('.')
+    if head.isdigit():
+        return f"{int(head) + 1}{dot}{dist}"
+    return release + '.1'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--output', required=True)
+    parser.add_argument('--packages', type=int, default=40000,
+                        help="total rows in Core Release (default: 40000)")
+    parser.add_argument('--update-every', type=int, default=10,
+                        help="give every Nth installed package an update")
+    parser.add_argument('--source-root',
+                        default=os.path.join(os.path.dirname(__file__), '..', '..'),
+                        help="directory holding the urpm package")
+    args = parser.parse_args()
+
+    sys.path.insert(0, os.path.abspath(args.source_root))
+    from urpm.core.config import get_system_version
+    from urpm.core.database import PackageDatabase
+
+    version = get_system_version() or 'cauldron'
+    arch = platform.machine()
+    dist = f"mga{version}" if version.isdigit() else 'mga10'
+
+    if os.path.exists(args.output):
+        os.unlink(args.output)
+    db = PackageDatabase(args.output)
+    try:
+        installed = _installed_packages()
+        release = list(installed)
+        names = {p['name'] for p in release}
+        for name in DESKTOP_NAMES:
+            if name not in names:
+                release.append(_package(name, '1.0', f"1.{dist}", arch,
+                                        f"{name} for the benchmark"))
+                names.add(name)
+        for i in range(len(release), args.packages):
+            release.append(_package(f"bench-filler{i:05d}", '1.0', f"1.{dist}",
+                                    arch, f"Filler package {i}"))
+
+        updates = [
+            _package(p['name'], p['version'], _bump_release(p['release']),
+                     p['arch'], p['summary'], epoch=p['epoch'])
+            for p in installed[::max(args.update_every, 1)]
+        ]
+
+        media_id = db.add_media(name='Core Release', short_name='core_release',
+                                mageia_version=version, architecture=arch,
+                                relative_path='core/release')
+        db.import_packages(iter(release), media_id=media_id)
+        media_id = db.add_media(name='Core Updates', short_name='core_updates',
+                                mageia_version=version, architecture=arch,
+                                relative_path='core/updates', update_media=True)
+        db.import_packages(iter(updates), media_id=media_id)
+    finally:
+        db.close()
+
+    print(f"{args.output}: {len(release)} packages, {len(installed)} installed, "
+          f"{len(updates)} updates")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
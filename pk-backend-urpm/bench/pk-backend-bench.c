@@ -0,0 +1,702 @@
+/*
+ * End-to-end latency benchmark for pk-backend-urpm
+ *
+ * Replays a recorded sequence of PackageKit query transactions through
+ * the backend entry points (pk_backend_get_updates(), ...) exactly as
+ * packagekitd would call them, against a urpm D-Bus service serving a
+ * fixture packages.db on a private bus.  For every step it reports:
+ *
+ *   - p50/p99 wall time from the pk_backend_* call until the job thread
+ *     returns, which covers the backend, the service handler and
+ *     PackageDatabase;
+ *   - bytes on the bus (median per call), counted by a monitor
+ *     connection, so a per-id round trip or a bloated reply shows up
+ *     even when it is fast on an idle machine;
+ *   - peak RSS of the bench (backend side) and of the service while the
+ *     step ran, using the kernel's resettable VmHWM.
+ *
+ * Usage:
+ *   pk-backend-urpm-bench --replay FILE --db packages.db [--runs N]
+ *   pk-backend-urpm-bench --replay FILE --system
+ *
+ * --system measures the running service on the real system bus instead;
+ * bus bytes and service RSS then need root.
+ *
+ * Copyright (C) 2026 Mageia Community
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "pk-backend-stub.h"
+#include <gio/gio.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#define URPM_BUS_NAME        "org.mageia.Urpm.v1"
+#define DBUS_NAME            "org.freedesktop.DBus"
+#define DBUS_PATH            "/org/freedesktop/DBus"
+
+/* How long the service may take to claim its name */
+#define SERVICE_START_TIMEOUT_US (30 * G_USEC_PER_SEC)
+
+typedef enum {
+    STEP_FILTERS,           /* (t) */
+    STEP_FILTERS_VALUES,    /* (t^as) */
+    STEP_PACKAGE_IDS,       /* (^as) */
+} StepParams;
+
+typedef struct {
+    PkRoleEnum role;
+    gchar *label;
+    PkBitfield filters;
+    gchar **args;
+
+    GArray *latency_us;     /* gint64 per measured run */
+    GArray *bus_bytes;      /* gint64 per measured run */
+    guint64 bench_rss_kb;
+    guint64 service_rss_kb;
+    guint results;
+    gchar *error;
+} BenchStep;
+
+typedef struct {
+    GDBusConnection *control;
+    GDBusConnection *monitor;   /* NULL when the bus refused BecomeMonitor */
+    gchar *service_pid;         /* NULL when unknown */
+
+    GMutex lock;
+    GCond cond;
+    gint64 bus_bytes;
+    guint markers;
+} Bench;
+
+static gchar *opt_replay = NULL;
+static gchar *opt_db = NULL;
+static gchar *opt_service = NULL;
+static gint opt_runs = 20;
+static gint opt_warmup = 1;
+static gboolean opt_system = FALSE;
+static gboolean opt_warm = FALSE;
+static gboolean opt_verbose = FALSE;
+
+static GOptionEntry options[] = {
+    { "replay", 'r', 0, G_OPTION_ARG_FILENAME, &opt_replay,
+      "Transactions to replay", "FILE" },
+    { "db", 'd', 0, G_OPTION_ARG_FILENAME, &opt_db,
+      "Fixture packages.db for the spawned service", "FILE" },
+    { "service", 0, 0, G_OPTION_ARG_STRING, &opt_service,
+      "Service command line (default: python3 -m urpm.dbus.service)", "CMD" },
+    { "runs", 'n', 0, G_OPTION_ARG_INT, &opt_runs,
+      "Measured runs of the whole replay (default: 20)", "N" },
+    { "warmup", 0, 0, G_OPTION_ARG_INT, &opt_warmup,
+      "Unmeasured runs first (default: 1)", "N" },
+    { "system", 0, 0, G_OPTION_ARG_NONE, &opt_system,
+      "Use the running service on the system bus", NULL },
+    { "warm", 0, 0, G_OPTION_ARG_NONE, &opt_warm,
+      "Keep the backend session cache between runs", NULL },
+    { "verbose", 'v', 0, G_OPTION_ARG_NONE, &opt_verbose,
+      "Show the service's log output", NULL },
+    { NULL }
+};
+
+/* ======================================================================
+ * Replay file
+ * ====================================================================== */
+
+static gboolean
+step_params_for_role(PkRoleEnum role, StepParams *params)
+{
+    switch (role) {
+    case PK_ROLE_ENUM_GET_UPDATES:
+    case PK_ROLE_ENUM_GET_PACKAGES:
+        *params = STEP_FILTERS;
+        return TRUE;
+    case PK_ROLE_ENUM_SEARCH_NAME:
+    case PK_ROLE_ENUM_SEARCH_DETAILS:
+    case PK_ROLE_ENUM_RESOLVE:
+        *params = STEP_FILTERS_VALUES;
+        return TRUE;
+    case PK_ROLE_ENUM_GET_DETAILS:
+    case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+    case PK_ROLE_ENUM_GET_FILES:
+        *params = STEP_PACKAGE_IDS;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static void
+bench_step_free(BenchStep *step)
+{
+    g_free(step->label);
+    g_strfreev(step->args);
+    g_array_unref(step->latency_us);
+    g_array_unref(step->bus_bytes);
+    g_free(step->error);
+    g_free(step);
+}
+
+static GPtrArray *
+replay_load(const gchar *filename, GError **error)
+{
+    g_autofree gchar *contents = NULL;
+    g_auto(GStrv) lines = NULL;
+    g_autoptr(GPtrArray) steps = g_ptr_array_new_with_free_func(
+        (GDestroyNotify) bench_step_free);
+    g_autoptr(GHashTable) seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    if (!g_file_get_contents(filename, &contents, NULL, error))
+        return NULL;
+
+    lines = g_strsplit(contents, "\n", -1);
+    for (guint i = 0; lines[i] != NULL; i++) {
+        g_auto(GStrv) tokens = NULL;
+        g_autoptr(GPtrArray) words = g_ptr_array_new();
+        const gchar *line = g_strstrip(lines[i]);
+        StepParams kind;
+
+        if (*line == '\0' || *line == '#')
+            continue;
+
+        tokens = g_strsplit_set(line, " \t", -1);
+        for (guint j = 0; tokens[j] != NULL; j++) {
+            if (*tokens[j] != '\0')
+                g_ptr_array_add(words, tokens[j]);
+        }
+        if (words->len < 2) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        "%s:%u: expected <role> <filters> [argument ...]",
+                        filename, i + 1);
+            return NULL;
+        }
+
+        BenchStep *step = g_new0(BenchStep, 1);
+        step->latency_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+        step->bus_bytes = g_array_new(FALSE, FALSE, sizeof(gint64));
+        g_ptr_array_add(steps, step);
+        step->role = pk_role_enum_from_string(g_ptr_array_index(words, 0));
+        if (!step_params_for_role(step->role, &kind)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                        "%s:%u: unsupported role '%s'", filename, i + 1,
+                        (const gchar *) g_ptr_array_index(words, 0));
+            return NULL;
+        }
+
+        const gchar *filters = g_ptr_array_index(words, 1);
+        if ((kind == STEP_PACKAGE_IDS) != (g_strcmp0(filters, "-") == 0)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        "%s:%u: '%s' %s filters", filename, i + 1,
+                        pk_role_enum_to_string(step->role),
+                        kind == STEP_PACKAGE_IDS ? "takes no" : "needs");
+            return NULL;
+        }
+        if (kind != STEP_PACKAGE_IDS)
+            step->filters = pk_filter_bitfield_from_string(filters);
+
+        step->args = g_new0(gchar *, words->len - 1);
+        for (guint j = 2; j < words->len; j++)
+            step->args[j - 2] = g_strdup(g_ptr_array_index(words, j));
+
+        guint occurrence = GPOINTER_TO_UINT(
+            g_hash_table_lookup(seen, GINT_TO_POINTER(step->role))) + 1;
+        g_hash_table_insert(seen, GINT_TO_POINTER(step->role),
+                            GUINT_TO_POINTER(occurrence));
+        step->label = occurrence == 1
+            ? g_strdup(pk_role_enum_to_string(step->role))
+            : g_strdup_printf("%s #%u", pk_role_enum_to_string(step->role),
+                              occurrence);
+    }
+
+    if (steps->len == 0) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s: no steps", filename);
+        return NULL;
+    }
+    return g_steal_pointer(&steps);
+}
+
+/*
+ * Expand "@role:N" into the first N package ids the last step of that
+ * role emitted in this run.  Returns a NULL-terminated array of
+ * borrowed strings.
+ */
+static GPtrArray *
+step_expand_args(BenchStep *step, GHashTable *emitted)
+{
+    GPtrArray *values = g_ptr_array_new();
+
+    for (guint i = 0; step->args[i] != NULL; i++) {
+        const gchar *arg = step->args[i];
+        const gchar *colon = strrchr(arg, ':');
+
+        if (arg[0] != '@' || colon == NULL) {
+            g_ptr_array_add(values, (gpointer) arg);
+            continue;
+        }
+
+        g_autofree gchar *role = g_strndup(arg + 1, colon - arg - 1);
+        guint limit = (guint) g_ascii_strtoull(colon + 1, NULL, 10);
+        GPtrArray *ids = g_hash_table_lookup(emitted, role);
+
+        for (guint j = 0; ids != NULL && j < ids->len && j < limit; j++)
+            g_ptr_array_add(values, g_ptr_array_index(ids, j));
+    }
+    g_ptr_array_add(values, NULL);
+    return values;
+}
+
+/* ======================================================================
+ * Bus bytes and peak RSS
+ * ====================================================================== */
+
+static GDBusMessage *
+on_monitor_message(GDBusConnection *connection, GDBusMessage *message,
+                   gboolean incoming, gpointer user_data)
+{
+    Bench *bench = user_data;
+    gsize size = 0;
+
+    if (!incoming)
+        return message;
+
+    /* Bus housekeeping (AddMatch, NameOwnerChanged, ...) is not ours */
+    if (g_strcmp0(g_dbus_message_get_destination(message), DBUS_NAME) == 0) {
+        if (g_strcmp0(g_dbus_message_get_member(message), "GetId") == 0) {
+            g_mutex_lock(&bench->lock);
+            bench->markers++;
+            g_cond_broadcast(&bench->cond);
+            g_mutex_unlock(&bench->lock);
+        }
+    } else if (g_strcmp0(g_dbus_message_get_sender(message), DBUS_NAME) != 0) {
+        g_free(g_dbus_message_to_blob(message, &size,
+                                      G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING,
+                                      NULL));
+        g_mutex_lock(&bench->lock);
+        bench->bus_bytes += size;
+        g_mutex_unlock(&bench->lock);
+    }
+
+    g_object_unref(message);
+    return NULL;
+}
+
+static GDBusConnection *
+monitor_new(const gchar *address, Bench *bench, GError **error)
+{
+    const gchar *no_rules[] = { NULL };
+    g_autoptr(GDBusConnection) connection = NULL;
+    g_autoptr(GVariant) reply = NULL;
+
+    connection = g_dbus_connection_new_for_address_sync(
+        address,
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+        NULL, NULL, error);
+    if (connection == NULL)
+        return NULL;
+
+    g_dbus_connection_add_filter(connection, on_monitor_message, bench, NULL);
+    reply = g_dbus_connection_call_sync(connection, DBUS_NAME, DBUS_PATH,
+                                        "org.freedesktop.DBus.Monitoring",
+                                        "BecomeMonitor",
+                                        g_variant_new("(^asu)", no_rules, 0),
+                                        NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+                                        NULL, error);
+    if (reply == NULL)
+        return NULL;
+    return g_steal_pointer(&connection);
+}
+
+/*
+ * Bytes seen so far.  The monitor receives messages in bus order, so
+ * once it has seen our GetId call it has seen every reply that reached
+ * us before it.
+ */
+static gint64
+bench_bus_bytes(Bench *bench)
+{
+    g_autoptr(GVariant) reply = NULL;
+    gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+    gint64 bytes;
+    guint target;
+
+    if (bench->monitor == NULL)
+        return 0;
+
+    g_mutex_lock(&bench->lock);
+    target = bench->markers + 1;
+    g_mutex_unlock(&bench->lock);
+
+    reply = g_dbus_connection_call_sync(bench->control, DBUS_NAME, DBUS_PATH,
+                                        DBUS_NAME, "GetId", NULL, NULL,
+                                        G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+
+    g_mutex_lock(&bench->lock);
+    while (bench->markers < target) {
+        if (!g_cond_wait_until(&bench->cond, &bench->lock, deadline))
+            break;
+    }
+    bytes = bench->bus_bytes;
+    g_mutex_unlock(&bench->lock);
+    return bytes;
+}
+
+/* Reset a process's peak RSS to its current RSS */
+static void
+rss_reset(const gchar *pid)
+{
+    g_autofree gchar *path = NULL;
+    FILE *file;
+
+    if (pid == NULL)
+        return;
+    path = g_strdup_printf("/proc/%s/clear_refs", pid);
+    file = fopen(path, "w");
+    if (file == NULL)
+        return;     /* not ours: VmHWM stays the lifetime peak */
+    fputs("5", file);
+    fclose(file);
+}
+
+static guint64
+rss_peak_kb(const gchar *pid)
+{
+    g_autofree gchar *path = NULL;
+    g_autofree gchar *status = NULL;
+    const gchar *hwm;
+
+    if (pid == NULL)
+        return 0;
+    path = g_strdup_printf("/proc/%s/status", pid);
+    if (!g_file_get_contents(path, &status, NULL, NULL))
+        return 0;
+    hwm = strstr(status, "VmHWM:");
+    if (hwm == NULL)
+        return 0;
+    return g_ascii_strtoull(hwm + strlen("VmHWM:"), NULL, 10);
+}
+
+/* ======================================================================
+ * Running the replay
+ * ====================================================================== */
+
+static void
+step_run(Bench *bench, BenchStep *step, GHashTable *emitted, gboolean measure)
+{
+    g_autoptr(GPtrArray) values = step_expand_args(step, emitted);
+    gchar **strv = (gchar **) values->pdata;
+    GVariant *params = NULL;
+    StepParams kind;
+
+    step_params_for_role(step->role, &kind);
+    switch (kind) {
+    case STEP_FILTERS:
+        params = g_variant_new("(t)", step->filters);
+        break;
+    case STEP_FILTERS_VALUES:
+        params = g_variant_new("(t^as)", step->filters, strv);
+        break;
+    case STEP_PACKAGE_IDS:
+        params = g_variant_new("(^as)", strv);
+        break;
+    }
+    g_autoptr(PkBackendJob) job = pk_bench_job_new(step->role, params);
+
+    rss_reset("self");
+    rss_reset(bench->service_pid);
+    gint64 bytes = bench_bus_bytes(bench);
+    gint64 start = g_get_monotonic_time();
+
+    switch (step->role) {
+    case PK_ROLE_ENUM_GET_UPDATES:
+        pk_backend_get_updates(NULL, job, step->filters);
+        break;
+    case PK_ROLE_ENUM_GET_PACKAGES:
+        pk_backend_get_packages(NULL, job, step->filters);
+        break;
+    case PK_ROLE_ENUM_SEARCH_NAME:
+        pk_backend_search_names(NULL, job, step->filters, strv);
+        break;
+    case PK_ROLE_ENUM_SEARCH_DETAILS:
+        pk_backend_search_details(NULL, job, step->filters, strv);
+        break;
+    case PK_ROLE_ENUM_RESOLVE:
+        pk_backend_resolve(NULL, job, step->filters, strv);
+        break;
+    case PK_ROLE_ENUM_GET_DETAILS:
+        pk_backend_get_details(NULL, job, strv);
+        break;
+    case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+        pk_backend_get_update_detail(NULL, job, strv);
+        break;
+    case PK_ROLE_ENUM_GET_FILES:
+        pk_backend_get_files(NULL, job, strv);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+    pk_bench_job_wait(job);
+
+    gint64 elapsed = g_get_monotonic_time() - start;
+    bytes = bench_bus_bytes(bench) - bytes;
+
+    g_hash_table_replace(emitted, g_strdup(pk_role_enum_to_string(step->role)),
+                         g_ptr_array_ref(pk_bench_job_get_package_ids(job)));
+
+    if (!measure)
+        return;
+    g_array_append_val(step->latency_us, elapsed);
+    g_array_append_val(step->bus_bytes, bytes);
+    step->bench_rss_kb = MAX(step->bench_rss_kb, rss_peak_kb("self"));
+    step->service_rss_kb = MAX(step->service_rss_kb,
+                               rss_peak_kb(bench->service_pid));
+    step->results = pk_bench_job_get_n_results(job);
+    if (step->error == NULL && pk_bench_job_get_error(job) != NULL)
+        step->error = g_strdup(pk_bench_job_get_error(job));
+}
+
+static void
+replay_run(Bench *bench, GPtrArray *steps, gboolean measure)
+{
+    g_autoptr(GHashTable) emitted = g_hash_table_new_full(
+        g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+
+    /* A GNOME Software cold start finds the backend cache empty */
+    if (!opt_warm)
+        pk_bench_files_changed();
+
+    for (guint i = 0; i < steps->len; i++)
+        step_run(bench, g_ptr_array_index(steps, i), emitted, measure);
+}
+
+static gint
+compare_gint64(gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *) a;
+    gint64 y = *(const gint64 *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile */
+static gint64
+percentile(GArray *samples, guint pct)
+{
+    g_autoptr(GArray) sorted = NULL;
+    guint rank;
+
+    if (samples->len == 0)
+        return 0;
+    sorted = g_array_sized_new(FALSE, FALSE, sizeof(gint64), samples->len);
+    g_array_append_vals(sorted, samples->data, samples->len);
+    g_array_sort(sorted, compare_gint64);
+    rank = (samples->len * pct + 99) / 100;
+    return g_array_index(sorted, gint64, MAX(rank, 1) - 1);
+}
+
+static void
+report(Bench *bench, GPtrArray *steps)
+{
+    g_autoptr(GArray) total = g_array_new(FALSE, TRUE, sizeof(gint64));
+
+    g_print("%-20s %8s %10s %10s %12s %12s %12s\n", "role", "results",
+            "p50 ms", "p99 ms", "bus bytes", "bench kB", "service kB");
+    for (guint i = 0; i < steps->len; i++) {
+        BenchStep *step = g_ptr_array_index(steps, i);
+
+        g_array_set_size(total, step->latency_us->len);
+        for (guint j = 0; j < step->latency_us->len; j++)
+            g_array_index(total, gint64, j) +=
+                g_array_index(step->latency_us, gint64, j);
+
+        g_print("%-20s %8u %10.1f %10.1f ", step->label, step->results,
+                percentile(step->latency_us, 50) / 1000.0,
+                percentile(step->latency_us, 99) / 1000.0);
+        if (bench->monitor != NULL)
+            g_print("%12" G_GINT64_FORMAT, percentile(step->bus_bytes, 50));
+        else
+            g_print("%12s", "-");
+        g_print(" %12" G_GUINT64_FORMAT, step->bench_rss_kb);
+        if (step->service_rss_kb != 0)
+            g_print(" %12" G_GUINT64_FORMAT "\n", step->service_rss_kb);
+        else
+            g_print(" %12s\n", "-");
+    }
+    g_print("%-20s %8s %10.1f %10.1f\n", "startup (total)", "",
+            percentile(total, 50) / 1000.0, percentile(total, 99) / 1000.0);
+}
+
+/* ======================================================================
+ * Service
+ * ====================================================================== */
+
+static GSubprocess *
+service_spawn(GError **error)
+{
+    g_auto(GStrv) argv = NULL;
+    g_autoptr(GPtrArray) full_argv = g_ptr_array_new();
+
+    if (!g_shell_parse_argv(opt_service != NULL ? opt_service
+                                                : "python3 -m urpm.dbus.service",
+                            NULL, &argv, error))
+        return NULL;
+
+    for (guint i = 0; argv[i] != NULL; i++)
+        g_ptr_array_add(full_argv, argv[i]);
+    g_ptr_array_add(full_argv, (gpointer) "--db");
+    g_ptr_array_add(full_argv, opt_db);
+    g_ptr_array_add(full_argv, NULL);
+
+    return g_subprocess_newv((const gchar * const *) full_argv->pdata,
+                             opt_verbose ? G_SUBPROCESS_FLAGS_NONE
+                                         : G_SUBPROCESS_FLAGS_STDERR_SILENCE,
+                             error);
+}
+
+static gboolean
+service_wait(GDBusConnection *connection, GSubprocess *service, GError **error)
+{
+    gint64 deadline = g_get_monotonic_time() + SERVICE_START_TIMEOUT_US;
+
+    while (g_get_monotonic_time() < deadline) {
+        g_autoptr(GVariant) reply = g_dbus_connection_call_sync(
+            connection, DBUS_NAME, DBUS_PATH, DBUS_NAME, "NameHasOwner",
+            g_variant_new("(s)", URPM_BUS_NAME), G_VARIANT_TYPE("(b)"),
+            G_DBUS_CALL_FLAGS_NONE, -1, NULL, error);
+        gboolean has_owner = FALSE;
+
+        if (reply == NULL)
+            return FALSE;
+        g_variant_get(reply, "(b)", &has_owner);
+        if (has_owner)
+            return TRUE;
+        if (service != NULL && g_subprocess_get_identifier(service) == NULL) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                        "service exited during startup");
+            return FALSE;
+        }
+        g_usleep(50 * 1000);
+    }
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                "%s did not appear on the bus", URPM_BUS_NAME);
+    return FALSE;
+}
+
+static gchar *
+service_pid(GDBusConnection *connection)
+{
+    g_autoptr(GVariant) reply = NULL;
+    guint32 pid;
+
+    reply = g_dbus_connection_call_sync(connection, DBUS_NAME, DBUS_PATH,
+                                        DBUS_NAME, "GetConnectionUnixProcessID",
+                                        g_variant_new("(s)", URPM_BUS_NAME),
+                                        G_VARIANT_TYPE("(u)"),
+                                        G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (reply == NULL)
+        return NULL;
+    g_variant_get(reply, "(u)", &pid);
+    return g_strdup_printf("%u", pid);
+}
+
+int
+main(int argc, char *argv[])
+{
+    g_autoptr(GOptionContext) context = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) steps = NULL;
+    g_autoptr(GTestDBus) test_bus = NULL;
+    g_autoptr(GSubprocess) service = NULL;
+    g_autofree gchar *address = NULL;
+    Bench bench = { 0 };
+    int status = 0;
+
+    context = g_option_context_new("- replay PackageKit roles through pk-backend-urpm");
+    g_option_context_add_main_entries(context, options, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        return 2;
+    }
+    if (opt_replay == NULL || (opt_db == NULL && !opt_system) || opt_runs < 1) {
+        g_printerr("--replay and either --db or --system are required\n");
+        return 2;
+    }
+
+    steps = replay_load(opt_replay, &error);
+    if (steps == NULL) {
+        g_printerr("%s\n", error->message);
+        return 2;
+    }
+
+    /* The backend and service both use the system bus; give them ours */
+    if (!opt_system) {
+        test_bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+        g_test_dbus_up(test_bus);
+        g_setenv("DBUS_SYSTEM_BUS_ADDRESS",
+                 g_test_dbus_get_bus_address(test_bus), TRUE);
+    }
+    address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (address != NULL)
+        bench.control = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (bench.control == NULL) {
+        g_printerr("Cannot connect to the bus: %s\n", error->message);
+        return 1;
+    }
+
+    if (!opt_system) {
+        service = service_spawn(&error);
+        if (service == NULL) {
+            g_printerr("Cannot start the service: %s\n", error->message);
+            status = 1;
+            goto out;
+        }
+    }
+    if (!service_wait(bench.control, service, &error)) {
+        g_printerr("%s\n", error->message);
+        status = 1;
+        goto out;
+    }
+    bench.service_pid = service != NULL
+        ? g_strdup(g_subprocess_get_identifier(service))
+        : service_pid(bench.control);
+
+    g_mutex_init(&bench.lock);
+    g_cond_init(&bench.cond);
+    bench.monitor = monitor_new(address, &bench, &error);
+    if (bench.monitor == NULL) {
+        g_printerr("Bus bytes unavailable: %s\n", error->message);
+        g_clear_error(&error);
+    }
+
+    pk_backend_initialize(NULL, NULL);
+    for (gint i = 0; i < opt_warmup; i++)
+        replay_run(&bench, steps, FALSE);
+    for (gint i = 0; i < opt_runs; i++)
+        replay_run(&bench, steps, TRUE);
+    pk_backend_destroy(NULL);
+
+    g_print("%s: %d runs%s\n\n", opt_replay, opt_runs,
+            opt_warm ? " (warm cache)" : "");
+    report(&bench, steps);
+
+    for (guint i = 0; i < steps->len; i++) {
+        BenchStep *step = g_ptr_array_index(steps, i);
+        if (step->error != NULL) {
+            g_printerr("%s failed: %s\n", step->label, step->error);
+            status = 1;
+        }
+    }
+
+out:
+    if (service != NULL) {
+        g_subprocess_send_signal(service, SIGTERM);
+        g_subprocess_wait(service, NULL, NULL);
+    }
+    g_clear_object(&bench.monitor);
+    g_clear_object(&bench.control);
+    g_free(bench.service_pid);
+    if (test_bus != NULL)
+        g_test_dbus_down(test_bus);
+    return status;
+}
@@ -0,0 +1,285 @@
+/*
+ * Minimal PackageKit job host for pk-backend-urpm-bench
+ *
+ * Only the helpers pk-backend-urpm.c calls are provided; linking the
+ * bench fails if the backend starts using another one, which is the
+ * cue to add it here.
+ *
+ * Copyright (C) 2026 Mageia Community
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "pk-backend-stub.h"
+#include <unistd.h>
+
+struct _PkBackendJob {
+    GObject parent_instance;
+
+    PkRoleEnum role;
+    GVariant *params;
+    GCancellable *cancellable;
+
+    GMutex lock;
+    GCond done_cond;
+    gboolean done;
+
+    gchar *error;
+    guint n_results;
+    GPtrArray *package_ids;
+};
+
+G_DEFINE_TYPE(PkBackendJob, pk_backend_job, G_TYPE_OBJECT)
+
+typedef struct {
+    PkBackendFileChanged func;
+    gpointer data;
+} WatchedFile;
+
+static GArray *watched_files = NULL;
+
+typedef struct {
+    PkBackendJob *job;
+    PkBackendJobThreadFunc func;
+    gpointer user_data;
+    GDestroyNotify destroy_func;
+} JobThread;
+
+static void
+pk_backend_job_finalize(GObject *object)
+{
+    PkBackendJob *job = PK_BACKEND_JOB(object);
+
+    g_variant_unref(job->params);
+    g_object_unref(job->cancellable);
+    g_mutex_clear(&job->lock);
+    g_cond_clear(&job->done_cond);
+    g_free(job->error);
+    g_ptr_array_unref(job->package_ids);
+
+    G_OBJECT_CLASS(pk_backend_job_parent_class)->finalize(object);
+}
+
+static void
+pk_backend_job_class_init(PkBackendJobClass *klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = pk_backend_job_finalize;
+}
+
+static void
+pk_backend_job_init(PkBackendJob *job)
+{
+    g_mutex_init(&job->lock);
+    g_cond_init(&job->done_cond);
+    job->cancellable = g_cancellable_new();
+    job->package_ids = g_ptr_array_new_with_free_func(g_free);
+}
+
+PkBackendJob *
+pk_bench_job_new(PkRoleEnum role, GVariant *params)
+{
+    PkBackendJob *job = g_object_new(PK_TYPE_BACKEND_JOB, NULL);
+
+    job->role = role;
+    job->params = g_variant_ref_sink(params);
+    return job;
+}
+
+void
+pk_bench_job_wait(PkBackendJob *job)
+{
+    g_mutex_lock(&job->lock);
+    while (!job->done)
+        g_cond_wait(&job->done_cond, &job->lock);
+    g_mutex_unlock(&job->lock);
+}
+
+const gchar *
+pk_bench_job_get_error(PkBackendJob *job)
+{
+    return job->error;
+}
+
+guint
+pk_bench_job_get_n_results(PkBackendJob *job)
+{
+    return job->n_results;
+}
+
+GPtrArray *
+pk_bench_job_get_package_ids(PkBackendJob *job)
+{
+    return job->package_ids;
+}
+
+void
+pk_bench_files_changed(void)
+{
+    if (watched_files == NULL)
+        return;
+    for (guint i = 0; i < watched_files->len; i++) {
+        WatchedFile *watch = &g_array_index(watched_files, WatchedFile, i);
+        watch->func(NULL, watch->data);
+    }
+}
+
+/* ======================================================================
+ * PackageKit helpers used by the backend
+ * ====================================================================== */
+
+static gpointer
+job_thread_run(gpointer data)
+{
+    JobThread *thread = data;
+    PkBackendJob *job = thread->job;
+
+    thread->func(job, job->params, thread->user_data);
+    if (thread->destroy_func != NULL)
+        thread->destroy_func(thread->user_data);
+
+    /* PackageKit finishes the job when the thread returns */
+    g_mutex_lock(&job->lock);
+    job->done = TRUE;
+    g_cond_broadcast(&job->done_cond);
+    g_mutex_unlock(&job->lock);
+
+    g_object_unref(job);
+    g_free(thread);
+    return NULL;
+}
+
+gboolean
+pk_backend_job_thread_create(PkBackendJob *job, PkBackendJobThreadFunc func,
+                             gpointer user_data, GDestroyNotify destroy_func)
+{
+    JobThread *thread = g_new0(JobThread, 1);
+
+    thread->job = g_object_ref(job);
+    thread->func = func;
+    thread->user_data = user_data;
+    thread->destroy_func = destroy_func;
+    g_thread_unref(g_thread_new("pk-bench-job", job_thread_run, thread));
+    return TRUE;
+}
+
+gboolean
+pk_backend_watch_file(PkBackend *backend, const gchar *filename,
+                      PkBackendFileChanged func, gpointer data)
+{
+    WatchedFile watch = { func, data };
+
+    if (watched_files == NULL)
+        watched_files = g_array_new(FALSE, FALSE, sizeof(WatchedFile));
+    g_array_append_val(watched_files, watch);
+    return TRUE;
+}
+
+PkRoleEnum
+pk_backend_job_get_role(PkBackendJob *job)
+{
+    return job->role;
+}
+
+GCancellable *
+pk_backend_job_get_cancellable(PkBackendJob *job)
+{
+    return job->cancellable;
+}
+
+guint
+pk_backend_job_get_uid(PkBackendJob *job)
+{
+    return getuid();
+}
+
+/* The replays are GNOME Software sessions: searches take its path */
+const gchar *
+pk_backend_job_get_cmdline(PkBackendJob *job)
+{
+    return "/usr/bin/gnome-software --gapplication-service";
+}
+
+void
+pk_backend_job_finished(PkBackendJob *job)
+{
+}
+
+void
+pk_backend_job_set_status(PkBackendJob *job, PkStatusEnum status)
+{
+}
+
+void
+pk_backend_job_set_percentage(PkBackendJob *job, guint percentage)
+{
+}
+
+void
+pk_backend_job_set_speed(PkBackendJob *job, guint speed)
+{
+}
+
+void
+pk_backend_job_set_download_size_remaining(PkBackendJob *job,
+                                           guint64 download_size_remaining)
+{
+}
+
+void
+pk_backend_job_error_code(PkBackendJob *job, PkErrorEnum code,
+                          const gchar *details, ...)
+{
+    va_list args;
+
+    va_start(args, details);
+    g_mutex_lock(&job->lock);
+    if (job->error == NULL) {
+        g_autofree gchar *message = g_strdup_vprintf(details, args);
+        job->error = g_strdup_printf("%s: %s", pk_error_enum_to_string(code),
+                                     message);
+    }
+    g_mutex_unlock(&job->lock);
+    va_end(args);
+}
+
+void
+pk_backend_job_package(PkBackendJob *job, PkInfoEnum info,
+                       const gchar *package_id, const gchar *summary)
+{
+    g_mutex_lock(&job->lock);
+    job->n_results++;
+    g_ptr_array_add(job->package_ids, g_strdup(package_id));
+    g_mutex_unlock(&job->lock);
+}
+
+void
+pk_backend_job_details(PkBackendJob *job, const gchar *package_id,
+                       const gchar *summary, const gchar *license,
+                       PkGroupEnum group, const gchar *description,
+                       const gchar *url, gulong size, guint64 download_size)
+{
+    g_mutex_lock(&job->lock);
+    job->n_results++;
+    g_mutex_unlock(&job->lock);
+}
+
+void
+pk_backend_job_files(PkBackendJob *job, const gchar *package_id, gchar **files)
+{
+    g_mutex_lock(&job->lock);
+    job->n_results++;
+    g_mutex_unlock(&job->lock);
+}
+
+void
+pk_backend_job_update_detail(PkBackendJob *job, const gchar *package_id,
+                             gchar **updates, gchar **obsoletes,
+                             gchar **vendor_urls, gchar **bugzilla_urls,
+                             gchar **cve_urls, PkRestartEnum restart,
+                             const gchar *update_text, const gchar *changelog,
+                             PkUpdateStateEnum state, const gchar *issued,
+                             const gchar *updated)
+{
+    g_mutex_lock(&job->lock);
+    job->n_results++;
+    g_mutex_unlock(&job->lock);
+}
@@ -0,0 +1,39 @@
+/*
+ * Minimal PackageKit job host for pk-backend-urpm-bench
+ *
+ * pk-backend-urpm.c is a module the PackageKit daemon loads; the
+ * pk_backend_job_* helpers it calls live in packagekitd.  The bench links
+ * the backend against these stand-ins instead, which run job threads the
+ * way PackageKit does and count what the backend emits.
+ *
+ * Copyright (C) 2026 Mageia Community
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef PK_BACKEND_STUB_H
+#define PK_BACKEND_STUB_H
+
+#include "pk-backend.h"
+
+G_BEGIN_DECLS
+
+PkBackendJob *pk_bench_job_new(PkRoleEnum role, GVariant *params);
+
+/* Block until the job thread has returned */
+void pk_bench_job_wait(PkBackendJob *job);
+
+/* Error details if the backend called pk_backend_job_error_code() */
+const gchar *pk_bench_job_get_error(PkBackendJob *job);
+
+/* Package, details, files and update-detail emissions */
+guint pk_bench_job_get_n_results(PkBackendJob *job);
+
+/* Package ids in emission order, owned by the job */
+GPtrArray *pk_bench_job_get_package_ids(PkBackendJob *job);
+
+/* Run the callbacks registered with pk_backend_watch_file() */
+void pk_bench_files_changed(void);
+
+G_END_DECLS
+
+#endif /* PK_BACKEND_STUB_H */
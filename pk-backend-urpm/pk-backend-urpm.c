@@ -18,26 +18,147 @@
 #define URPM_OBJECT_PATH   "/org/mageia/Urpm/v1"
 #define URPM_INTERFACE     "org.mageia.Urpm.v1"
 
+/*
+ * Maximum number of read-only jobs that may talk to the service at once.
+ * PackageKit only runs non-exclusive (query) transactions in parallel, so
+ * this bounds the fan-out of a GNOME Software / Discover startup burst.
+ */
+#define URPM_READ_POOL_SIZE 4
+
+/* Packages per GetInstalledPackagesPaged round-trip */
+#define URPM_PAGE_SIZE 500
+
+/* Results of one search-as-you-type query (SearchPackagesPrefixV2) */
+#define URPM_SEARCH_LIMIT 100
+
+/*
+ * Clients that search on every keystroke (matched on the program name of
+ * the job's command line).  Only their searches take the bounded prefix
+ * path; pkcon and scripts get every match.
+ */
+static const gchar * const urpm_typeahead_clients[] = {
+    "gnome-software",
+    "plasma-discover",
+    NULL
+};
+
+/* Returned by the service for a search replaced by a newer one */
+#define URPM_ERROR_SUPERSEDED "org.mageia.Urpm.v1.Error.Superseded"
+
+/*
+ * Files whose change means cached listings are stale.  packages.db is in
+ * WAL mode: a media sync lands in the -wal file and reaches the main file
+ * only at a checkpoint.
+ */
+#define URPM_RPMDB_PATH    "/var/lib/rpm/rpmdb.sqlite"
+#define URPM_PACKAGES_DB   "/var/lib/urpm/packages.db"
+#define URPM_PACKAGES_WAL  "/var/lib/urpm/packages.db-wal"
+
+/*
+ * Proxy roles.  Write roles (install, remove, update, refresh, ...) share
+ * the system bus connection: PackageKit serializes them and they need the
+ * OperationProgress subscription.  Read roles lease a private connection
+ * from a small pool so a multi-megabyte reply on one job never queues
+ * behind another job's messages.
+ */
+typedef enum {
+    URPM_ROLE_READ,
+    URPM_ROLE_WRITE,
+} UrpmProxyRole;
+
 typedef struct {
+    UrpmProxyRole role;
     GDBusConnection *connection;
     GDBusProxy *proxy;
+} UrpmProxyLease;
+
+typedef struct {
+    GMutex lock;
+    GCond read_available;
+
+    /* Shared system bus connection, used by write roles and cancel */
+    GDBusConnection *connection;
+    GDBusProxy *proxy;
+
+    /* Idle read leases, and how many exist in total (idle + in use) */
+    GQueue read_idle;
+    guint read_leases;
+
     guint progress_signal_id;
     guint complete_signal_id;
+
+    /*
+     * Session cache of get-packages / get-updates results, keyed by
+     * "role;filters".  Bumping cache_generation on invalidation keeps a
+     * job that started before the change from storing a stale listing.
+     * Each entry also keeps the service's GetDataGeneration token, so a
+     * change the file watches miss still makes it stale.
+     */
+    GMutex cache_lock;
+    GHashTable *cache;
+    guint cache_generation;
 } PkBackendUrpmPrivate;
 
+typedef struct {
+    PkInfoEnum info;
+    gchar *package_id;
+    gchar *summary;
+} UrpmCachedPackage;
+
+typedef struct {
+    gchar *data_generation;     /* "": service without GetDataGeneration */
+    GPtrArray *packages;
+} UrpmCacheEntry;
+
 static PkBackendUrpmPrivate *priv = NULL;
 
+/* Packages emitted by the current job thread, while it is being cached */
+static GPrivate cache_recorder = G_PRIVATE_INIT(NULL);
+
 /* ========================================================================= */
 /* D-Bus connection management                                               */
 /* ========================================================================= */
 
+static GDBusProxy *
+new_service_proxy(GDBusConnection *connection, GError **error)
+{
+    return g_dbus_proxy_new_sync(
+        connection,
+        G_DBUS_PROXY_FLAGS_NONE,
+        NULL,
+        URPM_BUS_NAME,
+        URPM_OBJECT_PATH,
+        URPM_INTERFACE,
+        NULL,
+        error
+    );
+}
+
+static void urpm_cache_invalidate(void);
+
+static void
+on_operation_complete(GDBusConnection *connection, const gchar *sender_name,
+                      const gchar *object_path, const gchar *interface_name,
+                      const gchar *signal_name, GVariant *parameters,
+                      gpointer user_data)
+{
+    /* Any client's install/remove/refresh through the service */
+    urpm_cache_invalidate();
+}
+
+/* Must be called with priv->lock held */
 static gboolean
-ensure_connection(PkBackendJob *job, GError **error)
+ensure_connection_locked(GError **error)
 {
     if (priv->connection != NULL && !g_dbus_connection_is_closed(priv->connection))
         return TRUE;
 
     /* Clear old connection */
+    if (priv->complete_signal_id != 0) {
+        g_dbus_connection_signal_unsubscribe(priv->connection,
+                                             priv->complete_signal_id);
+        priv->complete_signal_id = 0;
+    }
     g_clear_object(&priv->proxy);
     g_clear_object(&priv->connection);
 
@@ -45,24 +166,398 @@ ensure_connection(PkBackendJob *job, GError **error)
     if (priv->connection == NULL)
         return FALSE;
 
-    priv->proxy = g_dbus_proxy_new_sync(
+    priv->proxy = new_service_proxy(priv->connection, error);
+    if (priv->proxy == NULL) {
+        g_clear_object(&priv->connection);
+        return FALSE;
+    }
+
+    priv->complete_signal_id = g_dbus_connection_signal_subscribe(
         priv->connection,
-        G_DBUS_PROXY_FLAGS_NONE,
-        NULL,
         URPM_BUS_NAME,
-        URPM_OBJECT_PATH,
         URPM_INTERFACE,
+        "OperationComplete",
+        URPM_OBJECT_PATH,
         NULL,
-        error
+        G_DBUS_SIGNAL_FLAGS_NONE,
+        on_operation_complete,
+        NULL,
+        NULL
+    );
+
+    return TRUE;
+}
+
+static void
+read_lease_free(UrpmProxyLease *lease)
+{
+    g_clear_object(&lease->proxy);
+    g_clear_object(&lease->connection);
+    g_free(lease);
+}
+
+static UrpmProxyLease *
+read_lease_new(GError **error)
+{
+    g_autofree gchar *address = g_dbus_address_get_for_bus_sync(
+        G_BUS_TYPE_SYSTEM, NULL, error);
+    if (address == NULL)
+        return NULL;
+
+    UrpmProxyLease *lease = g_new0(UrpmProxyLease, 1);
+    lease->role = URPM_ROLE_READ;
+    lease->connection = g_dbus_connection_new_for_address_sync(
+        address,
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+        NULL, NULL, error);
+    if (lease->connection == NULL) {
+        read_lease_free(lease);
+        return NULL;
+    }
+
+    lease->proxy = new_service_proxy(lease->connection, error);
+    if (lease->proxy == NULL) {
+        read_lease_free(lease);
+        return NULL;
+    }
+
+    return lease;
+}
+
+static void
+on_acquire_cancelled(GCancellable *cancellable, gpointer user_data)
+{
+    /* Wake waiters so a cancelled job stops queueing for a lease */
+    g_mutex_lock(&priv->lock);
+    g_cond_broadcast(&priv->read_available);
+    g_mutex_unlock(&priv->lock);
+}
+
+/*
+ * Take a connection/proxy pair for the calling job.
+ *
+ * Read leases block while URPM_READ_POOL_SIZE jobs already hold one, or
+ * until cancellable (the job's, usually) is cancelled.  Leases whose
+ * connection was closed (service restart, bus hiccup) are dropped and
+ * replaced transparently.  Release with urpm_proxy_release(), or declare
+ * the lease with g_autoptr(UrpmProxyLease).
+ */
+static UrpmProxyLease *
+urpm_proxy_acquire(UrpmProxyRole role, GCancellable *cancellable, GError **error)
+{
+    UrpmProxyLease *lease = NULL;
+    gulong cancel_id = 0;
+
+    /* Connected before taking the lock: the handler runs at once if
+     * the job is already cancelled, and it takes the lock itself */
+    if (role == URPM_ROLE_READ && cancellable != NULL)
+        cancel_id = g_cancellable_connect(cancellable,
+                                          G_CALLBACK(on_acquire_cancelled),
+                                          NULL, NULL);
+
+    g_mutex_lock(&priv->lock);
+
+    if (role == URPM_ROLE_WRITE) {
+        if (ensure_connection_locked(error)) {
+            lease = g_new0(UrpmProxyLease, 1);
+            lease->role = URPM_ROLE_WRITE;
+            lease->connection = g_object_ref(priv->connection);
+            lease->proxy = g_object_ref(priv->proxy);
+        }
+        g_mutex_unlock(&priv->lock);
+        return lease;
+    }
+
+    for (;;) {
+        lease = g_queue_pop_head(&priv->read_idle);
+        if (lease != NULL) {
+            if (!g_dbus_connection_is_closed(lease->connection))
+                break;
+            read_lease_free(lease);
+            lease = NULL;
+            priv->read_leases--;
+            continue;
+        }
+        if (priv->read_leases < URPM_READ_POOL_SIZE)
+            break;
+        if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+            g_mutex_unlock(&priv->lock);
+            g_cancellable_disconnect(cancellable, cancel_id);
+            return NULL;
+        }
+        g_cond_wait(&priv->read_available, &priv->lock);
+    }
+
+    /* Reserve the free slot, then connect without holding the lock */
+    if (lease == NULL)
+        priv->read_leases++;
+    g_mutex_unlock(&priv->lock);
+    g_cancellable_disconnect(cancellable, cancel_id);
+
+    if (lease == NULL) {
+        lease = read_lease_new(error);
+        if (lease == NULL) {
+            g_mutex_lock(&priv->lock);
+            priv->read_leases--;
+            g_cond_signal(&priv->read_available);
+            g_mutex_unlock(&priv->lock);
+        }
+    }
+    return lease;
+}
+
+static void
+urpm_proxy_release(UrpmProxyLease *lease)
+{
+    if (lease == NULL)
+        return;
+
+    if (lease->role == URPM_ROLE_WRITE) {
+        /* The job may have changed the installed set or the media */
+        urpm_cache_invalidate();
+        g_clear_object(&lease->proxy);
+        g_clear_object(&lease->connection);
+        g_free(lease);
+        return;
+    }
+
+    g_mutex_lock(&priv->lock);
+    if (g_dbus_connection_is_closed(lease->connection)) {
+        read_lease_free(lease);
+        priv->read_leases--;
+    } else {
+        g_queue_push_head(&priv->read_idle, lease);
+    }
+    g_cond_signal(&priv->read_available);
+    g_mutex_unlock(&priv->lock);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(UrpmProxyLease, urpm_proxy_release)
+
+/* ========================================================================= */
+/* Result cache                                                              */
+/* ========================================================================= */
+
+static void
+cached_package_free(UrpmCachedPackage *pkg)
+{
+    g_free(pkg->package_id);
+    g_free(pkg->summary);
+    g_free(pkg);
+}
+
+static void
+cache_entry_free(UrpmCacheEntry *entry)
+{
+    g_free(entry->data_generation);
+    g_ptr_array_unref(entry->packages);
+    g_free(entry);
+}
+
+static gchar *
+urpm_cache_key(PkBackendJob *job, PkBitfield filters)
+{
+    return g_strdup_printf("%s;%" G_GUINT64_FORMAT,
+                           pk_role_enum_to_string(pk_backend_job_get_role(job)),
+                           filters);
+}
+
+static void
+urpm_cache_invalidate(void)
+{
+    g_mutex_lock(&priv->cache_lock);
+    g_hash_table_remove_all(priv->cache);
+    priv->cache_generation++;
+    g_mutex_unlock(&priv->cache_lock);
+}
+
+static void
+on_database_changed(PkBackend *backend, gpointer user_data)
+{
+    /* rpm run outside urpm, or a media sync by urpmd */
+    urpm_cache_invalidate();
+}
+
+/*
+ * The service's token for the current package data.  An older service
+ * without GetDataGeneration gives "", leaving invalidation to the file
+ * watches; NULL means the call failed and the cache must not be used.
+ */
+static gchar *
+urpm_data_generation(GDBusProxy *proxy, GCancellable *cancellable)
+{
+    g_autoptr(GError) error = NULL;
+    gchar *generation = NULL;
+
+    GVariant *result = g_dbus_proxy_call_sync(
+        proxy,
+        "GetDataGeneration",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        cancellable,
+        &error
     );
+    if (result == NULL) {
+        if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+            return g_strdup("");
+        g_debug("GetDataGeneration failed: %s", error->message);
+        return NULL;
+    }
+    g_variant_get(result, "(s)", &generation);
+    g_variant_unref(result);
+    return generation;
+}
+
+/*
+ * Emit the cached listing for key, if there is one taken at
+ * data_generation.  Returns FALSE on a miss; the caller then queries the
+ * service between urpm_cache_record_begin() and urpm_cache_record_end().
+ */
+static gboolean
+urpm_cache_replay(PkBackendJob *job, const gchar *key,
+                  const gchar *data_generation)
+{
+    GPtrArray *packages = NULL;
+
+    g_mutex_lock(&priv->cache_lock);
+    UrpmCacheEntry *entry = g_hash_table_lookup(priv->cache, key);
+    if (entry != NULL && data_generation != NULL &&
+        g_strcmp0(entry->data_generation, data_generation) == 0)
+        packages = g_ptr_array_ref(entry->packages);
+    g_mutex_unlock(&priv->cache_lock);
 
-    return priv->proxy != NULL;
+    if (packages == NULL)
+        return FALSE;
+
+    for (guint i = 0; i < packages->len; i++) {
+        UrpmCachedPackage *pkg = g_ptr_array_index(packages, i);
+        pk_backend_job_package(job, pkg->info, pkg->package_id, pkg->summary);
+    }
+    g_ptr_array_unref(packages);
+    return TRUE;
+}
+
+/* Start recording what this job thread emits; returns the generation */
+static guint
+urpm_cache_record_begin(void)
+{
+    g_private_set(&cache_recorder,
+                  g_ptr_array_new_with_free_func((GDestroyNotify) cached_package_free));
+
+    g_mutex_lock(&priv->cache_lock);
+    guint generation = priv->cache_generation;
+    g_mutex_unlock(&priv->cache_lock);
+    return generation;
+}
+
+/*
+ * Stop recording.  The listing is stored, with the data_generation it was
+ * read at, only if the job succeeded and nothing invalidated the cache
+ * while it ran.
+ */
+static void
+urpm_cache_record_end(const gchar *key, guint generation,
+                      const gchar *data_generation, gboolean store)
+{
+    GPtrArray *packages = g_private_get(&cache_recorder);
+    g_private_set(&cache_recorder, NULL);
+    if (packages == NULL)
+        return;
+
+    g_mutex_lock(&priv->cache_lock);
+    if (store && data_generation != NULL &&
+        generation == priv->cache_generation) {
+        UrpmCacheEntry *entry = g_new0(UrpmCacheEntry, 1);
+        entry->data_generation = g_strdup(data_generation);
+        entry->packages = packages;
+        g_hash_table_replace(priv->cache, g_strdup(key), entry);
+        packages = NULL;
+    }
+    g_mutex_unlock(&priv->cache_lock);
+
+    if (packages != NULL)
+        g_ptr_array_unref(packages);
+}
+
+/* pk_backend_job_package(), also feeding the cache recorder if active */
+static void
+urpm_job_package(PkBackendJob *job, PkInfoEnum info,
+                 const gchar *package_id, const gchar *summary)
+{
+    pk_backend_job_package(job, info, package_id, summary);
+
+    GPtrArray *recorder = g_private_get(&cache_recorder);
+    if (recorder != NULL) {
+        UrpmCachedPackage *pkg = g_new0(UrpmCachedPackage, 1);
+        pkg->info = info;
+        pkg->package_id = g_strdup(package_id);
+        pkg->summary = g_strdup(summary);
+        g_ptr_array_add(recorder, pkg);
+    }
+}
+
+/*
+ * PackageKit error code for a failed service call.  A call aborted
+ * through the job's GCancellable, or a search the service dropped for
+ * a newer one, reports TRANSACTION_CANCELLED rather than a service
+ * failure.
+ */
+static PkErrorEnum
+urpm_error_enum(const GError *error, PkErrorEnum fallback)
+{
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return PK_ERROR_ENUM_TRANSACTION_CANCELLED;
+    if (g_dbus_error_is_remote_error(error)) {
+        g_autofree gchar *name = g_dbus_error_get_remote_error(error);
+        if (g_strcmp0(name, URPM_ERROR_SUPERSEDED) == 0)
+            return PK_ERROR_ENUM_TRANSACTION_CANCELLED;
+    }
+    return fallback;
 }
 
 /* ========================================================================= */
 /* Helper: Parse JSON package list                                           */
 /* ========================================================================= */
 
+static void
+emit_package_object(PkBackendJob *job, JsonObject *pkg, PkInfoEnum info)
+{
+    const gchar *name = json_object_get_string_member_with_default(pkg, "name", "");
+    const gchar *version = json_object_get_string_member_with_default(pkg, "version", "");
+    const gchar *release = json_object_get_string_member_with_default(pkg, "release", "");
+    const gchar *arch = json_object_get_string_member_with_default(pkg, "arch", "");
+    const gchar *summary = json_object_get_string_member_with_default(pkg, "summary", "");
+    gboolean installed = json_object_get_boolean_member_with_default(pkg, "installed", FALSE);
+
+    if (name[0] == '\0' || version[0] == '\0')
+        return;
+
+    /* Build package_id: name;version-release;arch;urpm */
+    g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
+    g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
+
+    /* Override info enum based on installed status */
+    PkInfoEnum pkg_info = info;
+    if (info == PK_INFO_ENUM_AVAILABLE && installed)
+        pkg_info = PK_INFO_ENUM_INSTALLED;
+
+    urpm_job_package(job, pkg_info, package_id, summary);
+}
+
+static void
+emit_package_array(PkBackendJob *job, JsonArray *packages, PkInfoEnum info)
+{
+    guint len = json_array_get_length(packages);
+
+    for (guint i = 0; i < len; i++) {
+        JsonObject *pkg = json_array_get_object_element(packages, i);
+        if (pkg != NULL)
+            emit_package_object(job, pkg, info);
+    }
+}
+
 static void
 emit_packages_from_json(PkBackendJob *job, const gchar *json_str, PkInfoEnum info)
 {
@@ -77,39 +572,40 @@ emit_packages_from_json(PkBackendJob *job, const gchar *json_str, PkInfoEnum inf
     }
 
     JsonNode *root = json_parser_get_root(parser);
-    if (!JSON_NODE_HOLDS_ARRAY(root)) {
-        g_object_unref(parser);
-        return;
-    }
+    if (JSON_NODE_HOLDS_ARRAY(root))
+        emit_package_array(job, json_node_get_array(root), info);
 
-    JsonArray *packages = json_node_get_array(root);
-    guint len = json_array_get_length(packages);
+    g_object_unref(parser);
+}
 
-    for (guint i = 0; i < len; i++) {
-        JsonObject *pkg = json_array_get_object_element(packages, i);
-        if (pkg == NULL)
+/*
+ * Emit an a(sssssb) array of package records, as returned by the *V2
+ * service methods.  Strings are borrowed from the variant, so nothing is
+ * copied besides the package_id itself.
+ */
+static void
+emit_package_records(PkBackendJob *job, GVariant *records, PkInfoEnum info)
+{
+    GVariantIter iter;
+    const gchar *name, *version, *release, *arch, *summary;
+    gboolean installed;
+
+    g_variant_iter_init(&iter, records);
+    while (g_variant_iter_next(&iter, "(&s&s&s&s&sb)",
+                               &name, &version, &release, &arch,
+                               &summary, &installed)) {
+        if (name[0] == '\0' || version[0] == '\0')
             continue;
 
-        const gchar *name = json_object_get_string_member_with_default(pkg, "name", "");
-        const gchar *version = json_object_get_string_member_with_default(pkg, "version", "");
-        const gchar *release = json_object_get_string_member_with_default(pkg, "release", "");
-        const gchar *arch = json_object_get_string_member_with_default(pkg, "arch", "");
-        const gchar *summary = json_object_get_string_member_with_default(pkg, "summary", "");
-        gboolean installed = json_object_get_boolean_member_with_default(pkg, "installed", FALSE);
-
-        /* Build package_id: name;version-release;arch;urpm */
         g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
         g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
 
-        /* Override info enum based on installed status */
         PkInfoEnum pkg_info = info;
         if (info == PK_INFO_ENUM_AVAILABLE && installed)
             pkg_info = PK_INFO_ENUM_INSTALLED;
 
-        pk_backend_job_package(job, pkg_info, package_id, summary);
+        urpm_job_package(job, pkg_info, package_id, summary);
     }
-
-    g_object_unref(parser);
 }
 
 /* ========================================================================= */
@@ -131,15 +627,43 @@ pk_backend_get_author(PkBackend *backend)
 void
 pk_backend_initialize(GKeyFile *conf, PkBackend *backend)
 {
+    GError *error = NULL;
+
     priv = g_new0(PkBackendUrpmPrivate, 1);
+    g_mutex_init(&priv->lock);
+    g_cond_init(&priv->read_available);
+    g_queue_init(&priv->read_idle);
+
+    g_mutex_init(&priv->cache_lock);
+    priv->cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                        (GDestroyNotify) cache_entry_free);
+    pk_backend_watch_file(backend, URPM_RPMDB_PATH, on_database_changed, NULL);
+    pk_backend_watch_file(backend, URPM_PACKAGES_DB, on_database_changed, NULL);
+    pk_backend_watch_file(backend, URPM_PACKAGES_WAL, on_database_changed, NULL);
+
+    /* Connect now so OperationComplete is seen from the start */
+    g_mutex_lock(&priv->lock);
+    if (!ensure_connection_locked(&error)) {
+        g_debug("urpm D-Bus service not reachable yet: %s", error->message);
+        g_error_free(error);
+    }
+    g_mutex_unlock(&priv->lock);
 }
 
 void
 pk_backend_destroy(PkBackend *backend)
 {
     if (priv != NULL) {
+        g_queue_clear_full(&priv->read_idle, (GDestroyNotify) read_lease_free);
+        if (priv->complete_signal_id != 0)
+            g_dbus_connection_signal_unsubscribe(priv->connection,
+                                                 priv->complete_signal_id);
+        g_clear_pointer(&priv->cache, g_hash_table_unref);
+        g_mutex_clear(&priv->cache_lock);
         g_clear_object(&priv->proxy);
         g_clear_object(&priv->connection);
+        g_cond_clear(&priv->read_available);
+        g_mutex_clear(&priv->lock);
         g_free(priv);
         priv = NULL;
     }
@@ -198,13 +722,31 @@ pk_backend_get_mime_types(PkBackend *backend)
 gboolean
 pk_backend_supports_parallelization(PkBackend *backend)
 {
-    return FALSE;
+    /*
+     * Query roles each lease their own D-Bus connection (see
+     * urpm_proxy_acquire), and PackageKit still runs exclusive
+     * transactions one at a time, so concurrent jobs are safe.
+     */
+    return TRUE;
 }
 
 /* ========================================================================= */
 /* Search                                                                    */
 /* ========================================================================= */
 
+/* Whether the job comes from a search-as-you-type client */
+static gboolean
+urpm_job_is_typeahead(PkBackendJob *job)
+{
+    const gchar *cmdline = pk_backend_job_get_cmdline(job);
+    if (cmdline == NULL || *cmdline == '\0')
+        return FALSE;
+
+    g_auto(GStrv) argv = g_strsplit(cmdline, " ", 2);
+    g_autofree gchar *program = g_path_get_basename(argv[0]);
+    return g_strv_contains(urpm_typeahead_clients, program);
+}
+
 static void
 pk_backend_search_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
 {
@@ -214,8 +756,11 @@ pk_backend_search_thread(PkBackendJob *job, GVariant *params, gpointer user_data
 
     g_variant_get(params, "(t^a&s)", &filters, &values);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
@@ -227,18 +772,84 @@ pk_backend_search_thread(PkBackendJob *job, GVariant *params, gpointer user_data
     /* Join search terms */
     g_autofree gchar *pattern = g_strjoinv(" ", values);
 
-    GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+    /* Determine info based on filter */
+    PkInfoEnum info = PK_INFO_ENUM_AVAILABLE;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_INSTALLED))
+        info = PK_INFO_ENUM_INSTALLED;
+
+    GVariant *result = NULL;
+    if (urpm_job_is_typeahead(job)) {
+        /*
+         * The client searches on every keystroke: ask for a bounded,
+         * ranked answer.  All jobs of one user, client and role share a
+         * session, so the service drops the query this one replaces.
+         * Every read lease has its own connection, hence the explicit
+         * session.
+         */
+        g_autofree gchar *session = g_strdup_printf(
+            "pk;%u;%s;%s",
+            pk_backend_job_get_uid(job),
+            pk_backend_job_get_cmdline(job),
+            pk_role_enum_to_string(pk_backend_job_get_role(job)));
+
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
+            "SearchPackagesPrefixV2",
+            g_variant_new("(sbus)", pattern, FALSE, URPM_SEARCH_LIMIT, session),
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            pk_backend_job_get_cancellable(job),
+            &error
+        );
+    }
+
+    if (result == NULL &&
+        (error == NULL ||
+         g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))) {
+        /* Full search, or older service without prefix search */
+        g_clear_error(&error);
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
+            "SearchPackagesV2",
+            g_variant_new("(sb)", pattern, FALSE),  /* pattern, search_provides */
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            pk_backend_job_get_cancellable(job),
+            &error
+        );
+    }
+
+    if (result != NULL) {
+        g_autoptr(GVariant) records = g_variant_get_child_value(result, 0);
+        emit_package_records(job, records, info);
+        g_variant_unref(result);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    if (!g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_INTERNAL_ERROR),
+                                  "Search failed: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    /* Older service without typed methods: fall back to JSON */
+    g_clear_error(&error);
+    result = g_dbus_proxy_call_sync(
+        lease->proxy,
         "SearchPackages",
-        g_variant_new("(sb)", pattern, FALSE),  /* pattern, search_provides */
+        g_variant_new("(sb)", pattern, FALSE),
         G_DBUS_CALL_FLAGS_NONE,
         -1,
-        NULL,
+        pk_backend_job_get_cancellable(job),
         &error
     );
 
     if (result == NULL) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_INTERNAL_ERROR,
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_INTERNAL_ERROR),
                                   "Search failed: %s", error->message);
         g_error_free(error);
         return;
@@ -246,12 +857,6 @@ pk_backend_search_thread(PkBackendJob *job, GVariant *params, gpointer user_data
 
     const gchar *json_str;
     g_variant_get(result, "(&s)", &json_str);
-
-    /* Determine info based on filter */
-    PkInfoEnum info = PK_INFO_ENUM_AVAILABLE;
-    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_INSTALLED))
-        info = PK_INFO_ENUM_INSTALLED;
-
     emit_packages_from_json(job, json_str, info);
 
     g_variant_unref(result);
@@ -280,30 +885,47 @@ pk_backend_search_details(PkBackend *backend, PkBackendJob *job,
 static void
 pk_backend_get_updates_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
 {
+    PkBitfield filters;
     GError *error = NULL;
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_variant_get(params, "(t)", &filters);
+
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
         return;
     }
 
+    g_autofree gchar *cache_key = urpm_cache_key(job, filters);
+    g_autofree gchar *data_generation = urpm_data_generation(
+        lease->proxy, pk_backend_job_get_cancellable(job));
+    if (urpm_cache_replay(job, cache_key, data_generation)) {
+        pk_backend_job_finished(job);
+        return;
+    }
+
     pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
 
+    guint generation = urpm_cache_record_begin();
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "GetUpdates",
         NULL,
         G_DBUS_CALL_FLAGS_NONE,
         -1,
-        NULL,
+        pk_backend_job_get_cancellable(job),
         &error
     );
 
     if (result == NULL) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_INTERNAL_ERROR,
+        urpm_cache_record_end(cache_key, generation, NULL, FALSE);
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_INTERNAL_ERROR),
                                   "GetUpdates failed: %s", error->message);
         g_error_free(error);
         return;
@@ -314,7 +936,8 @@ pk_backend_get_updates_thread(PkBackendJob *job, GVariant *params, gpointer user
 
     /* Parse updates JSON */
     JsonParser *parser = json_parser_new();
-    if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
+    gboolean parsed = json_parser_load_from_data(parser, json_str, -1, NULL);
+    if (parsed) {
         JsonNode *root = json_parser_get_root(parser);
         if (JSON_NODE_HOLDS_OBJECT(root)) {
             JsonObject *obj = json_node_get_object(root);
@@ -347,12 +970,13 @@ pk_backend_get_updates_thread(PkBackendJob *job, GVariant *params, gpointer user
                         evr = g_strdup("0");
 
                     g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
-                    pk_backend_job_package(job, PK_INFO_ENUM_NORMAL, package_id, "");
+                    urpm_job_package(job, PK_INFO_ENUM_NORMAL, package_id, "");
                 }
             }
         }
     }
     g_object_unref(parser);
+    urpm_cache_record_end(cache_key, generation, data_generation, parsed);
 
     g_variant_unref(result);
     pk_backend_job_finished(job);
@@ -373,7 +997,8 @@ pk_backend_refresh_cache_thread(PkBackendJob *job, GVariant *params, gpointer us
 {
     GError *error = NULL;
 
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
@@ -385,7 +1010,7 @@ pk_backend_refresh_cache_thread(PkBackendJob *job, GVariant *params, gpointer us
     pk_backend_job_set_percentage(job, PK_BACKEND_PERCENTAGE_INVALID);
 
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "RefreshMetadata",
         NULL,
         G_DBUS_CALL_FLAGS_NONE,
@@ -425,6 +1050,20 @@ pk_backend_refresh_cache(PkBackend *backend, PkBackendJob *job, gboolean force)
 /* Install Packages                                                          */
 /* ========================================================================= */
 
+/*
+ * Phase values of OperationProgressV2; must match PROGRESS_PHASES in
+ * urpm/dbus/progress.py.
+ */
+typedef enum {
+    URPM_PROGRESS_UNKNOWN,
+    URPM_PROGRESS_RESOLVING,
+    URPM_PROGRESS_DOWNLOADING,
+    URPM_PROGRESS_INSTALLING,
+    URPM_PROGRESS_REMOVING,
+    URPM_PROGRESS_UPGRADING,
+    URPM_PROGRESS_REFRESHING,
+} UrpmProgressPhase;
+
 /* Context for async install with progress */
 typedef struct {
     PkBackendJob *job;
@@ -433,7 +1072,7 @@ typedef struct {
     GError *error;
     gchar **package_ids;
     guint signal_id;
-    gboolean in_download;
+    UrpmProgressPhase phase;
 } InstallContext;
 
 static void
@@ -446,37 +1085,64 @@ on_operation_progress(GDBusConnection *connection,
                       gpointer user_data)
 {
     InstallContext *ctx = user_data;
-    const gchar *op_id, *phase, *package, *message;
-    guint32 current, total;
-
-    /* Python signal format: (sssuus) = (op_id, phase, package, current, total, message) */
-    g_variant_get(parameters, "(&s&s&suu&s)",
-                  &op_id, &phase, &package, &current, &total, &message);
-
-    /* Calculate percentage based on phase */
-    guint percentage = 0;
-    if (total > 0) {
-        percentage = (current * 100) / total;
-    }
-
-    /* Update status based on phase */
-    if (g_str_equal(phase, "downloading")) {
-        if (!ctx->in_download) {
-            ctx->in_download = TRUE;
-            pk_backend_job_set_status(ctx->job, PK_STATUS_ENUM_DOWNLOAD);
+    const gchar *op_id, *package, *message;
+    guint32 phase, current, total;
+    guint64 bytes_done, bytes_total, speed;
+
+    /* (susuuttts) = (op_id, phase, package, current, total,
+     *                bytes_done, bytes_total, speed_bps, message) */
+    g_variant_get(parameters, "(&su&suuttt&s)",
+                  &op_id, &phase, &package, &current, &total,
+                  &bytes_done, &bytes_total, &speed, &message);
+
+    /* The service coalesces updates, a phase change always gets through */
+    if (phase != ctx->phase) {
+        if (ctx->phase == URPM_PROGRESS_DOWNLOADING) {
+            pk_backend_job_set_speed(ctx->job, 0);
+            pk_backend_job_set_download_size_remaining(ctx->job, 0);
         }
-        /* Download is 0-50% of total progress */
-        pk_backend_job_set_percentage(ctx->job, percentage / 2);
-    } else if (g_str_equal(phase, "installing")) {
-        if (ctx->in_download) {
-            ctx->in_download = FALSE;
+        ctx->phase = phase;
+        switch (phase) {
+        case URPM_PROGRESS_RESOLVING:
+            pk_backend_job_set_status(ctx->job, PK_STATUS_ENUM_DEP_RESOLVE);
+            pk_backend_job_set_percentage(ctx->job, 0);
+            break;
+        case URPM_PROGRESS_DOWNLOADING:
+            pk_backend_job_set_status(ctx->job, PK_STATUS_ENUM_DOWNLOAD);
+            break;
+        case URPM_PROGRESS_INSTALLING:
             pk_backend_job_set_status(ctx->job, PK_STATUS_ENUM_INSTALL);
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (phase) {
+    case URPM_PROGRESS_DOWNLOADING:
+        /* Download is 0-50% of total progress, by bytes when known */
+        if (bytes_total > 0) {
+            guint64 done = MIN(bytes_done, bytes_total);
+
+            pk_backend_job_set_percentage(ctx->job,
+                                          (guint) (done * 50 / bytes_total));
+            pk_backend_job_set_download_size_remaining(ctx->job,
+                                                       bytes_total - done);
+        } else if (total > 0) {
+            pk_backend_job_set_percentage(ctx->job,
+                                          (guint) ((guint64) current * 50 / total));
         }
+        /* PackageKit wants bits per second */
+        pk_backend_job_set_speed(ctx->job, (guint) MIN(speed * 8, G_MAXUINT));
+        break;
+    case URPM_PROGRESS_INSTALLING:
         /* Install is 50-100% of total progress */
-        pk_backend_job_set_percentage(ctx->job, 50 + percentage / 2);
-    } else if (g_str_equal(phase, "resolving")) {
-        pk_backend_job_set_status(ctx->job, PK_STATUS_ENUM_DEP_RESOLVE);
-        pk_backend_job_set_percentage(ctx->job, 0);
+        if (total > 0)
+            pk_backend_job_set_percentage(ctx->job,
+                                          50 + (guint) ((guint64) current * 50 / total));
+        break;
+    default:
+        break;
     }
 }
 
@@ -501,7 +1167,8 @@ pk_backend_install_packages_thread(PkBackendJob *job, GVariant *params, gpointer
 
     g_message("pk_backend_install_packages_thread: starting (simulate=%d)", simulate);
 
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         g_warning("pk_backend_install_packages_thread: connection failed: %s", error->message);
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
@@ -536,7 +1203,7 @@ pk_backend_install_packages_thread(PkBackendJob *job, GVariant *params, gpointer
         g_message("pk_backend_install_packages_thread: calling PreviewInstall (simulate)");
 
         GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+            lease->proxy,
             "PreviewInstall",
             g_variant_new("(@as)", pkg_array),
             G_DBUS_CALL_FLAGS_NONE,
@@ -575,15 +1242,15 @@ pk_backend_install_packages_thread(PkBackendJob *job, GVariant *params, gpointer
         .error = NULL,
         .package_ids = package_ids,
         .signal_id = 0,
-        .in_download = FALSE
+        .phase = URPM_PROGRESS_UNKNOWN
     };
 
     /* Subscribe to progress signals */
     ctx.signal_id = g_dbus_connection_signal_subscribe(
-        priv->connection,
+        lease->connection,
         URPM_BUS_NAME,
         URPM_INTERFACE,
-        "OperationProgress",
+        "OperationProgressV2",
         URPM_OBJECT_PATH,
         NULL,
         G_DBUS_SIGNAL_FLAGS_NONE,
@@ -594,7 +1261,7 @@ pk_backend_install_packages_thread(PkBackendJob *job, GVariant *params, gpointer
 
     /* Make async call */
     g_dbus_proxy_call(
-        priv->proxy,
+        lease->proxy,
         "InstallPackages",
         g_variant_new("(@as@a{sv})",
                       pkg_array,
@@ -610,7 +1277,7 @@ pk_backend_install_packages_thread(PkBackendJob *job, GVariant *params, gpointer
     g_main_loop_run(ctx.loop);
 
     /* Unsubscribe from signals */
-    g_dbus_connection_signal_unsubscribe(priv->connection, ctx.signal_id);
+    g_dbus_connection_signal_unsubscribe(lease->connection, ctx.signal_id);
     g_main_loop_unref(ctx.loop);
     g_ptr_array_free(names, TRUE);
 
@@ -707,7 +1374,8 @@ pk_backend_remove_packages_thread(PkBackendJob *job, GVariant *params, gpointer
     }
 
     /* REAL mode: do the actual removal */
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
@@ -735,7 +1403,7 @@ pk_backend_remove_packages_thread(PkBackendJob *job, GVariant *params, gpointer
     GVariant *pkg_array = g_variant_builder_end(&builder);
 
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "RemovePackages",
         g_variant_new("(@as@a{sv})",
                       pkg_array,
@@ -811,7 +1479,8 @@ pk_backend_update_packages_thread(PkBackendJob *job, GVariant *params, gpointer
     }
 
     /* REAL mode: do the actual upgrade */
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
@@ -823,7 +1492,7 @@ pk_backend_update_packages_thread(PkBackendJob *job, GVariant *params, gpointer
     pk_backend_job_set_percentage(job, PK_BACKEND_PERCENTAGE_INVALID);
 
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "UpgradePackages",
         g_variant_new("(@a{sv})",
                       g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0)),
@@ -865,36 +1534,67 @@ pk_backend_update_packages(PkBackend *backend, PkBackendJob *job,
 /* Get Package Details                                                       */
 /* ========================================================================= */
 
-static void
-pk_backend_get_details_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+/*
+ * Package names of a job's package_ids, as a NULL-terminated array ready
+ * for g_variant_new("(^as)", ...).
+ */
+static GPtrArray *
+package_id_names(gchar **package_ids)
 {
-    gchar **package_ids;
-    GError *error = NULL;
-
-    g_variant_get(params, "(^a&s)", &package_ids);
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
-                                  "Cannot connect to urpm D-Bus service: %s",
-                                  error->message);
-        g_error_free(error);
-        return;
+    for (guint i = 0; package_ids[i] != NULL; i++) {
+        g_auto(GStrv) parts = pk_package_id_split(package_ids[i]);
+        if (parts != NULL && parts[0] != NULL)
+            g_ptr_array_add(names, g_strdup(parts[0]));
     }
+    g_ptr_array_add(names, NULL);
+    return names;
+}
 
-    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+static void
+emit_details_from_object(PkBackendJob *job, const gchar *package_id, JsonObject *pkg)
+{
+    const gchar *description = json_object_get_string_member_with_default(
+        pkg, "description", "");
+    const gchar *url = json_object_get_string_member_with_default(
+        pkg, "url", "");
+    const gchar *license = json_object_get_string_member_with_default(
+        pkg, "license", "");
+    gint64 size = json_object_get_int_member_with_default(
+        pkg, "size", 0);
+
+    pk_backend_job_details(job, package_id,
+                           NULL,  /* summary (already have from package) */
+                           license,
+                           PK_GROUP_ENUM_OTHER,
+                           description,
+                           url,
+                           (gulong)size,
+                           0);  /* download_size */
+}
 
-    for (guint i = 0; package_ids[i] != NULL; i++) {
+/* Fallback for services without GetPackagesInfo: one call per package */
+static void
+get_details_one_by_one(PkBackendJob *job, GDBusProxy *proxy, gchar **package_ids)
+{
+    GError *error = NULL;
+
+    GCancellable *cancellable = pk_backend_job_get_cancellable(job);
+
+    for (guint i = 0; package_ids[i] != NULL &&
+                      !g_cancellable_is_cancelled(cancellable); i++) {
         g_auto(GStrv) parts = pk_package_id_split(package_ids[i]);
         if (parts == NULL || parts[0] == NULL)
             continue;
 
         GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+            proxy,
             "GetPackageInfo",
             g_variant_new("(s)", parts[0]),
             G_DBUS_CALL_FLAGS_NONE,
             -1,
-            NULL,
+            cancellable,
             &error
         );
 
@@ -910,31 +1610,93 @@ pk_backend_get_details_thread(PkBackendJob *job, GVariant *params, gpointer user
         JsonParser *parser = json_parser_new();
         if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
             JsonNode *root = json_parser_get_root(parser);
-            if (JSON_NODE_HOLDS_OBJECT(root)) {
-                JsonObject *pkg = json_node_get_object(root);
-
-                const gchar *description = json_object_get_string_member_with_default(
-                    pkg, "description", "");
-                const gchar *url = json_object_get_string_member_with_default(
-                    pkg, "url", "");
-                const gchar *license = json_object_get_string_member_with_default(
-                    pkg, "license", "");
-                gint64 size = json_object_get_int_member_with_default(
-                    pkg, "size", 0);
-
-                pk_backend_job_details(job, package_ids[i],
-                                       NULL,  /* summary (already have from package) */
-                                       license,
-                                       PK_GROUP_ENUM_OTHER,
-                                       description,
-                                       url,
-                                       (gulong)size,
-                                       0);  /* download_size */
-            }
+            if (JSON_NODE_HOLDS_OBJECT(root))
+                emit_details_from_object(job, package_ids[i],
+                                         json_node_get_object(root));
         }
         g_object_unref(parser);
         g_variant_unref(result);
     }
+}
+
+static void
+pk_backend_get_details_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+    gchar **package_ids;
+    GError *error = NULL;
+
+    g_variant_get(params, "(^a&s)", &package_ids);
+
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
+                                  "Cannot connect to urpm D-Bus service: %s",
+                                  error->message);
+        g_error_free(error);
+        return;
+    }
+
+    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+
+    /* One GetPackagesInfo call for the whole job */
+    g_autoptr(GPtrArray) names = package_id_names(package_ids);
+
+    GVariant *result = g_dbus_proxy_call_sync(
+        lease->proxy,
+        "GetPackagesInfo",
+        g_variant_new("(^as)", (gchar **) names->pdata),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        pk_backend_job_get_cancellable(job),
+        &error
+    );
+
+    if (result == NULL) {
+        if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+            get_details_one_by_one(job, lease->proxy, package_ids);
+        else
+            g_warning("GetPackagesInfo failed: %s", error->message);
+        g_error_free(error);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    const gchar *json_str;
+    g_variant_get(result, "(&s)", &json_str);
+
+    JsonParser *parser = json_parser_new();
+    if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
+        JsonNode *root = json_parser_get_root(parser);
+        if (JSON_NODE_HOLDS_ARRAY(root)) {
+            /* Index by lowercased name: the service matches case-insensitively */
+            g_autoptr(GHashTable) by_name = g_hash_table_new_full(
+                g_str_hash, g_str_equal, g_free, NULL);
+            JsonArray *arr = json_node_get_array(root);
+            guint len = json_array_get_length(arr);
+
+            for (guint i = 0; i < len; i++) {
+                JsonObject *pkg = json_array_get_object_element(arr, i);
+                if (pkg == NULL)
+                    continue;
+                const gchar *name = json_object_get_string_member_with_default(pkg, "name", "");
+                g_hash_table_insert(by_name, g_utf8_strdown(name, -1), pkg);
+            }
+
+            for (guint i = 0; package_ids[i] != NULL; i++) {
+                g_auto(GStrv) parts = pk_package_id_split(package_ids[i]);
+                if (parts == NULL || parts[0] == NULL)
+                    continue;
+                g_autofree gchar *key = g_utf8_strdown(parts[0], -1);
+                JsonObject *pkg = g_hash_table_lookup(by_name, key);
+                if (pkg != NULL)
+                    emit_details_from_object(job, package_ids[i], pkg);
+            }
+        }
+    }
+    g_object_unref(parser);
+    g_variant_unref(result);
 
     pk_backend_job_finished(job);
 }
@@ -963,8 +1725,11 @@ pk_backend_resolve_thread(PkBackendJob *job, GVariant *params, gpointer user_dat
     for (guint i = 0; packages[i] != NULL; i++) pkg_count++;
     g_debug("pk_backend_resolve_thread: filters=0x%lx, %u packages", (unsigned long)filters, pkg_count);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
@@ -986,12 +1751,12 @@ pk_backend_resolve_thread(PkBackendJob *job, GVariant *params, gpointer user_dat
 
     /* Single D-Bus call for all packages */
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "ResolvePackages",
         g_variant_new("(@as)", g_variant_builder_end(&builder)),
         G_DBUS_CALL_FLAGS_NONE,
         300000,  /* 5 min timeout for large batches */
-        NULL,
+        pk_backend_job_get_cancellable(job),
         &error
     );
 
@@ -1073,71 +1838,295 @@ pk_backend_resolve(PkBackend *backend, PkBackendJob *job,
 /* Cancel                                                                    */
 /* ========================================================================= */
 
+/* Roles whose work runs in the service and must be stopped there */
+static gboolean
+role_runs_service_operation(PkRoleEnum role)
+{
+    switch (role) {
+    case PK_ROLE_ENUM_INSTALL_PACKAGES:
+    case PK_ROLE_ENUM_INSTALL_FILES:
+    case PK_ROLE_ENUM_REMOVE_PACKAGES:
+    case PK_ROLE_ENUM_UPDATE_PACKAGES:
+    case PK_ROLE_ENUM_REFRESH_CACHE:
+    case PK_ROLE_ENUM_DOWNLOAD_PACKAGES:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 void
 pk_backend_cancel(PkBackend *backend, PkBackendJob *job)
 {
-    /* Signal cancellation - the D-Bus service should handle this */
-    GError *error = NULL;
+    g_autoptr(GDBusProxy) proxy = NULL;
 
-    if (priv->proxy == NULL) {
-        pk_backend_job_finished(job);
+    /*
+     * Read roles pass the job's cancellable to their calls and to the
+     * lease queue, so this returns their thread right away; the late
+     * reply is dropped by GDBus.
+     */
+    g_cancellable_cancel(pk_backend_job_get_cancellable(job));
+
+    if (!role_runs_service_operation(pk_backend_job_get_role(job)))
         return;
-    }
 
-    /* Try to call CancelOperation on D-Bus service */
-    GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+    g_mutex_lock(&priv->lock);
+    if (priv->proxy != NULL)
+        proxy = g_object_ref(priv->proxy);
+    g_mutex_unlock(&priv->lock);
+
+    if (proxy == NULL)
+        return;
+
+    /* Best-effort, and without blocking the daemon's main loop: the
+     * job thread finishes once the service gives up the operation */
+    g_dbus_proxy_call(
+        proxy,
         "CancelOperation",
         NULL,
         G_DBUS_CALL_FLAGS_NONE,
         5000,
         NULL,
-        &error
+        NULL,
+        NULL
     );
+}
+
+/* ========================================================================= */
+/* Get Update Detail                                                         */
+/* ========================================================================= */
+
+static gchar *package_id_to_nevra(const gchar *package_id);
+
+/*
+ * Emit one update detail.  detail is an entry of the GetUpdateDetails
+ * reply, or NULL when the service has nothing for that package.
+ */
+static void
+emit_update_detail(PkBackendJob *job, const gchar *package_id, JsonObject *detail)
+{
+    PkRestartEnum restart = PK_RESTART_ENUM_NONE;
+    g_autofree gchar *issued = NULL;
+    g_autoptr(GString) changelog = g_string_new(NULL);
+    const gchar *update_text = "Update available";
+
+    if (detail != NULL) {
+        const gchar *hint = json_object_get_string_member_with_default(
+            detail, "restart", "none");
+        if (g_strcmp0(hint, "system") == 0)
+            restart = PK_RESTART_ENUM_SYSTEM;
+        else if (g_strcmp0(hint, "session") == 0)
+            restart = PK_RESTART_ENUM_SESSION;
+
+        gint64 issued_time = json_object_get_int_member_with_default(
+            detail, "issued", 0);
+        if (issued_time > 0) {
+            g_autoptr(GDateTime) dt = g_date_time_new_from_unix_utc(issued_time);
+            issued = g_date_time_format_iso8601(dt);
+        }
+
+        JsonArray *entries = json_object_has_member(detail, "changelog")
+            ? json_object_get_array_member(detail, "changelog") : NULL;
+        guint len = entries != NULL ? json_array_get_length(entries) : 0;
+        for (guint i = 0; i < len; i++) {
+            JsonObject *entry = json_array_get_object_element(entries, i);
+            if (entry == NULL)
+                continue;
+            g_autoptr(GDateTime) dt = g_date_time_new_from_unix_utc(
+                json_object_get_int_member_with_default(entry, "time", 0));
+            g_autofree gchar *date = g_date_time_format(dt, "%a %b %d %Y");
+            g_string_append_printf(changelog, "**%s** - %s\n%s\n\n", date,
+                json_object_get_string_member_with_default(entry, "author", ""),
+                json_object_get_string_member_with_default(entry, "text", ""));
+            /* Newest entry describes this update */
+            if (i == 0)
+                update_text = json_object_get_string_member_with_default(
+                    entry, "text", update_text);
+        }
+    }
+
+    pk_backend_job_update_detail(job, package_id,
+                                 NULL,  /* updates */
+                                 NULL,  /* obsoletes */
+                                 NULL,  /* vendor_urls */
+                                 NULL,  /* bugzilla_urls */
+                                 NULL,  /* cve_urls */
+                                 restart,
+                                 update_text,
+                                 changelog->len > 0 ? changelog->str : NULL,
+                                 PK_UPDATE_STATE_ENUM_STABLE,
+                                 issued,
+                                 NULL); /* updated */
+}
+
+static void
+pk_backend_get_update_detail_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+    gchar **package_ids;
+    GError *error = NULL;
+
+    g_variant_get(params, "(^a&s)", &package_ids);
+
+    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+
+    /*
+     * Malformed ids are left out of the request; reply_slot maps each
+     * package id to its entry in the reply, or -1.
+     */
+    guint n_ids = g_strv_length(package_ids);
+    g_autofree gint *reply_slot = g_new(gint, n_ids);
+    g_autoptr(GPtrArray) nevras = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < n_ids; i++) {
+        gchar *nevra = package_id_to_nevra(package_ids[i]);
+        if (nevra == NULL) {
+            g_debug("Skipping invalid package id %s", package_ids[i]);
+            reply_slot[i] = -1;
+            continue;
+        }
+        reply_slot[i] = (gint) nevras->len;
+        g_ptr_array_add(nevras, nevra);
+    }
+    g_ptr_array_add(nevras, NULL);
+
+    /* One GetUpdateDetails call for the whole job */
+    GVariant *result = NULL;
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease != NULL)
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
+            "GetUpdateDetails",
+            g_variant_new("(^as)", (gchar **) nevras->pdata),
+            G_DBUS_CALL_FLAGS_NONE,
+            30000,
+            pk_backend_job_get_cancellable(job),
+            &error
+        );
 
+    /* Older service or no hdlist data: still answer with a minimal detail */
+    JsonParser *parser = json_parser_new();
+    JsonArray *details = NULL;
     if (result != NULL) {
-        g_variant_unref(result);
+        const gchar *json_str;
+        g_variant_get(result, "(&s)", &json_str);
+        if (json_parser_load_from_data(parser, json_str, -1, NULL) &&
+            JSON_NODE_HOLDS_ARRAY(json_parser_get_root(parser)))
+            details = json_node_get_array(json_parser_get_root(parser));
     } else {
-        /* Cancellation is best-effort */
+        g_debug("GetUpdateDetails failed: %s", error->message);
         g_clear_error(&error);
     }
 
+    /* The reply is in request order, one entry per requested package */
+    for (guint i = 0; i < n_ids; i++) {
+        JsonObject *detail = NULL;
+        if (reply_slot[i] < 0)
+            continue;
+        if (details != NULL &&
+            (guint) reply_slot[i] < json_array_get_length(details))
+            detail = json_array_get_object_element(details, reply_slot[i]);
+        emit_update_detail(job, package_ids[i], detail);
+    }
+
+    g_object_unref(parser);
+    if (result != NULL)
+        g_variant_unref(result);
     pk_backend_job_finished(job);
 }
 
-/* ========================================================================= */
-/* Get Update Detail                                                         */
-/* ========================================================================= */
-
 void
 pk_backend_get_update_detail(PkBackend *backend, PkBackendJob *job,
                              gchar **package_ids)
 {
-    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
-
-    /* Return minimal update detail for each package */
-    for (guint i = 0; package_ids[i] != NULL; i++) {
-        pk_backend_job_update_detail(job, package_ids[i],
-                                     NULL,  /* updates */
-                                     NULL,  /* obsoletes */
-                                     NULL,  /* vendor_urls */
-                                     NULL,  /* bugzilla_urls */
-                                     NULL,  /* cve_urls */
-                                     PK_RESTART_ENUM_NONE,
-                                     "Update available",  /* update_text */
-                                     NULL,  /* changelog */
-                                     PK_UPDATE_STATE_ENUM_STABLE,
-                                     NULL,  /* issued */
-                                     NULL); /* updated */
-    }
-
-    pk_backend_job_finished(job);
+    pk_backend_job_thread_create(job, pk_backend_get_update_detail_thread, NULL, NULL);
 }
 
 /* ========================================================================= */
 /* Stubs for required but not-yet-implemented functions                      */
 /* ========================================================================= */
 
+/*
+ * Walk GetInstalledPackagesPagedV2, emitting each page as soon as it
+ * arrives so the client sees packages early and only one page is held in
+ * memory at a time.
+ */
+static gboolean
+emit_installed_paged(PkBackendJob *job, GDBusProxy *proxy, GError **error)
+{
+    g_autofree gchar *cursor = g_strdup("");
+
+    do {
+        GVariant *result = g_dbus_proxy_call_sync(
+            proxy,
+            "GetInstalledPackagesPagedV2",
+            g_variant_new("(su)", cursor, URPM_PAGE_SIZE),
+            G_DBUS_CALL_FLAGS_NONE,
+            120000,  /* 2 min timeout: the first page runs rpm -qa */
+            pk_backend_job_get_cancellable(job),
+            error
+        );
+        if (result == NULL)
+            return FALSE;
+
+        g_autoptr(GVariant) records = NULL;
+        const gchar *next_cursor;
+        guint32 offset, total;
+
+        g_variant_get(result, "(@a(sssssb)&suu)",
+                      &records, &next_cursor, &offset, &total);
+        emit_package_records(job, records, PK_INFO_ENUM_INSTALLED);
+
+        if (total > 0)
+            pk_backend_job_set_percentage(job,
+                (guint) (((guint64) offset + g_variant_n_children(records)) * 100 / total));
+
+        g_free(cursor);
+        cursor = g_strdup(next_cursor);
+        g_variant_unref(result);
+    } while (cursor[0] != '\0');
+
+    return TRUE;
+}
+
+/*
+ * Stream the available-package catalog, one ListPackagesV2 page at a
+ * time.  Pages are keyed by package name, so each is an indexed range
+ * query on the service side and only one page is held here at once.
+ */
+static gboolean
+emit_catalog_paged(PkBackendJob *job, GDBusProxy *proxy, PkBitfield filters,
+                   GError **error)
+{
+    g_autofree gchar *filter_str = pk_filter_bitfield_to_string(filters);
+    g_autofree gchar *key = g_strdup("");
+
+    do {
+        GVariant *result = g_dbus_proxy_call_sync(
+            proxy,
+            "ListPackagesV2",
+            g_variant_new("(ssu)", filter_str, key, URPM_PAGE_SIZE),
+            G_DBUS_CALL_FLAGS_NONE,
+            60000,
+            pk_backend_job_get_cancellable(job),
+            error
+        );
+        if (result == NULL)
+            return FALSE;
+
+        g_autoptr(GVariant) records = NULL;
+        const gchar *next_key;
+
+        g_variant_get(result, "(@a(sssssb)&s)", &records, &next_key);
+        emit_package_records(job, records, PK_INFO_ENUM_AVAILABLE);
+
+        g_free(key);
+        key = g_strdup(next_key);
+        g_variant_unref(result);
+    } while (key[0] != '\0');
+
+    return TRUE;
+}
+
 static void
 pk_backend_get_packages_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
 {
@@ -1146,74 +2135,88 @@ pk_backend_get_packages_thread(PkBackendJob *job, GVariant *params, gpointer use
 
     g_variant_get(params, "(t)", &filters);
 
-    /* Only support INSTALLED filter for now */
     if (!pk_bitfield_contain(filters, PK_FILTER_ENUM_INSTALLED)) {
-        /* For NOT_INSTALLED or no filter, we'd need to return all available packages
-           which could be huge. Just finish for now. */
-        pk_backend_job_finished(job);
-        return;
-    }
-
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
-                                  "Cannot connect to urpm D-Bus service: %s",
-                                  error->message);
-        g_error_free(error);
-        return;
-    }
+        /* Available packages: streamed page by page, not cached (the
+           listing can run to tens of thousands of packages) */
+        g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+            URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+        if (lease == NULL) {
+            pk_backend_job_error_code(job,
+                                      urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
+                                      "Cannot connect to urpm D-Bus service: %s",
+                                      error->message);
+            g_error_free(error);
+            return;
+        }
 
-    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+        pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
 
-    GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
-        "GetInstalledPackages",
-        NULL,
-        G_DBUS_CALL_FLAGS_NONE,
-        120000,  /* 2 min timeout */
-        NULL,
-        &error
-    );
+        if (!emit_catalog_paged(job, lease->proxy, filters, &error)) {
+            if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+                /* Older service without ListPackages: nothing to list */
+                g_clear_error(&error);
+            } else {
+                pk_backend_job_error_code(job,
+                                          urpm_error_enum(error, PK_ERROR_ENUM_INTERNAL_ERROR),
+                                          "ListPackages failed: %s", error->message);
+                g_error_free(error);
+                return;
+            }
+        }
 
-    if (result == NULL) {
-        g_warning("GetInstalledPackages failed: %s", error->message);
-        g_error_free(error);
         pk_backend_job_finished(job);
         return;
     }
 
-    const gchar *json_str;
-    g_variant_get(result, "(&s)", &json_str);
-
-    JsonParser *parser = json_parser_new();
-    if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
-        JsonNode *root = json_parser_get_root(parser);
-        if (JSON_NODE_HOLDS_ARRAY(root)) {
-            JsonArray *arr = json_node_get_array(root);
-            guint len = json_array_get_length(arr);
-
-            for (guint i = 0; i < len; i++) {
-                JsonObject *pkg = json_array_get_object_element(arr, i);
-                if (pkg == NULL)
-                    continue;
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
+                                  "Cannot connect to urpm D-Bus service: %s",
+                                  error->message);
+        g_error_free(error);
+        return;
+    }
 
-                const gchar *name = json_object_get_string_member_with_default(pkg, "name", "");
-                const gchar *version = json_object_get_string_member_with_default(pkg, "version", "");
-                const gchar *release = json_object_get_string_member_with_default(pkg, "release", "");
-                const gchar *arch = json_object_get_string_member_with_default(pkg, "arch", "");
-                const gchar *summary = json_object_get_string_member_with_default(pkg, "summary", "");
+    g_autofree gchar *cache_key = urpm_cache_key(job, filters);
+    g_autofree gchar *data_generation = urpm_data_generation(
+        lease->proxy, pk_backend_job_get_cancellable(job));
+    if (urpm_cache_replay(job, cache_key, data_generation)) {
+        pk_backend_job_finished(job);
+        return;
+    }
 
-                if (name[0] == '\0' || version[0] == '\0')
-                    continue;
+    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
 
-                g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
-                g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
+    guint generation = urpm_cache_record_begin();
+    if (!emit_installed_paged(job, lease->proxy, &error) &&
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+        /* Older service without paging: fetch the whole list at once */
+        g_clear_error(&error);
 
-                pk_backend_job_package(job, PK_INFO_ENUM_INSTALLED, package_id, summary);
-            }
+        GVariant *result = g_dbus_proxy_call_sync(
+            lease->proxy,
+            "GetInstalledPackages",
+            NULL,
+            G_DBUS_CALL_FLAGS_NONE,
+            120000,  /* 2 min timeout */
+            pk_backend_job_get_cancellable(job),
+            &error
+        );
+        if (result != NULL) {
+            const gchar *json_str;
+            g_variant_get(result, "(&s)", &json_str);
+            emit_packages_from_json(job, json_str, PK_INFO_ENUM_INSTALLED);
+            g_variant_unref(result);
         }
     }
-    g_object_unref(parser);
-    g_variant_unref(result);
+
+    urpm_cache_record_end(cache_key, generation, data_generation, error == NULL);
+    if (error != NULL) {
+        g_warning("GetInstalledPackages failed: %s", error->message);
+        g_error_free(error);
+    }
 
     pk_backend_job_finished(job);
 }
@@ -1234,8 +2237,11 @@ pk_backend_depends_on_thread(PkBackendJob *job, GVariant *params, gpointer user_
 
     g_variant_get(params, "(t^a&sb)", &filters, &package_ids, &recursive);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
@@ -1256,12 +2262,12 @@ pk_backend_depends_on_thread(PkBackendJob *job, GVariant *params, gpointer user_
         GVariant *pkg_array = g_variant_builder_end(&builder);
 
         GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+            lease->proxy,
             "PreviewInstall",
             g_variant_new("(@as)", pkg_array),
             G_DBUS_CALL_FLAGS_NONE,
             60000,
-            NULL,
+            pk_backend_job_get_cancellable(job),
             &error
         );
 
@@ -1330,8 +2336,11 @@ pk_backend_required_by_thread(PkBackendJob *job, GVariant *params, gpointer user
 
     g_variant_get(params, "(t^a&sb)", &filters, &package_ids, &recursive);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
@@ -1340,18 +2349,45 @@ pk_backend_required_by_thread(PkBackendJob *job, GVariant *params, gpointer user
 
     pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
 
-    for (guint i = 0; package_ids[i] != NULL; i++) {
-        g_auto(GStrv) parts = pk_package_id_split(package_ids[i]);
-        if (parts == NULL)
-            continue;
+    /* One WhatRequiresAny call, deduplicated by the service */
+    g_autoptr(GPtrArray) names = package_id_names(package_ids);
 
-        GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+    GVariant *result = g_dbus_proxy_call_sync(
+        lease->proxy,
+        "WhatRequiresAny",
+        g_variant_new("(^as)", (gchar **) names->pdata),
+        G_DBUS_CALL_FLAGS_NONE,
+        30000,
+        pk_backend_job_get_cancellable(job),
+        &error
+    );
+
+    if (result != NULL) {
+        const gchar *json_str;
+        g_variant_get(result, "(&s)", &json_str);
+        emit_packages_from_json(job, json_str, PK_INFO_ENUM_AVAILABLE);
+        g_variant_unref(result);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    if (!g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+        g_warning("WhatRequiresAny failed: %s", error->message);
+        g_error_free(error);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    /* Older service: one WhatRequires call per package */
+    g_clear_error(&error);
+    for (guint i = 0; i + 1 < names->len; i++) {
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
             "WhatRequires",
-            g_variant_new("(s)", parts[PK_PACKAGE_ID_NAME]),
+            g_variant_new("(s)", (const gchar *) g_ptr_array_index(names, i)),
             G_DBUS_CALL_FLAGS_NONE,
             30000,
-            NULL,
+            pk_backend_job_get_cancellable(job),
             &error
         );
 
@@ -1363,36 +2399,7 @@ pk_backend_required_by_thread(PkBackendJob *job, GVariant *params, gpointer user
 
         const gchar *json_str;
         g_variant_get(result, "(&s)", &json_str);
-
-        JsonParser *parser = json_parser_new();
-        if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
-            JsonNode *root = json_parser_get_root(parser);
-            if (JSON_NODE_HOLDS_ARRAY(root)) {
-                JsonArray *arr = json_node_get_array(root);
-                guint len = json_array_get_length(arr);
-
-                for (guint j = 0; j < len; j++) {
-                    JsonObject *pkg = json_array_get_object_element(arr, j);
-                    if (pkg == NULL)
-                        continue;
-
-                    const gchar *name = json_object_get_string_member_with_default(pkg, "name", "");
-                    const gchar *version = json_object_get_string_member_with_default(pkg, "version", "");
-                    const gchar *release = json_object_get_string_member_with_default(pkg, "release", "");
-                    const gchar *arch = json_object_get_string_member_with_default(pkg, "arch", "");
-                    const gchar *summary = json_object_get_string_member_with_default(pkg, "summary", "");
-
-                    if (name[0] == '\0')
-                        continue;
-
-                    g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
-                    g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
-
-                    pk_backend_job_package(job, PK_INFO_ENUM_AVAILABLE, package_id, summary);
-                }
-            }
-        }
-        g_object_unref(parser);
+        emit_packages_from_json(job, json_str, PK_INFO_ENUM_AVAILABLE);
         g_variant_unref(result);
     }
 
@@ -1406,43 +2413,59 @@ pk_backend_required_by(PkBackend *backend, PkBackendJob *job, PkBitfield filters
     pk_backend_job_thread_create(job, pk_backend_required_by_thread, NULL, NULL);
 }
 
+/* Build NEVRA from package_id parts: name-version-release.arch */
+static gchar *
+package_id_to_nevra(const gchar *package_id)
+{
+    g_auto(GStrv) parts = pk_package_id_split(package_id);
+    if (parts == NULL)
+        return NULL;
+
+    /* parts[0]=name, parts[1]=evr (version-release), parts[2]=arch */
+    return g_strdup_printf("%s-%s.%s",
+        parts[PK_PACKAGE_ID_NAME],
+        parts[PK_PACKAGE_ID_VERSION],
+        parts[PK_PACKAGE_ID_ARCH]);
+}
+
 static void
-pk_backend_get_files_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+emit_files_from_array(PkBackendJob *job, const gchar *package_id, JsonArray *arr)
 {
-    gchar **package_ids;
-    GError *error = NULL;
+    guint len = json_array_get_length(arr);
+
+    /* Build file list */
+    g_autoptr(GPtrArray) file_array = g_ptr_array_new_with_free_func(g_free);
+    for (guint j = 0; j < len; j++) {
+        const gchar *file_path = json_array_get_string_element(arr, j);
+        if (file_path)
+            g_ptr_array_add(file_array, g_strdup(file_path));
+    }
+    g_ptr_array_add(file_array, NULL);
 
-    g_variant_get(params, "(^a&s)", &package_ids);
+    pk_backend_job_files(job, package_id, (gchar **)file_array->pdata);
+}
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
-                                  "Cannot connect to urpm D-Bus service: %s",
-                                  error->message);
-        g_error_free(error);
-        return;
-    }
+/* Fallback for services without GetPackagesFiles: one call per package */
+static void
+get_files_one_by_one(PkBackendJob *job, GDBusProxy *proxy, gchar **package_ids)
+{
+    GError *error = NULL;
 
-    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+    GCancellable *cancellable = pk_backend_job_get_cancellable(job);
 
-    for (guint i = 0; package_ids[i] != NULL; i++) {
-        g_auto(GStrv) parts = pk_package_id_split(package_ids[i]);
-        if (parts == NULL)
+    for (guint i = 0; package_ids[i] != NULL &&
+                      !g_cancellable_is_cancelled(cancellable); i++) {
+        g_autofree gchar *nevra = package_id_to_nevra(package_ids[i]);
+        if (nevra == NULL)
             continue;
 
-        /* Build NEVRA from package_id parts: name-version-release.arch */
-        /* parts[0]=name, parts[1]=evr (version-release), parts[2]=arch */
-        g_autofree gchar *nevra = g_strdup_printf("%s-%s.%s",
-            parts[PK_PACKAGE_ID_NAME],
-            parts[PK_PACKAGE_ID_VERSION],
-            parts[PK_PACKAGE_ID_ARCH]);
-
         GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+            proxy,
             "GetPackageFiles",
             g_variant_new("(s)", nevra),
             G_DBUS_CALL_FLAGS_NONE,
             30000,
-            NULL,
+            cancellable,
             &error
         );
 
@@ -1459,25 +2482,86 @@ pk_backend_get_files_thread(PkBackendJob *job, GVariant *params, gpointer user_d
         JsonParser *parser = json_parser_new();
         if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
             JsonNode *root = json_parser_get_root(parser);
-            if (JSON_NODE_HOLDS_ARRAY(root)) {
-                JsonArray *arr = json_node_get_array(root);
-                guint len = json_array_get_length(arr);
-
-                /* Build file list */
-                g_autoptr(GPtrArray) file_array = g_ptr_array_new_with_free_func(g_free);
-                for (guint j = 0; j < len; j++) {
-                    const gchar *file_path = json_array_get_string_element(arr, j);
-                    if (file_path)
-                        g_ptr_array_add(file_array, g_strdup(file_path));
-                }
-                g_ptr_array_add(file_array, NULL);
-
-                pk_backend_job_files(job, package_ids[i], (gchar **)file_array->pdata);
-            }
+            if (JSON_NODE_HOLDS_ARRAY(root))
+                emit_files_from_array(job, package_ids[i], json_node_get_array(root));
         }
         g_object_unref(parser);
         g_variant_unref(result);
     }
+}
+
+static void
+pk_backend_get_files_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+    gchar **package_ids;
+    GError *error = NULL;
+
+    g_variant_get(params, "(^a&s)", &package_ids);
+
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
+                                  "Cannot connect to urpm D-Bus service: %s",
+                                  error->message);
+        g_error_free(error);
+        return;
+    }
+
+    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+
+    /* One GetPackagesFiles call: a single pass over the media file lists */
+    g_autoptr(GPtrArray) nevras = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; package_ids[i] != NULL; i++) {
+        gchar *nevra = package_id_to_nevra(package_ids[i]);
+        if (nevra != NULL)
+            g_ptr_array_add(nevras, nevra);
+    }
+    g_ptr_array_add(nevras, NULL);
+
+    GVariant *result = g_dbus_proxy_call_sync(
+        lease->proxy,
+        "GetPackagesFiles",
+        g_variant_new("(^as)", (gchar **) nevras->pdata),
+        G_DBUS_CALL_FLAGS_NONE,
+        30000,
+        pk_backend_job_get_cancellable(job),
+        &error
+    );
+
+    if (result == NULL) {
+        if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+            get_files_one_by_one(job, lease->proxy, package_ids);
+        else
+            g_warning("GetPackagesFiles failed: %s", error->message);
+        g_error_free(error);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    const gchar *json_str;
+    g_variant_get(result, "(&s)", &json_str);
+
+    /* Parse JSON object {nevra: [file paths]} */
+    JsonParser *parser = json_parser_new();
+    if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
+        JsonNode *root = json_parser_get_root(parser);
+        if (JSON_NODE_HOLDS_OBJECT(root)) {
+            JsonObject *by_nevra = json_node_get_object(root);
+
+            for (guint i = 0; package_ids[i] != NULL; i++) {
+                g_autofree gchar *nevra = package_id_to_nevra(package_ids[i]);
+                if (nevra == NULL || !json_object_has_member(by_nevra, nevra))
+                    continue;
+                JsonArray *arr = json_object_get_array_member(by_nevra, nevra);
+                if (arr != NULL)
+                    emit_files_from_array(job, package_ids[i], arr);
+            }
+        }
+    }
+    g_object_unref(parser);
+    g_variant_unref(result);
 
     pk_backend_job_finished(job);
 }
@@ -1497,7 +2581,8 @@ pk_backend_download_packages_thread(PkBackendJob *job, GVariant *params, gpointe
 
     g_variant_get(params, "(^a&s&s)", &package_ids, &directory);
 
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
@@ -1518,7 +2603,7 @@ pk_backend_download_packages_thread(PkBackendJob *job, GVariant *params, gpointe
     }
 
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "DownloadPackages",
         g_variant_new("(@ass)", g_variant_builder_end(&builder), directory),
         G_DBUS_CALL_FLAGS_NONE,
@@ -1600,7 +2685,8 @@ pk_backend_install_files_thread(PkBackendJob *job, GVariant *params, gpointer us
         return;
     }
 
-    if (!ensure_connection(job, &error)) {
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(URPM_ROLE_WRITE, NULL, &error);
+    if (lease == NULL) {
         pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
@@ -1618,7 +2704,7 @@ pk_backend_install_files_thread(PkBackendJob *job, GVariant *params, gpointer us
     }
 
     GVariant *result = g_dbus_proxy_call_sync(
-        priv->proxy,
+        lease->proxy,
         "InstallFiles",
         g_variant_new("(@as)", g_variant_builder_end(&builder)),
         G_DBUS_CALL_FLAGS_NONE,
@@ -1665,12 +2751,80 @@ pk_backend_install_files(PkBackend *backend, PkBackendJob *job,
     pk_backend_job_thread_create(job, pk_backend_install_files_thread, NULL, NULL);
 }
 
+static void
+pk_backend_what_provides_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+    PkBitfield filters;
+    gchar **values;
+    GError *error = NULL;
+
+    g_variant_get(params, "(t^a&s)", &filters, &values);
+
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
+                                  "Cannot connect to urpm D-Bus service: %s",
+                                  error->message);
+        g_error_free(error);
+        return;
+    }
+
+    pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
+
+    PkInfoEnum info = PK_INFO_ENUM_AVAILABLE;
+    if (pk_bitfield_contain(filters, PK_FILTER_ENUM_INSTALLED))
+        info = PK_INFO_ENUM_INSTALLED;
+
+    /* Indexed lookup on the provides name, all values in one call */
+    GVariant *result = g_dbus_proxy_call_sync(
+        lease->proxy,
+        "WhatProvides",
+        g_variant_new("(^as)", values),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        pk_backend_job_get_cancellable(job),
+        &error
+    );
+
+    if (result == NULL &&
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+        /* Older service: substring search including provides */
+        g_clear_error(&error);
+        g_autofree gchar *pattern = g_strjoinv(" ", values);
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
+            "SearchPackages",
+            g_variant_new("(sb)", pattern, TRUE),
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            pk_backend_job_get_cancellable(job),
+            &error
+        );
+    }
+
+    if (result == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_INTERNAL_ERROR),
+                                  "WhatProvides failed: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    const gchar *json_str;
+    g_variant_get(result, "(&s)", &json_str);
+    emit_packages_from_json(job, json_str, info);
+
+    g_variant_unref(result);
+    pk_backend_job_finished(job);
+}
+
 void
 pk_backend_what_provides(PkBackend *backend, PkBackendJob *job,
                          PkBitfield filters, gchar **values)
 {
-    /* Use search with provides flag */
-    pk_backend_job_thread_create(job, pk_backend_search_thread, NULL, NULL);
+    pk_backend_job_thread_create(job, pk_backend_what_provides_thread, NULL, NULL);
 }
 
 void
@@ -1681,6 +2835,68 @@ pk_backend_search_groups(PkBackend *backend, PkBackendJob *job,
     pk_backend_job_finished(job);
 }
 
+/*
+ * Emit the packages owning the files of a SearchFiles/SearchFilesAny
+ * reply, skipping NEVRAs already in @seen.
+ */
+static void
+emit_file_owners_from_json(PkBackendJob *job, const gchar *json_str, GHashTable *seen)
+{
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, json_str, -1, NULL)) {
+        g_object_unref(parser);
+        return;
+    }
+
+    JsonNode *root = json_parser_get_root(parser);
+    if (!JSON_NODE_HOLDS_ARRAY(root)) {
+        g_object_unref(parser);
+        return;
+    }
+
+    JsonArray *arr = json_node_get_array(root);
+    guint len = json_array_get_length(arr);
+
+    for (guint j = 0; j < len; j++) {
+        JsonObject *file_info = json_array_get_object_element(arr, j);
+        if (file_info == NULL)
+            continue;
+
+        const gchar *pkg_nevra = json_object_get_string_member_with_default(
+            file_info, "pkg_nevra", "");
+
+        /* Skip if already emitted */
+        if (g_hash_table_contains(seen, pkg_nevra))
+            continue;
+        g_hash_table_add(seen, g_strdup(pkg_nevra));
+
+        /* Parse NEVRA: name-version-release.arch */
+        g_autofree gchar *nevra_copy = g_strdup(pkg_nevra);
+        gchar *arch_sep = g_strrstr(nevra_copy, ".");
+        if (!arch_sep) continue;
+        *arch_sep = '\0';
+        const gchar *arch = arch_sep + 1;
+
+        gchar *rel_sep = g_strrstr(nevra_copy, "-");
+        if (!rel_sep) continue;
+        *rel_sep = '\0';
+        const gchar *release = rel_sep + 1;
+
+        gchar *ver_sep = g_strrstr(nevra_copy, "-");
+        if (!ver_sep) continue;
+        *ver_sep = '\0';
+        const gchar *version = ver_sep + 1;
+        const gchar *name = nevra_copy;
+
+        g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
+        g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
+
+        pk_backend_job_package(job, PK_INFO_ENUM_AVAILABLE, package_id, "");
+    }
+
+    g_object_unref(parser);
+}
+
 static void
 pk_backend_search_files_thread(PkBackendJob *job, GVariant *params, gpointer user_data)
 {
@@ -1690,8 +2906,11 @@ pk_backend_search_files_thread(PkBackendJob *job, GVariant *params, gpointer use
 
     g_variant_get(params, "(t^a&s)", &filters, &values);
 
-    if (!ensure_connection(job, &error)) {
-        pk_backend_job_error_code(job, PK_ERROR_ENUM_CANNOT_GET_LOCK,
+    g_autoptr(UrpmProxyLease) lease = urpm_proxy_acquire(
+        URPM_ROLE_READ, pk_backend_job_get_cancellable(job), &error);
+    if (lease == NULL) {
+        pk_backend_job_error_code(job,
+                                  urpm_error_enum(error, PK_ERROR_ENUM_CANNOT_GET_LOCK),
                                   "Cannot connect to urpm D-Bus service: %s",
                                   error->message);
         g_error_free(error);
@@ -1700,15 +2919,46 @@ pk_backend_search_files_thread(PkBackendJob *job, GVariant *params, gpointer use
 
     pk_backend_job_set_status(job, PK_STATUS_ENUM_QUERY);
 
-    /* Search for each pattern */
+    /* Track emitted packages across all patterns to avoid duplicates */
+    g_autoptr(GHashTable) seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    /* All patterns in one SearchFilesAny scan */
+    GVariant *result = g_dbus_proxy_call_sync(
+        lease->proxy,
+        "SearchFilesAny",
+        g_variant_new("(^as)", values),
+        G_DBUS_CALL_FLAGS_NONE,
+        30000,
+        pk_backend_job_get_cancellable(job),
+        &error
+    );
+
+    if (result != NULL) {
+        const gchar *json_str;
+        g_variant_get(result, "(&s)", &json_str);
+        emit_file_owners_from_json(job, json_str, seen);
+        g_variant_unref(result);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    if (!g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+        g_warning("SearchFilesAny failed: %s", error->message);
+        g_error_free(error);
+        pk_backend_job_finished(job);
+        return;
+    }
+
+    /* Older service: search for each pattern */
+    g_clear_error(&error);
     for (guint i = 0; values[i] != NULL; i++) {
-        GVariant *result = g_dbus_proxy_call_sync(
-            priv->proxy,
+        result = g_dbus_proxy_call_sync(
+            lease->proxy,
             "SearchFiles",
             g_variant_new("(s)", values[i]),
             G_DBUS_CALL_FLAGS_NONE,
             30000,
-            NULL,
+            pk_backend_job_get_cancellable(job),
             &error
         );
 
@@ -1720,59 +2970,7 @@ pk_backend_search_files_thread(PkBackendJob *job, GVariant *params, gpointer use
 
         const gchar *json_str;
         g_variant_get(result, "(&s)", &json_str);
-
-        /* Parse results and emit packages */
-        JsonParser *parser = json_parser_new();
-        if (json_parser_load_from_data(parser, json_str, -1, NULL)) {
-            JsonNode *root = json_parser_get_root(parser);
-            if (JSON_NODE_HOLDS_ARRAY(root)) {
-                JsonArray *arr = json_node_get_array(root);
-                guint len = json_array_get_length(arr);
-
-                /* Track emitted packages to avoid duplicates */
-                GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-
-                for (guint j = 0; j < len; j++) {
-                    JsonObject *file_info = json_array_get_object_element(arr, j);
-                    if (file_info == NULL)
-                        continue;
-
-                    const gchar *pkg_nevra = json_object_get_string_member_with_default(
-                        file_info, "pkg_nevra", "");
-
-                    /* Skip if already emitted */
-                    if (g_hash_table_contains(seen, pkg_nevra))
-                        continue;
-                    g_hash_table_add(seen, g_strdup(pkg_nevra));
-
-                    /* Parse NEVRA: name-version-release.arch */
-                    g_autofree gchar *nevra_copy = g_strdup(pkg_nevra);
-                    gchar *arch_sep = g_strrstr(nevra_copy, ".");
-                    if (!arch_sep) continue;
-                    *arch_sep = '\0';
-                    const gchar *arch = arch_sep + 1;
-
-                    gchar *rel_sep = g_strrstr(nevra_copy, "-");
-                    if (!rel_sep) continue;
-                    *rel_sep = '\0';
-                    const gchar *release = rel_sep + 1;
-
-                    gchar *ver_sep = g_strrstr(nevra_copy, "-");
-                    if (!ver_sep) continue;
-                    *ver_sep = '\0';
-                    const gchar *version = ver_sep + 1;
-                    const gchar *name = nevra_copy;
-
-                    g_autofree gchar *evr = g_strdup_printf("%s-%s", version, release);
-                    g_autofree gchar *package_id = pk_package_id_build(name, evr, arch, "urpm");
-
-                    pk_backend_job_package(job, PK_INFO_ENUM_AVAILABLE, package_id, "");
-                }
-
-                g_hash_table_destroy(seen);
-            }
-        }
-        g_object_unref(parser);
+        emit_file_owners_from_json(job, json_str, seen);
         g_variant_unref(result);
     }
 
@@ -919,11 +919,15 @@ def cmd_install(args, db: 'PackageDatabase') -> int:
     cached = 0
     peer_stats = {}
 
+    from ...core.config import get_rpm_root
+    rpm_root = get_rpm_root(getattr(args, 'root', None), getattr(args, 'urpm_root', None))
+
     if download_items:
         print(colors.info(_("\nDownloading packages...")))
         dl_opts = InstallOptions(
             use_peers=not getattr(args, 'no_peers', False),
             only_peers=getattr(args, 'only_peers', False),
+            root=rpm_root or "/",
         )
 
         # Multi-line progress display using DownloadProgressDisplay
@@ -946,7 +950,8 @@ def cmd_install(args, db: 'PackageDatabase') -> int:
         download_start = time.time()
         dl_results, downloaded, cached, peer_stats = ops.download_packages(
             download_items, options=dl_opts, progress_callback=progress,
-            urpm_root=getattr(args, 'urpm_root', None)
+            urpm_root=getattr(args, 'urpm_root', None),
+            verify_ahead=not getattr(args, 'nosignature', False)
         )
         download_elapsed = time.time() - download_start
         progress_display.finish()
@@ -1023,8 +1028,6 @@ def cmd_install(args, db: 'PackageDatabase') -> int:
                 )
             ))
 
-    from ...core.config import get_rpm_root
-    rpm_root = get_rpm_root(getattr(args, 'root', None), getattr(args, 'urpm_root', None))
     install_opts = InstallOptions(
         verify_signatures=not getattr(args, 'nosignature', False),
         force=getattr(args, 'force', False),
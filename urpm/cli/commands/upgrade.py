@@ -319,6 +319,9 @@ def cmd_upgrade(args, db: 'PackageDatabase') -> int:
     dl_results = []
     downloaded = 0
 
+    from ...core.config import get_rpm_root
+    rpm_root = get_rpm_root(getattr(args, 'root', None), getattr(args, 'urpm_root', None))
+
     if download_items:
         print("\n" + ngettext(
             "Downloading {count} package...",
@@ -327,6 +330,7 @@ def cmd_upgrade(args, db: 'PackageDatabase') -> int:
         dl_opts = InstallOptions(
             use_peers=not getattr(args, 'no_peers', False),
             only_peers=getattr(args, 'only_peers', False),
+            root=rpm_root or "/",
         )
 
         # Multi-line progress display using DownloadProgressDisplay
@@ -347,7 +351,8 @@ def cmd_upgrade(args, db: 'PackageDatabase') -> int:
         download_start = time.time()
         dl_results, downloaded, cached, peer_stats = ops.download_packages(
             download_items, options=dl_opts, progress_callback=progress,
-            urpm_root=getattr(args, 'urpm_root', None)
+            urpm_root=getattr(args, 'urpm_root', None),
+            verify_ahead=not getattr(args, 'nosignature', False)
         )
         download_elapsed = time.time() - download_start
         progress_display.finish()
@@ -428,8 +433,6 @@ def cmd_upgrade(args, db: 'PackageDatabase') -> int:
         cmd_line = "urpm update " + " ".join(package_names)
     transaction_id = ops.begin_transaction('upgrade', cmd_line, all_record_actions)
 
-    from ...core.config import get_rpm_root
-    rpm_root = get_rpm_root(getattr(args, 'root', None), getattr(args, 'urpm_root', None))
     upgrade_opts = InstallOptions(
         verify_signatures=not getattr(args, 'nosignature', False),
         force=getattr(args, 'force', False),
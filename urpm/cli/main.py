@@ -322,6 +322,12 @@ def create_parser() -> argparse.ArgumentParser:
         metavar='PACKAGES',
         help=_('Watch specific packages during resolution (comma-separated)')
     )
+    debug_parent.add_argument(
+        '--profile-resolve',
+        action='store_true',
+        help=_('Report time and allocations per resolver phase on stderr '
+               'at exit (JSON with --json)')
+    )
 
     # Parent parser for --arch (inherited by init/download/image/media/...)
     arch_parent = argparse.ArgumentParser(add_help=False)
@@ -2428,6 +2434,11 @@ def main(argv=None) -> int:
             parser.print_help()
             return 1
 
+    profile_resolve = getattr(args, 'profile_resolve', False)
+    if profile_resolve:
+        from ..core.resolver import set_solver_debug
+        set_solver_debug(profile=True)
+
     # Open database for command execution
     db = PackageDatabase(db_path=db_path)
 
@@ -2671,6 +2682,21 @@ def main(argv=None) -> int:
 
     finally:
         db.close()
+        if profile_resolve:
+            _report_resolve_profile(args)
+
+
+def _report_resolve_profile(args):
+    """Print the --profile-resolve report on stderr."""
+    from ..core.resolver import get_solver_debug
+
+    debug = get_solver_debug()
+    if getattr(args, 'json', False):
+        import json
+        report = {'command': args.command, **debug.profile.to_dict()}
+        print(json.dumps(report), file=sys.stderr)
+    else:
+        debug.log_profile()
 
 
 if __name__ == '__main__':
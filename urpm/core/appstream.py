@@ -6,14 +6,29 @@ This module handles:
 - Generating degraded AppStream from package metadata (fallback)
 - Merging per-media AppStream files into unified catalog
 - Refreshing system AppStream cache
+
+Both steps are incremental.  Generated components are cached per media
+(``<media>.fragments.json``), keyed by NEVRA, so a refresh only builds
+the packages that changed.  The merge keeps the components of each
+per-media file (``.merge/``) and only re-parses files that changed; an
+unchanged catalog is not rewritten and the system cache is not
+refreshed, so GNOME Software does not reload it for nothing.  A rewrite
+leaves a refresh pending in the merge state until
+:meth:`AppStreamManager.refresh_system_cache` succeeds, so a failed or
+interrupted refresh is retried by the next merge.
 """
 
 import gzip
+import hashlib
+import json
 import logging
 import lzma
+import os
 import subprocess
+import time
 import xml.etree.ElementTree as ET
-from dataclasses import dataclass
+from dataclasses import dataclass, field
+from xml.sax.saxutils import quoteattr
 from pathlib import Path
 from typing import TYPE_CHECKING, Callable, Dict, List, Optional, Tuple
 from urllib.error import HTTPError, URLError
@@ -96,6 +111,13 @@ GROUP_TO_CATEGORY = {
 }
 
 
+# Bump when generate_for_media() output changes, to drop cached fragments
+GENERATOR_VERSION = 1
+
+MERGE_STATE_FILE = '.merge-state.json'
+MERGE_BLOCKS_DIR = '.merge'
+
+
 @dataclass
 class AppStreamSyncResult:
     """Result of syncing AppStream for a media."""
@@ -104,6 +126,43 @@ class AppStreamSyncResult:
     source: str  # 'upstream', 'generated', 'failed'
     component_count: int
     error: Optional[str] = None
+    unchanged: bool = False         # per-media file left as it was
+    fragments_reused: int = 0       # generated: components from the cache
+    fragments_generated: int = 0    # generated: components built anew
+    elapsed_ms: float = 0.0
+
+
+@dataclass
+class AppStreamMergeResult:
+    """Result of merging the per-media files into the system catalog."""
+    total_components: int
+    media_count: int
+    changed: bool = False           # catalog rewritten
+    needs_refresh: bool = False     # rewritten, or an earlier refresh failed
+    media_reparsed: int = 0
+    media_reused: int = 0
+    elapsed_ms: float = 0.0
+    timings_ms: Dict[str, float] = field(default_factory=dict)
+
+
+def _write_atomic(path: Path, text: str) -> None:
+    """Replace ``path`` with ``text`` so readers never see a partial file."""
+    tmp = path.with_name(path.name + '.tmp')
+    with open(tmp, 'w', encoding='utf-8') as f:
+        f.write(text)
+    os.replace(tmp, path)
+
+
+def _write_if_changed(path: Path, text: str) -> bool:
+    """Write ``text`` to ``path`` unless it already holds it; True if written."""
+    try:
+        with open(path, encoding='utf-8') as f:
+            if f.read() == text:
+                return False
+    except (OSError, UnicodeDecodeError):
+        pass
+    _write_atomic(path, text)
+    return True
 
 
 class AppStreamManager:
@@ -136,6 +195,29 @@ class AppStreamManager:
         """Get path for a media's AppStream file."""
         return self.appstream_dir / f"{self._sanitize_filename(media_name)}.xml"
 
+    def get_fragments_path(self, media_name: str) -> Path:
+        """Get path of a media's cache of generated components."""
+        return self.appstream_dir / f"{self._sanitize_filename(media_name)}.fragments.json"
+
+    def _load_fragments(self, media_name: str) -> Dict[str, Optional[str]]:
+        try:
+            with open(self.get_fragments_path(media_name), encoding='utf-8') as f:
+                data = json.load(f)
+        except (OSError, ValueError):
+            return {}
+        if not isinstance(data, dict) or data.get('version') != GENERATOR_VERSION:
+            return {}
+        return data.get('fragments') or {}
+
+    def _save_fragments(self, media_name: str, fragments: Dict[str, Optional[str]]):
+        path = self.get_fragments_path(media_name)
+        try:
+            self._ensure_dirs()
+            _write_atomic(path, json.dumps(
+                {'version': GENERATOR_VERSION, 'fragments': fragments}))
+        except OSError as e:
+            logger.debug(f"Cannot save AppStream fragments for {media_name}: {e}")
+
     def generate_for_media(
         self,
         media_id: int,
@@ -148,6 +230,9 @@ class AppStreamManager:
         This creates a "degraded" AppStream that only includes basic info
         from the synthesis (name, summary, description, group).
 
+        Components of packages already seen (same NEVRA) come from the
+        media's fragment cache; only new packages are built.
+
         Args:
             media_id: Database ID of the media
             media_name: Name of the media (for origin attribute)
@@ -156,90 +241,116 @@ class AppStreamManager:
         Returns:
             Tuple of (xml_string, component_count)
         """
+        xml_str, pkg_count, _reused, _generated = self._generate_incremental(
+            media_id, media_name, origin)
+        return xml_str, pkg_count
+
+    def _generate_incremental(
+        self,
+        media_id: int,
+        media_name: str,
+        origin: Optional[str] = None
+    ) -> Tuple[str, int, int, int]:
+        """:meth:`generate_for_media` plus (reused, generated) counts."""
         if origin is None:
             origin = f"mageia-{self._sanitize_filename(media_name)}"
 
-        # Create root element
-        root = ET.Element('components')
-        root.set('version', '0.16')
-        root.set('origin', origin)
+        cached = self._load_fragments(media_name)
+        # NEVRA -> component XML, or None for a package that is not an app
+        fragments: Dict[str, Optional[str]] = {}
+        parts: List[str] = []
+        reused = generated = 0
 
         conn = self.db._get_connection()
         cursor = conn.cursor()
 
         cursor.execute('''
             SELECT DISTINCT
-                p.name, p.version, p.release, p.arch,
-                p.summary, p.description, p.url, p.license,
-                p.size, p.group_name
+                p.nevra, p.name, p.summary, p.description, p.url, p.license,
+                p.group_name
             FROM packages p
             WHERE p.media_id = ?
             ORDER BY p.name
         ''', (media_id,))
 
-        pkg_count = 0
-        for row in cursor.fetchall():
-            name, ver, release, arch, summary, description, url, license_, size, group_name = row
-
-            # Skip non-application packages
-            if name.endswith(('-debug', '-debuginfo', '-devel', '-static', '-doc', '-docs')):
-                continue
-            if name.startswith(('lib', 'perl-', 'python-', 'python3-', 'ruby-', 'golang-', 'rust-')):
-                continue
-            if name.endswith(('-libs', '-common', '-data', '-lang', '-l10n', '-i18n')):
-                continue
-
-            # Filter by group - only desktop applications
-            group_lower = (group_name or '').lower()
-            if not any(group_lower.startswith(g) or group_lower == g for g in DESKTOP_GROUPS):
-                continue
-
-            # Create component as desktop-application
-            component = ET.SubElement(root, 'component')
-            component.set('type', 'desktop-application')
-
-            # Desktop ID (AppStream spec requires .desktop suffix)
-            desktop_id = f'{name}.desktop'
-            ET.SubElement(component, 'id').text = desktop_id
-            ET.SubElement(component, 'pkgname').text = name
-            ET.SubElement(component, 'name').text = name
-            ET.SubElement(component, 'summary').text = summary or f'{name} application'
-
-            # Launchable (desktop file reference)
-            launchable = ET.SubElement(component, 'launchable')
-            launchable.set('type', 'desktop-id')
-            launchable.text = desktop_id
-
-            if description:
-                desc_elem = ET.SubElement(component, 'description')
-                p_elem = ET.SubElement(desc_elem, 'p')
-                p_elem.text = description[:500]
-
-            if url:
-                url_elem = ET.SubElement(component, 'url')
-                url_elem.set('type', 'homepage')
-                url_elem.text = url
-
-            if license_:
-                ET.SubElement(component, 'project_license').text = license_
-
-            # Category from group mapping
-            categories = ET.SubElement(component, 'categories')
-            category = GROUP_TO_CATEGORY.get(group_lower, 'Utility')
-            ET.SubElement(categories, 'category').text = category
-
-            # Icon - use package name as stock icon
-            icon = ET.SubElement(component, 'icon')
-            icon.set('type', 'stock')
-            icon.text = name
-
-            pkg_count += 1
-
-        # Generate XML string
-        xml_str = ET.tostring(root, encoding='unicode')
-        xml_str = '<?xml version="1.0" encoding="UTF-8"?>\n' + xml_str
-
-        return xml_str, pkg_count
+        for nevra, *row in cursor.fetchall():
+            if nevra in cached:
+                fragment = cached[nevra]
+                if fragment is not None:
+                    reused += 1
+            else:
+                fragment = self._build_component(*row)
+                if fragment is not None:
+                    generated += 1
+            fragments[nevra] = fragment
+            if fragment is not None:
+                parts.append(fragment)
+
+        if fragments != cached:
+            self._save_fragments(media_name, fragments)
+
+        xml_str = (f'<?xml version="1.0" encoding="UTF-8"?>\n'
+                   f'<components version="0.16" origin={quoteattr(origin)}>'
+                   + ''.join(parts) + '</components>')
+        return xml_str, len(parts), reused, generated
+
+    @staticmethod
+    def _build_component(name, summary, description, url, license_,
+                         group_name) -> Optional[str]:
+        """Serialized <component> for one package, None if not an app."""
+        # Skip non-application packages
+        if name.endswith(('-debug', '-debuginfo', '-devel', '-static', '-doc', '-docs')):
+            return None
+        if name.startswith(('lib', 'perl-', 'python-', 'python3-', 'ruby-', 'golang-', 'rust-')):
+            return None
+        if name.endswith(('-libs', '-common', '-data', '-lang', '-l10n', '-i18n')):
+            return None
+
+        # Filter by group - only desktop applications
+        group_lower = (group_name or '').lower()
+        if not any(group_lower.startswith(g) or group_lower == g for g in DESKTOP_GROUPS):
+            return None
+
+        # Create component as desktop-application
+        component = ET.Element('component')
+        component.set('type', 'desktop-application')
+
+        # Desktop ID (AppStream spec requires .desktop suffix)
+        desktop_id = f'{name}.desktop'
+        ET.SubElement(component, 'id').text = desktop_id
+        ET.SubElement(component, 'pkgname').text = name
+        ET.SubElement(component, 'name').text = name
+        ET.SubElement(component, 'summary').text = summary or f'{name} application'
+
+        # Launchable (desktop file reference)
+        launchable = ET.SubElement(component, 'launchable')
+        launchable.set('type', 'desktop-id')
+        launchable.text = desktop_id
+
+        if description:
+            desc_elem = ET.SubElement(component, 'description')
+            p_elem = ET.SubElement(desc_elem, 'p')
+            p_elem.text = description[:500]
+
+        if url:
+            url_elem = ET.SubElement(component, 'url')
+            url_elem.set('type', 'homepage')
+            url_elem.text = url
+
+        if license_:
+            ET.SubElement(component, 'project_license').text = license_
+
+        # Category from group mapping
+        categories = ET.SubElement(component, 'categories')
+        category = GROUP_TO_CATEGORY.get(group_lower, 'Utility')
+        ET.SubElement(categories, 'category').text = category
+
+        # Icon - use package name as stock icon
+        icon = ET.SubElement(component, 'icon')
+        icon.set('type', 'stock')
+        icon.text = name
+
+        return ET.tostring(component, encoding='unicode')
 
     def sync_media_appstream(
         self,
@@ -265,12 +376,16 @@ class AppStreamManager:
         """
         self._ensure_dirs()
         output_path = self.get_media_appstream_path(media_name)
+        start = time.monotonic()
 
         def log(msg: str):
             if progress_callback:
                 progress_callback(msg)
             logger.info(msg)
 
+        def elapsed_ms() -> float:
+            return (time.monotonic() - start) * 1000
+
         # Try to download from upstream
         appstream_url = media_url.rstrip('/') + '/media_info/appstream.xml.lzma'
 
@@ -300,15 +415,19 @@ class AppStreamManager:
                         component_count = 0
 
                     # Save to file
-                    with open(output_path, 'w', encoding='utf-8') as f:
-                        f.write(xml_data)
+                    written = _write_if_changed(output_path, xml_data)
+                    # Upstream data replaces generated components
+                    self.get_fragments_path(media_name).unlink(missing_ok=True)
 
-                    log(f"Downloaded AppStream for {media_name}: {component_count} components")
+                    log(f"Downloaded AppStream for {media_name}: {component_count} components"
+                        + ("" if written else " (unchanged)"))
                     return AppStreamSyncResult(
                         media_name=media_name,
                         success=True,
                         source='upstream',
-                        component_count=component_count
+                        component_count=component_count,
+                        unchanged=not written,
+                        elapsed_ms=elapsed_ms(),
                     )
 
         except HTTPError as e:
@@ -325,17 +444,23 @@ class AppStreamManager:
 
         # Fallback: generate from synthesis
         try:
-            xml_str, component_count = self.generate_for_media(media_id, media_name)
+            xml_str, component_count, reused, generated = self._generate_incremental(
+                media_id, media_name)
 
-            with open(output_path, 'w', encoding='utf-8') as f:
-                f.write(xml_str)
+            written = _write_if_changed(output_path, xml_str)
 
-            log(f"Generated AppStream for {media_name}: {component_count} components")
+            log(f"Generated AppStream for {media_name}: {component_count} components "
+                f"({generated} new, {reused} cached"
+                + ("" if written else ", unchanged") + ")")
             return AppStreamSyncResult(
                 media_name=media_name,
                 success=True,
                 source='generated',
-                component_count=component_count
+                component_count=component_count,
+                unchanged=not written,
+                fragments_reused=reused,
+                fragments_generated=generated,
+                elapsed_ms=elapsed_ms(),
             )
 
         except Exception as e:
@@ -345,7 +470,8 @@ class AppStreamManager:
                 success=False,
                 source='failed',
                 component_count=0,
-                error=str(e)
+                error=str(e),
+                elapsed_ms=elapsed_ms(),
             )
 
     def merge_all_catalogs(
@@ -361,7 +487,50 @@ class AppStreamManager:
         Returns:
             Tuple of (total_components, media_count)
         """
+        result = self.merge_catalogs(progress_callback)
+        return result.total_components, result.media_count
+
+    def _load_merge_state(self) -> Dict:
+        try:
+            with open(self.appstream_dir / MERGE_STATE_FILE, encoding='utf-8') as f:
+                state = json.load(f)
+        except (OSError, ValueError):
+            return {}
+        return state if isinstance(state, dict) else {}
+
+    def _clear_refresh_pending(self) -> None:
+        state = self._load_merge_state()
+        if not state.get('refresh_pending'):
+            return
+        state['refresh_pending'] = False
+        try:
+            _write_atomic(self.appstream_dir / MERGE_STATE_FILE, json.dumps(state))
+        except OSError as e:
+            logger.debug(f"Cannot save AppStream merge state: {e}")
+
+    def merge_catalogs(
+        self,
+        progress_callback: Optional[Callable[[str], None]] = None
+    ) -> AppStreamMergeResult:
+        """
+        Merge the per-media AppStream files into the unified catalog.
+
+        The components of each per-media file are kept in ``.merge/``;
+        a file whose size and mtime match the last merge is not parsed
+        again.  The catalog is only rewritten (atomically) when its
+        content changed, which ``result.changed`` reports so callers
+        can skip :meth:`refresh_system_cache`.  ``result.needs_refresh``
+        also stays set while the refresh after an earlier rewrite has not
+        succeeded yet; that is the flag to check before refreshing.
+
+        Args:
+            progress_callback: Optional callback for status messages
+
+        Returns:
+            AppStreamMergeResult with counts and timings
+        """
         self._ensure_dirs()
+        start = time.monotonic()
 
         def log(msg: str):
             if progress_callback:
@@ -375,55 +544,112 @@ class AppStreamManager:
         except ImportError:
             version = 'unknown'
 
-        # Create merged root
-        merged_root = ET.Element('components')
-        merged_root.set('version', '0.16')
-        merged_root.set('origin', f'mageia-{version}')
-
-        total_components = 0
-        media_count = 0
-
         # Find all per-media AppStream files
         if not self.appstream_dir.exists():
             log("No AppStream directory found")
-            return 0, 0
+            return AppStreamMergeResult(0, 0)
 
-        for xml_file in sorted(self.appstream_dir.glob('*.xml')):
-            try:
-                tree = ET.parse(xml_file)
-                root = tree.getroot()
+        state = self._load_merge_state()
+        old_media = state.get('media', {}) if state.get('version') == GENERATOR_VERSION else {}
+        blocks_dir = self.appstream_dir / MERGE_BLOCKS_DIR
+        blocks_dir.mkdir(exist_ok=True)
 
-                # Copy all components
-                for component in root.findall('component'):
-                    merged_root.append(component)
-                    total_components += 1
+        result = AppStreamMergeResult(0, 0)
+        new_media = {}
+        blocks: List[str] = []
 
-                media_count += 1
-                logger.debug(f"Merged {xml_file.name}")
+        for xml_file in sorted(self.appstream_dir.glob('*.xml')):
+            block_path = blocks_dir / xml_file.name
+            try:
+                st = xml_file.stat()
+                stamp = [st.st_size, st.st_mtime_ns]
+                entry = old_media.get(xml_file.name)
+                block = None
+                if entry and entry.get('stamp') == stamp:
+                    try:
+                        block = block_path.read_text(encoding='utf-8')
+                        count = entry['count']
+                        result.media_reused += 1
+                    except OSError:
+                        block = None
+                if block is None:
+                    root = ET.parse(xml_file).getroot()
+                    components = root.findall('component')
+                    block = ''.join(ET.tostring(c, encoding='unicode')
+                                    for c in components)
+                    count = len(components)
+                    _write_atomic(block_path, block)
+                    result.media_reparsed += 1
+                    logger.debug(f"Merged {xml_file.name}")
+
+                new_media[xml_file.name] = {'stamp': stamp, 'count': count}
+                blocks.append(block)
+                result.total_components += count
+                result.media_count += 1
 
             except ET.ParseError as e:
                 logger.warning(f"Failed to parse {xml_file}: {e}")
             except Exception as e:
                 logger.warning(f"Error processing {xml_file}: {e}")
 
-        if total_components == 0:
-            log("No components to merge")
-            return 0, 0
-
-        # Write merged catalog (gzipped)
-        xml_str = ET.tostring(merged_root, encoding='unicode')
-        xml_str = '<?xml version="1.0" encoding="UTF-8"?>\n' + xml_str
+        # Blocks of media that are gone
+        for block_path in blocks_dir.glob('*.xml'):
+            if block_path.name not in new_media:
+                block_path.unlink(missing_ok=True)
+        result.timings_ms['read'] = (time.monotonic() - start) * 1000
 
-        with gzip.open(self.catalog_path, 'wt', encoding='utf-8') as f:
-            f.write(xml_str)
+        if result.total_components == 0:
+            log("No components to merge")
+            result.elapsed_ms = (time.monotonic() - start) * 1000
+            return AppStreamMergeResult(0, 0, elapsed_ms=result.elapsed_ms)
+
+        head = ('<?xml version="1.0" encoding="UTF-8"?>\n'
+                f'<components version="0.16" origin={quoteattr(f"mageia-{version}")}>')
+        tail = '</components>'
+        digest = hashlib.sha256()
+        for part in [head, *blocks, tail]:
+            digest.update(part.encode('utf-8'))
+        catalog_sha256 = digest.hexdigest()
+
+        write_start = time.monotonic()
+        result.changed = (catalog_sha256 != state.get('catalog_sha256')
+                          or not self.catalog_path.exists())
+        if result.changed:
+            # Write merged catalog (gzipped), streaming one media at a time
+            tmp = self.catalog_path.with_name(self.catalog_path.name + '.tmp')
+            with gzip.open(tmp, 'wt', encoding='utf-8', compresslevel=6) as f:
+                f.write(head)
+                for block in blocks:
+                    f.write(block)
+                f.write(tail)
+            os.replace(tmp, self.catalog_path)
+        result.timings_ms['write'] = (time.monotonic() - write_start) * 1000
+        result.needs_refresh = result.changed or bool(state.get('refresh_pending'))
 
-        log(f"Merged {total_components} components from {media_count} media into {self.catalog_path}")
-        return total_components, media_count
+        try:
+            _write_atomic(self.appstream_dir / MERGE_STATE_FILE, json.dumps({
+                'version': GENERATOR_VERSION,
+                'media': new_media,
+                'catalog_sha256': catalog_sha256,
+                'refresh_pending': result.needs_refresh,
+            }))
+        except OSError as e:
+            logger.debug(f"Cannot save AppStream merge state: {e}")
+
+        result.elapsed_ms = (time.monotonic() - start) * 1000
+        log(f"Merged {result.total_components} components from {result.media_count} media "
+            f"into {self.catalog_path}"
+            + ("" if result.changed else " (unchanged)")
+            + f" in {result.elapsed_ms:.0f} ms ({result.media_reparsed} re-read)")
+        return result
 
     def refresh_system_cache(self) -> bool:
         """
         Refresh system AppStream cache using appstreamcli.
 
+        Clears the refresh left pending by :meth:`merge_catalogs` on
+        success only.
+
         Returns:
             True if successful, False otherwise
         """
@@ -436,12 +662,14 @@ class AppStreamManager:
             )
             if result.returncode == 0:
                 logger.info("AppStream cache refreshed successfully")
+                self._clear_refresh_pending()
                 return True
             else:
                 logger.warning(f"appstreamcli returned {result.returncode}: {result.stderr}")
                 return False
         except FileNotFoundError:
             logger.info("appstreamcli not installed, skipping cache refresh")
+            self._clear_refresh_pending()
             return True  # Not an error if not installed
         except subprocess.TimeoutExpired:
             logger.warning("appstreamcli timed out")
@@ -511,6 +739,7 @@ class AppStreamManager:
         Returns:
             True if removed, False if didn't exist
         """
+        self.get_fragments_path(media_name).unlink(missing_ok=True)
         xml_path = self.get_media_appstream_path(media_name)
         if xml_path.exists():
             xml_path.unlink()
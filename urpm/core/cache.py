@@ -6,13 +6,21 @@ Handles:
 - Enforcing per-media and global quotas
 - Retention policy (max age)
 - Eviction of unreferenced and old files
+
+Quota passes work from the database: sizes come from the
+trigger-maintained ``cache_usage`` table and eviction candidates are read
+in LRU order from an index until enough bytes are found, so a pass costs
+about what it evicts.  Access stamps are buffered and written in batches
+(see ``CacheMixin.update_cache_file_access``).  Only :meth:`reconcile`
+and :meth:`get_disk_usage` walk the filesystem.
 """
 
 import logging
 import os
+import stat
 import time
 from pathlib import Path
-from typing import Dict, List, Optional, Tuple, Any
+from typing import Dict, List, Optional, Set, Tuple, Any
 
 from .database import PackageDatabase
 from .config import get_base_dir
@@ -63,9 +71,16 @@ class CacheManager:
         return self.db.register_cache_file(filename, media_id, file_path, file_size)
 
     def update_access(self, filename: str, media_id: int = None):
-        """Update last accessed time for a file (for LRU tracking)."""
+        """Update last accessed time for a file (for LRU tracking).
+
+        Buffered in memory; see :meth:`flush_access`.
+        """
         self.db.update_cache_file_access(filename, media_id)
 
+    def flush_access(self) -> int:
+        """Write buffered access times now; returns how many."""
+        return self.db.flush_cache_file_access()
+
     # =========================================================================
     # Statistics
     # =========================================================================
@@ -104,13 +119,11 @@ class CacheManager:
 
     def get_media_usage(self, media_id: int) -> int:
         """Get total cache size for a specific media in bytes."""
-        stats = self.db.get_cache_stats(media_id)
-        return stats.get('total_size', 0)
+        return self.db.get_cache_usage(media_id)['total_size']
 
     def get_total_usage(self) -> int:
         """Get total cache size in bytes."""
-        stats = self.db.get_cache_stats()
-        return stats.get('total_size', 0)
+        return self.db.get_cache_usage()['total_size']
 
     def get_disk_usage(self, media_id: int = None) -> Dict[str, int]:
         """Get actual disk usage by scanning the filesystem.
@@ -186,30 +199,28 @@ class CacheManager:
         }
 
         # Phase 1: Remove unreferenced files
-        unreferenced = self.db.list_cache_files(referenced_only=False)
-        unreferenced = [f for f in unreferenced if not f['is_referenced']]
-
+        unreferenced = self.db.get_files_to_evict(unreferenced_only=True)
+        deleted = self._delete_files(unreferenced, dry_run)
+        result['unreferenced_deleted'] += len(deleted)
+        result['unreferenced_bytes'] += sum(f['file_size'] for f in deleted)
+        deleted_ids = {f['id'] for f in deleted}
         for f in unreferenced:
-            if self._delete_file(f, dry_run):
-                result['unreferenced_deleted'] += 1
-                result['unreferenced_bytes'] += f['file_size']
-            else:
+            if f['id'] not in deleted_ids:
                 result['errors'].append(f"Failed to delete {f['file_path']}")
 
         # Phase 2: Apply retention policy per media
+        # (referenced files are never deleted for retention)
         for media in self.db.list_media():
             retention_days = media.get('retention_days', 30)
             if retention_days and retention_days > 0:
                 old_files = self.db.get_files_to_evict(
                     media_id=media['id'],
-                    max_age_days=retention_days
+                    max_age_days=retention_days,
+                    unreferenced_only=True
                 )
-                for f in old_files:
-                    if f['is_referenced']:
-                        continue  # Don't delete referenced files for retention
-                    if self._delete_file(f, dry_run):
-                        result['retention_deleted'] += 1
-                        result['retention_bytes'] += f['file_size']
+                deleted = self._delete_files(old_files, dry_run)
+                result['retention_deleted'] += len(deleted)
+                result['retention_bytes'] += sum(f['file_size'] for f in deleted)
 
         # Phase 3: Apply per-media quotas
         for media in self.db.list_media():
@@ -226,10 +237,9 @@ class CacheManager:
                     media_id=media['id'],
                     max_bytes=excess
                 )
-                for f in files_to_evict:
-                    if self._delete_file(f, dry_run):
-                        result['quota_deleted'] += 1
-                        result['quota_bytes'] += f['file_size']
+                deleted = self._delete_files(files_to_evict, dry_run)
+                result['quota_deleted'] += len(deleted)
+                result['quota_bytes'] += sum(f['file_size'] for f in deleted)
 
         # Phase 4: Apply global quota
         global_quota_str = self.db.get_mirror_config('global_quota_mb')
@@ -240,10 +250,9 @@ class CacheManager:
             if current_size > global_quota_bytes:
                 excess = current_size - global_quota_bytes
                 files_to_evict = self.db.get_files_to_evict(max_bytes=excess)
-                for f in files_to_evict:
-                    if self._delete_file(f, dry_run):
-                        result['quota_deleted'] += 1
-                        result['quota_bytes'] += f['file_size']
+                deleted = self._delete_files(files_to_evict, dry_run)
+                result['quota_deleted'] += len(deleted)
+                result['quota_bytes'] += sum(f['file_size'] for f in deleted)
 
         # Totals
         result['total_deleted'] = (
@@ -276,21 +285,15 @@ class CacheManager:
         # First try to evict from the specific media
         if media_id:
             files = self.db.get_files_to_evict(media_id=media_id, max_bytes=needed_bytes)
-            for f in files:
-                if self._delete_file(f, dry_run):
-                    freed += f['file_size']
-                    if freed >= needed_bytes:
-                        return True, freed
+            freed += sum(f['file_size'] for f in self._delete_files(files, dry_run))
+            if freed >= needed_bytes:
+                return True, freed
 
         # If not enough, evict globally
         remaining = needed_bytes - freed
         if remaining > 0:
             files = self.db.get_files_to_evict(max_bytes=remaining)
-            for f in files:
-                if self._delete_file(f, dry_run):
-                    freed += f['file_size']
-                    if freed >= needed_bytes:
-                        return True, freed
+            freed += sum(f['file_size'] for f in self._delete_files(files, dry_run))
 
         return freed >= needed_bytes, freed
 
@@ -314,14 +317,18 @@ class CacheManager:
     # Scanning and reconciliation
     # =========================================================================
 
-    def scan_media_directory(self, media_id: int, media_path: Path) -> Dict[str, Any]:
+    def scan_media_directory(self, media_id: int, media_path: Path,
+                             tracked: Set[str] = None) -> Dict[str, Any]:
         """Scan a media directory and register any untracked files.
 
-        Useful for initial setup or after manual file additions.
+        Useful for initial setup or after manual file additions.  New
+        files are registered in one transaction.
 
         Args:
             media_id: Media ID
             media_path: Full path to media directory
+            tracked: Filenames already recorded for this media (read
+                from the database if None)
 
         Returns:
             Dict with 'found', 'registered', 'already_tracked'
@@ -335,28 +342,29 @@ class CacheManager:
         if not media_path.exists():
             return result
 
+        if tracked is None:
+            tracked = {f['filename'] for f in self.db.list_cache_files(media_id=media_id)}
+
         # Find all RPM files
+        new_files = []
         for rpm_path in media_path.rglob("*.rpm"):
-            if not rpm_path.is_file():
+            try:
+                st = rpm_path.stat()
+                rel_path = str(rpm_path.relative_to(self.medias_dir))
+            except (OSError, ValueError) as e:
+                logger.warning(f"Failed to register {rpm_path}: {e}")
+                continue
+            if not stat.S_ISREG(st.st_mode):
                 continue
 
             result['found'] += 1
-            filename = rpm_path.name
-
-            # Check if already tracked
-            existing = self.db.get_cache_file(filename, media_id)
-            if existing:
+            if rpm_path.name in tracked:
                 result['already_tracked'] += 1
                 continue
+            new_files.append((rpm_path.name, media_id, rel_path, st.st_size))
 
-            # Register it
-            try:
-                rel_path = str(rpm_path.relative_to(self.medias_dir))
-                file_size = rpm_path.stat().st_size
-                self.db.register_cache_file(filename, media_id, rel_path, file_size)
-                result['registered'] += 1
-            except Exception as e:
-                logger.warning(f"Failed to register {rpm_path}: {e}")
+        if new_files:
+            result['registered'] = self.db.register_cache_files(new_files)
 
         return result
 
@@ -366,26 +374,37 @@ class CacheManager:
         - Remove DB entries for files that don't exist
         - Add DB entries for untracked files
 
+        One listing of the table and one walk of each media directory,
+        compared in memory; removals and additions are written in one
+        transaction each.
+
         Returns:
             Dict with statistics
         """
+        from .config import get_media_local_path
+
         result = {
             'orphan_records_removed': 0,
             'untracked_files_added': 0,
         }
 
         # Check for orphan DB records
+        tracked: Dict[int, Set[str]] = {}
+        orphans = []
         for cache_file in self.db.list_cache_files():
-            full_path = self.medias_dir / cache_file['file_path']
-            if not full_path.exists():
-                self.db.delete_cache_file(cache_file['filename'], cache_file['media_id'])
-                result['orphan_records_removed'] += 1
+            if (self.medias_dir / cache_file['file_path']).exists():
+                tracked.setdefault(cache_file['media_id'], set()).add(
+                    cache_file['filename'])
+            else:
+                orphans.append((cache_file['filename'], cache_file['media_id']))
+        result['orphan_records_removed'] = self.db.delete_cache_files(orphans)
 
         # Scan for untracked files
         for media in self.db.list_media():
-            from .config import get_media_local_path
             media_path = get_media_local_path(media, self.base_dir)
-            scan_result = self.scan_media_directory(media['id'], media_path)
+            scan_result = self.scan_media_directory(
+                media['id'], media_path, tracked=tracked.get(media['id'], set())
+            )
             result['untracked_files_added'] += scan_result['registered']
 
         return result
@@ -394,34 +413,40 @@ class CacheManager:
     # Internal helpers
     # =========================================================================
 
-    def _delete_file(self, cache_file: Dict, dry_run: bool = False) -> bool:
-        """Delete a cached file (both filesystem and DB record).
+    def _delete_files(self, cache_files: List[Dict],
+                      dry_run: bool = False) -> List[Dict]:
+        """Delete cached files, then their DB records in one transaction.
 
         Args:
-            cache_file: Cache file dict from database
+            cache_files: Cache file dicts from database
             dry_run: If True, don't actually delete
 
         Returns:
-            True if successful (or would be successful in dry_run)
+            The files that were (or would be) deleted
         """
-        file_path = self.medias_dir / cache_file['file_path']
-
         if dry_run:
-            logger.debug(f"Would delete: {file_path}")
-            return True
+            for cache_file in cache_files:
+                logger.debug(f"Would delete: {self.medias_dir / cache_file['file_path']}")
+            return list(cache_files)
 
-        try:
-            if file_path.exists():
+        deleted = []
+        for cache_file in cache_files:
+            file_path = self.medias_dir / cache_file['file_path']
+            try:
                 file_path.unlink()
                 logger.debug(f"Deleted: {file_path}")
+            except FileNotFoundError:
+                pass
+            except OSError as e:
+                logger.warning(f"Failed to delete {file_path}: {e}")
+                continue
+            deleted.append(cache_file)
 
-            # Always remove DB record
-            self.db.delete_cache_file(cache_file['filename'], cache_file['media_id'])
-            return True
-
-        except OSError as e:
-            logger.warning(f"Failed to delete {file_path}: {e}")
-            return False
+        # Always remove DB records of the deleted (or already gone) files
+        self.db.delete_cache_files(
+            (f['filename'], f['media_id']) for f in deleted
+        )
+        return deleted
 
 
 def format_size(size_bytes: int) -> str:
@@ -0,0 +1,117 @@
+"""
+Compact digest of a urpmd RPM cache for LAN peers
+
+Asking every peer ``/api/have`` for the whole download list costs one
+large request per peer before any byte moves.  Instead urpmd publishes a
+Bloom filter of the RPM filenames it can serve (``GET /api/cache-digest``)
+and clients test their list against it locally; only the filenames a
+peer's digest may contain are then confirmed with ``/api/have``.
+
+A Bloom filter has no false negatives, so a filename it rejects is never
+on that peer.  False positives (``FALSE_POSITIVE_RATE``) just cost a
+filename in the confirmation query.
+
+Wire format (JSON)::
+
+    {"format": 1, "id": "<hex>", "count": n, "bits": m, "hashes": k,
+     "data": "<base64 of zlib-compressed bit array>"}
+
+``id`` is a hash of the content, so a client holding that digest can
+skip the transfer (``?since=<id>``, or the id announced with the peer).
+"""
+
+import base64
+import hashlib
+import math
+import zlib
+from typing import Dict, Iterable, Optional
+
+DIGEST_FORMAT = 1
+
+# Target false positive rate of a freshly built digest
+FALSE_POSITIVE_RATE = 0.01
+
+# Smallest filter, so tiny caches still get a sensible array
+MIN_BITS = 1024
+
+
+def _hashes(name: str):
+    d = hashlib.blake2b(name.encode('utf-8'), digest_size=16).digest()
+    return int.from_bytes(d[:8], 'little'), int.from_bytes(d[8:], 'little') | 1
+
+
+class CacheDigest:
+    """Bloom filter over RPM filenames."""
+
+    __slots__ = ('num_bits', 'num_hashes', 'count', '_bits', '_id')
+
+    def __init__(self, num_bits: int, num_hashes: int, bits: bytearray = None,
+                 count: int = 0):
+        self.num_bits = num_bits
+        self.num_hashes = num_hashes
+        self.count = count
+        self._bits = bits if bits is not None else bytearray((num_bits + 7) // 8)
+        self._id: Optional[str] = None
+
+    @classmethod
+    def build(cls, names: Iterable[str],
+              fp_rate: float = FALSE_POSITIVE_RATE) -> 'CacheDigest':
+        """Return a digest sized for ``names`` at ``fp_rate``."""
+        names = list(names)
+        n = max(len(names), 1)
+        num_bits = max(MIN_BITS, math.ceil(-n * math.log(fp_rate) / math.log(2) ** 2))
+        num_bits = (num_bits + 7) // 8 * 8
+        num_hashes = max(1, round(num_bits / n * math.log(2)))
+        digest = cls(num_bits, num_hashes)
+        for name in names:
+            digest.add(name)
+        return digest
+
+    def _positions(self, name: str):
+        h1, h2 = _hashes(name)
+        m = self.num_bits
+        return ((h1 + i * h2) % m for i in range(self.num_hashes))
+
+    def add(self, name: str):
+        for pos in self._positions(name):
+            self._bits[pos >> 3] |= 1 << (pos & 7)
+        self.count += 1
+        self._id = None
+
+    def __contains__(self, name: str) -> bool:
+        bits = self._bits
+        return all(bits[pos >> 3] & (1 << (pos & 7)) for pos in self._positions(name))
+
+    @property
+    def id(self) -> str:
+        """Content hash; equal ids mean equal digests."""
+        if self._id is None:
+            h = hashlib.sha256(f"{self.num_bits}:{self.num_hashes}:".encode())
+            h.update(self._bits)
+            self._id = h.hexdigest()[:16]
+        return self._id
+
+    def to_dict(self) -> Dict:
+        return {
+            'format': DIGEST_FORMAT,
+            'id': self.id,
+            'count': self.count,
+            'bits': self.num_bits,
+            'hashes': self.num_hashes,
+            'data': base64.b64encode(zlib.compress(bytes(self._bits))).decode('ascii'),
+        }
+
+    @classmethod
+    def from_dict(cls, data: Dict) -> Optional['CacheDigest']:
+        """Parse :meth:`to_dict` output; None if malformed or another format."""
+        try:
+            if data.get('format') != DIGEST_FORMAT:
+                return None
+            num_bits = int(data['bits'])
+            num_hashes = int(data['hashes'])
+            bits = bytearray(zlib.decompress(base64.b64decode(data['data'])))
+        except (AttributeError, KeyError, TypeError, ValueError, zlib.error):
+            return None
+        if num_bits <= 0 or num_hashes <= 0 or len(bits) != (num_bits + 7) // 8:
+            return None
+        return cls(num_bits, num_hashes, bits, int(data.get('count', 0)))
@@ -0,0 +1,42 @@
+"""
+Hit/miss counters for urpm's caches
+
+The .solv caches, the hdlist and files.xml indexes and similar sidecars
+each save a slow path on a hit.  Code consulting one calls
+:func:`record`; long-running processes (the D-Bus service) report the
+totals through :func:`snapshot`.  Counting is a dict update under a lock,
+cheap enough to leave on in the CLI where nothing reads it.
+"""
+
+import threading
+from typing import Dict
+
+_lock = threading.Lock()
+_counts: Dict[str, list] = {}   # cache name -> [hits, misses]
+
+
+def record(cache: str, hit: bool):
+    """Count one lookup in ``cache``."""
+    with _lock:
+        counts = _counts.setdefault(cache, [0, 0])
+        counts[0 if hit else 1] += 1
+
+
+def snapshot() -> Dict[str, Dict]:
+    """Return ``{cache: {'hits', 'misses', 'hit_rate'}}`` so far."""
+    with _lock:
+        items = [(name, hits, misses) for name, (hits, misses) in _counts.items()]
+    return {
+        name: {
+            'hits': hits,
+            'misses': misses,
+            'hit_rate': hits / (hits + misses) if hits + misses else 0.0,
+        }
+        for name, hits, misses in sorted(items)
+    }
+
+
+def reset():
+    """Forget all counts (tests)."""
+    with _lock:
+        _counts.clear()
@@ -4,23 +4,74 @@ Compression utilities for urpm
 Auto-detects and handles multiple compression formats:
 - zstd (current Mageia format)
 - gzip (legacy)
-- xz/lzma (legacy)
+- xz/lzma (legacy; files.xml.lzma may use the raw lzma "alone" format)
 - bzip2 (legacy)
+
+:func:`decompress_stream` is the primary entry point: every format is
+read incrementally, so parsing a large hdlist or synthesis never
+holds the whole decompressed file in memory.
 """
 
+import io
 from pathlib import Path
-from typing import Union
+from typing import BinaryIO, Union
 
 # Magic bytes for format detection
 MAGIC_ZSTD = b'\x28\xb5\x2f\xfd'
 MAGIC_GZIP = b'\x1f\x8b'
 MAGIC_XZ = b'\xfd7zXZ\x00'
 MAGIC_BZ2 = b'BZ'
+# lzma "alone" has no magic: properties byte 0x5d (the default lc/lp/pb)
+# then a little-endian dictionary size whose low bytes are zero
+MAGIC_LZMA_ALONE = b'\x5d\x00\x00'
 
 
 import subprocess
 import shutil
 
+# Read size of the pipe and reader wrappers
+STREAM_BUFFER_SIZE = 256 * 1024
+
+
+class _ProcessReader(io.RawIOBase):
+    """Raw stream over the stdout of a decompressor subprocess.
+
+    The pipe bounds memory: the child blocks once the reader falls
+    behind.  A child that fails is reported when it reaches EOF, like
+    a corrupt gzip member is with gzip.open().
+    """
+
+    def __init__(self, args):
+        self._proc = subprocess.Popen(
+            args, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+        )
+        self._args = args
+
+    def readable(self) -> bool:
+        return True
+
+    def readinto(self, buffer) -> int:
+        n = self._proc.stdout.readinto(buffer)
+        if n == 0:
+            self._check()
+        return n
+
+    def _check(self):
+        rc = self._proc.wait()
+        if rc != 0:
+            err = self._proc.stderr.read().decode(errors='replace').strip()
+            raise ValueError(f"{self._args[0]} failed: {err}")
+
+    def close(self):
+        if not self.closed:
+            if self._proc.poll() is None:
+                # Closed before EOF: the rest is not wanted
+                self._proc.kill()
+            self._proc.wait()
+            self._proc.stdout.close()
+            self._proc.stderr.close()
+        super().close()
+
 
 def _decompress_zstd_subprocess(data: bytes) -> bytes:
     """Decompress zstd data using zstdcat subprocess (fallback)."""
@@ -113,6 +164,27 @@ class _ZstdWrapper:
             with open(filepath, 'rb') as f:
                 return self._module.decompress(f.read())
 
+    def open_stream(self, filepath) -> BinaryIO:
+        """Open a file for incremental decompression.
+
+        The simple ``zstd`` module has no streaming API; it is the last
+        resort (no zstandard, no zstdcat) and still decompresses at once.
+        """
+        if self._api_type == 'zstandard':
+            f = open(filepath, 'rb')
+            try:
+                reader = self._module.ZstdDecompressor().stream_reader(
+                    f, read_size=STREAM_BUFFER_SIZE, closefd=True)
+            except Exception:
+                f.close()
+                raise
+            return io.BufferedReader(reader, STREAM_BUFFER_SIZE)
+        elif self._api_type == 'subprocess':
+            return io.BufferedReader(
+                _ProcessReader(['zstdcat', str(filepath)]), STREAM_BUFFER_SIZE)
+        else:
+            return io.BytesIO(self.stream_decompress(filepath))
+
 
 # Lazy-loaded singleton
 _zstd_wrapper = None
@@ -132,7 +204,7 @@ def detect_format(data: bytes) -> str:
         data: First 8+ bytes of the file
         
     Returns:
-        Format name: 'zstd', 'gzip', 'xz', 'bzip2', or 'plain'
+        Format name: 'zstd', 'gzip', 'xz', 'lzma', 'bzip2', or 'plain'
     """
     if data[:4] == MAGIC_ZSTD:
         return 'zstd'
@@ -142,6 +214,8 @@ def detect_format(data: bytes) -> str:
         return 'xz'
     elif data[:2] == MAGIC_BZ2:
         return 'bzip2'
+    elif data[:3] == MAGIC_LZMA_ALONE:
+        return 'lzma'
     else:
         return 'plain'
 
@@ -168,7 +242,7 @@ def decompress_bytes(data: bytes) -> bytes:
         import gzip
         return gzip.decompress(data)
     
-    elif fmt == 'xz':
+    elif fmt in ('xz', 'lzma'):
         import lzma
         return lzma.decompress(data)
     
@@ -201,15 +275,17 @@ def decompress(filename: Union[str, Path], encoding: str = 'utf-8') -> str:
         if fmt == 'zstd':
             # Close file, use wrapper's stream decompress
             f.close()
-            data = _get_zstd().stream_decompress(path)
-            return data.decode(encoding, errors='replace')
+            with _get_zstd().open_stream(path) as zst:
+                with io.TextIOWrapper(zst, encoding=encoding,
+                                      errors='replace', newline='') as text:
+                    return text.read()
         
         elif fmt == 'gzip':
             import gzip
             with gzip.open(f, 'rt', encoding=encoding, errors='replace') as gz:
                 return gz.read()
         
-        elif fmt == 'xz':
+        elif fmt in ('xz', 'lzma'):
             import lzma
             with lzma.open(f, 'rt', encoding=encoding, errors='replace') as xz:
                 return xz.read()
@@ -223,9 +299,14 @@ def decompress(filename: Union[str, Path], encoding: str = 'utf-8') -> str:
             return f.read().decode(encoding, errors='replace')
 
 
-def decompress_stream(filename: Union[str, Path]):
+def decompress_stream(filename: Union[str, Path]) -> BinaryIO:
     """Open a compressed file and return a binary stream.
     
+    Data is decompressed as it is read, with bounded buffers for every
+    format (zstd through zstandard's stream reader or a zstdcat pipe).
+    The stream supports read(), readline() and line iteration; close it
+    (or use it as a context manager) to release the decompressor.
+
     Args:
         filename: Path to compressed file
         
@@ -240,16 +321,13 @@ def decompress_stream(filename: Union[str, Path]):
     fmt = detect_format(magic)
     
     if fmt == 'zstd':
-        # Return BytesIO with decompressed data
-        import io
-        data = _get_zstd().stream_decompress(path)
-        return io.BytesIO(data)
+        return _get_zstd().open_stream(path)
     
     elif fmt == 'gzip':
         import gzip
         return gzip.open(path, 'rb')
     
-    elif fmt == 'xz':
+    elif fmt in ('xz', 'lzma'):
         import lzma
         return lzma.open(path, 'rb')
     
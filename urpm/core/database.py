@@ -5,10 +5,12 @@ Provides fast queries on package metadata, replacing repeated parsing
 of synthesis/hdlist files.
 """
 
+import functools
 import sqlite3
 import hashlib
 import threading
 import time
+from contextlib import contextmanager
 from pathlib import Path
 from typing import Callable, Dict, List, Optional, Any, Iterator, Set, Tuple
 
@@ -86,8 +88,203 @@ def _register_rpm_collation(conn: sqlite3.Connection) -> None:
     """
     conn.create_collation('rpm_version_compare', _rpm_version_collation)
 
+
+def _catalog_order(a: Dict, b: Dict) -> int:
+    """Catalog row order: name and arch ascending, then newest EVR first.
+
+    The Python side of the ``ORDER BY ... rpm_version_compare DESC`` of
+    list_packages_page(), for rows merged in from the rpmdb.
+    """
+    key_a = (a['name'].lower(), a['arch'])
+    key_b = (b['name'].lower(), b['arch'])
+    if key_a != key_b:
+        return -1 if key_a < key_b else 1
+
+    import rpm
+    return rpm.labelCompare(
+        (str(b['epoch'] or 0), b['version'], b['release']),
+        (str(a['epoch'] or 0), a['version'], a['release']),
+    )
+
+
+def provide_name(capability: str) -> str:
+    """Strip the version constraint from a provides capability.
+
+    ``foo[== 1.0-1.mga9]`` and ``foo = 1.0`` both index as ``foo``.
+    An ``=`` inside the name itself (``font(:lang=en)``) is kept, so
+    the result is what ``whatprovides_any()`` looks up.
+    """
+    base = capability.split('[', 1)[0]
+    parts = base.split(None, 1)
+    return parts[0] if parts else capability
+
+
+# Provide namespaces whose package-side capabilities are glob patterns
+# matched against a concrete query (``modalias(pci:v00008086d*...)``)
+GLOB_PROVIDE_PREFIXES = ('modalias(',)
+
+# Child tables of packages holding one capability per row
+DEPENDENCY_TABLES = ('requires', 'provides', 'conflicts', 'obsoletes',
+                     'recommends', 'suggests', 'supplements', 'enhances')
+
+# Share of a media's packages changed by an import above which the FTS
+# index is rebuilt instead of updated row by row
+FTS_REBUILD_RATIO = 0.25
+
+
+def _package_hash(pkg: Dict, source: str) -> str:
+    """Content hash of an imported package, stored as ``pkg_hash``.
+
+    Covers every column and dependency the import writes, so an
+    unchanged hash means the stored rows can be kept as they are.
+    """
+    h = hashlib.sha256()
+    for key in ('nevra', 'summary', 'description', 'epoch', 'filesize',
+                'size', 'group', 'url', 'license'):
+        h.update(f"{pkg.get(key, '')}\x00".encode())
+    h.update(source.encode())
+    for table in DEPENDENCY_TABLES:
+        h.update(f"\x01{table}".encode())
+        for cap in pkg.get(table, ()):
+            h.update(f"\x00{cap}".encode())
+    return h.hexdigest()[:16]
+
+
+def _chunks(items: List, size: int = 500) -> Iterator[List]:
+    """Split items for ``IN (...)`` lists under SQLite's variable limit."""
+    for i in range(0, len(items), size):
+        yield items[i:i + size]
+
+
+def _in_list(values) -> Tuple[str, tuple]:
+    """Placeholders and parameters for an ``IN (...)`` list of ``values``.
+
+    sqlite3 caches prepared statements by SQL text, so one placeholder
+    per value turns every list length into a new statement that evicts
+    the hot ones.  The list is padded with NULLs (which never match) up
+    to a power of two, leaving a handful of shapes per query; lists past
+    512 values are left as they are.  Only for ``IN``: padded ``NOT IN``
+    lists never match.
+    """
+    values = tuple(values)
+    width = 8
+    while width < len(values):
+        width *= 2
+    if width > 512:
+        width = len(values)
+    return ','.join('?' * width), values + (None,) * (width - len(values))
+
+
+class ReadConnectionPool:
+    """Bounded pool of read-only connections to one database.
+
+    Connections are opened lazily up to ``size`` and handed out one
+    caller at a time.  In WAL mode each reads a committed snapshot, so
+    pooled queries neither serialize on a shared connection nor wait
+    for a writer such as a running media import.
+    """
+
+    def __init__(self, factory: Callable[[], sqlite3.Connection], size: int):
+        self._factory = factory
+        self._size = max(1, size)
+        self._idle: List[sqlite3.Connection] = []
+        self._created = 0
+        self._closed = False
+        self._cond = threading.Condition()
+
+    def acquire(self) -> sqlite3.Connection:
+        """Take a connection, waiting for one if all are in use."""
+        with self._cond:
+            while not self._idle and self._created >= self._size:
+                self._cond.wait()
+            if self._idle:
+                return self._idle.pop()
+            self._created += 1
+        try:
+            return self._factory()
+        except Exception:
+            with self._cond:
+                self._created -= 1
+                self._cond.notify()
+            raise
+
+    def release(self, conn: sqlite3.Connection):
+        """Give back a connection taken with :meth:`acquire`."""
+        with self._cond:
+            if not self._closed:
+                self._idle.append(conn)
+                self._cond.notify()
+                return
+            self._created -= 1
+        conn.close()
+
+    def close(self):
+        """Close idle connections; leased ones close when released."""
+        with self._cond:
+            self._closed = True
+            idle, self._idle = self._idle, []
+            self._created -= len(idle)
+        for conn in idle:
+            conn.close()
+
+
+def _pooled_read(method):
+    """Run a query method under :meth:`PackageDatabase.reading`."""
+    @functools.wraps(method)
+    def wrapper(self, *args, **kwargs):
+        with self.reading():
+            return method(self, *args, **kwargs)
+    return wrapper
+
+
 # Schema version - increment when schema changes
-SCHEMA_VERSION = 30
+SCHEMA_VERSION = 33
+
+# Eviction indexes and per-media usage of the RPM cache (v33+).
+# ``cache_usage`` is maintained by triggers, so every writer of
+# ``cache_files`` (including ON DELETE CASCADE from media) keeps it
+# exact; files without a media are counted under media_id 0.
+CACHE_USAGE_SQL = """
+CREATE INDEX IF NOT EXISTS idx_cache_files_evict_media
+    ON cache_files(media_id, is_referenced, last_accessed);
+CREATE INDEX IF NOT EXISTS idx_cache_files_evict
+    ON cache_files(is_referenced, last_accessed);
+
+CREATE TABLE IF NOT EXISTS cache_usage (
+    media_id INTEGER PRIMARY KEY,
+    file_count INTEGER NOT NULL DEFAULT 0,
+    total_size INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE TRIGGER IF NOT EXISTS cache_usage_insert AFTER INSERT ON cache_files
+BEGIN
+    INSERT INTO cache_usage (media_id, file_count, total_size)
+        VALUES (COALESCE(NEW.media_id, 0), 1, NEW.file_size)
+        ON CONFLICT(media_id) DO UPDATE SET
+            file_count = file_count + 1,
+            total_size = total_size + excluded.total_size;
+END;
+
+CREATE TRIGGER IF NOT EXISTS cache_usage_delete AFTER DELETE ON cache_files
+BEGIN
+    UPDATE cache_usage
+        SET file_count = file_count - 1, total_size = total_size - OLD.file_size
+        WHERE media_id = COALESCE(OLD.media_id, 0);
+END;
+
+CREATE TRIGGER IF NOT EXISTS cache_usage_update
+AFTER UPDATE OF media_id, file_size ON cache_files
+BEGIN
+    UPDATE cache_usage
+        SET file_count = file_count - 1, total_size = total_size - OLD.file_size
+        WHERE media_id = COALESCE(OLD.media_id, 0);
+    INSERT INTO cache_usage (media_id, file_count, total_size)
+        VALUES (COALESCE(NEW.media_id, 0), 1, NEW.file_size)
+        ON CONFLICT(media_id) DO UPDATE SET
+            file_count = file_count + 1,
+            total_size = total_size + excluded.total_size;
+END;
+"""
 
 # Extended schema with media, config, history tables
 SCHEMA = """
@@ -147,6 +344,7 @@ CREATE TABLE IF NOT EXISTS provides (
     capability TEXT NOT NULL,
     operator TEXT,
     version TEXT,
+    name TEXT,  -- capability without version constraint (v31+)
     FOREIGN KEY (pkg_id) REFERENCES packages(id) ON DELETE CASCADE
 );
 
@@ -421,7 +619,7 @@ CREATE TABLE IF NOT EXISTS cache_files (
 CREATE INDEX IF NOT EXISTS idx_cache_files_media ON cache_files(media_id);
 CREATE INDEX IF NOT EXISTS idx_cache_files_referenced ON cache_files(is_referenced);
 CREATE INDEX IF NOT EXISTS idx_cache_files_accessed ON cache_files(last_accessed);
-
+""" + CACHE_USAGE_SQL + """
 -- Proxy configuration (v11+)
 CREATE TABLE IF NOT EXISTS mirror_config (
     key TEXT PRIMARY KEY,
@@ -434,6 +632,8 @@ CREATE INDEX IF NOT EXISTS idx_pkg_nevra ON packages(nevra);
 CREATE INDEX IF NOT EXISTS idx_pkg_media ON packages(media_id);
 CREATE INDEX IF NOT EXISTS idx_provides_cap ON provides(capability);
 CREATE INDEX IF NOT EXISTS idx_provides_pkg ON provides(pkg_id);
+CREATE INDEX IF NOT EXISTS idx_provides_name ON provides(name);
+CREATE INDEX IF NOT EXISTS idx_provides_name_lower ON provides(lower(name));
 CREATE INDEX IF NOT EXISTS idx_requires_cap ON requires(capability);
 CREATE INDEX IF NOT EXISTS idx_requires_pkg ON requires(pkg_id);
 CREATE INDEX IF NOT EXISTS idx_conflicts_cap ON conflicts(capability);
@@ -465,13 +665,15 @@ CREATE TABLE IF NOT EXISTS transaction_readmes (
 );
 CREATE INDEX IF NOT EXISTS idx_tr_transaction ON transaction_readmes(transaction_id);
 
--- FTS5 index for fast package search (name, summary, description)
+-- FTS5 index for fast package search (name, summary, description);
+-- 2 and 3 character prefixes are indexed for search-as-you-type
 CREATE VIRTUAL TABLE IF NOT EXISTS packages_fts USING fts5(
     name,
     summary,
     description,
     content = 'packages',
-    content_rowid = 'id'
+    content_rowid = 'id',
+    prefix = '2 3'
 );
 """
 
@@ -837,6 +1039,51 @@ MIGRATIONS = {
 
         ALTER TABLE cache_files ADD COLUMN served_by_server_id INTEGER;
     """),
+    30: (31, """
+        -- Migration v30 -> v31: provides-name index for WhatProvides.
+        --
+        -- ``provides.capability`` keeps the raw synthesis form
+        -- (``foo[== 1.0-1.mga9]``), which an exact-match lookup on
+        -- ``foo`` misses.  ``name`` holds the bare capability, filled
+        -- at import time by provide_name(); backfill existing rows with
+        -- the same rule (cut at ``[``, then at the first space).
+        ALTER TABLE provides ADD COLUMN name TEXT;
+        UPDATE provides SET name = CASE
+            WHEN instr(capability, '[') > 0
+                THEN rtrim(substr(capability, 1, instr(capability, '[') - 1))
+            ELSE capability
+        END;
+        UPDATE provides SET name = substr(name, 1, instr(name, ' ') - 1)
+            WHERE instr(name, ' ') > 0;
+        CREATE INDEX IF NOT EXISTS idx_provides_name ON provides(name);
+    """),
+    31: (32, """
+        -- Migration v31 -> v32: prefix indexes for search-as-you-type.
+        --
+        -- Short FTS prefix queries (``fi*``) merge the doclists of every
+        -- term they cover; an FTS5 prefix index stores those ready-made.
+        -- The option can only be set at creation, so the (external
+        -- content) table is recreated; _migrate_v31_to_v32_fts() then
+        -- rebuilds it from ``packages``.  Provides get an index on the
+        -- lowercased name for prefix range scans.
+        DROP TABLE IF EXISTS packages_fts;
+        CREATE VIRTUAL TABLE packages_fts USING fts5(
+            name,
+            summary,
+            description,
+            content = 'packages',
+            content_rowid = 'id',
+            prefix = '2 3'
+        );
+        CREATE INDEX IF NOT EXISTS idx_provides_name_lower
+            ON provides(lower(name));
+    """),
+    32: (33, """
+        -- Migration v32 -> v33: eviction indexes and trigger-maintained
+        -- per-media usage for the RPM cache.  Created and backfilled
+        -- by _migrate_v32_to_v33_cache_usage() (CACHE_USAGE_SQL).
+        SELECT 1;
+    """),
 }
 
 
@@ -864,6 +1111,9 @@ class PackageDatabase(
     # Timeout for waiting on locked database (30 seconds)
     BUSY_TIMEOUT_MS = 30000
 
+    # Prepared statements kept per pooled read connection
+    READ_STATEMENT_CACHE = 256
+
     def __init__(self, db_path: Optional[Path] = None,
                  *, read_only: Optional[bool] = None):
         """Initialize database connection.
@@ -909,6 +1159,14 @@ class PackageDatabase(
         # Thread-local storage for per-thread connections
         self._local = threading.local()
 
+        # Read-only connections for hot queries, see enable_read_pool()
+        self._read_pool: Optional[ReadConnectionPool] = None
+
+        # Buffered cache access stamps, see update_cache_file_access()
+        self._access_lock = threading.Lock()
+        self._access_pending: Dict[Tuple[str, Optional[int]], int] = {}
+        self._access_since = 0.0
+
         # Main thread connection (also stored in _local for consistency)
         self._main_thread_id = threading.get_ident()
         self.conn = self._create_connection()
@@ -929,11 +1187,9 @@ class PackageDatabase(
             Configured SQLite connection
         """
         if self.read_only:
-            uri = f"file:{self.db_path}?mode=ro"
-            conn = sqlite3.connect(uri, uri=True, check_same_thread=False)
-            conn.row_factory = sqlite3.Row
+            conn = self._create_read_connection()
             conn.execute("PRAGMA foreign_keys=ON")
-            conn.execute(f"PRAGMA busy_timeout={self.BUSY_TIMEOUT_MS}")
+            return conn
         else:
             conn = sqlite3.connect(str(self.db_path), check_same_thread=False)
             conn.row_factory = sqlite3.Row
@@ -948,6 +1204,64 @@ class PackageDatabase(
         _register_rpm_collation(conn)
         return conn
 
+    def _create_read_connection(self,
+                                cached_statements: int = 128) -> sqlite3.Connection:
+        """Open a ``mode=ro`` connection (read-only handles and the read pool)."""
+        uri = f"file:{self.db_path}?mode=ro"
+        conn = sqlite3.connect(uri, uri=True, check_same_thread=False,
+                               cached_statements=cached_statements)
+        conn.row_factory = sqlite3.Row
+        conn.execute(f"PRAGMA busy_timeout={self.BUSY_TIMEOUT_MS}")
+        _register_rpm_collation(conn)
+        return conn
+
+    def enable_read_pool(self, size: int = 4):
+        """Serve the hot read queries from a pool of read-only connections.
+
+        Meant for long-running multi-threaded readers (the D-Bus service):
+        search(), get_packages_by_names(), get_packages_info() and the
+        whatprovides/whatrequires family then run on up to ``size``
+        connections in parallel instead of queueing on ``self.conn``,
+        and keep answering from the last committed state while a media
+        refresh writes.  A no-op if the database file does not exist yet.
+        """
+        if self._read_pool is not None or not self.db_path.exists():
+            return
+        if not self.read_only:
+            self.ensure_wal_readable()
+        self._read_pool = ReadConnectionPool(
+            functools.partial(self._create_read_connection,
+                              self.READ_STATEMENT_CACHE),
+            size
+        )
+
+    @contextmanager
+    def reading(self):
+        """Run the enclosed queries on a pooled read-only connection.
+
+        Nested use keeps the outer lease.  Without a pool, or while this
+        thread's own connection has a transaction open (the queries must
+        see its uncommitted writes), queries stay on ``self.conn``.
+        """
+        pool = self._read_pool
+        own = getattr(self._local, 'conn', None)
+        if (pool is None
+                or getattr(self._local, 'read_conn', None) is not None
+                or (own is not None and own.in_transaction)):
+            yield
+            return
+        conn = pool.acquire()
+        self._local.read_conn = conn
+        try:
+            yield
+        finally:
+            self._local.read_conn = None
+            pool.release(conn)
+
+    def _read_conn(self) -> sqlite3.Connection:
+        """Connection for read queries: the pooled lease, else ``self.conn``."""
+        return getattr(self._local, 'read_conn', None) or self.conn
+
     def _get_connection(self) -> sqlite3.Connection:
         """Get the connection for the current thread.
 
@@ -1135,6 +1449,10 @@ class PackageDatabase(
                     self._migrate_v9_to_v10_test_servers(logger)
                 elif version == 18 and to_version == 19:
                     print("A new column 'filesize' has been added in database. To populate it, launch the command:\n   'urpm media update'")
+                elif version == 31 and to_version == 32:
+                    self._migrate_v31_to_v32_fts(logger)
+                elif version == 32 and to_version == 33:
+                    self._migrate_v32_to_v33_cache_usage(logger)
                 version = to_version
             except sqlite3.Error as e:
                 logger.error(f"Migration v{version} -> v{to_version} failed: {e}")
@@ -1424,6 +1742,33 @@ class PackageDatabase(
         if moved:
             logger.info(f"Migrated {moved} media directories to new structure")
 
+    def _migrate_v31_to_v32_fts(self, logger):
+        """Fill the recreated packages_fts from the packages table."""
+        has_packages = self.conn.execute(
+            "SELECT 1 FROM sqlite_master WHERE type='table' AND name='packages'"
+        ).fetchone()
+        if not has_packages:
+            return
+        logger.info("Rebuilding the package search index...")
+        self.conn.execute(
+            "INSERT INTO packages_fts(packages_fts) VALUES('rebuild')")
+        self.conn.commit()
+
+    def _migrate_v32_to_v33_cache_usage(self, logger):
+        """Create the cache usage index and fill it from cache_files."""
+        columns = {row[1] for row in self.conn.execute(
+            "PRAGMA table_info(cache_files)")}
+        if not {'is_referenced', 'last_accessed'} <= columns:
+            return
+        self.conn.executescript(CACHE_USAGE_SQL)
+        self.conn.execute("DELETE FROM cache_usage")
+        self.conn.execute("""
+            INSERT INTO cache_usage (media_id, file_count, total_size)
+            SELECT COALESCE(media_id, 0), COUNT(*), COALESCE(SUM(file_size), 0)
+            FROM cache_files GROUP BY COALESCE(media_id, 0)
+        """)
+        self.conn.commit()
+
     def _migrate_v9_to_v10_test_servers(self, logger):
         """Test all servers for IPv4/IPv6 connectivity and update ip_mode."""
         from .config import test_server_ip_connectivity
@@ -1496,7 +1841,12 @@ class PackageDatabase(
         threads end (e.g., when ThreadPoolExecutor workers terminate).
         """
         if not self.read_only:
+            if self.conn:
+                self.flush_cache_file_access()
             self.ensure_wal_readable()
+        if self._read_pool is not None:
+            self._read_pool.close()
+            self._read_pool = None
         # Close main thread connection
         if self.conn:
             self.conn.close()
@@ -1558,38 +1908,81 @@ class PackageDatabase(
         # Collect all packages first
         all_packages = list(packages)
         total = len(all_packages)
-        imported_nevras = {pkg['nevra'] for pkg in all_packages}
 
         if progress_callback:
             progress_callback(0, "preparing...")
 
+        # Diff against what the media already holds: a NEVRA whose
+        # content hash is unchanged is left alone, rows and deps alike.
+        # A refresh of an updates media then only touches the few
+        # packages that came and went.
+        stored = {}
+        if media_id:
+            cursor = conn.execute(
+                "SELECT id, nevra, name, version, release, arch, pkg_hash "
+                "FROM packages WHERE media_id = ?",
+                (media_id,)
+            )
+            stored = {row['nevra']: dict(row) for row in cursor}
+
+        changed = []        # (pkg, hash): new or modified NEVRAs
+        seen = set()
+        for pkg in all_packages:
+            pkg_hash = _package_hash(pkg, source)
+            seen.add(pkg['nevra'])
+            old = stored.get(pkg['nevra'])
+            if old is None or old['pkg_hash'] != pkg_hash:
+                changed.append((pkg, pkg_hash))
+        obsolete_packages = [row for nevra, row in stored.items()
+                             if nevra not in seen]
+        modified_ids = [stored[pkg['nevra']]['id'] for pkg, _ in changed
+                        if pkg['nevra'] in stored]
+
+        pkg_logger.debug(
+            "Import media %s: %d packages, %d new/changed, %d obsolete",
+            media_id, total, len(changed), len(obsolete_packages))
+
+        if not changed and not obsolete_packages:
+            if progress_callback:
+                progress_callback(total, "done")
+            return total
+
+        # FTS entries are kept in step row by row unless most of the
+        # media changed, where a single rebuild is cheaper
+        has_fts = bool(media_id) and self._has_packages_fts(conn)
+        fts_rebuild = has_fts and (
+            len(changed) + len(obsolete_packages)
+            > max(len(stored), total) * FTS_REBUILD_RATIO
+        )
+        fts_targeted = has_fts and not fts_rebuild
+
         # Begin transaction
         conn.execute("BEGIN TRANSACTION")
 
         try:
-            # Step 1: Delete all dependencies for this media (they can change)
-            if media_id:
+            # Step 1: Drop search entries and dependencies of rows about to
+            # change or go.  FTS 'delete' needs the values it indexed, so
+            # it must run before the content table is touched.
+            gone_ids = modified_ids + [p['id'] for p in obsolete_packages]
+            if gone_ids:
                 if progress_callback:
                     progress_callback(0, "clearing dependencies...")
-                for table in ('requires', 'provides', 'conflicts', 'obsoletes',
-                              'recommends', 'suggests', 'supplements', 'enhances'):
-                    conn.execute(f"""
-                        DELETE FROM {table} WHERE pkg_id IN
-                        (SELECT id FROM packages WHERE media_id = ?)
-                    """, (media_id,))
-
-            # Step 2: Find obsolete packages (in DB but not in new synthesis)
-            obsolete_packages = []
-            if media_id:
-                cursor = conn.execute(
-                    "SELECT id, nevra, name, version, release, arch FROM packages WHERE media_id = ?",
-                    (media_id,)
-                )
-                for row in cursor:
-                    if row['nevra'] not in imported_nevras:
-                        obsolete_packages.append(dict(row))
+                for chunk in _chunks(gone_ids):
+                    placeholders = ','.join('?' * len(chunk))
+                    if fts_targeted:
+                        conn.execute(f"""
+                            INSERT INTO packages_fts
+                                (packages_fts, rowid, name, summary, description)
+                            SELECT 'delete', id, name, summary, description
+                            FROM packages WHERE id IN ({placeholders})
+                        """, chunk)
+                    for table in DEPENDENCY_TABLES:
+                        conn.execute(
+                            f"DELETE FROM {table} WHERE pkg_id IN ({placeholders})",
+                            chunk
+                        )
 
-            # Step 3: Delete local cached files for obsolete packages
+            # Step 2: Delete local cached files for obsolete packages
             if obsolete_packages:
                 if progress_callback:
                     progress_callback(0, f"removing {len(obsolete_packages)} obsolete packages...")
@@ -1624,22 +2017,20 @@ class PackageDatabase(
                         )
 
                 # Delete obsolete packages from DB
-                obsolete_ids = [p['id'] for p in obsolete_packages]
-                placeholders = ','.join('?' * len(obsolete_ids))
-                conn.execute(
-                    f"DELETE FROM packages WHERE id IN ({placeholders})",
-                    obsolete_ids
-                )
+                for chunk in _chunks([p['id'] for p in obsolete_packages]):
+                    placeholders = ','.join('?' * len(chunk))
+                    conn.execute(
+                        f"DELETE FROM packages WHERE id IN ({placeholders})",
+                        chunk
+                    )
 
-            # Step 4: UPSERT packages (preserves added_timestamp and server_last_modified)
+            # Step 3: UPSERT new and changed packages (preserves
+            # added_timestamp and server_last_modified)
             if progress_callback:
                 progress_callback(0, "upserting packages...")
 
             pkg_rows = []
-            for pkg in all_packages:
-                hash_data = f"{pkg['nevra']}|{pkg.get('summary', '')}"
-                pkg_hash = hashlib.sha256(hash_data.encode()).hexdigest()[:16]
-
+            for pkg, pkg_hash in changed:
                 pkg_rows.append((
                     media_id,
                     pkg['name'],
@@ -1689,14 +2080,19 @@ class PackageDatabase(
             if progress_callback:
                 progress_callback(total, "indexing deps...")
 
-            # Build nevra -> pkg_id mapping
-            cursor = conn.execute(
-                "SELECT id, nevra FROM packages WHERE media_id = ?",
-                (media_id,)
-            )
-            nevra_to_id = {row[1]: row[0] for row in cursor}
+            # Build nevra -> pkg_id mapping for the rows just written
+            nevra_to_id = {}
+            changed_nevras = [pkg['nevra'] for pkg, _ in changed]
+            for chunk in _chunks(changed_nevras):
+                placeholders = ','.join('?' * len(chunk))
+                cursor = conn.execute(
+                    f"SELECT id, nevra FROM packages WHERE media_id IS ? "
+                    f"AND nevra IN ({placeholders})",
+                    (media_id, *chunk)
+                )
+                nevra_to_id.update((row[1], row[0]) for row in cursor)
 
-            # Step 5: Collect and insert all dependencies
+            # Step 4: Collect and insert their dependencies
             requires_rows = []
             provides_rows = []
             conflicts_rows = []
@@ -1706,7 +2102,7 @@ class PackageDatabase(
             supplements_rows = []
             enhances_rows = []
 
-            for pkg in all_packages:
+            for pkg, _ in changed:
                 pkg_id = nevra_to_id.get(pkg['nevra'])
                 if not pkg_id:
                     continue
@@ -1714,7 +2110,7 @@ class PackageDatabase(
                 for cap in pkg.get('requires', []):
                     requires_rows.append((pkg_id, cap))
                 for cap in pkg.get('provides', []):
-                    provides_rows.append((pkg_id, cap))
+                    provides_rows.append((pkg_id, cap, provide_name(cap)))
                 for cap in pkg.get('conflicts', []):
                     conflicts_rows.append((pkg_id, cap))
                 for cap in pkg.get('obsoletes', []):
@@ -1736,7 +2132,7 @@ class PackageDatabase(
                 )
             if provides_rows:
                 conn.executemany(
-                    "INSERT INTO provides (pkg_id, capability) VALUES (?, ?)",
+                    "INSERT INTO provides (pkg_id, capability, name) VALUES (?, ?, ?)",
                     provides_rows
                 )
             if conflicts_rows:
@@ -1771,12 +2167,23 @@ class PackageDatabase(
                     enhances_rows
                 )
 
+            if fts_targeted and nevra_to_id:
+                ids = list(nevra_to_id.values())
+                for chunk in _chunks(ids):
+                    placeholders = ','.join('?' * len(chunk))
+                    conn.execute(f"""
+                        INSERT INTO packages_fts(rowid, name, summary, description)
+                        SELECT id, name, summary, description
+                        FROM packages WHERE id IN ({placeholders})
+                    """, chunk)
+
             conn.commit()
 
-            # Rebuild FTS index after commit — external content FTS5
-            # requires a full rebuild because targeted DELETE/INSERT
-            # can desync when the content table changes mid-transaction.
-            if media_id and self._has_packages_fts(conn):
+            # Full rebuild after commit — external content FTS5 only
+            # stays in sync with targeted updates fed the old values,
+            # done above in the transaction; a mostly rewritten media
+            # goes through the rebuild instead.
+            if fts_rebuild:
                 if progress_callback:
                     progress_callback(total, "updating search index...")
                 conn.execute(
@@ -1800,8 +2207,7 @@ class PackageDatabase(
         """
         # Delete dependencies first (faster than CASCADE)
         pkg_subquery = "(SELECT id FROM packages WHERE media_id = ?)"
-        for table in ('requires', 'provides', 'conflicts', 'obsoletes',
-                      'recommends', 'suggests', 'supplements', 'enhances'):
+        for table in DEPENDENCY_TABLES:
             self.conn.execute(
                 f"DELETE FROM {table} WHERE pkg_id IN {pkg_subquery}",
                 (media_id,)
@@ -1864,12 +2270,13 @@ class PackageDatabase(
 
     def _has_packages_fts(self, conn=None) -> bool:
         """Check if the packages_fts virtual table exists."""
-        c = conn or self.conn
+        c = conn or self._read_conn()
         row = c.execute(
             "SELECT 1 FROM sqlite_master WHERE type='table' AND name='packages_fts'"
         ).fetchone()
         return row is not None
 
+    @_pooled_read
     def search(self, pattern: str, limit: int = None, search_provides: bool = False) -> List[Dict]:
         """Search packages by name, summary, and optionally provides.
 
@@ -1911,7 +2318,7 @@ class PackageDatabase(
             provides_params = (pattern_lower,) + version_params
             if limit:
                 remaining = limit - len(results)
-                cursor = self.conn.execute(f"""
+                cursor = self._read_conn().execute(f"""
                     SELECT DISTINCT p.id, p.name, p.version, p.release, p.arch,
                            p.nevra, p.summary, p.size, pr.capability as matched_provide
                     FROM packages p
@@ -1922,7 +2329,7 @@ class PackageDatabase(
                     LIMIT ?
                 """, provides_params + (remaining + len(seen_ids),))
             else:
-                cursor = self.conn.execute(f"""
+                cursor = self._read_conn().execute(f"""
                     SELECT DISTINCT p.id, p.name, p.version, p.release, p.arch,
                            p.nevra, p.summary, p.size, pr.capability as matched_provide
                     FROM packages p
@@ -1957,6 +2364,155 @@ class PackageDatabase(
 
         return results
 
+    @_pooled_read
+    def search_prefix(self, pattern: str, limit: int = 50,
+                      search_provides: bool = False,
+                      interrupted: Callable[[], bool] = None) -> Optional[List[Dict]]:
+        """Ranked, bounded search for search-as-you-type.
+
+        Unlike :meth:`search`, each step is an index lookup cut at
+        ``limit``, so a keystroke costs about the same whether the
+        pattern matches ten packages or ten thousand.  The indexes are
+        pinned with ``INDEXED BY``: with the version filter's media join
+        the planner would rather walk a whole media.  Results come in
+        rank tiers, each queried only while the limit is not reached:
+
+            1. Exact name
+            2. Name prefix (range scan on ``idx_pkg_name_lower``)
+            3. Word prefixes in name, summary or description (FTS5
+               prefix index), best bm25 first with name hits weighted
+               highest; skipped for one-character patterns, which match
+               most of the index
+            4. Provides name prefix (range scan on
+               ``idx_provides_name_lower``), if ``search_provides``
+
+        Args:
+            pattern: What was typed so far (case-insensitive)
+            limit: Maximum results
+            search_provides: Also match provides names
+            interrupted: Polled between tiers, and while the queries run
+                on a pooled connection; returning True aborts the search
+                (a newer query superseded it)
+
+        Returns:
+            List of package dicts as for :meth:`search`, or None if
+            interrupted.
+        """
+        needle = pattern.strip().lower()
+        if not needle or limit <= 0:
+            return []
+
+        version_join, version_filter, version_params = self._build_version_filter()
+        # Smallest string above every string starting with needle
+        upper = needle[:-1] + chr(ord(needle[-1]) + 1)
+        columns = """p.id, p.name, p.version, p.release, p.arch,
+                     p.nevra, p.summary, p.size"""
+
+        tiers = [
+            (f"""
+                SELECT {columns}
+                FROM packages p INDEXED BY idx_pkg_name_lower
+                {version_join}
+                WHERE p.name_lower = ? {version_filter}
+                ORDER BY p.id
+                LIMIT ?
+            """, (needle,), None),
+            (f"""
+                SELECT {columns}
+                FROM packages p INDEXED BY idx_pkg_name_lower
+                {version_join}
+                WHERE p.name_lower > ? AND p.name_lower < ? {version_filter}
+                ORDER BY p.name_lower, p.id
+                LIMIT ?
+            """, (needle, upper), None),
+        ]
+        if len(needle) >= 2 and self._has_packages_fts():
+            fts_query = ' '.join(
+                '"{}"*'.format(word.replace('"', '""')) for word in needle.split())
+            tiers.append((f"""
+                SELECT {columns}
+                FROM packages_fts
+                JOIN packages p ON p.id = packages_fts.rowid
+                {version_join}
+                WHERE packages_fts MATCH ? {version_filter}
+                ORDER BY bm25(packages_fts, 10.0, 2.0, 1.0), p.name_lower
+                LIMIT ?
+            """, (fts_query,), 'matched_summary'))
+        if search_provides:
+            tiers.append((f"""
+                SELECT {columns}, pr.capability AS matched_provide
+                FROM provides pr INDEXED BY idx_provides_name_lower
+                JOIN packages p ON p.id = pr.pkg_id
+                {version_join}
+                WHERE lower(pr.name) >= ? AND lower(pr.name) < ? {version_filter}
+                ORDER BY lower(pr.name), p.name_lower
+                LIMIT ?
+            """, (needle, upper), 'matched_provide'))
+
+        conn = self._read_conn()
+        # Only a leased connection is ours to interrupt: self.conn is
+        # shared with every other caller
+        handler = interrupted if conn is not self.conn else None
+        if handler is not None:
+            conn.set_progress_handler(handler, 1000)
+        results = []
+        seen = set()
+        try:
+            for sql, params, flag in tiers:
+                if len(results) >= limit:
+                    break
+                if interrupted is not None and interrupted():
+                    return None
+                # Over-fetch by what is already listed, which may repeat
+                fetch = limit - len(results) + len(seen)
+                for row in conn.execute(sql, params + version_params + (fetch,)):
+                    pkg = dict(row)
+                    # Same noarch package in several media: keep one
+                    nevra = pkg.get('nevra') or pkg['id']
+                    if pkg['id'] in seen or nevra in seen:
+                        continue
+                    seen.update((pkg['id'], nevra))
+                    if flag == 'matched_summary' and needle not in pkg['name'].lower():
+                        pkg['matched_summary'] = True
+                    results.append(pkg)
+                    if len(results) >= limit:
+                        break
+        except sqlite3.OperationalError:
+            if interrupted is not None and interrupted():
+                return None
+            raise
+        finally:
+            if handler is not None:
+                conn.set_progress_handler(None, 0)
+
+        for pkg in results:
+            pkg['installed'] = self._is_installed(pkg['name'])
+        return results
+
+    @_pooled_read
+    def search_generation(self) -> tuple:
+        """Token that changes whenever search results may change.
+
+        Cheap enough to check on every keystroke: an import that adds
+        packages raises ``MAX(id)``, every sync stamps its media's
+        ``last_sync`` and ``synthesis_md5``, and an install or removal
+        changes the rpmdb mtime (the ``installed`` flags).  A changed
+        rpmdb also drops the cached installed names.
+        """
+        from .resolution.pool import rpmdb_solv_key
+        rpmdb_key = rpmdb_solv_key()
+        if rpmdb_key != self._installed_key:
+            self._installed_cache = None
+            self._installed_pkgs_cache = None
+            self._installed_key = rpmdb_key
+
+        conn = self._read_conn()
+        max_id = conn.execute("SELECT MAX(id) FROM packages").fetchone()[0]
+        media = conn.execute("""
+            SELECT id, enabled, last_sync, synthesis_md5 FROM media ORDER BY id
+        """).fetchall()
+        return (max_id, tuple(tuple(row) for row in media), rpmdb_key)
+
     def _search_fts(self, pattern: str, limit: int,
                     version_join: str, version_filter: str,
                     version_params: tuple) -> tuple:
@@ -1978,7 +2534,7 @@ class PackageDatabase(
         limit_clause = f"LIMIT ?" if limit else ""
         limit_params = (limit,) if limit else ()
 
-        cursor = self.conn.execute(f"""
+        cursor = self._read_conn().execute(f"""
             SELECT p.id, p.name, p.version, p.release, p.arch,
                    p.nevra, p.summary, p.size,
                    (p.name_lower LIKE ?) AS is_name_match
@@ -2018,7 +2574,7 @@ class PackageDatabase(
 
         # Search by name
         if limit:
-            cursor = self.conn.execute(f"""
+            cursor = self._read_conn().execute(f"""
                 SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra, p.summary, p.size
                 FROM packages p
                 {version_join}
@@ -2027,7 +2583,7 @@ class PackageDatabase(
                 LIMIT ?
             """, base_params + (limit,))
         else:
-            cursor = self.conn.execute(f"""
+            cursor = self._read_conn().execute(f"""
                 SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra, p.summary, p.size
                 FROM packages p
                 {version_join}
@@ -2044,7 +2600,7 @@ class PackageDatabase(
         if limit is None or len(results) < limit:
             if limit:
                 remaining = limit - len(results)
-                cursor = self.conn.execute(f"""
+                cursor = self._read_conn().execute(f"""
                     SELECT p.id, p.name, p.version, p.release, p.arch,
                            p.nevra, p.summary, p.size
                     FROM packages p
@@ -2054,7 +2610,7 @@ class PackageDatabase(
                     LIMIT ?
                 """, base_params + (remaining + len(seen_ids),))
             else:
-                cursor = self.conn.execute(f"""
+                cursor = self._read_conn().execute(f"""
                     SELECT p.id, p.name, p.version, p.release, p.arch,
                            p.nevra, p.summary, p.size
                     FROM packages p
@@ -2251,6 +2807,7 @@ class PackageDatabase(
         return pkg
 
     _installed_cache: Optional[set] = None
+    _installed_key: Optional[str] = None      # rpmdb key of _installed_cache
 
     def _get_installed_names(self) -> set:
         """Get the set of all installed package names (cached)."""
@@ -2273,6 +2830,42 @@ class PackageDatabase(
         """Check if a package is installed in the RPM database."""
         return name in self._get_installed_names()
 
+    _installed_pkgs_cache: Optional[Dict[str, Dict]] = None
+
+    def _get_installed_packages(self) -> Dict[str, Dict]:
+        """Installed packages by NEVRA (cached with the installed names).
+
+        Values are dicts with the columns of a catalog row (name, epoch,
+        version, release, arch, nevra, summary).  ``gpg-pubkey`` entries,
+        which have no arch, are left out.
+        """
+        if self._installed_pkgs_cache is None:
+            installed = {}
+            try:
+                import subprocess
+                result = subprocess.run(
+                    ['rpm', '-qa', '--qf',
+                     '%{NAME}\t%{EPOCH}\t%{VERSION}\t%{RELEASE}\t%{ARCH}\t%{SUMMARY}\n'],
+                    capture_output=True, text=True, timeout=30
+                )
+                if result.returncode == 0:
+                    for line in result.stdout.splitlines():
+                        fields = line.split('\t', 5)
+                        if len(fields) != 6 or fields[4] == '(none)':
+                            continue
+                        name, epoch, version, release, arch, summary = fields
+                        nevra = f"{name}-{version}-{release}.{arch}"
+                        installed[nevra] = {
+                            'name': name,
+                            'epoch': int(epoch) if epoch.isdigit() else 0,
+                            'version': version, 'release': release,
+                            'arch': arch, 'nevra': nevra, 'summary': summary,
+                        }
+            except Exception:
+                pass
+            self._installed_pkgs_cache = installed
+        return self._installed_pkgs_cache
+
     def find_package_by_nevra(self, name: str, evr: str, arch: str) -> Optional[Dict]:
         """Find a package by name, evr (epoch:version-release), and arch.
 
@@ -2350,6 +2943,7 @@ class PackageDatabase(
         else:
             return self.get_package(identifier)
 
+    @_pooled_read
     def get_packages_by_names(self, names: List[str]) -> List[Dict]:
         """Batch get packages by names (for resolve operations).
 
@@ -2369,8 +2963,7 @@ class PackageDatabase(
         version_join, version_filter, version_params = self._build_version_filter()
 
         # Query all packages at once
-        placeholders = ','.join(['?' for _ in names])
-        names_lower = [n.lower() for n in names]
+        placeholders, names_params = _in_list(n.lower() for n in names)
 
         if version_join:
             query = f"""
@@ -2379,16 +2972,16 @@ class PackageDatabase(
                 {version_join}
                 WHERE p.name_lower IN ({placeholders}) {version_filter}
             """
-            params = tuple(names_lower) + version_params
+            params = names_params + version_params
         else:
             query = f"""
                 SELECT name, version, release, arch, summary
                 FROM packages
                 WHERE name_lower IN ({placeholders})
             """
-            params = tuple(names_lower)
+            params = names_params
 
-        cursor = self.conn.execute(query, params)
+        cursor = self._read_conn().execute(query, params)
         rows = cursor.fetchall()
 
         # Build result dict by name (handle duplicates - keep first/latest)
@@ -2432,6 +3025,158 @@ class PackageDatabase(
 
         return results
 
+    @_pooled_read
+    def get_packages_info(self, names: List[str]) -> List[Dict]:
+        """Batch get package details by names (for get-details operations).
+
+        One query for all names instead of one get_package() per name.
+        For each name the latest version wins, using the same ordering as
+        get_package(). Dependencies are not loaded.
+
+        Args:
+            names: List of package names (case-insensitive)
+
+        Returns:
+            List of package dicts (name, epoch, version, release, arch,
+            nevra, summary, description, size, group_name, url, license,
+            filesize), in input order; unknown names are skipped and
+            duplicate names yield one entry.
+        """
+        if not names:
+            return []
+
+        version_join, version_filter, version_params = self._build_version_filter()
+
+        names_lower = list(dict.fromkeys(n.lower() for n in names))
+        placeholders, names_params = _in_list(names_lower)
+
+        cursor = self._read_conn().execute(f"""
+            SELECT p.name, p.epoch, p.version, p.release, p.arch, p.nevra,
+                   p.summary, p.description, p.size, p.group_name, p.url,
+                   p.license, p.filesize, p.name_lower
+            FROM packages p
+            {version_join}
+            WHERE p.name_lower IN ({placeholders}) {version_filter}
+            ORDER BY p.name_lower,
+                     p.epoch COLLATE rpm_version_compare DESC,
+                     p.version COLLATE rpm_version_compare DESC,
+                     p.release COLLATE rpm_version_compare DESC
+        """, names_params + version_params)
+
+        latest = {}
+        for row in cursor:
+            pkg = dict(row)
+            key = pkg.pop('name_lower')
+            if key not in latest:
+                latest[key] = pkg
+
+        return [latest[key] for key in names_lower if key in latest]
+
+    @_pooled_read
+    def list_packages_page(self, after: str = '', limit: int = 500,
+                           arches: Optional[List[str]] = None,
+                           exclude_arches: bool = False,
+                           newest: bool = False,
+                           with_installed: bool = False) -> Tuple[List[Dict], str]:
+        """One page of the available-package catalog, keyset-paginated.
+
+        Pages are cut by package name: each holds the packages of the next
+        ``limit`` names after ``after`` (lowercase), so the query walks
+        ``idx_pkg_name_lower`` from the key instead of counting an offset
+        and memory stays bounded whatever the catalog size.  A NEVRA found
+        in several media is listed once.  Filters by system version like
+        search().
+
+        ``installed`` is set per NEVRA from the rpmdb: with foo-1.0
+        installed, foo-2.0 from an update medium is not installed.
+
+        Args:
+            after: Key returned by the previous page ('' for the first)
+            limit: Package names per page
+            arches: Only (or, with ``exclude_arches``, all but) these
+                architectures
+            exclude_arches: Invert the ``arches`` filter
+            newest: Keep only the latest EVR of each name and arch
+            with_installed: Also list installed packages found in no
+                enabled medium
+
+        Returns:
+            ``(packages, next_key)``; packages are dicts (name, epoch,
+            version, release, arch, nevra, summary, installed) ordered by
+            name then newest first, ``next_key`` is '' after the last page.
+        """
+        version_join, version_filter, version_params = self._build_version_filter()
+        arch_filter, arch_params = "", ()
+        if arches:
+            # Not padded by _in_list(): a NULL in NOT IN matches nothing
+            arch_params = tuple(arches)
+            arch_filter = (f"AND p.arch {'NOT IN' if exclude_arches else 'IN'} "
+                           f"({','.join('?' * len(arch_params))})")
+
+        installed = self._get_installed_packages()
+        local = []
+        if with_installed:
+            local = [pkg for pkg in installed.values()
+                     if pkg['name'].lower() > after
+                     and (not arches or (pkg['arch'] in arches) != exclude_arches)]
+
+        # INDEXED BY: left alone, the planner starts from the media
+        # join and sorts the whole catalog for every page
+        conn = self._read_conn()
+        keys = [row[0] for row in conn.execute(f"""
+            SELECT DISTINCT p.name_lower
+            FROM packages p INDEXED BY idx_pkg_name_lower
+            {version_join}
+            WHERE p.name_lower > ? {version_filter} {arch_filter}
+            ORDER BY p.name_lower
+            LIMIT ?
+        """, (after,) + version_params + arch_params + (limit,))]
+        all_keys = sorted(set(keys).union(pkg['name'].lower() for pkg in local))
+        keys = all_keys[:limit]
+        if not keys:
+            return [], ''
+
+        keys_in, keys_params = _in_list(keys)
+        cursor = conn.execute(f"""
+            SELECT p.name, p.epoch, p.version, p.release, p.arch, p.nevra,
+                   p.summary
+            FROM packages p
+            {version_join}
+            WHERE p.name_lower IN ({keys_in}) {version_filter} {arch_filter}
+            ORDER BY p.name_lower, p.arch,
+                     p.epoch COLLATE rpm_version_compare DESC,
+                     p.version COLLATE rpm_version_compare DESC,
+                     p.release COLLATE rpm_version_compare DESC
+        """, keys_params + version_params + arch_params)
+
+        rows = []
+        seen_nevras = set()
+        for row in cursor:
+            if row['nevra'] not in seen_nevras:
+                seen_nevras.add(row['nevra'])
+                rows.append(dict(row))
+
+        page_keys = set(keys)
+        local = [dict(pkg) for pkg in local
+                 if pkg['name'].lower() in page_keys
+                 and pkg['nevra'] not in seen_nevras]
+        if local:
+            rows = sorted(rows + local, key=functools.cmp_to_key(_catalog_order))
+
+        packages = []
+        seen_latest = set()
+        for pkg in rows:
+            if newest:
+                name_arch = (pkg['name'], pkg['arch'])
+                if name_arch in seen_latest:
+                    continue
+                seen_latest.add(name_arch)
+            pkg['installed'] = pkg['nevra'] in installed
+            packages.append(pkg)
+
+        next_key = keys[-1] if len(all_keys) >= limit else ''
+        return packages, next_key
+
     def _get_deps(self, pkg_id: int, table: str) -> List[str]:
         """Get dependencies from a specific table."""
         cursor = self.conn.execute(
@@ -2440,9 +3185,10 @@ class PackageDatabase(
         )
         return [row[0] for row in cursor]
 
+    @_pooled_read
     def whatprovides(self, capability: str) -> List[Dict]:
         """Find packages that provide a capability."""
-        cursor = self.conn.execute("""
+        cursor = self._read_conn().execute("""
             SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra
             FROM packages p
             JOIN provides pr ON pr.pkg_id = p.id
@@ -2452,9 +3198,79 @@ class PackageDatabase(
 
         return [dict(row) for row in cursor]
 
+    @_pooled_read
+    def whatprovides_any(self, capabilities: List[str]) -> List[Dict]:
+        """Find packages providing any of several capabilities.
+
+        Backed by the ``provides.name`` index, so ``foo`` also matches a
+        versioned ``foo[== 1.0]`` provide.  Capabilities in a
+        GLOB_PROVIDE_PREFIXES namespace are matched the other way round:
+        the package side is a glob (``modalias(pci:v00008086d*...)``)
+        tested against the concrete query, scanning only that namespace's
+        index range.  Filters by system version like search().
+
+        Args:
+            capabilities: Capability names (no version constraint)
+
+        Returns:
+            List of package dicts (id, name, version, release, arch,
+            nevra, summary, installed, matched_provide), one per NEVRA,
+            ordered by name
+        """
+        import fnmatch
+
+        caps = list(dict.fromkeys(c for c in capabilities if c))
+        if not caps:
+            return []
+
+        version_join, version_filter, version_params = self._build_version_filter()
+        select = f"""
+            SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra,
+                   p.summary, pr.name AS matched_provide
+            FROM provides pr
+            JOIN packages p ON p.id = pr.pkg_id
+            {version_join}
+        """
+
+        exact = [c for c in caps if not c.startswith(GLOB_PROVIDE_PREFIXES)]
+        rows = []
+        if exact:
+            placeholders, exact_params = _in_list(exact)
+            rows += self._read_conn().execute(
+                f"{select} WHERE pr.name IN ({placeholders}) {version_filter}",
+                exact_params + version_params
+            ).fetchall()
+
+        for prefix in GLOB_PROVIDE_PREFIXES:
+            wanted = [c for c in caps if c.startswith(prefix)]
+            if not wanted:
+                continue
+            # Index range scan over the namespace: prefix <= name < prefix'
+            upper = prefix[:-1] + chr(ord(prefix[-1]) + 1)
+            for row in self._read_conn().execute(
+                f"{select} WHERE pr.name >= ? AND pr.name < ? {version_filter}",
+                (prefix, upper) + version_params
+            ):
+                pattern = row['matched_provide']
+                if any(fnmatch.fnmatchcase(c, pattern) for c in wanted):
+                    rows.append(row)
+
+        installed = self._get_installed_packages()
+        results = []
+        seen_nevras = set()
+        for row in sorted(rows, key=lambda r: (r['name'].lower(), r['nevra'])):
+            if row['nevra'] in seen_nevras:
+                continue
+            seen_nevras.add(row['nevra'])
+            pkg = dict(row)
+            pkg['installed'] = pkg['nevra'] in installed
+            results.append(pkg)
+        return results
+
+    @_pooled_read
     def whatrequires(self, capability: str, limit: int = 50) -> List[Dict]:
         """Find packages that require a capability."""
-        cursor = self.conn.execute("""
+        cursor = self._read_conn().execute("""
             SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra
             FROM packages p
             JOIN requires r ON r.pkg_id = p.id
@@ -2465,6 +3281,53 @@ class PackageDatabase(
 
         return [dict(row) for row in cursor]
 
+    @_pooled_read
+    def whatrequires_any(self, capabilities: List[str],
+                         limit: Optional[int] = None) -> List[Dict]:
+        """Find packages that require any of several capabilities.
+
+        Batched whatrequires(): one query for the whole list. A package
+        requiring several of the capabilities, or present in several
+        media, is returned once.
+
+        Args:
+            capabilities: Capabilities to look up
+            limit: Maximum results (default: 50 per capability, as
+                whatrequires())
+
+        Returns:
+            List of package dicts (id, name, version, release, arch,
+            nevra, summary) ordered by name
+        """
+        caps = list(dict.fromkeys(capabilities))
+        if not caps:
+            return []
+        if limit is None:
+            limit = 50 * len(caps)
+
+        placeholders, caps_params = _in_list(caps)
+        cursor = self._read_conn().execute(f"""
+            SELECT p.id, p.name, p.version, p.release, p.arch, p.nevra,
+                   p.summary
+            FROM packages p
+            WHERE p.id IN (
+                SELECT r.pkg_id FROM requires r
+                WHERE r.capability IN ({placeholders})
+            )
+            ORDER BY p.name_lower
+        """, caps_params)
+
+        results = []
+        seen_nevras = set()
+        for row in cursor:
+            if row['nevra'] in seen_nevras:
+                continue
+            seen_nevras.add(row['nevra'])
+            results.append(dict(row))
+            if len(results) >= limit:
+                break
+        return results
+
     def whatrecommends(self, capability: str, limit: int = 50) -> List[Dict]:
         """Find packages that recommend a capability."""
         cursor = self.conn.execute("""
@@ -1,7 +1,16 @@
 """Cache file tracking database operations."""
 
+import logging
+import sqlite3
 import time
-from typing import Any, Dict, List, Optional
+from typing import Any, Dict, Iterable, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+# Access stamps are buffered in memory and written in one transaction
+# once this many are pending, or when the oldest is this old (seconds)
+ACCESS_FLUSH_BATCH = 256
+ACCESS_FLUSH_INTERVAL = 60
 
 
 class CacheMixin:
@@ -11,6 +20,13 @@ class CacheMixin:
         - self.conn: sqlite3.Connection
         - self._get_connection(): method returning thread-safe connection
         - self._lock: threading.Lock for thread safety
+        - self._access_lock, self._access_pending, self._access_since:
+          buffer of update_cache_file_access() stamps
+        - self.read_only: True when the database is opened ``mode=ro``
+
+    Per-media usage (``cache_usage``) is kept up to date by triggers on
+    ``cache_files``, so quota checks read one row instead of summing the
+    table.
     """
 
     def register_cache_file(self, filename: str, media_id: int, file_path: str,
@@ -34,16 +50,58 @@ class CacheMixin:
             Cache file ID.
         """
         with self._lock:
-            now = int(time.time())
-            cursor = self.conn.execute("""
-                INSERT OR REPLACE INTO cache_files
-                (filename, media_id, file_path, file_size, added_time,
-                 last_accessed, is_referenced, served_by_server_id)
-                VALUES (?, ?, ?, ?, ?, ?, 1, ?)
-            """, (filename, media_id, file_path, file_size, now, now,
-                  served_by_server_id))
+            self._upsert_cache_files(self.conn, [
+                (filename, media_id, file_path, file_size, served_by_server_id)
+            ])
             self.conn.commit()
-            return cursor.lastrowid
+            row = self.conn.execute(
+                "SELECT id FROM cache_files WHERE filename = ? AND media_id IS ?",
+                (filename, media_id)
+            ).fetchone()
+            return row[0] if row else None
+
+    def register_cache_files(self, files: Iterable[Tuple[str, int, str, int]]) -> int:
+        """Register several cached files in one transaction.
+
+        Args:
+            files: (filename, media_id, file_path, file_size) tuples
+
+        Returns:
+            Number of files registered
+        """
+        rows = [(filename, media_id, file_path, file_size, None)
+                for filename, media_id, file_path, file_size in files]
+        if not rows:
+            return 0
+        with self._lock:
+            self._upsert_cache_files(self.conn, rows)
+            self.conn.commit()
+        return len(rows)
+
+    @staticmethod
+    def _upsert_cache_files(conn, rows):
+        """Insert or refresh cache rows (filename, media_id, file_path,
+        file_size, served_by_server_id).
+
+        An upsert rather than INSERT OR REPLACE: the rows REPLACE
+        deletes do not fire the delete trigger that keeps
+        ``cache_usage`` in step.
+        """
+        now = int(time.time())
+        conn.executemany("""
+            INSERT INTO cache_files
+            (filename, media_id, file_path, file_size, added_time,
+             last_accessed, is_referenced, served_by_server_id)
+            VALUES (?, ?, ?, ?, ?, ?, 1, ?)
+            ON CONFLICT(filename, media_id) DO UPDATE SET
+                file_path = excluded.file_path,
+                file_size = excluded.file_size,
+                added_time = excluded.added_time,
+                last_accessed = excluded.last_accessed,
+                is_referenced = 1,
+                served_by_server_id = excluded.served_by_server_id
+        """, [(filename, media_id, file_path, file_size, now, now, server_id)
+              for filename, media_id, file_path, file_size, server_id in rows])
 
     def get_cache_file_server_id(self, file_path: str) -> Optional[int]:
         """Return the server id that served a cached file, or None.
@@ -81,20 +139,80 @@ class CacheMixin:
         row = cursor.fetchone()
         return dict(row) if row else None
 
-    def update_cache_file_access(self, filename: str, media_id: int = None):
-        """Update last_accessed timestamp for a cache file."""
+    def update_cache_file_access(self, filename: str, media_id: int = None,
+                                 flush: bool = True):
+        """Record an access to a cache file (for LRU eviction). Thread-safe.
+
+        The stamp is buffered; :meth:`flush_cache_file_access` writes the
+        pending ones in one transaction, at the latest after
+        ACCESS_FLUSH_BATCH accesses or ACCESS_FLUSH_INTERVAL seconds, and
+        before the cache is listed from this handle.
+
+        With ``flush=False`` the stamp is only buffered, for callers on
+        short-lived threads (urpmd's HTTP handlers) that should not open
+        a connection: a long-lived thread collects them with
+        :meth:`take_cache_file_access`.
+        """
         now = int(time.time())
-        if media_id:
-            self.conn.execute(
-                "UPDATE cache_files SET last_accessed = ? WHERE filename = ? AND media_id = ?",
-                (now, filename, media_id)
-            )
-        else:
-            self.conn.execute(
-                "UPDATE cache_files SET last_accessed = ? WHERE filename = ?",
-                (now, filename)
-            )
-        self.conn.commit()
+        with self._access_lock:
+            if not self._access_pending:
+                self._access_since = time.monotonic()
+            self._access_pending[(filename, media_id or None)] = now
+            due = (len(self._access_pending) >= ACCESS_FLUSH_BATCH
+                   or time.monotonic() - self._access_since >= ACCESS_FLUSH_INTERVAL)
+        if due and flush:
+            self.flush_cache_file_access()
+
+    def take_cache_file_access(self) -> Dict[Tuple[str, Optional[int]], int]:
+        """Remove and return the buffered access stamps. Thread-safe.
+
+        Returns:
+            Dict of (filename, media_id or None) -> access time, for
+            :meth:`flush_cache_file_access` of any handle on the database
+        """
+        with self._access_lock:
+            pending, self._access_pending = self._access_pending, {}
+        return pending
+
+    def flush_cache_file_access(self, stamps: Dict = None) -> int:
+        """Write buffered access stamps. Thread-safe.
+
+        Stamps are advisory: if the write fails they are dropped.
+
+        Args:
+            stamps: Stamps taken from another handle with
+                :meth:`take_cache_file_access`, written along with this
+                handle's own
+
+        Returns:
+            Number of stamps written
+        """
+        pending = self.take_cache_file_access()
+        for key, ts in (stamps or {}).items():
+            pending[key] = max(ts, pending.get(key, 0))
+        if not pending or self.read_only:
+            return 0
+
+        by_media = [(ts, filename, media_id)
+                    for (filename, media_id), ts in pending.items() if media_id]
+        by_name = [(ts, filename)
+                   for (filename, media_id), ts in pending.items() if not media_id]
+        conn = self._get_connection()
+        try:
+            with self._lock:
+                conn.executemany("""
+                    UPDATE cache_files SET last_accessed = MAX(COALESCE(last_accessed, 0), ?)
+                    WHERE filename = ? AND media_id = ?
+                """, by_media)
+                conn.executemany("""
+                    UPDATE cache_files SET last_accessed = MAX(COALESCE(last_accessed, 0), ?)
+                    WHERE filename = ?
+                """, by_name)
+                conn.commit()
+        except sqlite3.Error as e:
+            logger.debug("Dropped %d cache access stamps: %s", len(pending), e)
+            return 0
+        return len(pending)
 
     def list_cache_files(self, media_id: int = None, referenced_only: bool = False,
                          order_by: str = 'added_time', limit: int = None) -> List[Dict]:
@@ -109,6 +227,7 @@ class CacheMixin:
         Returns:
             List of cache file dicts
         """
+        self.flush_cache_file_access()
         query = "SELECT * FROM cache_files WHERE 1=1"
         params = []
 
@@ -180,6 +299,28 @@ class CacheMixin:
         conn.commit()
         return cursor.rowcount > 0
 
+    def delete_cache_files(self, keys: Iterable[Tuple[str, int]]) -> int:
+        """Delete several cache file records in one transaction. Thread-safe.
+
+        Args:
+            keys: (filename, media_id) pairs
+
+        Returns:
+            Number of records deleted
+        """
+        keys = list(keys)
+        if not keys:
+            return 0
+        conn = self._get_connection()
+        with self._lock:
+            cursor = conn.executemany(
+                "DELETE FROM cache_files WHERE filename = ? AND media_id IS ?",
+                keys
+            )
+            deleted = cursor.rowcount
+            conn.commit()
+        return deleted
+
     def unregister_cache_file(self, file_path: str) -> bool:
         """Delete the cache record matching an absolute or relative file path.
 
@@ -238,20 +379,49 @@ class CacheMixin:
         row = cursor.fetchone()
         return dict(row) if row else {}
 
+    def get_cache_usage(self, media_id: int = None) -> Dict[str, int]:
+        """Cached bytes and files, from the trigger-maintained index.
+
+        Args:
+            media_id: Filter by media (None = whole cache)
+
+        Returns:
+            Dict with 'total_size' and 'file_count'
+        """
+        if media_id:
+            row = self.conn.execute(
+                "SELECT total_size, file_count FROM cache_usage WHERE media_id = ?",
+                (media_id,)
+            ).fetchone()
+        else:
+            row = self.conn.execute("""
+                SELECT COALESCE(SUM(total_size), 0), COALESCE(SUM(file_count), 0)
+                FROM cache_usage
+            """).fetchone()
+        if row is None:
+            return {'total_size': 0, 'file_count': 0}
+        return {'total_size': row[0], 'file_count': row[1]}
+
     def get_files_to_evict(self, media_id: int = None, max_bytes: int = None,
-                           max_age_days: int = None) -> List[Dict]:
+                           max_age_days: int = None,
+                           unreferenced_only: bool = False) -> List[Dict]:
         """Get list of files that should be evicted based on criteria.
 
         Priority: unreferenced files first, then oldest by last_accessed.
+        The rows are read in that order straight from the eviction
+        indexes and reading stops once ``max_bytes`` is covered, so the
+        cost follows the number of files returned, not the cache size.
 
         Args:
             media_id: Filter by media (None = all)
             max_bytes: Stop when we have enough bytes to free
             max_age_days: Include files older than this
+            unreferenced_only: Only files no longer in any synthesis
 
         Returns:
             List of cache file dicts to evict
         """
+        self.flush_cache_file_access()
         query = """
             SELECT * FROM cache_files
             WHERE 1=1
@@ -262,6 +432,9 @@ class CacheMixin:
             query += " AND media_id = ?"
             params.append(media_id)
 
+        if unreferenced_only:
+            query += " AND is_referenced = 0"
+
         if max_age_days:
             cutoff = int(time.time()) - (max_age_days * 86400)
             query += " AND added_time < ?"
@@ -270,18 +443,11 @@ class CacheMixin:
         # Order: unreferenced first, then oldest accessed
         query += " ORDER BY is_referenced ASC, last_accessed ASC"
 
-        cursor = self.conn.execute(query, params)
-        files = [dict(row) for row in cursor]
-
-        if max_bytes:
-            # Only return enough files to free max_bytes
-            result = []
-            total = 0
-            for f in files:
-                result.append(f)
-                total += f['file_size']
-                if total >= max_bytes:
-                    break
-            return result
-
-        return files
+        result = []
+        total = 0
+        for row in self.conn.execute(query, params):
+            result.append(dict(row))
+            total += row['file_size']
+            if max_bytes and total >= max_bytes:
+                break
+        return result
@@ -21,6 +21,7 @@ from typing import List, Optional, Callable, Tuple, Dict, Set
 
 import pycurl
 
+from . import http_pool
 from .database import PackageDatabase
 from .config import get_base_dir, is_dev_mode
 from .peer_client import (
@@ -153,6 +154,13 @@ def verify_rpm_signature(rpm_path: Path) -> tuple:
         return (False, f"Verification error: {e}")
 
 
+def _peer_url(peer: Peer, peer_path: str) -> str:
+    """Build the download URL of a file served by a peer."""
+    from urllib.parse import quote
+    # URL-encode the path (but keep slashes)
+    return f"{peer.base_url}/media/{quote(peer_path, safe='/')}"
+
+
 def get_hostname_from_url(url: str) -> str:
     """Extract hostname from a URL for cache organization."""
     from urllib.parse import urlparse
@@ -288,6 +296,36 @@ class DownloadProgress:
         return (newest_bytes - oldest_bytes) / elapsed
 
 
+# ── Range-split downloads ─────────────────────────────────────────────
+#
+# Per-file parallelism leaves one huge package (texlive, kernel-devel,
+# firmware) bound by a single mirror connection while the other workers
+# idle at the end of the batch.  Files of at least
+# ``download.split_size_mb`` are fetched as _SPLIT_CHUNK_SIZE ranges
+# from several mirrors and LAN peers at once.  Each source pulls the
+# next range as soon as it finishes one, so faster sources naturally
+# take more of the file; once fewer ranges remain than sources, a
+# source much slower than the best one stops taking ranges instead of
+# holding the last piece hostage.
+
+_SPLIT_CHUNK_SIZE = 8 * 1048576
+_SPLIT_MAX_SOURCES = 4
+_SPLIT_SOURCE_FAILURES = 2   # failed ranges before a source is dropped
+_SPLIT_SLOW_RATIO = 0.5      # endgame cutoff relative to the fastest source
+_SPLIT_SAMPLE_INTERVAL = 0.25
+
+
+@dataclass
+class RangeSource:
+    """A mirror or peer serving byte ranges of a split download."""
+    name: str
+    url: str
+    source_type: str              # 'server' or 'peer'
+    server_id: Optional[int] = None
+    peer: Optional[Peer] = None
+    ip_mode: str = 'auto'
+
+
 class DownloadCoordinator:
     """Coordinates parallel downloads with queue-based architecture.
 
@@ -371,6 +409,69 @@ class DownloadCoordinator:
         )
         return alternatives[0] if alternatives else None
 
+    def split_sources(self, item: DownloadItem) -> List[RangeSource]:
+        """Sources a large file can be split across, best first.
+
+        LAN peers come first, then mirrors by measured speed (session
+        EWMA, falling back to the stored bandwidth).  Saturated and
+        excluded mirrors are left out, as are all mirrors in
+        ``only_peers`` mode.
+        """
+        sources = []
+        if self._peer_availability:
+            for peer, path in self._peer_availability.get_peers_for_file(
+                    item.filename, exclude=self.get_failed_peers()):
+                sources.append(RangeSource(
+                    name=f"peer@{peer.host}", url=_peer_url(peer, path),
+                    source_type='peer', peer=peer))
+        if self.downloader.only_peers:
+            return sources
+
+        if item.uses_new_schema():
+            from .settings import get_settings
+            max_per = get_settings().download.max_per_server
+            with self.downloader._session_stats_lock:
+                speeds = dict(self.downloader._session_server_kbps)
+            with self.downloader._server_slots_lock:
+                active = dict(self.downloader._server_active_slots)
+            servers = [
+                s for s in item.servers
+                if s.get('id') not in item.exclude_server_ids
+                and active.get(s.get('id'), 0) < max_per
+            ]
+            servers.sort(key=lambda s: speeds.get(
+                s.get('id'), s.get('bandwidth_kbps') or 0), reverse=True)
+            for server in servers:
+                sources.append(RangeSource(
+                    name=server['name'],
+                    url=self.downloader._build_package_url(
+                        server, item.relative_path, item.filename),
+                    source_type='server', server_id=server.get('id'),
+                    ip_mode=server.get('ip_mode', 'auto')))
+        elif item.url:
+            sources.append(RangeSource(
+                name=get_hostname_from_url(item.url), url=item.url,
+                source_type='server', ip_mode='ipv4'))
+        return sources
+
+    def _download_split(self, item: DownloadItem, slot: int,
+                        progress_cb: Callable[[int, int], None]
+                        ) -> Optional[DownloadResult]:
+        """Range-split download of a large item, or None if not applicable."""
+        from .settings import get_settings
+        split_bytes = get_settings().download.split_size_mb * 1048576
+        if not split_bytes or (item.size or 0) < split_bytes:
+            return None
+        sources = self.split_sources(item)
+        if len(sources) < 2:
+            return None
+        self.start_download(
+            slot, item.name, item.size,
+            f"{min(len(sources), _SPLIT_MAX_SOURCES)} sources",
+            sources[0].source_type)
+        return self.downloader.download_split(item, sources,
+                                              progress_callback=progress_cb)
+
     def start_download(self, slot: int, item_name: str, bytes_total: int,
                         source: str, source_type: str):
         """Start tracking a new download for a worker slot (thread-safe)."""
@@ -529,6 +630,13 @@ class DownloadCoordinator:
         last_peer_error: Optional[str] = None
 
         try:
+            # Large files: ranges from several mirrors and peers at once
+            result = self._download_split(item, slot, progress_cb)
+            if result is not None:
+                if result.success:
+                    return result
+                logger.debug(f"{result.error}; downloading {item.filename} whole")
+
             # Try peer download if assigned
             if assignment and assignment.source == 'peer' and assignment.peer:
                 peer = assignment.peer
@@ -612,13 +720,17 @@ class DownloadCoordinator:
 
     def download_all(self, items: List[DownloadItem],
                      peer_availability: Dict,
-                     progress_callback: Callable = None) -> Tuple[List[DownloadResult], dict]:
+                     progress_callback: Callable = None,
+                     result_callback: Callable[[DownloadResult], None] = None
+                     ) -> Tuple[List[DownloadResult], dict]:
         """Download all items using queue-based parallel processing.
 
         Args:
             items: List of items to download
             peer_availability: Dict[filename, List[PeerPackageInfo]] from query_peers_have()
             progress_callback: Optional callback(name, pkg_num, total, bytes, total_bytes)
+            result_callback: Optional callback(result), called on this
+                thread as soon as each item is done
 
         Returns:
             Tuple of (results, stats)
@@ -690,6 +802,8 @@ class DownloadCoordinator:
                 # Short timeout to stay responsive and allow progress updates
                 result = self._results_queue.get(timeout=0.1)
                 results.append(result)
+                if result_callback:
+                    result_callback(result)
 
                 # ── Mid-session replan check ────────────────────────
                 if (not _replanned
@@ -1160,7 +1274,9 @@ class Downloader:
 
         Uses **pycurl** (libcurl C bindings) so the entire transfer runs
         in native code without holding the GIL.  This matches wget/curl
-        throughput even under heavy multithreading.
+        throughput even under heavy multithreading.  The handle comes
+        from :mod:`http_pool`, so consecutive files from one mirror
+        reuse its keep-alive connection.
 
         Args:
             url: URL to download
@@ -1177,7 +1293,7 @@ class Downloader:
             same mirror or move on.
         """
         temp_path = cache_path.with_suffix('.tmp')
-        c = pycurl.Curl()
+        c = http_pool.acquire()
         f = None
         try:
             f = open(temp_path, 'wb')
@@ -1246,7 +1362,7 @@ class Downloader:
         # handling, ResourceWarning, …) propagate — silencing them
         # here masked real bugs as "download failed" in past releases.
         finally:
-            c.close()
+            http_pool.release(c)
             if f is not None:
                 f.close()
             # Clean up temp on failure
@@ -1530,15 +1646,11 @@ class Downloader:
         Returns:
             DownloadResult with status
         """
-        from urllib.parse import quote
-
         cache_path = self.get_cache_path(item)
-        # URL-encode the path (but keep slashes)
-        encoded_path = quote(peer_path, safe='/')
-        url = f"{peer.base_url}/media/{encoded_path}"
+        url = _peer_url(peer, peer_path)
 
         temp_path = cache_path.with_suffix('.tmp')
-        c = pycurl.Curl()
+        c = http_pool.acquire()
         f = None
         try:
             f = open(temp_path, 'wb')
@@ -1640,7 +1752,7 @@ class Downloader:
                 item=item, success=False,
                 error=f"Peer download failed: {e}")
         finally:
-            c.close()
+            http_pool.release(c)
             if f is not None:
                 f.close()
             if temp_path.exists() and not cache_path.exists():
@@ -1649,8 +1761,360 @@ class Downloader:
                 except OSError:
                     pass
 
+    def _fetch_range(self, source: RangeSource, fd: Optional[int],
+                     start: int, end: int,
+                     progress_callback: Callable[[int], None] = None,
+                     timeout: int = 30
+                     ) -> Tuple[Optional[int], Optional[DownloadError]]:
+        """Fetch bytes ``start``..``end`` (inclusive) of a source.
+
+        Data is written at its file offset with ``os.pwrite()`` so ranges
+        from several sources can fill the same temp file concurrently;
+        ``fd=None`` only probes the source.
+
+        Args:
+            source: Mirror or peer to fetch from
+            fd: Open file descriptor of the temp file, or None
+            start: First byte offset
+            end: Last byte offset (inclusive)
+            progress_callback: Optional callback(bytes_of_this_range)
+            timeout: Connection timeout in seconds
+
+        Returns:
+            ``(file_size, None)`` with the total size announced by the
+            ``Content-Range`` header, or ``(None, DownloadError)``.  A
+            source that ignores ranges is a ``HARD_HTTP`` failure.
+        """
+        c = http_pool.acquire()
+        headers: Dict[str, str] = {}
+        pos = start
+        overflow = False
+        write_error: Optional[OSError] = None
+
+        def _header(line: bytes):
+            name, sep, value = line.decode('iso-8859-1').partition(':')
+            if sep:
+                headers[name.strip().lower()] = value.strip()
+
+        def _write(data: bytes):
+            nonlocal pos, overflow, write_error
+            if pos + len(data) > end + 1:
+                # Whole body instead of the requested range
+                overflow = True
+                return 0
+            try:
+                if fd is not None:
+                    os.pwrite(fd, data, pos)
+            except OSError as e:
+                write_error = e
+                return 0
+            pos += len(data)
+            if progress_callback:
+                progress_callback(pos - start)
+            return None
+
+        try:
+            c.setopt(pycurl.URL, source.url)
+            c.setopt(pycurl.RANGE, f"{start}-{end}")
+            c.setopt(pycurl.HEADERFUNCTION, _header)
+            c.setopt(pycurl.WRITEFUNCTION, _write)
+            c.setopt(pycurl.FOLLOWLOCATION, 1)
+            c.setopt(pycurl.MAXREDIRS, 5)
+            c.setopt(pycurl.CONNECTTIMEOUT, timeout)
+            c.setopt(pycurl.LOW_SPEED_LIMIT, 1024)
+            c.setopt(pycurl.LOW_SPEED_TIME, timeout)
+            c.setopt(pycurl.USERAGENT, 'urpm/0.7')
+            c.setopt(pycurl.HTTPHEADER, ['Accept-Encoding: identity'])
+            c.setopt(pycurl.BUFFERSIZE, _CHUNK_SIZE)
+            c.setopt(pycurl.NOSIGNAL, 1)
+            c.setopt(pycurl.NOPROGRESS, 1)
+            if source.ip_mode == 'ipv6':
+                c.setopt(pycurl.IPRESOLVE, pycurl.IPRESOLVE_V6)
+            elif source.ip_mode in ('ipv4', 'auto', 'dual'):
+                c.setopt(pycurl.IPRESOLVE, pycurl.IPRESOLVE_V4)
+
+            try:
+                c.perform()
+            except pycurl.error as e:
+                if write_error is not None:
+                    return None, DownloadError(
+                        kind=DownloadErrorKind.LOCAL_IO,
+                        message=str(write_error),
+                    )
+                if not overflow:
+                    _code, msg = e.args
+                    return None, DownloadError(
+                        kind=DownloadErrorKind.TRANSIENT_NETWORK,
+                        message=f"libcurl error: {msg}",
+                    )
+
+            http_code = c.getinfo(pycurl.HTTP_CODE)
+            if http_code >= 400:
+                return None, DownloadError(
+                    kind=DownloadErrorKind.HARD_HTTP,
+                    message=f"HTTP {http_code}",
+                    http_code=http_code,
+                )
+            if overflow or http_code != 206:
+                return None, DownloadError(
+                    kind=DownloadErrorKind.HARD_HTTP,
+                    message="byte ranges not supported",
+                    http_code=http_code,
+                )
+            if pos != end + 1:
+                return None, DownloadError(
+                    kind=DownloadErrorKind.TRANSIENT_NETWORK,
+                    message=f"short range ({pos - start} of "
+                            f"{end - start + 1} bytes)",
+                )
+            total = headers.get('content-range', '').rpartition('/')[2]
+            if not total.isdigit():
+                return None, DownloadError(
+                    kind=DownloadErrorKind.HARD_HTTP,
+                    message="missing Content-Range size",
+                    http_code=http_code,
+                )
+            return int(total), None
+        finally:
+            http_pool.release(c)
+
+    def download_split(self, item: DownloadItem, sources: List[RangeSource],
+                       progress_callback: Callable[[int, int], None] = None,
+                       timeout: int = 30,
+                       max_retries: int = 3) -> Optional[DownloadResult]:
+        """Download one large file as byte ranges from several sources.
+
+        Every source runs in its own thread and pulls the next pending
+        range when it is done with one.  A failed range goes back to
+        the queue for another source (up to ``max_retries`` attempts);
+        a source is dropped after a hard failure or
+        _SPLIT_SOURCE_FAILURES failed ranges.  In the endgame, sources
+        whose :meth:`DownloadProgress.get_speed` is below
+        _SPLIT_SLOW_RATIO of the fastest one stop taking ranges.
+
+        The reassembled file is checked with :func:`is_valid_rpm`, and
+        its signature verified when any peer served part of it.
+
+        Args:
+            item: Package to download
+            sources: Candidate sources, best first
+            progress_callback: Optional callback(downloaded, total)
+            timeout: Connection timeout in seconds
+            max_retries: Attempts per range before giving up
+
+        Returns:
+            A DownloadResult, or None when splitting does not apply
+            (fewer than two sources answer ranges, or the file is below
+            ``download.split_size_mb``); the caller then downloads the
+            file normally.
+        """
+        from .settings import get_settings
+
+        split_bytes = get_settings().download.split_size_mb * 1048576
+        if not split_bytes:
+            return None
+
+        # Probe every source the file would be split across for range
+        # support and the real size (item.size is a hint); one that
+        # reports another size does not serve the same file
+        total = None
+        usable: List[RangeSource] = []
+        for source in sources:
+            if len(usable) >= _SPLIT_MAX_SOURCES:
+                break
+            size, error = self._fetch_range(source, None, 0, 0,
+                                            timeout=timeout)
+            if size is None:
+                logger.debug("No ranges from %s for %s: %s",
+                             source.name, item.filename, error)
+                continue
+            if total is None:
+                if size < split_bytes:
+                    return None
+                total = size
+            elif size != total:
+                logger.debug("%s has %s at %d bytes, not %d",
+                             source.name, item.filename, size, total)
+                continue
+            usable.append(source)
+        if len(usable) < 2:
+            return None
+
+        cache_path = self.get_cache_path(item)
+        temp_path = cache_path.with_suffix('.tmp')
+
+        pending = [(offset, 0) for offset in range(0, total, _SPLIT_CHUNK_SIZE)]
+        pending.reverse()        # pop() hands out ranges in file order
+        cond = threading.Condition()
+        in_flight: Dict[int, int] = {}      # source index -> bytes of range
+        running: Set[int] = set()
+        contributed = [0] * len(usable)
+        completed = 0
+        errors: List[str] = []
+        failed = False
+        t_start = _time_mod.time()
+        speeds = [
+            DownloadProgress(name=item.name, bytes_done=0, bytes_total=total,
+                             source=src.name, source_type=src.source_type,
+                             start_time=t_start)
+            for src in usable
+        ]
+
+        def report():
+            if progress_callback:
+                progress_callback(completed + sum(in_flight.values()), total)
+
+        def too_slow(idx: int) -> bool:
+            # Only once fewer ranges remain than sources to take them
+            if len(pending) >= len(running) or len(speeds[idx].samples) < 2:
+                return False
+            best = max(speeds[i].get_speed() for i in running)
+            return speeds[idx].get_speed() < _SPLIT_SLOW_RATIO * best
+
+        def run(idx: int, source: RangeSource, fd: int):
+            nonlocal completed, failed
+            failures = 0
+            last_sample = 0.0
+            try:
+                while True:
+                    with cond:
+                        while not failed and not pending and in_flight:
+                            # A range in flight elsewhere may come back
+                            cond.wait(0.5)
+                        if failed or not pending or too_slow(idx):
+                            return
+                        offset, attempts = pending.pop()
+                        in_flight[idx] = 0
+                    end = min(offset + _SPLIT_CHUNK_SIZE, total) - 1
+                    base = contributed[idx]
+
+                    def on_bytes(done: int):
+                        nonlocal last_sample
+                        now = _time_mod.time()
+                        with cond:
+                            in_flight[idx] = done
+                            if now - last_sample >= _SPLIT_SAMPLE_INTERVAL:
+                                last_sample = now
+                                speeds[idx].add_sample(base + done)
+                            report()
+
+                    _, error = self._fetch_range(source, fd, offset, end,
+                                                 on_bytes, timeout)
+                    with cond:
+                        del in_flight[idx]
+                        if error is None:
+                            failures = 0
+                            completed += end - offset + 1
+                            contributed[idx] += end - offset + 1
+                            speeds[idx].add_sample(contributed[idx])
+                        else:
+                            failures += 1
+                            errors.append(f"{source.name}: {error}")
+                            if attempts + 1 >= max_retries:
+                                failed = True
+                            else:
+                                pending.append((offset, attempts + 1))
+                        report()
+                        cond.notify_all()
+                    if error is not None and (
+                            error.is_hard or failures >= _SPLIT_SOURCE_FAILURES):
+                        logger.debug("Dropping %s from split download of %s",
+                                     source.name, item.filename)
+                        return
+            finally:
+                with cond:
+                    running.discard(idx)
+                    cond.notify_all()
+
+        server_ids = [src.server_id for src in usable if src.server_id]
+        with self._server_slots_lock:
+            for sid in server_ids:
+                self._server_active_slots[sid] = (
+                    self._server_active_slots.get(sid, 0) + 1)
+        fd = None
+        try:
+            fd = os.open(temp_path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+            os.ftruncate(fd, total)
+            running.update(range(len(usable)))
+            threads = [
+                threading.Thread(target=run, args=(idx, src, fd), daemon=True)
+                for idx, src in enumerate(usable)
+            ]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            os.close(fd)
+            fd = None
+
+            if failed or pending:
+                return DownloadResult(
+                    item=item, success=False,
+                    error=f"Split download failed: {'; '.join(errors[-3:])}")
+            temp_path.rename(cache_path)
+        except OSError as e:
+            return DownloadResult(
+                item=item, success=False,
+                error=f"Split download failed: {e}")
+        finally:
+            if fd is not None:
+                os.close(fd)
+            with self._server_slots_lock:
+                for sid in server_ids:
+                    cur = self._server_active_slots.get(sid, 1)
+                    self._server_active_slots[sid] = max(0, cur - 1)
+            if temp_path.exists() and not cache_path.exists():
+                try:
+                    temp_path.unlink()
+                except OSError:
+                    pass
+
+        is_rpm, rpm_error = is_valid_rpm(cache_path)
+        peers_used = [src for idx, src in enumerate(usable)
+                      if src.peer is not None and contributed[idx]]
+        if is_rpm and peers_used:
+            # Don't cache tampered RPMs from peers
+            sig_ok, sig_error = verify_rpm_signature(cache_path)
+            if not sig_ok:
+                is_rpm, rpm_error = False, f"signature verification failed ({sig_error})"
+        if not is_rpm:
+            logger.warning(f"Split download of {item.filename} is invalid: {rpm_error}")
+            try:
+                cache_path.unlink()
+            except OSError:
+                pass
+            return DownloadResult(item=item, success=False,
+                                  error=f"Split download invalid: {rpm_error}")
+
+        # Per-server speed feeds the planner like whole-file downloads do
+        elapsed = _time_mod.time() - t_start
+        if elapsed >= 0.5:
+            with self._session_stats_lock:
+                for idx, src in enumerate(usable):
+                    if src.server_id and contributed[idx]:
+                        kbps = int(contributed[idx] / elapsed / 1024)
+                        prev = self._session_server_kbps.get(src.server_id)
+                        self._session_server_kbps[src.server_id] = (
+                            kbps if prev is None
+                            else int(0.3 * kbps + 0.7 * prev))
+
+        top = max(range(len(usable)), key=lambda i: contributed[i])
+        server_id = usable[top].server_id
+        logger.info(f"Downloaded {item.filename} in ranges from "
+                    f"{', '.join(src.name for i, src in enumerate(usable) if contributed[i])}")
+        with self._pending_cache_lock:
+            self._pending_cache_registrations.append(
+                (item, cache_path, server_id))
+        return DownloadResult(
+            item=item, success=True, path=cache_path,
+            from_peer=not any(contributed[i] for i, src in enumerate(usable)
+                              if src.peer is None),
+            source_server_id=server_id,
+        )
+
     def download_all(self, items: List[DownloadItem],
-                     progress_callback: Callable[[str, int, int, int, int], None] = None
+                     progress_callback: Callable[[str, int, int, int, int], None] = None,
+                     result_callback: Callable[[DownloadResult], None] = None
                      ) -> Tuple[List[DownloadResult], int, int, dict]:
         """Download multiple packages using queue-based parallel processing.
 
@@ -1662,6 +2126,9 @@ class Downloader:
         Args:
             items: List of packages to download
             progress_callback: Optional callback(name, pkg_num, pkg_total, bytes, bytes_total)
+            result_callback: Optional callback(result) for each item as
+                soon as it is available (cached ones first), so work on
+                finished files can overlap the remaining downloads
 
         Returns:
             Tuple of (results, total_downloaded, total_cached, peer_stats)
@@ -1684,6 +2151,8 @@ class Downloader:
                     path=self.get_cache_path(item),
                     cached=True
                 ))
+                if result_callback:
+                    result_callback(results[-1])
                 cached_count += 1
                 downloaded_bytes += item.size
             else:
@@ -1763,7 +2232,8 @@ class Downloader:
         dl_results, stats = coordinator.download_all(
             to_download,
             peer_availability,
-            progress_callback=coord_callback
+            progress_callback=coord_callback,
+            result_callback=result_callback
         )
 
         t_dl_end = _time.time()
@@ -1791,6 +2261,13 @@ class Downloader:
 
         # Process DB operations in main thread (SQLite is not thread-safe)
         if self.db:
+            # LRU access times for the packages taken from the cache
+            for result in results:
+                if result.success and result.cached:
+                    self.db.update_cache_file_access(result.item.filename,
+                                                     result.item.media_id)
+            self.db.flush_cache_file_access()
+
             # Blacklist peers that served bad packages
             blacklisted_count = 0
             for bl in stats.get('pending_blacklist', []):
@@ -24,12 +24,25 @@ without ever populating a SQLite cache.
 import fnmatch
 import logging
 import lzma
+import mmap
+import os
 import re
+import signal
+import struct
+import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Iterable, Iterator, List, Optional, Callable, Set, Tuple
+from typing import (
+    BinaryIO, Callable, Dict, Iterable, Iterator, List, Optional, Sequence,
+    Set, Tuple, Union,
+)
 from xml.etree.ElementTree import iterparse
 
+from . import cache_stats
+from .compression import decompress_stream
+
 logger = logging.getLogger(__name__)
 
 
@@ -67,17 +80,11 @@ def parse_files_xml(
         logger.warning(f"files.xml not found: {path}")
         return
 
-    # Determine if compressed
-    if path.suffix == '.lzma' or str(path).endswith('.xml.lzma'):
-        opener = lambda p: lzma.open(p, 'rb')
-    else:
-        opener = lambda p: open(p, 'rb')
-
     pkg_count = 0
     file_count = 0
 
     try:
-        with opener(path) as f:
+        with decompress_stream(path) as f:
             # Use iterparse for streaming - only care about 'end' events for <files>
             context = iterparse(f, events=('end',))
 
@@ -218,14 +225,8 @@ def extract_nevras_from_files_xml(path: Path) -> Set[str]:
     nevras = set()
     pattern = re.compile(rb'fn="([^"]+)"')
 
-    # Determine if compressed
-    if path.suffix == '.lzma' or str(path).endswith('.xml.lzma'):
-        opener = lambda p: lzma.open(p, 'rb')
-    else:
-        opener = lambda p: open(p, 'rb')
-
     try:
-        with opener(path) as f:
+        with decompress_stream(path) as f:
             for line in f:
                 match = pattern.search(line)
                 if match:
@@ -250,6 +251,51 @@ def extract_nevras_from_files_xml(path: Path) -> Set[str]:
 # It does *not* maintain any persistent cache: each invocation reopens
 # the compressed XML.  For ~26 MB of compressed data on SSD this stays
 # below one second, which is acceptable for an interactive command.
+# Media are scanned concurrently (one xzgrep pipeline each, at most
+# FILES_XML_MAX_WORKERS at a time) and merged back in media order.
+
+# Upper bound on media scanned at once
+FILES_XML_MAX_WORKERS = 4
+
+
+class _ScanCancel:
+    """Stops the pending and running media scans of one search.
+
+    Scans register their ``xzgrep`` process; :meth:`cancel` kills the
+    process groups so a scan blocked in ``communicate()`` returns at
+    once instead of decompressing the rest of its medium.
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._procs = []
+        self.cancelled = False
+
+    def spawned(self, proc) -> bool:
+        """Register a scan process; False if the search is already over."""
+        with self._lock:
+            if not self.cancelled:
+                self._procs.append(proc)
+                return True
+        _kill_group(proc)
+        return False
+
+    def cancel(self):
+        with self._lock:
+            self.cancelled = True
+            procs, self._procs = self._procs, []
+        for proc in procs:
+            _kill_group(proc)
+
+
+def _kill_group(proc):
+    """Terminate an ``xzgrep`` pipeline (the script, xz and grep)."""
+    if proc.poll() is not None:
+        return
+    try:
+        os.killpg(proc.pid, signal.SIGTERM)
+    except (ProcessLookupError, PermissionError):
+        pass
 
 
 def _compile_byte_matcher(pattern: str) -> Callable[[bytes], bool]:
@@ -341,6 +387,7 @@ def _iter_matches_in_lzma(
     media_name: str,
     matches: List["FileMatch"],
     limit: int,
+    cancel: Optional[_ScanCancel] = None,
 ) -> bool:
     """Stream-scan ``path`` and append matching :class:`FileMatch`.
 
@@ -356,7 +403,8 @@ def _iter_matches_in_lzma(
 
     Returns ``True`` when ``limit`` is reached so the caller can
     stop iterating remaining media early.  Falls back to an
-    in-process ``lzma`` scan when ``xzgrep`` is missing.
+    in-process ``lzma`` scan when ``xzgrep`` is missing.  A scan
+    stopped through ``cancel`` appends nothing.
     """
     import subprocess
 
@@ -368,14 +416,21 @@ def _iter_matches_in_lzma(
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
             bufsize=-1,
+            # Own process group, so cancelling reaches xz and grep too
+            start_new_session=True,
         )
     except (FileNotFoundError, OSError) as exc:
         logger.debug("xzgrep unavailable (%s); falling back to lzma module", exc)
         return _iter_matches_in_lzma_pure(
-            path, matcher, media_name, matches, limit,
+            path, matcher, media_name, matches, limit, cancel,
         )
 
+    if cancel is not None and not cancel.spawned(proc):
+        proc.communicate()
+        return False
     out, err = proc.communicate()
+    if cancel is not None and cancel.cancelled:
+        return False
     if proc.returncode not in (0, 1):
         # 0 = matches, 1 = no matches; anything else is an error.
         logger.warning(
@@ -420,38 +475,41 @@ def _iter_matches_in_lzma_pure(
     media_name: str,
     matches: List["FileMatch"],
     limit: int,
+    cancel: Optional[_ScanCancel] = None,
 ) -> bool:
     """Pure-Python fallback used when ``xzgrep`` isn't on PATH.
 
     Slower than the xzgrep pipeline (~1.5 s vs 0.5 s on Core
     Release) because the LZMA decompression and the Python loop
-    can't truly run in parallel, but functionally equivalent.
+    can't truly run in parallel, but functionally equivalent.  The
+    medium is streamed line by line, so memory stays flat and a
+    cancelled scan stops within one buffer.
     """
+    current_nevra: Optional[str] = None
     try:
-        with lzma.open(path, 'rb') as fh:
-            blob = fh.read()
-    except (lzma.LZMAError, OSError) as exc:
+        with decompress_stream(path) as fh:
+            for line in fh:
+                if cancel is not None and cancel.cancelled:
+                    return False
+                line = line.rstrip(b'\n')
+                if not line:
+                    continue
+                if line[:1] == b'<':
+                    m = _FN_LINE_BYTES_RE.search(line)
+                    if m is not None:
+                        current_nevra = m.group(1).decode('utf-8', 'replace')
+                    continue
+                if current_nevra is None or not matcher(line):
+                    continue
+                try:
+                    filepath = line.decode('utf-8')
+                except UnicodeDecodeError:
+                    continue
+                matches.append(FileMatch(current_nevra, filepath, media_name))
+                if limit and len(matches) >= limit:
+                    return True
+    except (lzma.LZMAError, OSError, ValueError) as exc:
         logger.warning("Failed to read %s: %s", path, exc)
-        return False
-
-    current_nevra: Optional[str] = None
-    for line in blob.split(b'\n'):
-        if not line:
-            continue
-        if line[:1] == b'<':
-            m = _FN_LINE_BYTES_RE.search(line)
-            if m is not None:
-                current_nevra = m.group(1).decode('utf-8', 'replace')
-            continue
-        if current_nevra is None or not matcher(line):
-            continue
-        try:
-            filepath = line.decode('utf-8')
-        except UnicodeDecodeError:
-            continue
-        matches.append(FileMatch(current_nevra, filepath, media_name))
-        if limit and len(matches) >= limit:
-            return True
     return False
 
 
@@ -491,9 +549,426 @@ def _evr_compare(a: str, b: str) -> int:
     return rpm.labelCompare(_split(a), _split(b))
 
 
+# ---------------------------------------------------------------------------
+# Basename index sidecar (opt-in, see ``[media] files_basename_index``)
+# ---------------------------------------------------------------------------
+#
+# ``<files.xml.lzma>.bidx`` answers exact-basename lookups without
+# decompressing the medium.  Layout, all integers big-endian:
+#
+#   header     magic, source size and mtime_ns, then the counts
+#              n_pkgs, n_dirs, n_keys, n_restarts and the restart
+#              interval the keys were written with
+#   pkgs       (n_pkgs + 1) u32 offsets, then the NEVRA bytes
+#   dirs       (n_dirs + 1) u32 offsets, then the directory bytes,
+#              sorted by (lowercase, bytes)
+#   restarts   n_restarts u32 offsets into the key blob
+#   keys       basenames sorted by (lowercase, bytes), prefix-compressed
+#              against the previous key except at every restart
+#              interval-th one (FILES_INDEX_RESTART when built); each
+#              followed by its postings
+#
+# A key is ``varint shared, varint suffix length, suffix, varint count``
+# then ``count`` times ``varint pkg delta, varint dir``: the packages
+# (ordinals in file order) and directories shipping that basename.
+# The file is mmap'd and binary-searched over the restart keys.
+
+FILES_INDEX_SUFFIX = '.bidx'
+FILES_INDEX_MAGIC = b'URPMBIX2'
+FILES_INDEX_RESTART = 16
+_FILES_INDEX_HEADER = struct.Struct('>8sQQIIIII')
+
+
+def files_index_path(path: Path) -> Path:
+    """Basename index sidecar path for a files.xml file."""
+    path = Path(path)
+    return path.with_name(path.name + FILES_INDEX_SUFFIX)
+
+
+def _varint(value: int) -> bytes:
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _read_varint(buf, pos: int) -> Tuple[int, int]:
+    value = shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def _dir_order(directory: bytes) -> Tuple[bytes, bytes]:
+    return directory.lower(), directory
+
+
+def _string_table(strings: List[bytes]) -> bytes:
+    offsets = [0]
+    for s in strings:
+        offsets.append(offsets[-1] + len(s))
+    return struct.pack(f'>{len(offsets)}I', *offsets) + b''.join(strings)
+
+
+def build_files_index(path: Path) -> Path:
+    """Write the basename index sidecar of a files.xml.lzma file.
+
+    Entries are first spread over temporary bucket files by the first
+    byte of their lowercase basename, so only one bucket is sorted in
+    memory at a time.
+
+    Args:
+        path: Path to files.xml.lzma
+
+    Returns:
+        Path of the written index
+    """
+    path = Path(path)
+    index_path = files_index_path(path)
+    st = os.stat(path)
+
+    nevras: List[bytes] = []
+    dirs: Dict[bytes, int] = {}
+    pkg_ord = -1
+    record = struct.Struct('>II')
+
+    with tempfile.TemporaryDirectory(dir=index_path.parent,
+                                     prefix='.bidx-') as tmpdir:
+        buckets: Dict[int, BinaryIO] = {}
+        try:
+            with decompress_stream(path) as fh:
+                for line in fh:
+                    line = line.rstrip(b'\n')
+                    if line[:1] == b'<':
+                        m = _FN_LINE_BYTES_RE.search(line)
+                        if m is not None:
+                            nevras.append(m.group(1))
+                            pkg_ord += 1
+                        continue
+                    slash = line.rfind(b'/')
+                    if pkg_ord < 0 or slash < 0 or slash == len(line) - 1:
+                        continue
+                    base = line[slash + 1:]
+                    dir_ord = dirs.setdefault(line[:slash], len(dirs))
+                    lower = base.lower()
+                    out = buckets.get(lower[0])
+                    if out is None:
+                        out = buckets[lower[0]] = open(
+                            os.path.join(tmpdir, f'{lower[0]:02x}'), 'wb')
+                    entry = lower + b'\0' + base + b'\0' + record.pack(pkg_ord, dir_ord)
+                    out.write(struct.pack('>H', len(entry)) + entry)
+        finally:
+            for out in buckets.values():
+                out.close()
+
+        restarts: List[int] = []
+        keys = bytearray()
+        n_keys = 0
+        previous = b''
+
+        # Directory ordinals were handed out in file order; the table is
+        # written sorted so lookups by path can binary-search it
+        dir_list = sorted(dirs, key=_dir_order)
+        remap = [0] * len(dir_list)
+        for new, directory in enumerate(dir_list):
+            remap[dirs[directory]] = new
+        del dirs
+
+        def add_key(base: bytes, postings: List[Tuple[int, int]]):
+            nonlocal n_keys, previous
+            if n_keys % FILES_INDEX_RESTART == 0:
+                restarts.append(len(keys))
+                shared = 0
+            else:
+                shared = len(os.path.commonprefix([previous, base]))
+            keys.extend(_varint(shared) + _varint(len(base) - shared))
+            keys.extend(base[shared:])
+            keys.extend(_varint(len(postings)))
+            last_pkg = 0
+            for pkg, dir_ord in postings:
+                keys.extend(_varint(pkg - last_pkg) + _varint(remap[dir_ord]))
+                last_pkg = pkg
+            previous = base
+            n_keys += 1
+
+        for first in sorted(buckets):
+            with open(os.path.join(tmpdir, f'{first:02x}'), 'rb') as fh:
+                data = fh.read()
+            entries = []
+            pos = 0
+            while pos < len(data):
+                size = struct.unpack_from('>H', data, pos)[0]
+                entries.append(data[pos + 2:pos + 2 + size])
+                pos += 2 + size
+            del data
+            # Sorting the raw records orders by lowercase, basename,
+            # then package ordinal (big-endian packed)
+            entries.sort()
+            current = None
+            postings: List[Tuple[int, int]] = []
+            for entry in entries:
+                _, base, tail = entry.split(b'\0', 2)
+                if base != current:
+                    if current is not None:
+                        add_key(current, postings)
+                    current, postings = base, []
+                postings.append(record.unpack(tail[-record.size:]))
+            if current is not None:
+                add_key(current, postings)
+
+    tmp_path = index_path.with_name(index_path.name + '.tmp')
+    with open(tmp_path, 'wb') as out:
+        out.write(_FILES_INDEX_HEADER.pack(
+            FILES_INDEX_MAGIC, st.st_size, st.st_mtime_ns,
+            len(nevras), len(dir_list), n_keys, len(restarts),
+            FILES_INDEX_RESTART))
+        out.write(_string_table(nevras))
+        out.write(_string_table(dir_list))
+        out.write(struct.pack(f'>{len(restarts)}I', *restarts))
+        out.write(keys)
+    os.replace(tmp_path, index_path)
+    logger.debug("Indexed %d basenames of %d packages from %s",
+                 n_keys, len(nevras), path)
+    return index_path
+
+
+class FilesIndex:
+    """Exact-basename lookups in a files.xml through its sidecar.
+
+    Use :meth:`load`, which returns None when there is no usable index
+    (missing, corrupt or built from another version of the file).
+    """
+
+    def __init__(self, buf: mmap.mmap, header: tuple):
+        self._buf = buf
+        (_, _, _, n_pkgs, self._n_dirs, self._n_keys, n_restarts,
+         self._restart_interval) = header
+        if (self._restart_interval == 0 or n_restarts !=
+                -(-self._n_keys // self._restart_interval)):
+            raise ValueError("inconsistent restart interval")
+        pos = _FILES_INDEX_HEADER.size
+        self._pkgs, pos = self._table(pos, n_pkgs)
+        self._dirs, pos = self._table(pos, self._n_dirs)
+        self._restarts = struct.unpack_from(f'>{n_restarts}I', buf, pos)
+        self._keys = pos + n_restarts * 4
+        if n_restarts and self._keys + self._restarts[-1] > len(buf):
+            raise ValueError("truncated basename index")
+
+    def _table(self, pos: int, count: int) -> Tuple[Tuple[int, int], int]:
+        """(offsets position, strings position) and the table's end."""
+        data = pos + (count + 1) * 4
+        size = struct.unpack_from('>I', self._buf, data - 4)[0]
+        return (pos, data), data + size
+
+    def _string(self, table, ordinal: int) -> bytes:
+        offsets, data = table
+        start, end = struct.unpack_from('>II', self._buf, offsets + ordinal * 4)
+        return self._buf[data + start:data + end]
+
+    def _dir_ordinals(self, directory: bytes) -> Set[int]:
+        """Ordinals of the directories equal to *directory*, ignoring case."""
+        target = directory.lower()
+        lo, hi = 0, self._n_dirs
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._string(self._dirs, mid).lower() < target:
+                lo = mid + 1
+            else:
+                hi = mid
+        found = set()
+        while lo < self._n_dirs and self._string(self._dirs, lo).lower() == target:
+            found.add(lo)
+            lo += 1
+        return found
+
+    @classmethod
+    def load(cls, path: Path) -> Optional['FilesIndex']:
+        """Open the index of files.xml *path*, if it is up to date."""
+        try:
+            st = os.stat(path)
+            with open(files_index_path(path), 'rb') as f:
+                buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError):
+            return None
+        try:
+            header = _FILES_INDEX_HEADER.unpack_from(buf, 0)
+            if (header[0] != FILES_INDEX_MAGIC
+                    or (header[1], header[2]) != (st.st_size, st.st_mtime_ns)):
+                buf.close()
+                return None
+            return cls(buf, header)
+        except (struct.error, ValueError):
+            buf.close()
+            return None
+
+    def _scan(self, restart: int):
+        """Yield (basename, postings position) from a restart point on."""
+        buf = self._buf
+        pos = self._keys + self._restarts[restart]
+        key = b''
+        for _ in range(self._n_keys - restart * self._restart_interval):
+            shared, pos = _read_varint(buf, pos)
+            length, pos = _read_varint(buf, pos)
+            key = key[:shared] + buf[pos:pos + length]
+            pos += length
+            count, pos = _read_varint(buf, pos)
+            yield key, pos, count
+            for _ in range(count * 2):
+                pos = _skip_varint(buf, pos)
+
+    def lookup(self, basename: bytes,
+               directory: Optional[bytes] = None) -> List[Tuple[int, bytes, bytes]]:
+        """Files named *basename*, case-insensitively.
+
+        Args:
+            basename: file name to look up
+            directory: only files in this directory (no trailing ``/``)
+
+        Returns:
+            ``(package ordinal, nevra, path)`` tuples sorted by package
+            ordinal then path, i.e. in files.xml order
+        """
+        target = basename.lower()
+        if not target or not self._restarts:
+            return []
+        wanted_dirs = None
+        if directory is not None:
+            wanted_dirs = self._dir_ordinals(directory)
+            if not wanted_dirs:
+                return []
+
+        # Last restart block whose first key sorts before the target:
+        # equal keys can continue from the previous block
+        lo, hi = 0, len(self._restarts)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            first = next(self._scan(mid))[0]
+            if first.lower() < target:
+                lo = mid + 1
+            else:
+                hi = mid
+        start = max(lo - 1, 0)
+
+        found = []
+        for key, pos, count in self._scan(start):
+            lower = key.lower()
+            if lower < target:
+                continue
+            if lower > target:
+                break
+            pkg = 0
+            for _ in range(count):
+                delta, pos = _read_varint(self._buf, pos)
+                dir_ord, pos = _read_varint(self._buf, pos)
+                pkg += delta
+                if wanted_dirs is None or dir_ord in wanted_dirs:
+                    found.append((pkg, self._dirs_path(dir_ord, key)))
+        found.sort()
+        return [(pkg, self._string(self._pkgs, pkg), file_path)
+                for pkg, file_path in found]
+
+    def _dirs_path(self, dir_ord: int, basename: bytes) -> bytes:
+        return self._string(self._dirs, dir_ord) + b'/' + basename
+
+    def close(self):
+        self._buf.close()
+
+
+def _skip_varint(buf, pos: int) -> int:
+    while buf[pos] >= 0x80:
+        pos += 1
+    return pos + 1
+
+
+def ensure_files_index(path: Path) -> Optional[Path]:
+    """Build the basename index of *path* unless an up-to-date one exists.
+
+    Returns the index path, or None when it cannot be written.
+    """
+    index = FilesIndex.load(path)
+    if index is not None:
+        index.close()
+        return files_index_path(path)
+    try:
+        return build_files_index(path)
+    except (OSError, lzma.LZMAError, struct.error) as e:
+        logger.warning("Cannot index %s: %s", path, e)
+        return None
+
+
+def _index_key(pattern: str) -> Optional[Tuple[Optional[str], str]]:
+    """``(directory, basename)`` the index can look ``pattern`` up by.
+
+    None for wildcards, which need the streaming scan.  Any other
+    pattern matches paths ending with ``/<pattern>``, so every hit has
+    its last component as basename; an absolute path also pins the
+    directory.  The caller still filters candidates with the matcher.
+    """
+    if '*' in pattern or '?' in pattern:
+        return None
+    directory, _, basename = pattern.rpartition('/')
+    if not basename:
+        return None
+    if not pattern.startswith('/'):
+        directory = None
+    return directory, basename
+
+
+def _scan_media(
+    path: Path,
+    matcher: Callable[[bytes], bool],
+    grep_re: str,
+    media_name: str,
+    limit: int,
+    cancel: _ScanCancel,
+    index_keys: Optional[List[Tuple[Optional[str], str]]] = None,
+) -> List[FileMatch]:
+    """Worker of :func:`iter_file_matches`: matches of one medium.
+
+    Served from the basename index when the patterns allow it
+    (``index_keys``) and the medium has an up-to-date one.
+    """
+    matches: List[FileMatch] = []
+    if cancel.cancelled:
+        return matches
+    index = FilesIndex.load(path) if index_keys else None
+    if index_keys:
+        cache_stats.record('files_index', index is not None)
+    if index is None:
+        _iter_matches_in_lzma(path, matcher, grep_re, media_name,
+                              matches, limit, cancel)
+        return matches
+
+    try:
+        candidates = set()
+        for directory, basename in index_keys:
+            candidates.update(index.lookup(
+                basename.encode('utf-8'),
+                None if directory is None else directory.encode('utf-8')))
+    finally:
+        index.close()
+    for _, nevra, file_path in sorted(candidates):
+        if not matcher(file_path):
+            continue
+        try:
+            matches.append(FileMatch(nevra.decode('utf-8', 'replace'),
+                                     file_path.decode('utf-8'), media_name))
+        except UnicodeDecodeError:
+            continue
+        if limit and len(matches) >= limit:
+            break
+    return matches
+
+
 def iter_file_matches(
     media_files: Iterable[Tuple[Path, str]],
-    pattern: str,
+    pattern: Union[str, Sequence[str]],
     *,
     all_versions: bool = False,
     limit: int = 0,
@@ -501,19 +976,24 @@ def iter_file_matches(
     """Scan ``files.xml.lzma`` of given media for paths matching ``pattern``.
 
     Args:
-        media_files: iterable of ``(files_xml_path, media_name)`` tuples,
-            iterated in order.  Missing or empty files are silently
-            skipped.
-        pattern: user pattern; see :func:`_compile_pattern`.
+        media_files: iterable of ``(files_xml_path, media_name)`` tuples.
+            They are scanned concurrently but merged in this order.
+            Missing or empty files are silently skipped.
+        pattern: user pattern; see :func:`_compile_pattern`.  A list of
+            patterns matches paths matching any of them, still in a
+            single pass over each medium.
         all_versions: when ``False`` (default), the result is deduped on
             ``(name, arch)`` keeping only matches whose package has the
             highest EVR seen across all media — i.e. what ``urpm
             install`` would actually pick.  When ``True``, every match
             is returned, including older versions and any duplicate
             across media.
-        limit: stop after this many matches (``0`` means unlimited).
-            Applied **before** dedup to keep the scan bounded; in dedup
-            mode the final list may be shorter than ``limit``.
+        limit: stop after this many matches (``0`` means unlimited);
+            scans still running are cancelled.  In dedup mode, matches
+            already shadowed by a newer EVR of the same ``(name, arch)``
+            are dropped while merging and don't count; the final list
+            may still be shorter than ``limit``, when a later match
+            shadows an earlier one.
 
     Returns:
         List of :class:`FileMatch` in scan order.
@@ -524,30 +1004,69 @@ def iter_file_matches(
         ``/usr/sbin/sendmail``) are kept separate by the
         ``(name, arch)`` dedup key, so they remain visible.
     """
-    matcher = _compile_byte_matcher(pattern)
-    grep_re = _grep_pattern_for(pattern)
+    patterns = [pattern] if isinstance(pattern, str) else list(pattern)
+    if not patterns:
+        return []
+    if len(patterns) == 1:
+        matcher = _compile_byte_matcher(patterns[0])
+    else:
+        matchers = [_compile_byte_matcher(p) for p in patterns]
+        matcher = lambda b: any(m(b) for m in matchers)
+    grep_re = '|'.join(_grep_pattern_for(p) for p in patterns)
+    index_keys = [_index_key(p) for p in patterns]
+    if None in index_keys:
+        index_keys = None  # streaming scan only
     matches: List[FileMatch] = []
 
+    media = []
     for path, media_name in media_files:
         if not path.exists():
             logger.debug("Skipping %s: not on disk", path)
             continue
-        if _iter_matches_in_lzma(path, matcher, grep_re, media_name, matches, limit):
-            break  # ``limit`` reached — short-circuit remaining media.
-
-    if all_versions:
+        media.append((path, media_name))
+    if not media:
         return matches
 
-    # Dedup by (name, arch) on highest EVR.  Two passes:
-    #   1. find the winning EVR for each (name, arch);
-    #   2. keep only matches whose nevra has that EVR.
+    # Winning EVR per (name, arch), maintained while merging
     best_evr: dict[Tuple[str, str], str] = {}
-    for m in matches:
-        name, evr, arch = _split_nevra(m.nevra)
-        key = (name, arch)
-        if key not in best_evr or _evr_compare(evr, best_evr[key]) > 0:
-            best_evr[key] = evr
+    cancel = _ScanCancel()
+    workers = min(len(media), os.cpu_count() or 1, FILES_XML_MAX_WORKERS)
+    with ThreadPoolExecutor(max_workers=workers,
+                            thread_name_prefix='files-xml') as pool:
+        futures = [
+            pool.submit(_scan_media, path, matcher, grep_re, media_name,
+                        limit, cancel, index_keys)
+            for path, media_name in media
+        ]
+        try:
+            # Media order: each result is merged once the media before
+            # it are, while the later ones keep scanning
+            for future in futures:
+                for m in future.result():
+                    if not all_versions:
+                        name, evr, arch = _split_nevra(m.nevra)
+                        key = (name, arch)
+                        if key not in best_evr:
+                            best_evr[key] = evr
+                        elif evr != best_evr[key]:
+                            order = _evr_compare(evr, best_evr[key])
+                            if order < 0:
+                                continue  # shadowed by a newer EVR
+                            if order > 0:
+                                best_evr[key] = evr
+                    matches.append(m)
+                    if limit and len(matches) >= limit:
+                        break
+                if limit and len(matches) >= limit:
+                    break  # ``limit`` reached — drop remaining media.
+        finally:
+            cancel.cancel()
+
+    if all_versions:
+        return matches
 
+    # Dedup by (name, arch) on highest EVR: keep only matches whose
+    # nevra has the winning EVR.
     deduped: List[FileMatch] = []
     for m in matches:
         name, evr, arch = _split_nevra(m.nevra)
@@ -5,12 +5,21 @@ Parses hdlist.cz files containing concatenated RPM headers.
 Format validated with real Mageia files.
 """
 
+import json
+import logging
+import os
+import re
 import struct
+import threading
+import zlib
 from pathlib import Path
-from typing import BinaryIO, Dict, Iterator, List, Optional, Any
+from typing import Any, BinaryIO, Dict, Iterable, Iterator, List, Optional
 
+from . import cache_stats
 from .compression import decompress_stream
 
+logger = logging.getLogger(__name__)
+
 # RPM Header magic (3 bytes)
 RPM_HEADER_MAGIC = b'\x8e\xad\xe8'
 
@@ -44,6 +53,9 @@ RPMTAG_CONFLICTFLAGS = 1053
 RPMTAG_OBSOLETENAME = 1090
 RPMTAG_OBSOLETEVERSION = 1115
 RPMTAG_OBSOLETEFLAGS = 1114
+RPMTAG_CHANGELOGTIME = 1080
+RPMTAG_CHANGELOGNAME = 1081
+RPMTAG_CHANGELOGTEXT = 1082
 RPMTAG_RECOMMENDNAME = 5046
 RPMTAG_SUGGESTNAME = 5049
 
@@ -59,6 +71,20 @@ RPM_BIN = 7
 RPM_STRING_ARRAY = 8
 RPM_I18NSTRING = 9
 
+# Offset index sidecar (<hdlist>.idx): headers recompressed in
+# independent zlib blocks of about HDLIST_INDEX_BLOCK_SIZE bytes, then a
+# JSON table NEVRA -> (block, offset, length), then a trailer holding the
+# table offset and the magic.  Reading one header costs one block.
+HDLIST_INDEX_SUFFIX = '.idx'
+HDLIST_INDEX_MAGIC = b'URPMHIX1'
+HDLIST_INDEX_BLOCK_SIZE = 256 * 1024
+
+# Loaded indexes kept in memory, one per media hdlist, so a lookup does
+# not re-read the NEVRA table: index path -> (stamps, HdlistIndex)
+HDLIST_INDEX_CACHE_SIZE = 32
+_loaded_indexes: Dict[str, tuple] = {}
+_loaded_lock = threading.Lock()
+
 
 class RPMHeader:
     """Represents a parsed RPM header."""
@@ -67,69 +93,84 @@ class RPMHeader:
         self.index = index  # List of (tag, type, offset, count)
         self.store = store  # Raw data store
         self._cache: Dict[int, Any] = {}
+        self._entries: Optional[Dict[int, tuple]] = None
+
+    def _entry(self, tag: int, *types: int) -> Optional[tuple]:
+        """(offset, count, end) of a tag's data, or None.
+
+        ``end`` is where the next entry's data starts, which bounds the
+        slices decoded for it.
+        """
+        if self._entries is None:
+            entries = {}
+            offsets = sorted({offset for _, _, offset, _ in self.index})
+            ends = dict(zip(offsets, offsets[1:] + [len(self.store)]))
+            for t, etyp, offset, count in self.index:
+                entries.setdefault(t, (etyp, offset, count, ends[offset]))
+            self._entries = entries
+        entry = self._entries.get(tag)
+        if entry is None or entry[0] not in types:
+            return None
+        return entry[1:]
     
     def get_string(self, tag: int) -> Optional[str]:
         """Get a string tag value."""
         if tag in self._cache:
             return self._cache[tag]
         
-        for t, typ, offset, count in self.index:
-            if t == tag and typ == RPM_STRING:
-                end = self.store.find(b'\x00', offset)
-                if end == -1:
-                    value = self.store[offset:].decode('utf-8', errors='replace')
-                else:
-                    value = self.store[offset:end].decode('utf-8', errors='replace')
-                self._cache[tag] = value
-                return value
-        return None
+        # I18N strings (summary, description, group) start with the C
+        # locale value
+        entry = self._entry(tag, RPM_STRING, RPM_I18NSTRING)
+        if entry is None:
+            return None
+        offset, _, end = entry
+        nul = self.store.find(b'\x00', offset, end)
+        if nul != -1:
+            end = nul
+        value = self.store[offset:end].decode('utf-8', errors='replace')
+        self._cache[tag] = value
+        return value
     
     def get_int32(self, tag: int) -> Optional[int]:
         """Get an int32 tag value."""
         if tag in self._cache:
             return self._cache[tag]
         
-        for t, typ, offset, count in self.index:
-            if t == tag and typ == RPM_INT32:
-                value = struct.unpack('>I', self.store[offset:offset+4])[0]
-                self._cache[tag] = value
-                return value
-        return None
+        entry = self._entry(tag, RPM_INT32)
+        if entry is None:
+            return None
+        value = struct.unpack_from('>I', self.store, entry[0])[0]
+        self._cache[tag] = value
+        return value
     
     def get_string_array(self, tag: int) -> List[str]:
         """Get a string array tag value."""
         if tag in self._cache:
             return self._cache[tag]
         
-        for t, typ, offset, count in self.index:
-            if t == tag and typ == RPM_STRING_ARRAY:
-                strings = []
-                pos = offset
-                for _ in range(count):
-                    end = self.store.find(b'\x00', pos)
-                    if end == -1:
-                        strings.append(self.store[pos:].decode('utf-8', errors='replace'))
-                        break
-                    strings.append(self.store[pos:end].decode('utf-8', errors='replace'))
-                    pos = end + 1
-                self._cache[tag] = strings
-                return strings
-        return []
+        entry = self._entry(tag, RPM_STRING_ARRAY)
+        if entry is None:
+            return []
+        offset, count, end = entry
+        # One decode and split for the whole array; NUL never ends a
+        # multibyte sequence, so this matches decoding each string
+        data = self.store[offset:end].decode('utf-8', errors='replace')
+        strings = data.split('\x00', count)[:count]
+        self._cache[tag] = strings
+        return strings
     
     def get_int32_array(self, tag: int) -> List[int]:
         """Get an int32 array tag value."""
         if tag in self._cache:
             return self._cache[tag]
         
-        for t, typ, offset, count in self.index:
-            if t == tag and typ == RPM_INT32:
-                values = []
-                for i in range(count):
-                    val = struct.unpack('>I', self.store[offset+i*4:offset+i*4+4])[0]
-                    values.append(val)
-                self._cache[tag] = values
-                return values
-        return []
+        entry = self._entry(tag, RPM_INT32)
+        if entry is None:
+            return []
+        offset, count, _ = entry
+        values = list(struct.unpack_from(f'>{count}I', self.store, offset))
+        self._cache[tag] = values
+        return values
     
     @property
     def name(self) -> str:
@@ -175,12 +216,32 @@ class RPMHeader:
     def license(self) -> str:
         return self.get_string(RPMTAG_LICENSE) or ''
     
+    @property
+    def buildtime(self) -> int:
+        return self.get_int32(RPMTAG_BUILDTIME) or 0
+
     @property
     def nevra(self) -> str:
         """Full Name-Epoch-Version-Release.Arch string."""
         if self.epoch:
             return f"{self.name}-{self.epoch}:{self.version}-{self.release}.{self.arch}"
         return f"{self.name}-{self.version}-{self.release}.{self.arch}"
+
+    @property
+    def nvra(self) -> str:
+        """Name-Version-Release.Arch string, without epoch."""
+        return f"{self.name}-{self.version}-{self.release}.{self.arch}"
+
+    @property
+    def changelog(self) -> List[Dict[str, Any]]:
+        """Changelog entries, newest first, as time/author/text dicts."""
+        times = self.get_int32_array(RPMTAG_CHANGELOGTIME)
+        names = self.get_string_array(RPMTAG_CHANGELOGNAME)
+        texts = self.get_string_array(RPMTAG_CHANGELOGTEXT)
+        return [
+            {'time': t, 'author': n, 'text': x}
+            for t, n, x in zip(times, names, texts)
+        ]
     
     @property
     def provides(self) -> List[str]:
@@ -220,6 +281,37 @@ class RPMHeader:
         }
 
 
+def read_header_bytes(f: BinaryIO) -> Optional[bytes]:
+    """Read the raw bytes of a single RPM header from a binary stream.
+
+    Args:
+        f: Binary file stream positioned at header start
+
+    Returns:
+        Header bytes (intro, index and data store) or None if no more
+        headers
+    """
+    intro = f.read(16)
+
+    if len(intro) < 16 or intro[:3] != RPM_HEADER_MAGIC:
+        return None
+
+    # magic (3), version (1), reserved (4), index count, data store size
+    nindex, hsize = struct.unpack('>II', intro[8:16])
+    body = f.read(nindex * 16 + hsize)
+    if len(body) < nindex * 16 + hsize:
+        return None
+    return intro + body
+
+
+def header_from_bytes(data: bytes) -> RPMHeader:
+    """Build an RPMHeader from bytes returned by read_header_bytes()."""
+    nindex, hsize = struct.unpack('>II', data[8:16])
+    index = list(struct.iter_unpack('>IIII', data[16:16 + nindex * 16]))
+    store = data[16 + nindex * 16:16 + nindex * 16 + hsize]
+    return RPMHeader(index, store)
+
+
 def read_header(f: BinaryIO) -> Optional[RPMHeader]:
     """Read a single RPM header from a binary stream.
     
@@ -229,34 +321,10 @@ def read_header(f: BinaryIO) -> Optional[RPMHeader]:
     Returns:
         RPMHeader object or None if no more headers
     """
-    magic = f.read(3)
-    
-    if not magic or len(magic) < 3:
+    data = read_header_bytes(f)
+    if data is None:
         return None
-    
-    if magic != RPM_HEADER_MAGIC:
-        return None
-    
-    # Skip version (1 byte) and reserved (4 bytes)
-    f.read(5)
-    
-    # Read index count and data store size
-    nindex = struct.unpack('>I', f.read(4))[0]
-    hsize = struct.unpack('>I', f.read(4))[0]
-    
-    # Read index entries
-    index = []
-    for _ in range(nindex):
-        tag = struct.unpack('>I', f.read(4))[0]
-        typ = struct.unpack('>I', f.read(4))[0]
-        offset = struct.unpack('>I', f.read(4))[0]
-        count = struct.unpack('>I', f.read(4))[0]
-        index.append((tag, typ, offset, count))
-    
-    # Read data store
-    store = f.read(hsize)
-    
-    return RPMHeader(index, store)
+    return header_from_bytes(data)
 
 
 def parse_hdlist(filename: Path) -> Iterator[RPMHeader]:
@@ -276,6 +344,229 @@ def parse_hdlist(filename: Path) -> Iterator[RPMHeader]:
             yield header
 
 
+def hdlist_index_path(filename: Path) -> Path:
+    """Sidecar offset index path for an hdlist file."""
+    filename = Path(filename)
+    return filename.with_name(filename.name + HDLIST_INDEX_SUFFIX)
+
+
+def _source_stamp(filename: Path) -> Dict[str, int]:
+    st = os.stat(filename)
+    return {'size': st.st_size, 'mtime_ns': st.st_mtime_ns}
+
+
+def build_hdlist_index(filename: Path) -> Path:
+    """Write the offset index sidecar of an hdlist.
+
+    Decompresses the hdlist once.  The index records the size and mtime
+    of the hdlist it was built from and is ignored once they change.
+
+    Args:
+        filename: Path to hdlist.cz file
+
+    Returns:
+        Path of the written index
+    """
+    filename = Path(filename)
+    index_path = hdlist_index_path(filename)
+    tmp_path = index_path.with_name(index_path.name + '.tmp')
+
+    blocks: List[List[int]] = []
+    headers: Dict[str, List[int]] = {}
+    pending = bytearray()
+
+    with open(tmp_path, 'wb') as out:
+        out.write(HDLIST_INDEX_MAGIC)
+
+        def flush():
+            if pending:
+                data = zlib.compress(bytes(pending), 6)
+                blocks.append([out.tell(), len(data)])
+                out.write(data)
+                pending.clear()
+
+        with decompress_stream(filename) as f:
+            while True:
+                raw = read_header_bytes(f)
+                if raw is None:
+                    break
+                nevra = header_from_bytes(raw).nevra
+                headers[nevra] = [len(blocks), len(pending), len(raw)]
+                pending += raw
+                if len(pending) >= HDLIST_INDEX_BLOCK_SIZE:
+                    flush()
+        flush()
+
+        table_offset = out.tell()
+        out.write(json.dumps({
+            'source': _source_stamp(filename),
+            'blocks': blocks,
+            'headers': headers,
+        }, separators=(',', ':')).encode('utf-8'))
+        out.write(struct.pack('>Q', table_offset) + HDLIST_INDEX_MAGIC)
+
+    os.replace(tmp_path, index_path)
+    return index_path
+
+
+class HdlistIndex:
+    """Random access to the headers of an hdlist through its sidecar.
+
+    Use :meth:`load`, which returns None when there is no usable index
+    (missing, corrupt or built from another version of the hdlist).
+    Lookups accept NEVRAs with or without epoch.  Instances are read-only
+    and shared between threads.
+    """
+
+    def __init__(self, index_path: Path, blocks: List[List[int]],
+                 headers: Dict[str, List[int]]):
+        self.index_path = index_path
+        self._blocks = blocks
+        self._headers = headers
+        # Epoch-less aliases: name-E:V-R.A -> name-V-R.A
+        for nevra in [n for n in headers if ':' in n]:
+            headers.setdefault(re.sub(r'-\d+:', '-', nevra, count=1),
+                               headers[nevra])
+
+    @classmethod
+    def load(cls, filename: Path) -> Optional['HdlistIndex']:
+        """Open the index of hdlist *filename*, if it is up to date.
+
+        The NEVRA table is parsed once and kept in memory until the
+        hdlist or its index changes on disk; later calls cost two stats.
+        Never builds the index (see :func:`ensure_hdlist_index`).
+        """
+        index_path = hdlist_index_path(filename)
+        try:
+            stamps = (_source_stamp(filename), _source_stamp(index_path))
+        except OSError:
+            cache_stats.record('hdlist_index', False)
+            return None
+        key = str(index_path)
+        with _loaded_lock:
+            cached = _loaded_indexes.get(key)
+        if cached is not None and cached[0] == stamps:
+            cache_stats.record('hdlist_index', True)
+            return cached[1]
+
+        index = cls._read(index_path, stamps[0])
+        cache_stats.record('hdlist_index', index is not None)
+        with _loaded_lock:
+            _loaded_indexes.pop(key, None)
+            if index is not None:
+                _loaded_indexes[key] = (stamps, index)
+                while len(_loaded_indexes) > HDLIST_INDEX_CACHE_SIZE:
+                    del _loaded_indexes[next(iter(_loaded_indexes))]
+        return index
+
+    @classmethod
+    def _read(cls, index_path: Path,
+              source: Dict[str, int]) -> Optional['HdlistIndex']:
+        """Parse an index file built from the hdlist stamped *source*."""
+        try:
+            with open(index_path, 'rb') as f:
+                f.seek(-16, os.SEEK_END)
+                trailer = f.read(16)
+                if trailer[8:] != HDLIST_INDEX_MAGIC:
+                    return None
+                table_end = f.tell() - 16
+                table_offset = struct.unpack('>Q', trailer[:8])[0]
+                f.seek(table_offset)
+                table = json.loads(f.read(table_end - table_offset))
+            if table.get('source') != source:
+                return None
+            return cls(index_path, table['blocks'], table['headers'])
+        except (OSError, ValueError, KeyError) as e:
+            logger.debug("Unusable hdlist index %s: %s", index_path, e)
+            return None
+
+    def __contains__(self, nevra: str) -> bool:
+        return nevra in self._headers
+
+    def get_many(self, nevras: Iterable[str]) -> Dict[str, RPMHeader]:
+        """Headers of the given NEVRAs that are in the index.
+
+        Each block is read and decompressed once, however many of the
+        requested headers it carries.
+        """
+        by_block: Dict[int, List[str]] = {}
+        for nevra in nevras:
+            entry = self._headers.get(nevra)
+            if entry is not None:
+                by_block.setdefault(entry[0], []).append(nevra)
+
+        found: Dict[str, RPMHeader] = {}
+        if not by_block:
+            return found
+        with open(self.index_path, 'rb') as f:
+            for block, wanted in sorted(by_block.items()):
+                offset, length = self._blocks[block]
+                f.seek(offset)
+                data = zlib.decompress(f.read(length))
+                for nevra in wanted:
+                    _, start, size = self._headers[nevra]
+                    found[nevra] = header_from_bytes(data[start:start + size])
+        return found
+
+    def get(self, nevra: str) -> Optional[RPMHeader]:
+        """Header of one NEVRA, or None."""
+        return self.get_many([nevra]).get(nevra)
+
+
+def ensure_hdlist_index(filename: Path) -> Optional[HdlistIndex]:
+    """Load the offset index of an hdlist, (re)building it if needed.
+
+    Called at sync time, also for hdlists synced before indexes existed.
+    Building decompresses the whole hdlist, so query paths use
+    :meth:`HdlistIndex.load` and go without when it returns None.
+    Returns None when the index cannot be written (read-only cache,
+    corrupt hdlist, ...).
+    """
+    index = HdlistIndex.load(filename)
+    if index is not None:
+        return index
+    try:
+        build_hdlist_index(filename)
+    except (OSError, ValueError, zlib.error) as e:
+        logger.debug("Cannot index %s: %s", filename, e)
+        return None
+    return HdlistIndex.load(filename)
+
+
+def find_headers(filename: Path, nevras: Iterable[str]) -> Dict[str, RPMHeader]:
+    """Pick the headers of a few packages out of an hdlist.
+
+    Served from the offset index when the hdlist has an up-to-date one
+    (see :func:`build_hdlist_index`).  Otherwise one pass over the file,
+    stopping as soon as every package has been seen.  Tags are decoded
+    lazily, so headers that are not asked for only cost their NEVRA tags.
+
+    Args:
+        filename: Path to hdlist.cz file
+        nevras: Wanted NEVRAs, with or without epoch
+
+    Returns:
+        Dict mapping each requested NEVRA found in the file to its header
+    """
+    wanted = set(nevras)
+    found: Dict[str, RPMHeader] = {}
+    if not wanted:
+        return found
+
+    index = HdlistIndex.load(filename)
+    if index is not None:
+        return index.get_many(wanted)
+
+    for header in parse_hdlist(filename):
+        for key in (header.nevra, header.nvra):
+            if key in wanted:
+                found[key] = header
+                wanted.discard(key)
+        if not wanted:
+            break
+    return found
+
+
 def parse_hdlist_to_list(filename: Path) -> List[Dict[str, Any]]:
     """Parse an hdlist file and return list of package dicts.
     
@@ -0,0 +1,133 @@
+"""
+Shared keep-alive HTTP connections
+
+Media sync and package downloads used to build a fresh libcurl handle
+(or a urllib opener) per file, so an update of 300 small packages from
+one mirror paid for 300 TCP+TLS handshakes.  Transfers now borrow a
+per-thread curl handle that is reset, not closed, between files, and
+every handle is attached to one process-wide ``CurlShare`` holding the
+connection, DNS and TLS session caches.  Any worker can therefore pick
+up an idle connection another worker (or the metadata sync before it)
+left open to the same host.
+
+With ``[download] http2`` enabled, HTTPS transfers negotiate HTTP/2
+when the mirror offers it, falling back to HTTP/1.1 otherwise.
+
+Usage::
+
+    c = acquire()
+    try:
+        c.setopt(pycurl.URL, url)
+        ...
+        c.perform()
+    finally:
+        release(c)
+"""
+
+import logging
+import os
+import threading
+from typing import List, Optional
+
+import pycurl
+
+logger = logging.getLogger(__name__)
+
+_lock = threading.Lock()
+_local = threading.local()
+_share: Optional['pycurl.CurlShare'] = None
+_share_pid: Optional[int] = None
+
+# Handles inherited across fork() are never closed in the child: closing
+# them would shut down TLS sessions the parent is still using
+_abandoned: List[object] = []
+
+
+def _get_share() -> Optional['pycurl.CurlShare']:
+    """Return the process-wide CurlShare, creating it on first use."""
+    global _share, _share_pid
+    with _lock:
+        if _share is not None and _share_pid == os.getpid():
+            return _share
+        if _share is not None:
+            _abandoned.append(_share)
+        _share_pid = os.getpid()
+        try:
+            share = pycurl.CurlShare()
+            share.setopt(pycurl.SH_SHARE, pycurl.LOCK_DATA_DNS)
+            share.setopt(pycurl.SH_SHARE, pycurl.LOCK_DATA_SSL_SESSION)
+            # Sharing the connection cache needs libcurl >= 7.57
+            if hasattr(pycurl, 'LOCK_DATA_CONNECT'):
+                share.setopt(pycurl.SH_SHARE, pycurl.LOCK_DATA_CONNECT)
+            _share = share
+        except pycurl.error as e:
+            # Per-thread handles still keep their own connections alive
+            logger.debug(f"curl share unavailable: {e}")
+            _share = None
+        return _share
+
+
+def _configure(c: 'pycurl.Curl'):
+    """Apply the pool options to a freshly reset handle."""
+    from .settings import get_settings
+
+    share = _get_share()
+    if share is not None:
+        c.setopt(pycurl.SHARE, share)
+    c.setopt(pycurl.TCP_KEEPALIVE, 1)
+    if get_settings().download.http2 and hasattr(pycurl, 'CURL_HTTP_VERSION_2TLS'):
+        c.setopt(pycurl.HTTP_VERSION, pycurl.CURL_HTTP_VERSION_2TLS)
+
+
+def acquire() -> 'pycurl.Curl':
+    """Borrow this thread's curl handle for one transfer.
+
+    The handle comes back with default options plus the pool settings;
+    callers set everything else.  A transfer started while the thread's
+    handle is already in use (from inside a callback) gets a temporary
+    handle that still shares the connection cache.
+
+    Returns:
+        A ``pycurl.Curl`` to hand back with :func:`release`.
+    """
+    pid = os.getpid()
+    c = getattr(_local, 'curl', None)
+    if c is not None and getattr(_local, 'pid', pid) != pid:
+        _abandoned.append(c)
+        c = _local.curl = None
+        _local.busy = False
+    if getattr(_local, 'busy', False):
+        c = pycurl.Curl()
+    else:
+        if c is None:
+            c = _local.curl = pycurl.Curl()
+            _local.pid = pid
+        _local.busy = True
+    _configure(c)
+    return c
+
+
+def release(c: 'pycurl.Curl'):
+    """Return a handle obtained from :func:`acquire`.
+
+    The thread's handle is reset, which drops references to callbacks
+    and output files but keeps its connections open for the next
+    transfer; temporary handles are closed.
+    """
+    if c is getattr(_local, 'curl', None):
+        c.reset()
+        _local.busy = False
+    else:
+        c.close()
+
+
+def apply_ip_mode(c: 'pycurl.Curl', ip_mode: str):
+    """Restrict name resolution according to a server's ``ip_mode``.
+
+    'ipv6' forces IPv6; 'auto', 'dual' and 'ipv4' prefer IPv4, which
+    avoids long IPv6 timeouts on hosts without working IPv6 routes.
+    """
+    if ip_mode == 'ipv6':
+        c.setopt(pycurl.IPRESOLVE, pycurl.IPRESOLVE_V6)
+    elif ip_mode in ('ipv4', 'auto', 'dual'):
+        c.setopt(pycurl.IPRESOLVE, pycurl.IPRESOLVE_V4)
@@ -23,13 +23,17 @@ from .database import PackageDatabase
 from .download import Downloader, DownloadItem
 from .install import InstallResult
 from .resilient_install import (
-    pre_verify_signatures, purge_failed_from_cache,
+    SignaturePipeline, pre_verify_signatures, purge_failed_from_cache,
     find_dependents, retry_failed_downloads, _extract_name_from_path,
 )
+from .settings import get_settings
 from .transaction_queue import TransactionQueue, TransactionProgress, TransactionPhase
 
 logger = logging.getLogger(__name__)
 
+# Changelog entries reported per package by get_update_details()
+UPDATE_CHANGELOG_ENTRIES = 5
+
 # Optional auth imports - available when urpm.auth is installed
 try:
     from ..auth.context import AuthContext, Permission, AuthError
@@ -79,6 +83,9 @@ class PackageOperations:
             base_dir = get_base_dir()
         self.base_dir = base_dir
         self.audit = audit_logger
+        # Set by download_packages(verify_ahead=True), used up by
+        # the next resilient_install()
+        self._signature_pipeline: Optional[SignaturePipeline] = None
 
     # =========================================================================
     # Auth helpers
@@ -232,7 +239,8 @@ class PackageOperations:
         download_items: List[DownloadItem],
         options: InstallOptions = None,
         progress_callback: Callable = None,
-        urpm_root: str = None
+        urpm_root: str = None,
+        verify_ahead: bool = False,
     ) -> Tuple[list, int, int, dict]:
         """Download packages.
 
@@ -241,6 +249,10 @@ class PackageOperations:
             options: Install options (peers config)
             progress_callback: Download progress callback
             urpm_root: Override base dir for cache
+            verify_ahead: Pre-verify signatures of finished RPMs while
+                the others download (see :class:`SignaturePipeline`);
+                the next :meth:`resilient_install` picks the results up.
+                Ignored when ``download.verify_while_downloading`` is off.
 
         Returns:
             (dl_results, downloaded_count, cached_count, peer_stats)
@@ -261,9 +273,22 @@ class PackageOperations:
             db=self.db
         )
 
-        dl_results, downloaded, cached, peer_stats = downloader.download_all(
-            download_items, progress_callback
-        )
+        result_callback = None
+        if verify_ahead and get_settings().download.verify_while_downloading:
+            pipeline = SignaturePipeline(root=options.root)
+            self._signature_pipeline = pipeline
+
+            def result_callback(result):
+                if result.success and result.path:
+                    pipeline.submit(result.path)
+
+        try:
+            dl_results, downloaded, cached, peer_stats = downloader.download_all(
+                download_items, progress_callback, result_callback=result_callback
+            )
+        finally:
+            if self._signature_pipeline is not None:
+                self._signature_pipeline.close()
 
         return dl_results, downloaded, cached, peer_stats
 
@@ -391,7 +416,11 @@ class PackageOperations:
         path_objects = [Path(p) for p in rpm_paths]
 
         # ── Step 1: Pre-verify signatures (skip if --nosignature) ──
-        if options.verify_signatures:
+        # Mostly done already if the download ran with verify_ahead.
+        pipeline, self._signature_pipeline = self._signature_pipeline, None
+        if options.verify_signatures and pipeline is not None:
+            valid_paths, sig_failed = pipeline.collect(path_objects, root=root)
+        elif options.verify_signatures:
             valid_paths, sig_failed = pre_verify_signatures(path_objects, root=root)
         else:
             valid_paths = path_objects
@@ -778,6 +807,28 @@ class PackageOperations:
         """
         return self.db.search(pattern, limit=limit, search_provides=search_provides)
 
+    def search_packages_prefix(
+        self,
+        pattern: str,
+        search_provides: bool = False,
+        limit: int = 50,
+        interrupted: Callable[[], bool] = None
+    ) -> Optional[List[Dict]]:
+        """Ranked, bounded search for search-as-you-type.
+
+        Args:
+            pattern: What was typed so far
+            search_provides: Also match provides names
+            limit: Maximum results
+            interrupted: Polled during the query; True aborts it
+
+        Returns:
+            List of package dicts, best match first, or None if interrupted.
+        """
+        return self.db.search_prefix(pattern, limit=limit,
+                                     search_provides=search_provides,
+                                     interrupted=interrupted)
+
     def get_package_info(self, identifier: str) -> Optional[Dict]:
         """Get detailed package information.
 
@@ -789,6 +840,50 @@ class PackageOperations:
         """
         return self.db.get_package_smart(identifier)
 
+    def get_packages_info(self, names: List[str]) -> List[Dict]:
+        """Batch variant of get_package_info() for package names.
+
+        Args:
+            names: List of package names
+
+        Returns:
+            List of package dicts, in input order (unknown names skipped)
+        """
+        packages = self.db.get_packages_info(names)
+        self._fill_from_hdlist(packages)
+        return packages
+
+    def _fill_from_hdlist(self, packages: List[Dict]):
+        """Fill description/url/license missing from the database.
+
+        Synthesis does not carry them; they come from the media hdlist
+        offset indexes, one block read per package at most.  A medium
+        whose index was not built at sync time is skipped.
+        """
+        from .hdlist import HdlistIndex
+
+        missing = {p['nevra']: p for p in packages
+                   if not p.get('description') and p.get('nevra')}
+        if not missing:
+            return
+
+        for hdlist, _media_name in self._hdlist_media():
+            if not missing:
+                break
+            try:
+                index = HdlistIndex.load(hdlist)
+                if index is None:
+                    continue
+                headers = index.get_many(missing)
+            except Exception as e:
+                logger.debug("Cannot read %s: %s", hdlist, e)
+                continue
+            for nevra, header in headers.items():
+                pkg = missing.pop(nevra)
+                pkg['description'] = header.description
+                pkg['url'] = pkg.get('url') or header.url
+                pkg['license'] = pkg.get('license') or header.license
+
     def resolve_packages(self, names: List[str]) -> List[Dict]:
         """Batch resolve: get info for multiple packages at once.
 
@@ -802,6 +897,102 @@ class PackageOperations:
         """
         return self.db.get_packages_by_names(names)
 
+    def _hdlist_media(self) -> List[Tuple[Path, str]]:
+        """``(hdlist.cz path, media name)`` for every enabled medium that
+        has a full hdlist on disk, update media first.
+
+        Looks where :func:`~urpm.core.sync.sync_media` stores it; only
+        update media get one (``[media] update_hdlist``).
+        """
+        from .sync import HDLIST_PATH, get_media_sync_dir
+
+        media_hdlists = []
+        for media in sorted(self.db.list_media(),
+                            key=lambda m: not m.get('update_media')):
+            if not media.get('enabled', True):
+                continue
+            hdlist = get_media_sync_dir(media, self.base_dir) / HDLIST_PATH
+            if hdlist.exists():
+                media_hdlists.append((hdlist, media['name']))
+        return media_hdlists
+
+    def get_update_details(self, nevras: List[str]) -> List[Dict]:
+        """Changelog, issue date and restart hint for several packages.
+
+        Read from the media ``hdlist.cz`` headers (synthesis carries no
+        changelog) through their offset index, so only the blocks holding
+        the requested headers are decompressed.  The index is built at
+        sync time; a medium without one is skipped rather than scanned.
+
+        Args:
+            nevras: Package NEVRAs, with or without epoch
+
+        Returns:
+            One dict per requested NEVRA, in input order: ``nevra``,
+            ``changelog`` (newest first, at most UPDATE_CHANGELOG_ENTRIES
+            ``time``/``author``/``text`` dicts), ``issued`` (build time),
+            ``restart`` (``system``, ``session`` or ``none``) and
+            ``media``.  Packages not found in any hdlist come back with
+            an empty changelog.
+        """
+        from .hdlist import HdlistIndex
+
+        details: Dict[str, Dict] = {}
+        pending = set(nevras)
+
+        for hdlist, media_name in self._hdlist_media():
+            if not pending:
+                break
+            try:
+                index = HdlistIndex.load(hdlist)
+                if index is None:
+                    continue
+                headers = index.get_many(pending)
+            except Exception as e:
+                logger.debug("Cannot read %s: %s", hdlist, e)
+                continue
+
+            for nevra, header in headers.items():
+                provides = header.provides
+                if 'should-restart:system' in provides:
+                    restart = 'system'
+                elif 'should-restart:session' in provides:
+                    restart = 'session'
+                else:
+                    restart = 'none'
+                details[nevra] = {
+                    'nevra': nevra,
+                    'changelog': header.changelog[:UPDATE_CHANGELOG_ENTRIES],
+                    'issued': header.buildtime,
+                    'restart': restart,
+                    'media': media_name,
+                }
+                pending.discard(nevra)
+
+        return [
+            details.get(nevra) or {
+                'nevra': nevra, 'changelog': [], 'issued': 0,
+                'restart': 'none', 'media': '',
+            }
+            for nevra in nevras
+        ]
+
+    def _files_xml_media(self) -> List[Tuple[Path, str]]:
+        """``(files.xml.lzma path, media name)`` for every enabled medium
+        that has a non-empty file list on disk."""
+        from .config import get_base_dir, get_media_local_path
+        from .sync import FILES_XML_PATH
+
+        base_dir = get_base_dir()
+        media_files = []
+        for media in self.db.list_media():
+            if not media.get('enabled', True):
+                continue
+            files_xml = get_media_local_path(media, base_dir) / FILES_XML_PATH
+            if files_xml.exists() and files_xml.stat().st_size > 200:
+                media_files.append((files_xml, media['name']))
+        return media_files
+
     def search_files(self, pattern: str, limit: int = 100) -> List[Dict]:
         """Search for files matching a pattern across enabled media.
 
@@ -820,19 +1011,9 @@ class PackageOperations:
             ``media_name``.  Empty when no enabled medium has a
             ``files.xml.lzma`` on disk yet.
         """
-        from .config import get_base_dir, get_media_local_path
         from .files_xml import iter_file_matches
-        from .sync import FILES_XML_PATH
-
-        base_dir = get_base_dir()
-        media_files = []
-        for media in self.db.list_media():
-            if not media.get('enabled', True):
-                continue
-            files_xml = get_media_local_path(media, base_dir) / FILES_XML_PATH
-            if files_xml.exists() and files_xml.stat().st_size > 200:
-                media_files.append((files_xml, media['name']))
 
+        media_files = self._files_xml_media()
         if not media_files:
             return []
 
@@ -846,48 +1027,93 @@ class PackageOperations:
             for m in matches
         ]
 
+    def search_files_any(self, patterns: List[str], limit: int = 100) -> List[Dict]:
+        """Find the packages owning files that match any of ``patterns``.
+
+        Batched search_files(): every pattern is matched in the same
+        pass over each medium, and the result holds one entry per
+        package (its first matching file) instead of one per file.
+
+        Args:
+            patterns: patterns as accepted by search_files()
+            limit: maximum number of file matches scanned before the
+                per-package dedup (0 means unlimited).
+
+        Returns:
+            List of dicts with ``file_path``, ``pkg_nevra``,
+            ``media_name``, one per package.
+        """
+        from .files_xml import iter_file_matches
+
+        patterns = [p for p in dict.fromkeys(patterns) if p]
+        media_files = self._files_xml_media()
+        if not patterns or not media_files:
+            return []
+
+        results = []
+        seen = set()
+        for m in iter_file_matches(media_files, patterns, limit=limit):
+            if m.nevra in seen:
+                continue
+            seen.add(m.nevra)
+            results.append({
+                'file_path': m.path,
+                'pkg_nevra': m.nevra,
+                'media_name': m.media_name,
+            })
+        return results
+
     def get_package_files(self, nevra: str) -> List[str]:
         """Get the list of files shipped by ``nevra``.
 
         Used by the D-Bus ``GetPackageFiles`` endpoint; CLI consumers
         should prefer ``urpm show --files`` which already reads the
-        rpmdb for installed packages.
+        rpmdb for installed packages.  See get_packages_files().
+
+        Returns:
+            List of file paths shipped by ``nevra``, or empty list
+            when the package is not in any on-disk ``files.xml.lzma``.
+        """
+        return self.get_packages_files([nevra])[nevra]
+
+    def get_packages_files(self, nevras: List[str]) -> Dict[str, List[str]]:
+        """Get the file lists of several packages at once.
 
         Two-stage scan for performance: an ``xzgrep -q`` containment
         check probes each medium's ``files.xml.lzma`` (xz decompresses
         in parallel with grep, ~0.5 s for the 26 MB compressed Core
-        Release), and only the medium that actually carries the
-        package is fully parsed.  Without this, a single D-Bus call
-        could decompress several hundred MB just to discover the
-        package lives in the second or third medium.  Falls back to a
-        straight parse when ``xzgrep`` is missing.
+        Release), and only media that actually carry one of the
+        packages are fully parsed — once for all of them, stopping as
+        soon as every package has been found.  Without this, a single
+        D-Bus call could decompress several hundred MB just to discover
+        the package lives in the second or third medium.  Falls back to
+        a straight parse when ``xzgrep`` is missing.
 
         Returns:
-            List of file paths shipped by ``nevra``, or empty list
-            when the package is not in any on-disk ``files.xml.lzma``.
+            Dict mapping each requested NEVRA to its file paths (empty
+            list when the package is not in any on-disk
+            ``files.xml.lzma``).
         """
         import subprocess
-        from .config import get_base_dir, get_media_local_path
         from .files_xml import parse_files_xml
-        from .sync import FILES_XML_PATH
 
-        base_dir = get_base_dir()
-        # We grep for the literal ``fn="<nevra>"`` attribute, which
-        # synthesis files put once and only once per package.  ``-F``
-        # turns off regex parsing so an unusual NEVRA cannot inject a
-        # metacharacter.
-        needle = f'fn="{nevra}"'
+        found: Dict[str, List[str]] = {}
+        pending = set(nevras)
 
-        for media in self.db.list_media():
-            if not media.get('enabled', True):
-                continue
-            files_xml = get_media_local_path(media, base_dir) / FILES_XML_PATH
-            if not files_xml.exists() or files_xml.stat().st_size <= 200:
-                continue
+        for files_xml, _media_name in self._files_xml_media():
+            if not pending:
+                break
 
+            # We grep for the literal ``fn="<nevra>"`` attribute, which
+            # synthesis files put once and only once per package.
+            # ``-F`` turns off regex parsing so an unusual NEVRA cannot
+            # inject a metacharacter.
+            needles = []
+            for nevra in sorted(pending):
+                needles += ['-e', f'fn="{nevra}"']
             try:
                 hit = subprocess.run(
-                    ['xzgrep', '-aqF', needle, str(files_xml)],
+                    ['xzgrep', '-aqF'] + needles + [str(files_xml)],
                     check=False,
                 ).returncode == 0
             except FileNotFoundError:
@@ -901,11 +1127,51 @@ class PackageOperations:
 
             try:
                 for parsed_nevra, files in parse_files_xml(files_xml):
-                    if parsed_nevra == nevra:
-                        return list(files)
+                    if parsed_nevra in pending:
+                        found[parsed_nevra] = list(files)
+                        pending.discard(parsed_nevra)
+                        if not pending:
+                            break
             except Exception:
                 continue
-        return []
+
+        return {nevra: found.get(nevra, []) for nevra in nevras}
+
+    def list_packages(self, filters: str, after_key: str = '',
+                      page_size: int = 500) -> Tuple[List[Dict], str]:
+        """One page of the available-package catalog.
+
+        Args:
+            filters: PackageKit filter string (``"~installed;arch"``);
+                ``installed``, ``~installed``, ``arch``, ``~arch`` and
+                ``newest`` are applied, other filters are ignored.
+                Unless ``~installed`` is given, installed packages found
+                in no medium are listed too
+            after_key: '' for the first page, else the key returned by
+                the previous one
+            page_size: Package names per page
+
+        Returns:
+            ``(packages, next_key)``, see PackageDatabase.list_packages_page()
+        """
+        import platform
+
+        wanted = {f.strip() for f in filters.split(';') if f.strip()}
+        arches = None
+        if 'arch' in wanted or '~arch' in wanted:
+            arches = [platform.machine(), 'noarch']
+
+        packages, next_key = self.db.list_packages_page(
+            after_key, page_size,
+            arches=arches, exclude_arches='~arch' in wanted,
+            newest='newest' in wanted,
+            with_installed='~installed' not in wanted,
+        )
+        if 'installed' in wanted:
+            packages = [p for p in packages if p['installed']]
+        elif '~installed' in wanted:
+            packages = [p for p in packages if not p['installed']]
+        return packages, next_key
 
     def get_installed_packages(self) -> List[Dict]:
         """Get list of all installed packages.
@@ -998,6 +1264,47 @@ class PackageOperations:
         """
         return self.db.whatrequires(package_name)
 
+    def whatrequires_any(self, package_names: List[str]) -> List[Dict]:
+        """Batched whatrequires(): packages requiring any of the given
+        packages, each listed once.
+
+        Args:
+            package_names: Package names to check
+
+        Returns:
+            List of package dicts that depend on at least one of them
+        """
+        return self.db.whatrequires_any(package_names)
+
+    def whatprovides(self, values: List[str]) -> List[Dict]:
+        """Find packages providing any of the given capabilities.
+
+        Values come straight from PackageKit WhatProvides (codecs, mime
+        types, fonts, hardware modaliases, ...).  A bare ``type/subtype``
+        is looked up as ``mimehandler(type/subtype)``, and gstreamer
+        provides are tried with and without the ``()(64bit)`` suffix.
+
+        Args:
+            values: Capability names, no version constraint
+
+        Returns:
+            List of package dicts, one per NEVRA
+        """
+        capabilities = []
+        for value in values:
+            value = value.strip()
+            if not value:
+                continue
+            capabilities.append(value)
+            if '(' not in value and value.count('/') == 1:
+                capabilities.append(f"mimehandler({value})")
+            elif value.startswith('gstreamer'):
+                if value.endswith('()(64bit)'):
+                    capabilities.append(value[:-len('()(64bit)')])
+                else:
+                    capabilities.append(value + '()(64bit)')
+        return self.db.whatprovides_any(capabilities)
+
     def install_local_files(
         self,
         rpm_paths: List[str],
@@ -8,13 +8,15 @@ Used by the Downloader to distribute downloads across peers + upstream mirrors.
 import json
 import logging
 import socket
+import threading
 import time as _time
 import urllib.request
 import urllib.error
 from concurrent.futures import ThreadPoolExecutor, as_completed
 from dataclasses import dataclass, field
-from typing import Dict, List, Optional, Set
+from typing import Dict, List, Optional, Set, Tuple
 
+from .cache_digest import CacheDigest
 from .config import PROD_PORT, DEV_PORT, PROD_DISCOVERY_PORT, DEV_DISCOVERY_PORT, is_dev_mode
 from .. import __version__
 
@@ -41,6 +43,7 @@ class Peer:
     local_version: str = ''
     local_arch: str = ''
     served_media: List[dict] = field(default_factory=list)
+    cache_digest: str = ''  # id of the peer's digest, as announced
 
     @property
     def base_url(self) -> str:
@@ -81,6 +84,9 @@ class PeerClient:
         self.discovery_port = DEV_DISCOVERY_PORT if dev_mode else PROD_DISCOVERY_PORT
         self._peers: List[Peer] = []
         self._peers_ts: float = 0.0  # monotonic timestamp of last discovery
+        # (host, port) -> (cache digest, monotonic timestamp of last check)
+        self._digests: Dict[Tuple[str, int], Tuple[CacheDigest, float]] = {}
+        self._digests_lock = threading.Lock()
 
     def discover_peers(self) -> List[Peer]:
         """Discover peers on the LAN.
@@ -197,7 +203,8 @@ class PeerClient:
                                 mirror_enabled=p.get('mirror_enabled', False),
                                 local_version=p.get('local_version', ''),
                                 local_arch=p.get('local_arch', ''),
-                                served_media=p.get('served_media', [])
+                                served_media=p.get('served_media', []),
+                                cache_digest=p.get('cache_digest', ''),
                             ))
                     return peers
 
@@ -302,11 +309,61 @@ class PeerClient:
         except OSError:
             return '127.0.0.1'
 
+    def get_peer_digest(self, peer: Peer) -> Optional[CacheDigest]:
+        """Return the cache digest of ``peer``, fetching it only when needed.
+
+        A cached digest is reused while its id matches the one the peer
+        announced, or for :data:`PEER_CACHE_TTL` seconds when no id is
+        known.  Otherwise it is revalidated with ``?since=<id>``, which
+        costs a few bytes when nothing changed.
+
+        Returns:
+            The digest, or None if the peer does not publish one (older
+            urpmd) or could not be reached
+        """
+        key = (peer.host, peer.port)
+        with self._digests_lock:
+            cached = self._digests.get(key)
+        if cached:
+            digest, checked = cached
+            if peer.cache_digest == digest.id or (
+                    not peer.cache_digest
+                    and _time.monotonic() - checked < PEER_CACHE_TTL):
+                return digest
+
+        url = f"{peer.base_url}/api/cache-digest"
+        if cached:
+            url += f"?since={cached[0].id}"
+        try:
+            req = urllib.request.Request(url)
+            req.add_header('Accept', 'application/json')
+            with urllib.request.urlopen(req, timeout=self.timeout) as response:
+                data = json.loads(response.read().decode('utf-8'))
+        except (urllib.error.URLError, urllib.error.HTTPError,
+                OSError, json.JSONDecodeError) as e:
+            logger.debug(f"No cache digest from {peer.host}:{peer.port}: {e}")
+            return None
+
+        if cached and data.get('unchanged') and data.get('id') == cached[0].id:
+            digest = cached[0]
+        else:
+            digest = CacheDigest.from_dict(data)
+            if digest is None:
+                return None
+        with self._digests_lock:
+            self._digests[key] = (digest, _time.monotonic())
+        return digest
+
     def query_peers_have(self, peers: List[Peer], filenames: List[str],
                          version: str = None, arch: str = None
                          ) -> Dict[str, List[PeerPackageInfo]]:
         """Query multiple peers for package availability.
 
+        Each peer's cache digest (:meth:`get_peer_digest`) is tested
+        first; only the filenames it may contain are confirmed with
+        ``/api/have``, and a peer with no hit is not queried at all.
+        Peers without a digest get the full list.
+
         Args:
             peers: List of peers to query
             filenames: List of RPM filenames to check
@@ -324,10 +381,19 @@ class PeerClient:
 
         def query_one_peer(peer: Peer) -> Optional[Dict]:
             """Query a single peer."""
+            digest = self.get_peer_digest(peer)
+            if digest is None:
+                candidates = filenames
+            else:
+                candidates = [f for f in filenames if f in digest]
+                logger.debug(f"Peer {peer.host}:{peer.port} digest: "
+                             f"{len(candidates)}/{len(filenames)} candidates")
+                if not candidates:
+                    return None
             try:
                 url = f"{peer.base_url}/api/have"
                 # Build payload with optional version/arch filters
-                payload_dict = {'packages': filenames}
+                payload_dict = {'packages': candidates}
                 if version:
                     payload_dict['version'] = version
                 if arch:
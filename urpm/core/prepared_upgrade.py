@@ -0,0 +1,210 @@
+"""
+Upgrade transactions prepared ahead of time by urpmd
+
+The scheduler resolves the pending upgrade and pre-downloads its RPMs in
+the background (``Scheduler._run_predownload``).  It saves the resolved
+actions, and the RPMs that passed :func:`pre_verify_signatures`, next to
+the package database.  When the user then asks for the upgrade (D-Bus
+``UpgradePackages``) the service can skip both resolution and download
+and go straight to the rpm transaction.
+
+A prepared upgrade is only used while nothing it was computed from has
+changed.  :func:`state_key` hashes the package tables, the media
+settings, holds and pins, and the rpmdb; any sync, media edit or rpm
+run outside urpm gives a different key, and the prepared file is then
+ignored.  Each RPM is also checked against the size and mtime it had
+when its signature was verified.  rpm still checks signatures during
+the transaction itself; what is skipped is the early pre-check that
+lets a bad file be retried before the transaction starts.
+"""
+
+import hashlib
+import json
+import logging
+import os
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from .resolver import InstallReason, PackageAction, TransactionType
+
+logger = logging.getLogger(__name__)
+
+PREPARED_UPGRADE_FILE = "prepared-upgrade.json"
+FORMAT_VERSION = 1
+
+# Beyond this age a prepared upgrade is ignored even if the key matches
+# (settings that steer the resolver are not part of the key)
+MAX_AGE = 24 * 3600
+
+
+@dataclass
+class PreparedUpgrade:
+    """A resolved upgrade and the pre-verified RPMs it installs."""
+    key: str
+    created: float
+    actions: List[PackageAction]
+    # RPM path -> [size, mtime_ns] at signature verification time
+    verified: Dict[str, List[int]] = field(default_factory=dict)
+
+    def ready_rpms(self) -> Optional[List[str]]:
+        """RPM paths for the upgrade if every one is verified and unchanged.
+
+        Returns None when the RPMs were not all pre-downloaded, or when
+        one went missing or changed since it was verified; the caller
+        then runs the download step as usual.
+        """
+        upgrades = [a for a in self.actions if a.action != TransactionType.REMOVE]
+        if not upgrades or len(self.verified) != len(upgrades):
+            return None
+        for path, (size, mtime_ns) in self.verified.items():
+            try:
+                st = os.stat(path)
+            except OSError:
+                return None
+            if st.st_size != size or st.st_mtime_ns != mtime_ns:
+                return None
+        return list(self.verified)
+
+
+def prepared_path(db) -> Path:
+    """Where the prepared upgrade for ``db`` is stored."""
+    return db.db_path.parent / PREPARED_UPGRADE_FILE
+
+
+def _rpmdb_key() -> Optional[str]:
+    from .resolution.pool import rpmdb_solv_key
+    return rpmdb_solv_key()
+
+
+def state_key(db, arch: str) -> str:
+    """Fingerprint of everything an upgrade resolution depends on."""
+    h = hashlib.sha256()
+    h.update(f"{FORMAT_VERSION}\0{arch}\0{_rpmdb_key()}\0".encode())
+
+    conn = db.conn
+    count, max_id = conn.execute(
+        "SELECT COUNT(*), MAX(id) FROM packages"
+    ).fetchone()
+    h.update(f"packages\0{count}\0{max_id}\0".encode())
+    for row in conn.execute("""
+        SELECT id, name, enabled, update_media, priority, synthesis_md5
+        FROM media ORDER BY id
+    """):
+        h.update(("media\0" + "\0".join(str(v) for v in row) + "\0").encode())
+    for name in sorted(db.get_held_packages_set()):
+        h.update(f"hold\0{name}\0".encode())
+    for pin in db.list_pins():
+        h.update(("pin\0" + json.dumps(pin, sort_keys=True, default=str)
+                  + "\0").encode())
+    return h.hexdigest()
+
+
+def save(db, key: str, actions: List[PackageAction], rpm_paths: List[Path]):
+    """Store a prepared upgrade for ``db`` (atomically, mode 644).
+
+    Args:
+        db: Package database (the file goes next to it)
+        key: :func:`state_key` taken before resolving
+        actions: Resolved upgrade actions
+        rpm_paths: RPMs that passed signature pre-verification; pass an
+            empty list when only the resolution was done
+    """
+    verified = {}
+    for path in rpm_paths:
+        try:
+            st = os.stat(path)
+        except OSError:
+            continue
+        verified[str(path)] = [st.st_size, st.st_mtime_ns]
+
+    data = {
+        'version': FORMAT_VERSION,
+        'key': key,
+        'created': time.time(),
+        'actions': [{
+            'action': a.action.value,
+            'name': a.name,
+            'evr': a.evr,
+            'arch': a.arch,
+            'nevra': a.nevra,
+            'size': a.size,
+            'filesize': a.filesize,
+            'media_name': a.media_name,
+            'reason': a.reason.value,
+            'from_evr': a.from_evr,
+        } for a in actions],
+        'verified': verified,
+    }
+
+    path = prepared_path(db)
+    tmp = path.with_name(path.name + ".tmp")
+    try:
+        with open(tmp, 'w') as f:
+            json.dump(data, f)
+        os.chmod(tmp, 0o644)
+        os.replace(tmp, path)
+    except OSError as e:
+        logger.warning("Cannot save prepared upgrade: %s", e)
+        tmp.unlink(missing_ok=True)
+        return
+    logger.info("Prepared upgrade saved: %d actions, %d verified RPMs",
+                len(actions), len(verified))
+
+
+def load(db, key: str, max_age: float = MAX_AGE) -> Optional[PreparedUpgrade]:
+    """Return the prepared upgrade for ``db`` if it matches ``key``.
+
+    The file must belong to the current user and not be writable by
+    anyone else, since its RPM paths go straight to the transaction.
+    """
+    path = prepared_path(db)
+    try:
+        st = path.stat()
+        if st.st_uid != os.getuid() or st.st_mode & 0o022:
+            logger.warning("Ignoring %s: unsafe ownership or mode", path)
+            return None
+        with open(path) as f:
+            data = json.load(f)
+    except FileNotFoundError:
+        return None
+    except (OSError, ValueError) as e:
+        logger.debug("Unreadable prepared upgrade %s: %s", path, e)
+        return None
+
+    if data.get('version') != FORMAT_VERSION or data.get('key') != key:
+        return None
+    created = data.get('created', 0)
+    if time.time() - created > max_age:
+        return None
+
+    try:
+        actions = [PackageAction(
+            action=TransactionType(a['action']),
+            name=a['name'],
+            evr=a['evr'],
+            arch=a['arch'],
+            nevra=a['nevra'],
+            size=a.get('size', 0),
+            filesize=a.get('filesize', 0),
+            media_name=a.get('media_name', ''),
+            reason=InstallReason(a.get('reason', 'dependency')),
+            from_evr=a.get('from_evr', ''),
+        ) for a in data.get('actions', [])]
+    except (KeyError, TypeError, ValueError) as e:
+        logger.debug("Malformed prepared upgrade %s: %s", path, e)
+        return None
+
+    return PreparedUpgrade(key=key, created=created, actions=actions,
+                           verified=data.get('verified') or {})
+
+
+def discard(db):
+    """Remove the prepared upgrade for ``db``, if any."""
+    try:
+        prepared_path(db).unlink()
+    except FileNotFoundError:
+        pass
+    except OSError as e:
+        logger.debug("Cannot remove prepared upgrade: %s", e)
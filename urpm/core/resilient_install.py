@@ -15,6 +15,9 @@ in the CLI / GUI layers that call these functions.
 """
 
 import logging
+import os
+import queue
+import threading
 from collections import namedtuple
 from pathlib import Path
 from typing import List, Set, Dict, Tuple, Optional, TYPE_CHECKING
@@ -157,6 +160,107 @@ def pre_verify_signatures(
     return valid, failed
 
 
+class SignaturePipeline:
+    """Run :func:`pre_verify_signatures` on RPMs while others download.
+
+    Without it the install flow downloads everything, then checks every
+    signature, then starts the transaction: the CPU is idle while the
+    network works and the other way round.  The download step hands
+    each finished RPM to :meth:`submit`; a single background thread
+    verifies it right away, so by the time the last download lands
+    little verification is left.
+
+    :meth:`collect` returns the same ``(valid, failed)`` as
+    :func:`pre_verify_signatures` for the paths asked for.  A result
+    is only reused if the file has the size and mtime it had when it
+    was verified, against the keyring of the same root; anything else
+    (not submitted, replaced by a retry) is verified there and then.
+    """
+
+    def __init__(self, root: str = "/"):
+        self.root = root
+        self._queue: "queue.Queue[Optional[Path]]" = queue.Queue()
+        # path -> (size, mtime_ns, FailedRpm or None)
+        self._results: Dict[str, tuple] = {}
+        self._lock = threading.Lock()
+        self._thread: Optional[threading.Thread] = None
+        self._closed = False
+
+    def submit(self, path: Path):
+        """Queue ``path`` for verification (no-op once closed)."""
+        if self._closed:
+            return
+        if self._thread is None:
+            self._thread = threading.Thread(
+                target=self._run, name="sig-verify", daemon=True)
+            self._thread.start()
+        self._queue.put(Path(path))
+
+    def close(self):
+        """Stop accepting paths; queued ones are still verified."""
+        if not self._closed:
+            self._closed = True
+            self._queue.put(None)
+
+    def _run(self):
+        while True:
+            path = self._queue.get()
+            if path is None:
+                return
+            try:
+                st = path.stat()
+                _valid, failed = pre_verify_signatures([path], root=self.root)
+            except Exception as exc:    # never let the worker die silently
+                logger.debug("Background verification of %s failed: %s",
+                             path.name, exc)
+                continue
+            with self._lock:
+                self._results[str(path)] = (
+                    st.st_size, st.st_mtime_ns, failed[0] if failed else None)
+
+    def collect(self, rpm_paths: List[Path],
+                root: Optional[str] = None) -> Tuple[List[Path], List[FailedRpm]]:
+        """Wait for the queued work and return results for ``rpm_paths``.
+
+        If ``root`` names a different root than the pipeline verified
+        against, nothing is reused and every path is checked with that
+        root's keyring.
+        """
+        self.close()
+        if self._thread is not None:
+            self._thread.join()
+        if root is not None and os.path.normpath(root) != os.path.normpath(self.root):
+            logger.debug("Signature pipeline verified against %s, not %s: "
+                         "verifying again", self.root, root)
+            return pre_verify_signatures(rpm_paths, root=root)
+
+        valid: List[Path] = []
+        failed: List[FailedRpm] = []
+        pending: List[Path] = []
+        for path in rpm_paths:
+            entry = self._results.get(str(path))
+            try:
+                st = path.stat()
+            except OSError:
+                st = None
+            if entry is None or st is None or (st.st_size, st.st_mtime_ns) != entry[:2]:
+                pending.append(path)
+            elif entry[2] is None:
+                valid.append(path)
+            else:
+                failed.append(entry[2])
+
+        logger.debug("Signature pipeline: %d verified during download, %d left",
+                     len(rpm_paths) - len(pending), len(pending))
+        if pending:
+            more_valid, more_failed = pre_verify_signatures(pending, root=self.root)
+            valid.extend(more_valid)
+            failed.extend(more_failed)
+            order = {str(p): i for i, p in enumerate(rpm_paths)}
+            valid.sort(key=lambda p: order[str(p)])
+        return valid, failed
+
+
 # ── RPM magic bytes (file header) ─────────────────────────────────────
 # https://refspecs.linuxbase.org/LSB_3.0.0/LSB-Core-generic/LSB-Core-generic/swinstall.html#FILEFORMAT
 _RPM_MAGIC = b"\xed\xab\xee\xdb"
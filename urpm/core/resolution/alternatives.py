@@ -6,6 +6,7 @@ from typing import Dict, List, Optional, Tuple
 import solv
 
 from urpm.core.resolution.pool import lookup_all_requires
+from urpm.core.resolution.profile import phased
 
 
 class AlternativesMixin:
@@ -14,9 +15,11 @@ class AlternativesMixin:
     Requires:
         - self.pool: solv.Pool instance
         - self._solvable_to_pkg: dict mapping solvable IDs to package info
+        - self.profile: Optional ResolveProfile (phase costs)
         - TransactionType, PackageAction, Alternative, InstallReason from resolver
     """
 
+    @phased('alternatives')
     def _find_alternatives(self, solver, trans, actions: list,
                            max_providers: int = 100) -> list:
         """Find cases where multiple packages could satisfy a dependency.
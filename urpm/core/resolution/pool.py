@@ -1,12 +1,17 @@
 """Pool creation and loading operations."""
 
 import logging
+import os
+import shutil
 import tempfile
 from pathlib import Path
-from typing import Dict, List
+from typing import Dict, Iterable, List, Optional
 
 import solv
 
+from .. import cache_stats
+from .profile import phased
+
 try:
     import rpm
     HAS_RPM = True
@@ -15,6 +20,194 @@ except ImportError:
 
 logger = logging.getLogger(__name__)
 
+# Directory holding the rpmdb when rpm cannot tell us (%_dbpath)
+DEFAULT_RPMDB_DIR = "/var/lib/rpm"
+
+
+# =========================================================================
+# .solv repo caches
+#
+# add_mdk() on a decompressed synthesis and add_rpmdb() dominate pool
+# creation.  Their result is cached as libsolv .solv files named after
+# the key of the data they were built from, so a stale cache is simply
+# never found:
+#   <media_info>/synthesis-<key>.solv  key: synthesis md5 + file stamp
+#   <base_dir>/rpmdb-<key>.solv        key: rpmdb mtime
+# Caches are raw loader output; settings-dependent rewrites (suggests ->
+# recommends) are applied after loading, as for a fresh add_mdk().
+# =========================================================================
+
+def _file_stamp(path: Path) -> str:
+    st = path.stat()
+    return f"{st.st_size:x}-{st.st_mtime_ns:x}"
+
+
+def synthesis_solv_path(synthesis_path: Path, md5: Optional[str]) -> Path:
+    """Cache path for a media synthesis, keyed by its md5 and stamp.
+
+    The stamp covers a synthesis replaced on disk before the database
+    md5 was updated (interrupted sync).
+    """
+    key = _file_stamp(synthesis_path)
+    if md5:
+        key = f"{md5[:16]}-{key}"
+    return synthesis_path.with_name(f"synthesis-{key}.solv")
+
+
+def rpmdb_solv_key() -> Optional[str]:
+    """Key of the live rpmdb: newest mtime of its files, or None."""
+    dbpath = DEFAULT_RPMDB_DIR
+    if HAS_RPM:
+        dbpath = rpm.expandMacro('%{_dbpath}') or dbpath
+    try:
+        mtimes = [
+            entry.stat().st_mtime_ns for entry in os.scandir(dbpath)
+            # -shm is touched by readers too
+            if entry.is_file() and not entry.name.endswith('-shm')
+        ]
+    except OSError:
+        return None
+    return f"{max(mtimes):x}" if mtimes else None
+
+
+def load_solv(repo: 'solv.Repo', path: Path) -> bool:
+    """add_solv() a cache into an empty repo; False (repo left empty)
+    when it is missing or unreadable."""
+    if not path.exists():
+        return False
+    f = solv.xfopen(str(path))
+    if f is None:
+        return False
+    try:
+        if repo.add_solv(f):
+            return True
+    finally:
+        f.close()
+    logger.debug("Unreadable solv cache %s, ignoring", path)
+    repo.empty()
+    return False
+
+
+def write_solv(repo: 'solv.Repo', path: Path, stale: Iterable[Path] = ()):
+    """Write repo to a .solv cache, then drop the stale ones.
+
+    Best-effort: a read-only cache directory (resolver run as a user)
+    just means no cache.  Each writer gets its own temporary file, so
+    resolver threads missing the same key never share one.
+    """
+    try:
+        fd, tmp_name = tempfile.mkstemp(dir=path.parent, prefix=path.name,
+                                        suffix='.tmp')
+    except OSError as e:
+        logger.debug("Cannot write solv cache %s: %s", path, e)
+        return
+    tmp_path = Path(tmp_name)
+    try:
+        try:
+            # mkstemp() creates it 0600; resolvers run as a user read it too
+            os.fchmod(fd, 0o644)
+        finally:
+            os.close(fd)
+        f = solv.xfopen(tmp_name, 'w')
+        if f is None:
+            return
+        try:
+            ok = repo.write(f)
+        finally:
+            f.close()
+        if not ok:
+            return
+        os.replace(tmp_path, path)
+    except OSError as e:
+        logger.debug("Cannot write solv cache %s: %s", path, e)
+        return
+    finally:
+        tmp_path.unlink(missing_ok=True)
+    for old in stale:
+        if old != path:
+            try:
+                old.unlink()
+            except OSError:
+                pass
+
+
+def add_synthesis(repo: 'solv.Repo', synthesis_path: Path):
+    """Load a compressed synthesis file into repo with add_mdk()."""
+    from ..compression import STREAM_BUFFER_SIZE, decompress_stream
+
+    with decompress_stream(synthesis_path) as stream, \
+            tempfile.NamedTemporaryFile(suffix='.hdlist', delete=False) as tmp:
+        shutil.copyfileobj(stream, tmp, STREAM_BUFFER_SIZE)
+        tmp_path = tmp.name
+
+    try:
+        f = solv.xfopen(tmp_path)
+        repo.add_mdk(f)
+        f.close()
+    finally:
+        Path(tmp_path).unlink()
+
+
+def load_synthesis_cached(repo: 'solv.Repo', synthesis_path: Path,
+                          md5: Optional[str]) -> bool:
+    """Fill repo from the synthesis .solv cache, building it on a miss.
+
+    Returns:
+        True when the cache was used
+    """
+    cache_path = synthesis_solv_path(synthesis_path, md5)
+    hit = load_solv(repo, cache_path)
+    cache_stats.record('solv_synthesis', hit)
+    if hit:
+        return True
+    add_synthesis(repo, synthesis_path)
+    write_solv(repo, cache_path,
+               synthesis_path.parent.glob('synthesis-*.solv'))
+    return False
+
+
+def write_synthesis_solv(synthesis_path: Path, md5: Optional[str]):
+    """Build the .solv cache of a freshly synced synthesis."""
+    pool = solv.Pool()
+    pool.setdisttype(solv.Pool.DISTTYPE_RPM)
+    repo = pool.add_repo("sync")
+    add_synthesis(repo, synthesis_path)
+    write_solv(repo, synthesis_solv_path(synthesis_path, md5),
+               synthesis_path.parent.glob('synthesis-*.solv'))
+
+
+def add_rpmdb_cached(repo: 'solv.Repo', cache_dir: Path) -> bool:
+    """Load the live rpmdb into repo, through a .solv cache.
+
+    An up-to-date cache is loaded as is.  Otherwise the previous cache
+    still serves as reference for add_rpmdb_reffp(), so only headers
+    that changed are read back from the rpmdb, and the cache is
+    rewritten.
+
+    Returns:
+        True when the cache was used as is
+    """
+    key = rpmdb_solv_key()
+    if key is None:
+        repo.add_rpmdb()
+        return False
+
+    cache_path = cache_dir / f"rpmdb-{key}.solv"
+    hit = load_solv(repo, cache_path)
+    cache_stats.record('solv_rpmdb', hit)
+    if hit:
+        return True
+
+    previous = sorted(cache_dir.glob('rpmdb-*.solv'))
+    ref = solv.xfopen(str(previous[-1])) if previous else None
+    if ref is not None:
+        repo.add_rpmdb_reffp(ref)
+        ref.close()
+    else:
+        repo.add_rpmdb()
+    write_solv(repo, cache_path, previous)
+    return False
+
 
 def lookup_all_requires(solvable) -> list:
     """Return all SOLVABLE_REQUIRES including prereq-marked deps.
@@ -47,8 +240,10 @@ class PoolMixin:
         - self.allowed_arches: set of allowed architectures
         - self._solvable_to_pkg: dict mapping solvable IDs to package info
         - self._installed_count: int
+        - self.profile: Optional ResolveProfile (phase costs)
     """
 
+    @phased('pool')
     def _create_pool(self) -> solv.Pool:
         """Create and populate libsolv Pool from database.
 
@@ -57,7 +252,6 @@ class PoolMixin:
         - add_mdk() for loading synthesis files directly
         """
         from ..config import get_media_local_path, get_base_dir, get_system_version
-        from ..compression import decompress_stream
         from ..resolver import get_solver_debug, parse_capability, VersionConflictError
         import time as _time
 
@@ -90,7 +284,7 @@ class PoolMixin:
                     # dependency types (Requires, Conflicts, Obsoletes, …).
                     self._installed_count = self._load_rpmdb(pool, installed)
                 else:
-                    installed.add_rpmdb()
+                    self._add_rpmdb(installed)
                     self._installed_count = installed.nsolvables
             else:
                 self._installed_count = 0
@@ -163,18 +357,9 @@ class PoolMixin:
 
             if synthesis_path.exists():
                 try:
-                    # Decompress and load with add_mdk
-                    stream = decompress_stream(synthesis_path)
-                    data = stream.read()
-
-                    with tempfile.NamedTemporaryFile(suffix='.hdlist', delete=False) as tmp:
-                        tmp.write(data)
-                        tmp_path = tmp.name
-
-                    f = solv.xfopen(tmp_path)
-                    repo.add_mdk(f)
-                    f.close()
-                    Path(tmp_path).unlink()
+                    # .solv cache, or decompress and load with add_mdk
+                    cached = load_synthesis_cached(
+                        repo, synthesis_path, media.get('synthesis_md5'))
 
                     # genhdlist2 maps RPM Recommends to @suggests@ in
                     # synthesis.  add_mdk() loads them as SOLVABLE_SUGGESTS.
@@ -203,7 +388,8 @@ class PoolMixin:
                             'filesize': s.lookup_num(solv.SOLVABLE_DOWNLOADSIZE) or 0,
                             'media_name': repo.name,
                         }
-                    debug.log(f"Loaded {repo.nsolvables} packages from synthesis")
+                    debug.log(f"Loaded {repo.nsolvables} packages from "
+                              f"{'solv cache' if cached else 'synthesis'}")
                 except Exception as e:
                     debug.log(f"Failed to load synthesis for {media['name']}: {e}")
                     # Fallback to SQLite loading
@@ -217,8 +403,30 @@ class PoolMixin:
         _pool_elapsed = _time.monotonic() - _pool_t0
         debug.log_timing(f"pool creation total: {_pool_elapsed:.3f}s")
         debug.log_pool_stats(pool)
+        self._profile_pool(pool)
         return pool
 
+    def _profile_pool(self, pool: solv.Pool):
+        """Record the pool size in the resolve profile, if any."""
+        if self.profile is not None:
+            self.profile.count(
+                solvables=sum(repo.nsolvables for repo in pool.repos),
+                installed=self._installed_count,
+                repos=len(pool.repos),
+            )
+
+    @phased('rpmdb')
+    def _add_rpmdb(self, installed: solv.Repo):
+        """add_rpmdb() for the live system, through the rpmdb .solv cache."""
+        from ..config import get_base_dir
+
+        cache_dir = get_base_dir(urpm_root=self.urpm_root)
+        if not cache_dir.is_dir():
+            installed.add_rpmdb()
+            return
+        add_rpmdb_cached(installed, cache_dir)
+
+    @phased('pool')
     def _create_system_pool(self) -> solv.Pool:
         """Create a pool with only installed packages (@System).
 
@@ -245,13 +453,14 @@ class PoolMixin:
             if self.root:
                 self._installed_count = self._load_rpmdb(pool, installed)
             else:
-                installed.add_rpmdb()
+                self._add_rpmdb(installed)
                 self._installed_count = installed.nsolvables
         else:
             self._installed_count = 0
 
         pool.createwhatprovides()
         debug.log_pool_stats(pool)
+        self._profile_pool(pool)
         return pool
 
     def _load_repo_packages(self, pool: solv.Pool, repo: solv.Repo, media_id: int):
@@ -386,6 +595,7 @@ class PoolMixin:
                 if s:
                     s.add_deparray(solv_type, parse_capability(pool, cap))
 
+    @phased('rpmdb')
     def _load_rpmdb(self, pool: solv.Pool, repo: solv.Repo) -> int:
         """Load installed packages from rpmdb into libsolv repo.
 
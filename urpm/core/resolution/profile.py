@@ -0,0 +1,168 @@
+"""Per-phase cost of dependency resolution.
+
+A :class:`ResolveProfile` attached to a Resolver (``--profile-resolve``,
+or the ``profile`` field of PreviewInstall) records, for each phase:
+
+    calls         times the phase was entered
+    wall_ms       elapsed time
+    cpu_ms        CPU time of the resolving thread
+    alloc_blocks  net Python object blocks allocated (sys.getallocatedblocks)
+    rss_kb        resident memory growth; libsolv's own allocations,
+                  which the block count does not see, show up here
+
+``wall_ms`` and ``cpu_ms`` belong to the resolving thread.
+``alloc_blocks`` and ``rss_kb`` are process-wide: in the D-Bus service
+they also count whatever the other read workers allocate meanwhile, so
+they only compare across calls made on an otherwise idle process (as
+with the CLI).
+
+Phases nest and each is charged its own time only, so they add up to
+the total.  Time spent in a resolve call outside any named phase is
+charged to ``other``.
+"""
+
+import functools
+import os
+import sys
+import time
+from contextlib import contextmanager, nullcontext
+from typing import Dict, List, Optional
+
+# Phases in report order
+PHASES = ('pool', 'rpmdb', 'jobs', 'solve', 'alternatives', 'order', 'other')
+
+_METRICS = ('wall', 'cpu', 'alloc_blocks', 'rss_kb')
+
+try:
+    _PAGE_KB = os.sysconf('SC_PAGE_SIZE') // 1024
+except (AttributeError, OSError, ValueError):
+    _PAGE_KB = 4
+
+
+def _rss_kb() -> int:
+    """Resident set size in KiB (0 where /proc is not available)."""
+    try:
+        with open('/proc/self/statm') as f:
+            return int(f.read().split()[1]) * _PAGE_KB
+    except (OSError, ValueError, IndexError):
+        return 0
+
+
+def _sample():
+    return (time.perf_counter(), time.thread_time(),
+            sys.getallocatedblocks(), _rss_kb())
+
+
+class ResolveProfile:
+    """Per-phase wall/CPU time and allocations of resolve calls.
+
+    Not thread-safe: use one profile per resolving thread.
+    """
+
+    def __init__(self):
+        self.phases: Dict[str, Dict[str, float]] = {}
+        self.counts: Dict[str, int] = {}
+        # [charged, own] name per open phase(); mark() relabels the
+        # innermost one
+        self._stack: List[List[str]] = []
+        self._last = None
+
+    def _charge(self):
+        now = _sample()
+        if self._stack:
+            stats = self.phases.setdefault(self._stack[-1][0], _empty())
+            for key, before, after in zip(_METRICS, self._last, now):
+                stats[key] += after - before
+        self._last = now
+
+    @contextmanager
+    def phase(self, name: str):
+        """Charge the enclosed code to ``name``."""
+        self._charge()
+        self.phases.setdefault(name, _empty())['calls'] += 1
+        self._stack.append([name, name])
+        try:
+            yield self
+        finally:
+            self._charge()
+            self._stack.pop()
+
+    def mark(self, name: Optional[str]):
+        """Charge the rest of the innermost phase to ``name``.
+
+        ``None`` returns to the innermost phase's own name.  Suits the
+        sequential steps of a resolve call, which may return at any
+        point: the label ends with the phase it was set in.
+        """
+        if not self._stack:
+            return
+        self._charge()
+        frame = self._stack[-1]
+        frame[0] = frame[1] if name is None else name
+        if name is not None:
+            self.phases.setdefault(name, _empty())['calls'] += 1
+
+    def count(self, **counts: int):
+        """Record sizes of the problem (solvables, jobs, steps...)."""
+        self.counts.update(counts)
+
+    def total(self) -> Dict[str, float]:
+        return {key: sum(p[key] for p in self.phases.values())
+                for key in _METRICS}
+
+    def to_dict(self) -> Dict:
+        """JSON-ready report, times in milliseconds."""
+        order = [p for p in PHASES if p in self.phases]
+        order += sorted(p for p in self.phases if p not in PHASES)
+        return {
+            'phases': {name: _export(self.phases[name]) for name in order},
+            'total': _export(self.total()),
+            'counts': dict(self.counts),
+        }
+
+    def format(self) -> List[str]:
+        """Report as aligned text lines."""
+        report = self.to_dict()
+        lines = [f"{'phase':<13}{'calls':>6}{'wall ms':>11}{'cpu ms':>11}"
+                 f"{'blocks':>10}{'rss KiB':>10}"]
+        rows = list(report['phases'].items()) + [('total', report['total'])]
+        for name, p in rows:
+            lines.append(f"{name:<13}{p.get('calls', ''):>6}{p['wall_ms']:>11.1f}"
+                         f"{p['cpu_ms']:>11.1f}{p['alloc_blocks']:>10}"
+                         f"{p['rss_kb']:>10}")
+        if report['counts']:
+            lines.append(', '.join(f"{k}={v}" for k, v in report['counts'].items()))
+        return lines
+
+
+def _empty() -> Dict[str, float]:
+    return {'calls': 0, 'wall': 0.0, 'cpu': 0.0, 'alloc_blocks': 0, 'rss_kb': 0}
+
+
+def _export(stats: Dict[str, float]) -> Dict:
+    result = {
+        'wall_ms': round(stats['wall'] * 1000, 3),
+        'cpu_ms': round(stats['cpu'] * 1000, 3),
+        'alloc_blocks': int(stats['alloc_blocks']),
+        'rss_kb': int(stats['rss_kb']),
+    }
+    if 'calls' in stats:
+        result = {'calls': stats['calls'], **result}
+    return result
+
+
+def profile_phase(obj, name: str):
+    """``obj.profile.phase(name)``, or a no-op when not profiling."""
+    profile = obj.profile
+    return profile.phase(name) if profile is not None else nullcontext()
+
+
+def phased(name: str):
+    """Decorator: charge a Resolver method to phase ``name``."""
+    def decorator(method):
+        @functools.wraps(method)
+        def wrapper(self, *args, **kwargs):
+            with profile_phase(self, name):
+                return method(self, *args, **kwargs)
+        return wrapper
+    return decorator
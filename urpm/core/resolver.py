@@ -7,6 +7,7 @@ Uses the SAT-based libsolv library for fast, correct dependency resolution.
 import logging
 import re
 import solv
+import sys
 from pathlib import Path
 from urpm.core.resolution.pool import lookup_all_requires
 from typing import List, Dict, Optional, Tuple
@@ -23,6 +24,7 @@ from .database import PackageDatabase
 from .config import get_media_local_path, get_base_dir, get_system_version
 from .compression import decompress_stream
 from .resolution import PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin
+from .resolution.profile import ResolveProfile, phased
 from .synthesis import parse_nevra
 
 LOGGER = logging.getLogger(__name__)
@@ -101,13 +103,17 @@ class SolverDebug:
         debug = SolverDebug(enabled=True, watched=['pkg1', 'pkg2'])
         debug.log("Pool created")
         debug.watch("pkg1", "Found installed", "1.0-1.mga10")
+
+    With ``profile=True`` it also carries the :class:`ResolveProfile`
+    that resolvers created without one of their own record into.
     """
 
     def __init__(self, enabled: bool = False, watched: List[str] = None,
-                 timing: bool = False):
+                 timing: bool = False, profile: bool = False):
         self.enabled = enabled
         self.timing = timing
         self.watched = set(w.lower() for w in (watched or []))
+        self.profile = ResolveProfile() if profile else None
 
     def log(self, msg: str, indent: int = 0):
         """Print a debug message."""
@@ -130,6 +136,13 @@ class SolverDebug:
         if self.timing:
             print(f"[TIMING] {msg}")
 
+    def log_profile(self, file=None):
+        """Print the per-phase resolve profile (to stderr by default)."""
+        if self.profile is None:
+            return
+        for line in self.profile.format():
+            print(f"[PROFILE] {line}", file=file or sys.stderr)
+
     def log_pool_stats(self, pool):
         """Log pool statistics."""
         if not self.enabled:
@@ -211,10 +224,17 @@ _solver_debug = SolverDebug()
 
 
 def set_solver_debug(enabled: bool = False, watched: List[str] = None,
-                     timing: bool = False):
-    """Set global solver debug options."""
+                     timing: bool = False, profile: bool = False):
+    """Set global solver debug options.
+
+    A profile already started (``--profile-resolve``) is kept.
+    """
     global _solver_debug, DEBUG_RESOLVER
-    _solver_debug = SolverDebug(enabled=enabled, watched=watched, timing=timing)
+    active_profile = _solver_debug.profile
+    _solver_debug = SolverDebug(enabled=enabled, watched=watched, timing=timing,
+                                profile=profile and active_profile is None)
+    if active_profile is not None:
+        _solver_debug.profile = active_profile
     if enabled:
         DEBUG_RESOLVER = True
 
@@ -437,12 +457,15 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
     - OrphansMixin: Orphan package detection
     """
 
+    # Per-phase cost recorder, None when not profiling
+    profile: Optional[ResolveProfile] = None
+
     def __init__(self, db: PackageDatabase, arch: str = "x86_64", root: str = None,
                  urpm_root: str = None, install_recommends: bool = True,
                  ignore_installed: bool = False,
                  allowed_arches: list = None,
                  media: str = None, excludemedia: str = None,
-                 sortmedia: str = None):
+                 sortmedia: str = None, profile: ResolveProfile = None):
         """Initialize resolver.
 
         Args:
@@ -458,8 +481,11 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             media: Comma-separated list of media names to restrict to (--media)
             excludemedia: Comma-separated list of media names to exclude (--excludemedia)
             sortmedia: Comma-separated list of media names for priority ordering (--sortmedia)
+            profile: Record per-phase costs here (default: the one set
+                     with set_solver_debug(profile=True), if any)
         """
         self.db = db
+        self.profile = profile if profile is not None else get_solver_debug().profile
         self.arch = arch
         # --urpm-root implies --root to same location
         self.root = urpm_root or root
@@ -483,6 +509,11 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
         self._held_obsolete_warnings = []  # List of (held_pkg, obsoleting_pkg) tuples
         self._held_upgrade_warnings = []  # List of held package names skipped from upgrade
 
+    def _mark_phase(self, name: Optional[str]):
+        """Charge the rest of the current resolve call to phase ``name``."""
+        if self.profile is not None:
+            self.profile.mark(name)
+
     def _solvable_srpm_id(self, solvable) -> Optional[str]:
         """Return ``"<sourcename>-<sourceevr>"`` for a solvable or ``None``.
 
@@ -917,6 +948,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
 
         return problems, skipped
 
+    @phased('other')
     def resolve_install(self, package_names: List[str],
                         choices: Dict[str, str] = None,
                         favored_packages: set = None,
@@ -962,6 +994,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             self._solvable_to_pkg = {}
             self.pool = self._create_pool()
 
+        self._mark_phase('jobs')
         jobs = []
         not_found = []
 
@@ -1208,6 +1241,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             solver.set_flag(solv.Solver.SOLVER_FLAG_IGNORE_RECOMMENDED, 1)
 
         job_origins = self._classify_jobs(jobs, default_kind="user_explicit")
+        if self.profile is not None:
+            self.profile.count(jobs=len(jobs))
+        self._mark_phase('solve')
         problems, _skipped = self._solve(
             solver, jobs, job_origins, atomic=atomic
         )
@@ -1221,7 +1257,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
 
         # Get transaction and order it for correct install sequence
         trans = solver.transaction()
+        self._mark_phase('order')
         trans.order()
+        self._mark_phase(None)
 
         # Build set of explicitly requested package names (lowercase)
         # Extract the base name from NEVRAs and version constraints
@@ -1317,6 +1355,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
                 from_evr=from_evr,
             ))
 
+        if self.profile is not None:
+            self.profile.count(actions=len(actions))
+
         # Detect alternatives: packages that could satisfy the same dependency
         # Filter out alternatives where user already made a choice
         all_alternatives = self._find_alternatives(solver, trans, actions)
@@ -1544,6 +1585,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
         )
         return jobs, will_be_obsoleted, held_warnings
 
+    @phased('other')
     def resolve_upgrade(self, package_names: List[str] = None,
                         local_packages: set = None,
                         atomic: bool = False) -> Resolution:
@@ -1573,6 +1615,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             self.pool = self._create_pool()
             debug.log_pool_stats(self.pool)
 
+        self._mark_phase('jobs')
         jobs = []
         obs_job_ids: set = set()  # ids of jobs that came from _scan_obsoletes
         will_be_obsoleted = set()
@@ -1803,6 +1846,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             if key and key not in requested_solvables:
                 requested_solvables[key] = head
 
+        if self.profile is not None:
+            self.profile.count(jobs=len(jobs))
+        self._mark_phase('solve')
         problems, _skipped = self._solve(
             solver, jobs, job_origins, atomic=atomic, debug=debug
         )
@@ -1817,6 +1863,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
 
         # Get transaction
         trans = solver.transaction()
+        self._mark_phase(None)
         debug.log_transaction(trans)
         if trans.isempty():
             debug.log("Transaction is empty, nothing to do")
@@ -1826,7 +1873,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
                 problems=[],
             )
 
+        self._mark_phase('order')
         trans.order()
+        self._mark_phase(None)
 
         # Build set of explicitly requested package names for reason tracking
         if package_names:
@@ -1896,6 +1945,9 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
                 from_evr=from_evr,
             ))
 
+        if self.profile is not None:
+            self.profile.count(actions=len(actions))
+
         skipped = list(_skipped or [])
         skipped.extend(self._diagnose_silent_holdback(
             requested_solvables, actions, skipped,
@@ -1911,6 +1963,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             skipped=skipped,
         )
 
+    @phased('other')
     def resolve_remove(self, package_names: List[str], clean_deps: bool = True) -> Resolution:
         """Resolve packages to remove.
 
@@ -1924,6 +1977,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
         self._solvable_to_pkg = {}
         self.pool = self._create_system_pool()
 
+        self._mark_phase('jobs')
         jobs = []
         not_found = []
 
@@ -1968,6 +2022,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
                 problems=[f"Package not installed: {n}" for n in not_found]
             )
 
+        self._mark_phase('solve')
         solver = self.pool.Solver()
 
         # Allow removing packages that depend on what we're removing (reverse deps)
@@ -1983,6 +2038,7 @@ class Resolver(PoolMixin, QueriesMixin, AlternativesMixin, OrphansMixin):
             )
 
         trans = solver.transaction()
+        self._mark_phase(None)
         actions = []
         remove_size = 0
 
@@ -96,6 +96,54 @@ class DownloadSettings:
     rather sweep more peers before giving up.
     """
 
+    split_size_mb: int = 64
+    """Fetch packages at least this big (MB) as ranges from several sources.
+
+    Ranges are spread over the fastest mirrors and LAN peers that have
+    the file, so one huge package is not bound by a single connection.
+    ``0`` disables splitting.
+    """
+
+    verify_while_downloading: bool = True
+    """Check signatures of finished RPMs while the rest still download.
+
+    The install and upgrade commands then only wait for the last few
+    files to be verified once the downloads are done, instead of
+    verifying every package after the fact.
+    """
+
+    http2: bool = False
+    """Negotiate HTTP/2 with HTTPS mirrors that offer it.
+
+    Connections are kept alive and shared between media sync and
+    package downloads either way; HTTP/2 adds header compression and
+    falls back to HTTP/1.1 on mirrors without it.
+    """
+
+
+@dataclass
+class MediaSettings:
+    """Media metadata kept alongside the synthesis."""
+
+    files_basename_index: bool = False
+    """Write a basename index next to each ``files.xml.lzma`` at sync.
+
+    ``urpm f`` and file searches then answer exact-name lookups
+    (``bash``, ``/usr/bin/foo``) without decompressing every medium.
+    Costs one pass over the file per refresh and a sidecar on disk;
+    wildcard patterns still use the streaming scan.
+    """
+
+    update_hdlist: bool = True
+    """Keep the full ``hdlist.cz`` of update media, with its offset index.
+
+    Update details (changelog, issue date, restart hint) are only in
+    the hdlist headers.  The hdlist is fetched again each time the
+    update synthesis changes and is roughly ten times its size; the
+    index re-packs the headers with zlib and takes somewhat more disk
+    than the hdlist itself.
+    """
+
 
 @dataclass
 class TransactionSettings:
@@ -232,6 +280,7 @@ class Settings:
 
     resolver: ResolverSettings = field(default_factory=ResolverSettings)
     download: DownloadSettings = field(default_factory=DownloadSettings)
+    media: MediaSettings = field(default_factory=MediaSettings)
     transaction: TransactionSettings = field(default_factory=TransactionSettings)
     daemon: DaemonSettings = field(default_factory=DaemonSettings)
     server: ServerSettings = field(default_factory=ServerSettings)
@@ -385,6 +434,25 @@ def _apply(cp: configparser.ConfigParser, settings: Settings) -> None:
                     val = _as_int(raw)
                     if 0 <= val <= 10:
                         settings.download.max_retries = val
+                elif key == "split_size_mb":
+                    val = _as_int(raw)
+                    if val >= 0:
+                        settings.download.split_size_mb = val
+                elif key == "verify_while_downloading":
+                    settings.download.verify_while_downloading = _as_bool(raw)
+                elif key == "http2":
+                    settings.download.http2 = _as_bool(raw)
+            except ValueError:
+                pass
+
+    # [media]
+    if cp.has_section("media"):
+        for key, raw in cp.items("media"):
+            try:
+                if key == "files_basename_index":
+                    settings.media.files_basename_index = _as_bool(raw)
+                elif key == "update_hdlist":
+                    settings.media.update_hdlist = _as_bool(raw)
             except ValueError:
                 pass
 
@@ -507,6 +575,14 @@ def format_settings(settings: Settings = None) -> str:
     lines.append(f"parallel = {settings.download.parallel}")
     lines.append(f"timeout = {settings.download.timeout}")
     lines.append(f"min_servers = {settings.download.min_servers}")
+    lines.append(f"split_size_mb = {settings.download.split_size_mb}")
+    lines.append(f"verify_while_downloading = {str(settings.download.verify_while_downloading).lower()}")
+    lines.append(f"http2 = {str(settings.download.http2).lower()}")
+    lines.append("")
+
+    lines.append("[media]")
+    lines.append(f"files_basename_index = {str(settings.media.files_basename_index).lower()}")
+    lines.append(f"update_hdlist = {str(settings.media.update_hdlist).lower()}")
     lines.append("")
 
     lines.append("[transaction]")
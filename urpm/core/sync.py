@@ -6,18 +6,17 @@ Downloads synthesis/hdlist files from media sources and imports into cache.
 
 import hashlib
 import logging
+import os
 import shutil
 import tempfile
 import time
-import urllib.request
-import urllib.error
 from pathlib import Path
 from typing import Optional, Callable, Tuple, List, Dict
 from dataclasses import dataclass
 
 from .compression import decompress, decompress_stream
 from .synthesis import parse_synthesis
-from .hdlist import parse_hdlist
+from .hdlist import build_hdlist_index, ensure_hdlist_index, parse_hdlist
 from .database import PackageDatabase
 
 
@@ -51,6 +50,21 @@ def get_media_cache_dir(media_name: str, media_url: str, base_dir: Path = None)
     return get_media_dir(base_dir, hostname, media_name)
 
 
+def get_media_sync_dir(media: dict, base_dir: Path = None) -> Path:
+    """Local directory a sync stores *media*'s metadata under.
+
+    v8 media use :func:`get_media_local_path`; legacy media (no
+    ``relative_path``) keep the hostname-based layout of their URL.
+    Readers of synced files (hdlist, files.xml) must look here.
+    """
+    if base_dir is None:
+        base_dir = get_base_dir()
+    if media.get('relative_path'):
+        return get_media_local_path(media, base_dir)
+    hostname = get_hostname_from_url(media.get('url') or '')
+    return get_media_dir(base_dir, hostname, media['name'])
+
+
 @dataclass
 class DownloadResult:
     """Result of a download operation."""
@@ -81,6 +95,11 @@ def download_file(url: str, dest: Path,
                   ip_mode: str = 'auto') -> DownloadResult:
     """Download a file from URL to destination.
 
+    The transfer reuses a keep-alive connection from
+    :mod:`urpm.core.http_pool` when one to the same host is idle.  The
+    body goes to a ``.part`` file renamed over ``dest`` on success, so
+    a failed download leaves an existing ``dest`` untouched.
+
     Args:
         url: URL to download
         dest: Destination path
@@ -91,57 +110,74 @@ def download_file(url: str, dest: Path,
     Returns:
         DownloadResult with success status and metadata
     """
-    import socket
-    from .config import get_socket_family_for_ip_mode
-
-    # Force IPv4/IPv6 by patching getaddrinfo temporarily
-    family = get_socket_family_for_ip_mode(ip_mode)
-    original_getaddrinfo = socket.getaddrinfo
+    import pycurl
+    from . import http_pool
 
-    def patched_getaddrinfo(host, port, fam=0, *args, **kwargs):
-        # Force the socket family for hostname resolution
-        return original_getaddrinfo(host, port, family, *args, **kwargs)
+    md5_hash = hashlib.md5()
+    downloaded = 0
+    write_error: Optional[OSError] = None
 
+    dest.parent.mkdir(parents=True, exist_ok=True)
+    part = dest.with_name(dest.name + '.part')
+    c = http_pool.acquire()
     try:
-        socket.getaddrinfo = patched_getaddrinfo
-
-        req = urllib.request.Request(url)
-        req.add_header('User-Agent', 'urpm/0.1')
-
-        with urllib.request.urlopen(req, timeout=timeout) as response:
-            total_size = int(response.headers.get('Content-Length', 0))
-            downloaded = 0
-            md5_hash = hashlib.md5()
+        with open(part, 'wb') as f:
+            def _write(data: bytes):
+                nonlocal downloaded, write_error
+                try:
+                    f.write(data)
+                except OSError as e:
+                    write_error = e
+                    return 0
+                md5_hash.update(data)
+                downloaded += len(data)
+                return None
+
+            c.setopt(pycurl.URL, url)
+            c.setopt(pycurl.WRITEFUNCTION, _write)
+            c.setopt(pycurl.FOLLOWLOCATION, 1)
+            c.setopt(pycurl.MAXREDIRS, 5)
+            c.setopt(pycurl.CONNECTTIMEOUT, timeout)
+            c.setopt(pycurl.LOW_SPEED_LIMIT, 1024)
+            c.setopt(pycurl.LOW_SPEED_TIME, timeout)
+            c.setopt(pycurl.USERAGENT, 'urpm/0.1')
+            c.setopt(pycurl.NOSIGNAL, 1)
+            http_pool.apply_ip_mode(c, ip_mode)
+            if progress_callback:
+                c.setopt(pycurl.NOPROGRESS, 0)
+                c.setopt(pycurl.XFERINFOFUNCTION,
+                         lambda dl_total, dl_now, _ut, _un:
+                         progress_callback(int(dl_now), int(dl_total)))
+            else:
+                c.setopt(pycurl.NOPROGRESS, 1)
 
-            dest.parent.mkdir(parents=True, exist_ok=True)
+            c.perform()
 
-            with open(dest, 'wb') as f:
-                while True:
-                    chunk = response.read(8192)
-                    if not chunk:
-                        break
-                    f.write(chunk)
-                    md5_hash.update(chunk)
-                    downloaded += len(chunk)
+        http_code = c.getinfo(pycurl.HTTP_CODE)
+        if http_code >= 400:
+            return DownloadResult(success=False, error=f"HTTP {http_code}")
 
-                    if progress_callback:
-                        progress_callback(downloaded, total_size)
-
-            return DownloadResult(
-                success=True,
-                path=dest,
-                size=downloaded,
-                md5=md5_hash.hexdigest()
-            )
+        part.replace(dest)
+        return DownloadResult(
+            success=True,
+            path=dest,
+            size=downloaded,
+            md5=md5_hash.hexdigest()
+        )
 
-    except urllib.error.HTTPError as e:
-        return DownloadResult(success=False, error=f"HTTP {e.code}: {e.reason}")
-    except urllib.error.URLError as e:
-        return DownloadResult(success=False, error=f"URL error: {e.reason}")
+    except pycurl.error as e:
+        if write_error is not None:
+            return DownloadResult(success=False, error=str(write_error))
+        return DownloadResult(success=False, error=f"URL error: {e.args[1]}")
     except Exception as e:
         return DownloadResult(success=False, error=str(e))
     finally:
-        socket.getaddrinfo = original_getaddrinfo
+        http_pool.release(c)
+        if part.exists():
+            try:
+                part.unlink()
+            except OSError:
+                pass
 
 
 def get_media_base_url(media_url: str) -> str:
@@ -330,13 +366,37 @@ def head_synthesis(synthesis_url: str, server: dict = None,
         except OSError:
             return None
 
+    import pycurl
+    from . import http_pool
+
+    headers = {}
+
+    def _header(line: bytes):
+        name, sep, value = line.decode('iso-8859-1').partition(':')
+        if sep:
+            headers[name.strip().lower()] = value.strip()
+
+    c = http_pool.acquire()
     try:
-        req = urllib.request.Request(synthesis_url, method='HEAD')
-        req.add_header('User-Agent', 'urpm/0.1')
-        with urllib.request.urlopen(req, timeout=timeout) as response:
-            return response.headers.get('Last-Modified')
+        c.setopt(pycurl.URL, synthesis_url)
+        c.setopt(pycurl.NOBODY, 1)
+        c.setopt(pycurl.HEADERFUNCTION, _header)
+        c.setopt(pycurl.FOLLOWLOCATION, 1)
+        c.setopt(pycurl.MAXREDIRS, 5)
+        c.setopt(pycurl.CONNECTTIMEOUT, timeout)
+        c.setopt(pycurl.TIMEOUT, timeout)
+        c.setopt(pycurl.USERAGENT, 'urpm/0.1')
+        c.setopt(pycurl.NOSIGNAL, 1)
+        if server:
+            http_pool.apply_ip_mode(c, server.get('ip_mode', 'auto'))
+        c.perform()
+        if c.getinfo(pycurl.HTTP_CODE) >= 400:
+            return None
+        return headers.get('last-modified')
     except Exception:
         return None
+    finally:
+        http_pool.release(c)
 
 
 def _fetch_files_xml_if_changed(db: PackageDatabase, media_id: int,
@@ -353,7 +413,9 @@ def _fetch_files_xml_if_changed(db: PackageDatabase, media_id: int,
 
     The freshly downloaded file is not parsed nor imported anywhere —
     ``urpm f`` streams it directly via
-    :func:`urpm.core.files_xml.iter_file_matches`.
+    :func:`urpm.core.files_xml.iter_file_matches`.  With
+    ``[media] files_basename_index`` enabled, its basename index is
+    (re)built here as well.
 
     Args:
         db: Database instance — used to read and update
@@ -380,7 +442,10 @@ def _fetch_files_xml_if_changed(db: PackageDatabase, media_id: int,
     dest = cache_media_info / FILES_XML_PATH.split('/')[-1]
 
     if stored_md5 == remote_md5 and dest.exists():
-        return  # Up to date, nothing to fetch.
+        # Up to date, nothing to fetch; index it if that was only
+        # enabled since the last download
+        _index_files_xml(dest)
+        return
 
     files_xml_url = (
         f"{build_media_url(server, media)}/{FILES_XML_PATH}"
@@ -418,10 +483,73 @@ def _fetch_files_xml_if_changed(db: PackageDatabase, media_id: int,
             return
         shutil.move(str(tmp_path), str(dest))
         db.update_media_files_xml_md5(media_id, remote_md5)
+        _index_files_xml(dest)
     finally:
         tmp_path.unlink(missing_ok=True)
 
 
+def _index_files_xml(files_xml: Path) -> None:
+    """Build the opt-in basename index of a synced files.xml.lzma."""
+    from .files_xml import ensure_files_index
+    from .settings import get_settings
+
+    if get_settings().media.files_basename_index:
+        ensure_files_index(files_xml)
+
+
+def _wants_hdlist(media: dict) -> bool:
+    """Whether a sync keeps the full hdlist.cz of *media*.
+
+    Only update media carry it (``[media] update_hdlist``): update
+    details are read from its headers.
+    """
+    from .settings import get_settings
+
+    return bool(media.get('update_media')) and get_settings().media.update_hdlist
+
+
+def _fetch_hdlist(media: dict, server: Optional[dict], media_url: str,
+                  dest: Path,
+                  progress_callback: Callable[[str, int, int], None] = None
+                  ) -> DownloadResult:
+    """Download the hdlist.cz of *media* to *dest*.
+
+    The file is written under a temporary name and renamed on success,
+    so *dest* is never left half-written.
+    """
+    if progress_callback:
+        progress_callback("downloading hdlist", 0, 0)
+
+    def hdl_progress(current, total):
+        if progress_callback:
+            progress_callback("downloading hdlist", current, total)
+
+    part_path = dest.with_name(dest.name + '.part')
+    try:
+        if server:
+            result = download_from_server(build_hdlist_url_v8(server, media),
+                                          part_path, server, hdl_progress)
+        else:
+            result = download_file(build_hdlist_url(media_url),
+                                   part_path, hdl_progress)
+        if result.success:
+            os.replace(part_path, dest)
+            result.path = dest
+        return result
+    finally:
+        part_path.unlink(missing_ok=True)
+
+
+def _index_hdlist(hdlist: Path) -> None:
+    """Build the offset index of a synced hdlist.cz if it has none yet.
+
+    Covers hdlists synced before indexes existed: query paths only read
+    the index and never build it.
+    """
+    if hdlist.exists() and ensure_hdlist_index(hdlist) is None:
+        logger.warning("Cannot index %s", hdlist)
+
+
 def check_media_update_needed(db: PackageDatabase, media_id: int,
                               media_url: str,
                               server: dict = None,
@@ -508,7 +636,7 @@ def check_media_update_needed(db: PackageDatabase, media_id: int,
 def sync_media(db: PackageDatabase, media_name: str,
                progress_callback: Callable[[str, int, int], None] = None,
                force: bool = False,
-               download_hdlist: bool = False,
+               download_hdlist: Optional[bool] = None,
                urpm_root: str = None,
                skip_appstream: bool = False) -> SyncResult:
     """Synchronize a media source.
@@ -522,6 +650,7 @@ def sync_media(db: PackageDatabase, media_name: str,
         progress_callback: Optional callback(stage, current, total)
         force: Force update even if MD5 matches
         download_hdlist: Also download hdlist for full metadata
+            (default: update media, see ``[media] update_hdlist``)
         urpm_root: If set, store files in <urpm_root>/var/lib/urpm/
         skip_appstream: Skip AppStream sync (default: False)
 
@@ -538,6 +667,8 @@ def sync_media(db: PackageDatabase, media_name: str,
         return SyncResult(success=False, error=f"Media '{media_name}' is disabled")
 
     media_id = media['id']
+    if download_hdlist is None:
+        download_hdlist = _wants_hdlist(media)
 
     # Build an ordered list of (server_dict, media_url) candidates to try.
     # get_servers_for_media() already orders by priority DESC, bandwidth_kbps DESC
@@ -562,9 +693,23 @@ def sync_media(db: PackageDatabase, media_name: str,
             db, media_id, first_url, server=first_server, media=media
         )
         if not needs_update:
+            # Media synced before hdlists were kept get theirs on the
+            # first sync that finds them up to date
+            hdlist = get_media_sync_dir(media, base_dir) / HDLIST_PATH
+            hdlist_downloaded = False
+            if download_hdlist and not hdlist.exists():
+                hdlist.parent.mkdir(parents=True, exist_ok=True)
+                hdl_result = _fetch_hdlist(media, first_server, first_url,
+                                           hdlist, progress_callback)
+                hdlist_downloaded = hdl_result.success
+                if not hdlist_downloaded:
+                    logger.warning("Cannot download hdlist for %s: %s",
+                                   media_name, hdl_result.error)
+            _index_hdlist(hdlist)
             if progress_callback:
                 progress_callback("up-to-date", 0, 0)
-            return SyncResult(success=True, packages_count=0, skipped=True)
+            return SyncResult(success=True, packages_count=0, skipped=True,
+                              hdlist_downloaded=hdlist_downloaded)
 
     # Create temp directory for downloads
     with tempfile.TemporaryDirectory(prefix='urpm_sync_') as tmpdir:
@@ -633,26 +778,12 @@ def sync_media(db: PackageDatabase, media_name: str,
 
         # Optionally download hdlist
         if download_hdlist:
-            if progress_callback:
-                progress_callback("downloading hdlist", 0, 0)
-
-            if server:
-                hdlist_url = build_hdlist_url_v8(server, media)
-            else:
-                hdlist_url = build_hdlist_url(media_url)
-
-            hdlist_path = tmpdir / "hdlist.cz"
-
-            def hdl_progress(current, total):
-                if progress_callback:
-                    progress_callback("downloading hdlist", current, total)
-
-            if server:
-                hdl_result = download_from_server(hdlist_url, hdlist_path, server, hdl_progress)
-            else:
-                hdl_result = download_file(hdlist_url, hdlist_path, hdl_progress)
-
+            hdl_result = _fetch_hdlist(media, server, media_url,
+                                       tmpdir / "hdlist.cz", progress_callback)
             hdlist_downloaded = hdl_result.success
+            if not hdlist_downloaded:
+                logger.warning("Cannot download hdlist for %s: %s",
+                               media_name, hdl_result.error)
 
         # Parse and import synthesis (UPSERT handles obsolete packages)
         if progress_callback:
@@ -681,14 +812,7 @@ def sync_media(db: PackageDatabase, media_name: str,
         # Copy files to permanent cache
         # v8 schema: official/<relative_path>/ or custom/<short_name>/
         # Legacy: <hostname>/<media_name>/
-        if media.get('relative_path'):
-            # v8 schema - use new path structure
-            cache_media_dir = get_media_local_path(media, base_dir)
-        else:
-            # Legacy - use old hostname-based structure
-            cache_media_dir = get_media_cache_dir(media_name, media_url)
-
-        cache_media_info = cache_media_dir / "media_info"
+        cache_media_info = get_media_sync_dir(media, base_dir) / "media_info"
         cache_media_info.mkdir(parents=True, exist_ok=True)
 
         # Copy synthesis
@@ -699,6 +823,11 @@ def sync_media(db: PackageDatabase, media_name: str,
         if hdlist_downloaded:
             cache_hdlist = cache_media_info / "hdlist.cz"
             shutil.copy2(tmpdir / "hdlist.cz", cache_hdlist)
+            try:
+                build_hdlist_index(cache_hdlist)
+            except Exception as e:
+                # Readers fall back to a full scan
+                logger.warning("Cannot index %s: %s", cache_hdlist, e)
 
         # Download and copy MD5SUM
         if server:
@@ -740,6 +869,16 @@ def sync_media(db: PackageDatabase, media_name: str,
         # Update media sync info (thread-safe)
         db.update_media_sync_info(media_id, result.md5, last_modified)
 
+        # Prebuild the resolver's .solv cache so the first resolution
+        # after a sync doesn't pay for add_mdk()
+        try:
+            from .resolution.pool import write_synthesis_solv
+            write_synthesis_solv(cache_synthesis, result.md5)
+        except Exception as e:
+            # The resolver builds it on first use
+            logger.debug("Cannot prebuild solv cache for %s: %s",
+                         media_name, e)
+
         # Conditionally fetch files.xml.lzma alongside the synthesis.
         # The file is consumed on demand by ``urpm f`` (no DB import);
         # we only refresh it when MD5SUM says it changed.  Errors are
@@ -872,9 +1011,11 @@ def sync_all_media(db: PackageDatabase,
             if progress_callback:
                 progress_callback("__appstream__", "merging catalogs", 0, 0)
 
-            total_components, media_count = appstream_mgr.merge_all_catalogs()
+            merge = appstream_mgr.merge_catalogs()
 
-            if total_components > 0:
+            # An unchanged catalog needs no (slow, forced) cache rebuild,
+            # unless the refresh after its last rewrite did not succeed
+            if merge.total_components > 0 and merge.needs_refresh:
                 if progress_callback:
                     progress_callback("__appstream__", "refreshing cache", 0, 0)
                 appstream_mgr.refresh_system_cache()
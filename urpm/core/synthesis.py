@@ -6,11 +6,12 @@ Format: Tags (@provides, @requires, etc.) followed by @info which terminates
 each package definition.
 """
 
+import io
 import re
 from pathlib import Path
 from typing import Dict, Iterator, List, Any, Optional, Tuple
 
-from .compression import decompress
+from .compression import decompress_stream
 
 
 def parse_nevra(nevra: str) -> Tuple[str, str, str, str]:
@@ -115,6 +116,13 @@ def parse_dependency(dep: str) -> Tuple[str, str, str]:
     return dep, '', ''
 
 
+# Tags whose fields are a capability list
+_LIST_TAGS = frozenset((
+    'provides', 'requires', 'conflicts', 'obsoletes',
+    'suggests', 'recommends', 'supplements', 'enhances',
+))
+
+
 def _split_synthesis_line(line: str) -> List[str]:
     """Split a synthesis line on @ separators, handling nested parentheses.
 
@@ -122,28 +130,34 @@ def _split_synthesis_line(line: str) -> List[str]:
     inside parentheses like bundled(npm(@xterm/addon-canvas)).
     We need to only split on @ that are NOT inside parentheses.
 
+    The line is split with str.split(), then pieces cut inside
+    parentheses are joined back, which keeps the walk out of Python
+    for the common case.
+
     Args:
         line: A synthesis line starting with @
 
     Returns:
         List of parts (first element is empty since line starts with @)
     """
+    pieces = line.split('@')
+    if '(' not in line and ')' not in line:
+        if not pieces[-1]:
+            pieces.pop()
+        return pieces
+
+    # Glue back the pieces split on an @ inside parentheses
     parts = []
-    current = ""
-    paren_depth = 0
-
-    for char in line:
-        if char == '(':
-            paren_depth += 1
-            current += char
-        elif char == ')':
-            paren_depth -= 1
-            current += char
-        elif char == '@' and paren_depth == 0:
-            parts.append(current)
-            current = ""
+    current = pieces[0]
+    paren_depth = current.count('(') - current.count(')')
+
+    for piece in pieces[1:]:
+        if paren_depth:
+            current += '@' + piece
         else:
-            current += char
+            parts.append(current)
+            current = piece
+        paren_depth += piece.count('(') - piece.count(')')
 
     if current:
         parts.append(current)
@@ -155,7 +169,8 @@ def parse_synthesis(filename: Path) -> Iterator[Dict[str, Any]]:
     """Parse a synthesis file and yield package dictionaries.
 
     The synthesis format has tags BEFORE @info. When we encounter @info,
-    we create the package with all accumulated tags.
+    we create the package with all accumulated tags.  The file is read
+    line by line from :func:`decompress_stream`, never as a whole.
 
     Args:
         filename: Path to synthesis.hdlist.cz file
@@ -163,11 +178,17 @@ def parse_synthesis(filename: Path) -> Iterator[Dict[str, Any]]:
     Yields:
         Package dictionaries
     """
-    content = decompress(filename)
+    with decompress_stream(filename) as raw, \
+            io.TextIOWrapper(raw, encoding='utf-8', errors='replace',
+                             newline='\n') as content:
+        yield from _parse_synthesis_lines(content)
 
+
+def _parse_synthesis_lines(content) -> Iterator[Dict[str, Any]]:
+    """Body of :func:`parse_synthesis` over an iterable of lines."""
     current_tags: Dict[str, Any] = {}
 
-    for line in content.split('\n'):
+    for line in content:
         line = line.strip()
         if not line or not line.startswith('@'):
             continue
@@ -226,28 +247,13 @@ def parse_synthesis(filename: Path) -> Iterator[Dict[str, Any]]:
             yield pkg
             current_tags = {}
 
-        else:
-            # Accumulate tags for the next @info
-            if tag == 'summary':
-                current_tags['summary'] = parts[2] if len(parts) > 2 else ''
-            elif tag == 'provides':
-                current_tags['provides'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'requires':
-                current_tags['requires'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'conflicts':
-                current_tags['conflicts'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'obsoletes':
-                current_tags['obsoletes'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'suggests':
-                current_tags['suggests'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'recommends':
-                current_tags['recommends'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'supplements':
-                current_tags['supplements'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'enhances':
-                current_tags['enhances'] = list(parts[2:]) if len(parts) > 2 else []
-            elif tag == 'filesize':
-                current_tags['filesize'] = parts[2] if len(parts) > 2 else "0"
+        # Accumulate tags for the next @info
+        elif tag in _LIST_TAGS:
+            current_tags[tag] = parts[2:]
+        elif tag == 'summary':
+            current_tags['summary'] = parts[2] if len(parts) > 2 else ''
+        elif tag == 'filesize':
+            current_tags['filesize'] = parts[2] if len(parts) > 2 else "0"
 
 
 def parse_synthesis_to_list(filename: Path) -> List[Dict[str, Any]]:
@@ -14,6 +14,7 @@ from typing import Optional, List, Dict, Any
 
 # Imports are relative to package - bin/urpmd handles sys.path
 from ..core.database import PackageDatabase
+from ..core.cache_digest import CacheDigest
 from ..core.config import (
     PROD_BASE_DIR, PROD_DB_PATH, PROD_PID_FILE, PROD_PORT,
     DEV_BASE_DIR, DEV_DB_PATH, DEV_PID_FILE, DEV_PORT,
@@ -25,6 +26,9 @@ from .discovery import PeerDiscovery
 
 logger = logging.getLogger(__name__)
 
+# Digest builds raced by an invalidation before one is served uncached
+RPM_DIGEST_ATTEMPTS = 3
+
 
 class UrpmDaemon:
     """Main urpmd daemon class."""
@@ -52,6 +56,15 @@ class UrpmDaemon:
         self._start_time: Optional[datetime] = None
         self._last_refresh: Optional[datetime] = None
 
+        # Served RPMs (filename -> size and path) and their digest, shared
+        # by the HTTP handlers, the discovery thread and the scheduler.
+        # Both are published whole under the lock; the generation moves on
+        # every invalidation so a build that raced with one is not kept.
+        self._rpm_index_lock = threading.Lock()
+        self._rpm_index: Optional[Dict[str, Dict]] = None
+        self._rpm_digest: Optional[CacheDigest] = None
+        self._rpm_index_generation = 0
+
     def start(self, foreground: bool = False):
         """Start the daemon.
 
@@ -341,7 +354,7 @@ class UrpmDaemon:
     def register_peer(self, host: str, port: int, media: List[str],
                        mirror_enabled: bool = False, local_version: str = "",
                        local_arch: str = "", served_media: List[Dict] = None,
-                       instance_id: str = "") -> Dict[str, Any]:
+                       instance_id: str = "", cache_digest: str = "") -> Dict[str, Any]:
         """Register or update a peer."""
         if self.discovery:
             return self.discovery.register_peer(
@@ -351,6 +364,7 @@ class UrpmDaemon:
                 local_arch=local_arch,
                 served_media=served_media,
                 instance_id=instance_id,
+                cache_digest=cache_digest,
             )
         return {'error': 'Discovery not initialized'}
 
@@ -388,8 +402,7 @@ class UrpmDaemon:
 
         # Build index of all available RPMs (filename -> relative path)
         # This is more efficient when checking many packages
-        if not hasattr(self, '_rpm_index') or self._rpm_index is None:
-            self._build_rpm_index()
+        rpm_index = self._get_rpm_index()
 
         # Build path prefix filter for version/arch
         # Path structure: official/<version>/<arch>/media/...
@@ -404,8 +417,8 @@ class UrpmDaemon:
                 missing.append(filename or '<invalid>')
                 continue
 
-            if filename in self._rpm_index:
-                info = self._rpm_index[filename]
+            info = rpm_index.get(filename)
+            if info is not None:
                 path = info['path']
 
                 # Apply version/arch filter
@@ -434,7 +447,8 @@ class UrpmDaemon:
                         "Dropping stale index entry: %s (path %s no longer on disk)",
                         filename, path,
                     )
-                    self._rpm_index.pop(filename, None)
+                    with self._rpm_index_lock:
+                        rpm_index.pop(filename, None)
                     missing.append(filename)
                     continue
 
@@ -453,9 +467,25 @@ class UrpmDaemon:
             'missing_count': len(missing),
         }
 
-    def _build_rpm_index(self):
+    def _get_rpm_index(self) -> Dict[str, Dict]:
+        """The published RPM index, built first if there is none."""
+        with self._rpm_index_lock:
+            if self._rpm_index is not None:
+                return self._rpm_index
+            generation = self._rpm_index_generation
+
+        # Walking the cache is slow: not under the lock
+        rpm_index = self._build_rpm_index()
+        with self._rpm_index_lock:
+            if self._rpm_index is not None:
+                return self._rpm_index
+            if self._rpm_index_generation == generation:
+                self._rpm_index = rpm_index
+        return rpm_index
+
+    def _build_rpm_index(self) -> Dict[str, Dict]:
         """Build index of all RPM files in medias directory and file:// servers."""
-        self._rpm_index = {}
+        rpm_index: Dict[str, Dict] = {}
         medias_dir = self.base_dir / "medias"
 
         # Index files from cache directory
@@ -467,7 +497,7 @@ class UrpmDaemon:
                         size = rpm_path.stat().st_size
                         # Path relative to medias/ for URL construction
                         rel_path = str(rpm_path.relative_to(medias_dir))
-                        self._rpm_index[filename] = {
+                        rpm_index[filename] = {
                             'size': size,
                             'path': rel_path,
                         }
@@ -501,9 +531,9 @@ class UrpmDaemon:
                                 try:
                                     filename = rpm_path.name
                                     # Don't overwrite if already indexed from cache
-                                    if filename not in self._rpm_index:
+                                    if filename not in rpm_index:
                                         size = rpm_path.stat().st_size
-                                        self._rpm_index[filename] = {
+                                        rpm_index[filename] = {
                                             'size': size,
                                             'path': f"{url_path_prefix}/{filename}",
                                         }
@@ -512,9 +542,41 @@ class UrpmDaemon:
             except Exception:
                 pass  # Ignore database errors, use cache only
 
+        return rpm_index
+
+    def get_cache_digest(self) -> CacheDigest:
+        """Return the Bloom filter digest of the RPMs this daemon serves.
+
+        Built from the same index as :meth:`check_have_packages` and
+        rebuilt with it.  Filenames dropped from the index as stale stay
+        in the digest until then, which only costs a false positive.  A
+        digest is only kept if no invalidation came in while it was
+        built, so it never misses a file indexed since; the build is
+        retried up to RPM_DIGEST_ATTEMPTS times for a current one.
+        """
+        for _ in range(RPM_DIGEST_ATTEMPTS):
+            with self._rpm_index_lock:
+                if self._rpm_digest is not None:
+                    return self._rpm_digest
+                generation = self._rpm_index_generation
+
+            rpm_index = self._get_rpm_index()
+            with self._rpm_index_lock:
+                names = list(rpm_index)
+            digest = CacheDigest.build(names)
+
+            with self._rpm_index_lock:
+                if self._rpm_index_generation == generation:
+                    self._rpm_digest = digest
+                    return digest
+        return digest
+
     def invalidate_rpm_index(self):
         """Invalidate the RPM index so it will be rebuilt on next check."""
-        self._rpm_index = None
+        with self._rpm_index_lock:
+            self._rpm_index = None
+            self._rpm_digest = None
+            self._rpm_index_generation += 1
 
 
 class ColoredFormatter(logging.Formatter):
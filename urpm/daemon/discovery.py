@@ -50,6 +50,7 @@ class Peer:
     local_version: str = ""  # Peer's local Mageia version
     local_arch: str = ""     # Peer's local architecture
     served_media: List[dict] = field(default_factory=list)  # [{version, arch, types}]
+    cache_digest: str = ""   # id of the peer's current /api/cache-digest
 
     def is_alive(self, timeout: int = PEER_TIMEOUT) -> bool:
         """Check if peer is still considered alive."""
@@ -76,6 +77,7 @@ class Peer:
             'local_version': self.local_version,
             'local_arch': self.local_arch,
             'served_media': self.served_media,
+            'cache_digest': self.cache_digest,
         }
 
 
@@ -184,7 +186,7 @@ class PeerDiscovery:
     def register_peer(self, host: str, port: int, media: List[str],
                        mirror_enabled: bool = False, local_version: str = "",
                        local_arch: str = "", served_media: List[dict] = None,
-                       instance_id: str = "") -> dict:
+                       instance_id: str = "", cache_digest: str = "") -> dict:
         """Register or update a peer (called when receiving HTTP announce).
 
         Peers are keyed by ``instance_id`` when available (one entry per
@@ -201,6 +203,7 @@ class PeerDiscovery:
             local_arch: Peer's architecture
             served_media: List of {version, arch, types} dicts
             instance_id: Ephemeral UUID of the peer daemon
+            cache_digest: id of the peer's cache digest (empty for old peers)
         """
         key = instance_id or f"{host}:{port}"
         served_media = served_media or []
@@ -217,6 +220,7 @@ class PeerDiscovery:
                 peer.local_version = local_version
                 peer.local_arch = local_arch
                 peer.served_media = served_media
+                peer.cache_digest = cache_digest
                 logger.debug(f"Updated peer: {host}:{port}")
             else:
                 # New peer
@@ -226,7 +230,8 @@ class PeerDiscovery:
                     mirror_enabled=mirror_enabled,
                     local_version=local_version,
                     local_arch=local_arch,
-                    served_media=served_media
+                    served_media=served_media,
+                    cache_digest=cache_digest,
                 )
                 self.peers[key] = peer
                 served_info = f", serves {len(served_media)} version(s)" if served_media else ""
@@ -488,6 +493,12 @@ class PeerDiscovery:
                         'types': types
                     })
 
+            # Lets peers skip fetching our digest while theirs is current
+            try:
+                cache_digest = self.daemon.get_cache_digest().id
+            except OSError:
+                cache_digest = ""
+
             payload = json.dumps({
                 'host': self._get_local_ip(),
                 'port': self.daemon.port,
@@ -497,6 +508,7 @@ class PeerDiscovery:
                 'local_version': local_version,
                 'local_arch': local_arch,
                 'served_media': served_media,
+                'cache_digest': cache_digest,
             }).encode('utf-8')
 
             req = Request(url, data=payload, method='POST')
@@ -226,6 +226,7 @@ class Scheduler:
                         self._run_metadata_check()
 
                     self._check_tasks()
+                    self._flush_cache_access()
                 except Exception as e:
                     logger.error(f"Scheduler error: {e}")
 
@@ -237,10 +238,25 @@ class Scheduler:
         finally:
             # Close our database connection
             if self.db:
+                self._flush_cache_access()
                 self.db.close()
                 self.db = None
                 logger.debug("Scheduler closed database connection")
 
+    def _flush_cache_access(self):
+        """Write the cache access stamps buffered by the HTTP handlers.
+
+        They stamp the daemon's database handle without flushing, so
+        they never open a connection; this thread writes them on its
+        own, once per tick.
+        """
+        daemon_db = self.daemon.db
+        if daemon_db is None or self.db is None:
+            return
+        written = self.db.flush_cache_file_access(daemon_db.take_cache_file_access())
+        if written:
+            logger.debug(f"Wrote {written} cache access stamps")
+
     def _check_tasks(self):
         """Check if any scheduled tasks should run."""
         now = time.time()
@@ -557,16 +573,19 @@ class Scheduler:
 
             if total_size > self.max_predownload_size:
                 logger.info(f"Updates too large to pre-download: {total_size / 1024 / 1024:.1f} MB")
+                self._save_prepared_upgrade(updates, [])
                 return
 
             # Check if system is idle enough for background downloads
             if not self._is_system_idle():
                 logger.debug("Skipping pre-download: system not idle")
+                self._save_prepared_upgrade(updates, [])
                 return
 
             # Pre-download packages
             logger.info(f"Pre-downloading {len(update_list)} packages ({total_size / 1024 / 1024:.1f} MB)")
-            self._predownload_packages(update_list)
+            verified = self._predownload_packages(update_list)
+            self._save_prepared_upgrade(updates, verified)
 
             # Run cache cleanup after predownload completes
             self._run_cache_cleanup()
@@ -574,16 +593,20 @@ class Scheduler:
         except Exception as e:
             logger.error(f"Pre-download error: {e}")
 
-    def _predownload_packages(self, updates: list):
+    def _predownload_packages(self, updates: list) -> list:
         """Download packages for updates.
 
         Args:
             updates: List of update dicts with name, available version, arch, media_name, etc.
+
+        Returns:
+            Paths of the downloaded (or cached) RPMs that passed the
+            signature pre-check
         """
         from ..core.download import Downloader, DownloadItem
 
         if not self.db:
-            return
+            return []
 
         downloader = Downloader(cache_dir=self.base_dir, db=self.db)
 
@@ -641,6 +664,7 @@ class Scheduler:
                     size=update.get('size', 0),
                 ))
 
+        valid = []
         if items:
             # Download with progress logging (rate-limited)
             # Callback signature: (name, pkg_num, pkg_total, bytes_done, bytes_total,
@@ -687,6 +711,27 @@ class Scheduler:
             if downloaded > 0:
                 self.daemon.invalidate_rpm_index()
 
+        return valid
+
+    def _save_prepared_upgrade(self, updates: dict, verified: list):
+        """Persist the resolved upgrade for the D-Bus UpgradePackages path.
+
+        The RPMs are only recorded when every upgrade of the transaction
+        was pre-downloaded and verified; otherwise just the resolution is.
+        """
+        from ..core import prepared_upgrade
+        from ..core.resolver import TransactionType
+
+        resolution = updates.get('resolution')
+        if resolution is None or not resolution.success:
+            return
+        upgrades = [a for a in resolution.actions
+                    if a.action != TransactionType.REMOVE]
+        if len(verified) != len(upgrades):
+            verified = []
+        prepared_upgrade.save(self.db, updates['state_key'],
+                              resolution.actions, verified)
+
     def _run_cache_cleanup(self):
         """Clean up cached packages based on quotas and retention policies."""
         logger.info("Running scheduled cache cleanup")
@@ -917,11 +962,11 @@ class Scheduler:
         quota_mb = media.get('quota_mb')
         available_bytes = None
         if quota_mb:
-            # Use actual disk usage (more reliable than DB stats)
+            # Indexed usage; reconcile at startup and before each cache
+            # cleanup keeps it in step with the disk
             from ..core.cache import CacheManager
             cache_mgr = CacheManager(self.db, self.base_dir)
-            disk_stats = cache_mgr.get_disk_usage(media_id=media_id)
-            current_bytes = disk_stats.get('total_size', 0)
+            current_bytes = cache_mgr.get_media_usage(media_id)
             quota_bytes = quota_mb * 1024 * 1024
             available_bytes = quota_bytes - current_bytes
 
@@ -1253,7 +1298,9 @@ class Scheduler:
         Uses own database connection.
 
         Returns:
-            Dict with 'updates' list and 'total_size', or None on error
+            Dict with 'updates' list and 'total_size', plus the resolver
+            'resolution' and the prepared-upgrade 'state_key' it was
+            computed under, or None on error
         """
         if not self.db:
             return None
@@ -1261,8 +1308,13 @@ class Scheduler:
         import platform
         from ..core.resolver import Resolver
 
+        from ..core.prepared_upgrade import state_key
+
         try:
             arch = platform.machine()
+            # Taken before resolving, so a change during the solve makes
+            # the prepared upgrade stale rather than subtly wrong
+            key = state_key(self.db, arch)
             resolver = Resolver(self.db, arch=arch)
             result = resolver.resolve_upgrade([])
 
@@ -1283,6 +1335,8 @@ class Scheduler:
                 'count': len(updates),
                 'updates': updates,
                 'total_size': total_size,
+                'resolution': result,
+                'state_key': key,
             }
         except Exception as e:
             logger.error(f"Error checking updates: {e}")
@@ -8,7 +8,7 @@ import sys
 import threading
 from http.server import HTTPServer, BaseHTTPRequestHandler, ThreadingHTTPServer
 from pathlib import Path
-from typing import Optional, Dict, Any, List
+from typing import Optional, Dict, Any, List, Tuple
 from urllib.parse import urlparse, parse_qs, unquote
 
 from .. import __version__
@@ -25,9 +25,58 @@ DEFAULT_PORT = 9876
 DEFAULT_HOST = "0.0.0.0"  # All interfaces for P2P (firewall controls access)
 
 
+def parse_byte_range(header: str, size: int) -> Optional[Tuple[int, int]]:
+    """Parse a single-range ``Range: bytes=...`` header.
+
+    Peers split large package downloads into ranges fetched from
+    several hosts at once, so only the one-range forms are needed.
+
+    Args:
+        header: Value of the Range header
+        size: Size of the file being served
+
+    Returns:
+        Inclusive ``(start, end)`` offsets, or None when the header
+        should be ignored and the whole file served (unknown unit,
+        several ranges, malformed).
+
+    Raises:
+        ValueError: The range lies entirely past the end of the file.
+    """
+    unit, _, spec = header.strip().partition('=')
+    if unit.strip().lower() != 'bytes' or ',' in spec:
+        return None
+    first, sep, last = spec.strip().partition('-')
+    first, last = first.strip(), last.strip()
+    if (not sep or not (first or last)
+            or (first and not first.isdigit())
+            or (last and not last.isdigit())):
+        return None
+    if not first:
+        # Suffix form: the last N bytes
+        length = int(last)
+        if length == 0 or size == 0:
+            raise ValueError("empty suffix range")
+        return max(0, size - length), size - 1
+    start = int(first)
+    end = int(last) if last else size - 1
+    if start >= size:
+        raise ValueError(f"range starts past end of file ({size} bytes)")
+    if end < start:
+        return None
+    return start, min(end, size - 1)
+
+
 class UrpmdHandler(BaseHTTPRequestHandler):
     """HTTP request handler for urpmd."""
 
+    # Keep-alive lets peers fetch many packages over one connection;
+    # every response carries a Content-Length.  Idle connections are
+    # dropped after ``timeout`` seconds.
+    protocol_version = 'HTTP/1.1'
+    disable_nagle_algorithm = True
+    timeout = 30
+
     # Reference to the daemon instance (set by UrpmdServer)
     daemon = None
 
@@ -69,6 +118,8 @@ class UrpmdHandler(BaseHTTPRequestHandler):
             self.handle_updates()
         elif path == '/api/peers':
             self.handle_peers()
+        elif path == '/api/cache-digest':
+            self.handle_cache_digest(query)
         elif path.startswith('/media'):
             # File serving endpoint
             self.handle_media_files(path)
@@ -112,7 +163,7 @@ class UrpmdHandler(BaseHTTPRequestHandler):
             'endpoints': {
                 'api': ['/api/ping', '/api/status', '/api/media', '/api/available',
                         '/api/updates', '/api/refresh', '/api/peers', '/api/announce',
-                        '/api/have'],
+                        '/api/have', '/api/cache-digest'],
                 'files': ['/media/'],
             }
         })
@@ -247,6 +298,12 @@ class UrpmdHandler(BaseHTTPRequestHandler):
         if target_path.is_dir():
             self._send_directory_listing(target_path, level1, level2, subpath)
         else:
+            if target_path.suffix == '.rpm' and self.daemon.db:
+                # Served to a peer: keeps the file warm for LRU eviction.
+                # Only buffered: this handler thread is short-lived, the
+                # scheduler writes the stamps on its own connection.
+                self.daemon.db.update_cache_file_access(target_path.name,
+                                                        flush=False)
             self._send_file(target_path)
 
     def _find_in_file_server(self, version: str, subpath: str) -> Optional[Path]:
@@ -394,25 +451,50 @@ class UrpmdHandler(BaseHTTPRequestHandler):
         if content_type is None:
             content_type = 'application/octet-stream'
 
+        # A single byte range lets clients split big packages across peers
+        start, end = 0, file_size - 1
+        byte_range = None
+        range_header = self.headers.get('Range')
+        if range_header:
+            try:
+                byte_range = parse_byte_range(range_header, file_size)
+            except ValueError:
+                self.send_response(416)
+                self.send_header('Content-Range', f'bytes */{file_size}')
+                self.send_header('Content-Length', 0)
+                self.end_headers()
+                return
+            if byte_range:
+                start, end = byte_range
+
         # Send headers
-        self.send_response(200)
+        self.send_response(206 if byte_range else 200)
         self.send_header('Content-Type', content_type)
-        self.send_header('Content-Length', file_size)
+        self.send_header('Content-Length', end - start + 1)
+        self.send_header('Accept-Ranges', 'bytes')
+        if byte_range:
+            self.send_header('Content-Range', f'bytes {start}-{end}/{file_size}')
         self.send_header('Content-Disposition', f'inline; filename="{file_path.name}"')
         self.end_headers()
 
         # Send file content
+        remaining = end - start + 1
         try:
             with open(file_path, 'rb') as f:
+                f.seek(start)
                 # Send in chunks for large files
                 chunk_size = 64 * 1024  # 64 KB
-                while True:
-                    chunk = f.read(chunk_size)
+                while remaining > 0:
+                    chunk = f.read(min(chunk_size, remaining))
                     if not chunk:
                         break
                     self.wfile.write(chunk)
+                    remaining -= len(chunk)
         except (OSError, BrokenPipeError) as e:
             logger.warning(f"Error sending file {file_path}: {e}")
+        if remaining:
+            # Short body: the connection cannot carry another response
+            self.close_connection = True
 
     def handle_available(self, query: Dict[str, list]):
         """Check package availability (GET with query params)."""
@@ -499,6 +581,7 @@ class UrpmdHandler(BaseHTTPRequestHandler):
         local_arch = data.get('local_arch', '')
         served_media = data.get('served_media', [])
         instance_id = data.get('instance_id', '')
+        cache_digest = data.get('cache_digest', '')
 
         if not host or not port:
             self.send_error_json(400, "Missing 'host' or 'port' in request")
@@ -512,9 +595,31 @@ class UrpmdHandler(BaseHTTPRequestHandler):
             local_arch=local_arch,
             served_media=served_media,
             instance_id=instance_id,
+            cache_digest=cache_digest,
         )
         self.send_json(result)
 
+    def handle_cache_digest(self, query: Dict[str, list]):
+        """Bloom filter of the RPM filenames served by this daemon.
+
+        Query parameters:
+            since: id of the digest the client already has; if it is
+                still current the reply is just {"id": ..., "unchanged": true}
+
+        See urpm.core.cache_digest for the format.  Clients test their
+        download list against it and only send /api/have for the hits.
+        """
+        if not self.daemon:
+            self.send_error_json(500, "Daemon not initialized")
+            return
+
+        digest = self.daemon.get_cache_digest()
+        since = query.get('since', [None])[0]
+        if since and since == digest.id:
+            self.send_json({'id': digest.id, 'unchanged': True})
+            return
+        self.send_json(digest.to_dict())
+
     def handle_have(self, data: Dict[str, Any]):
         """Check which packages are available in local cache.
 
@@ -0,0 +1,194 @@
+"""
+Per-method metrics of the D-Bus service
+
+Every method call is timed from the moment the main loop dispatches it
+until its reply has been handed back to GDBus, and that time is split
+into phases so a slow Discover can be pinned on the right layer:
+
+    queue      waiting for a read worker
+    auth       caller credentials and PolicyKit
+    db         handler work outside the other phases (SQL, file scans)
+    resolve    libsolv pool loading and solving
+    serialize  JSON encoding and typed reply construction
+    reply      handing the reply back to the main loop and GDBus
+    other      dispatch of write methods (the operation itself runs on
+               its own thread and reports through OperationComplete)
+
+Handlers mark a phase with ``with metrics.phase('resolve'): ...``; time
+not covered by a nested phase goes to the phase the call was in.  The
+totals are kept as cumulative histograms (Prometheus style buckets) per
+method and per phase, exposed through the GetMetrics method.
+"""
+
+import threading
+import time
+from contextlib import contextmanager
+from typing import Dict, Optional
+
+# Upper bounds of the latency buckets, in milliseconds
+LATENCY_BUCKETS_MS = (1, 2, 5, 10, 25, 50, 100, 250, 500,
+                      1000, 2500, 5000, 10000, 30000)
+
+PHASES = ('queue', 'auth', 'db', 'resolve', 'serialize', 'reply', 'other')
+
+
+class Histogram:
+    """Latency histogram with fixed bucket bounds."""
+
+    __slots__ = ('counts', 'count', 'sum_ms')
+
+    def __init__(self):
+        self.counts = [0] * (len(LATENCY_BUCKETS_MS) + 1)
+        self.count = 0
+        self.sum_ms = 0.0
+
+    def observe(self, ms: float):
+        for i, bound in enumerate(LATENCY_BUCKETS_MS):
+            if ms <= bound:
+                break
+        else:
+            i = len(LATENCY_BUCKETS_MS)
+        self.counts[i] += 1
+        self.count += 1
+        self.sum_ms += ms
+
+    def snapshot(self) -> Dict:
+        """Return ``{'count', 'sum_ms', 'buckets': {le: cumulative}}``."""
+        buckets = {}
+        total = 0
+        for bound, n in zip(LATENCY_BUCKETS_MS, self.counts):
+            total += n
+            buckets[str(bound)] = total
+        buckets['+Inf'] = self.count
+        return {'count': self.count, 'sum_ms': round(self.sum_ms, 3),
+                'buckets': buckets}
+
+
+class MethodCall:
+    """Timing state of one method call.
+
+    A call is only ever touched by one thread at a time (main loop, then
+    a read worker, then the main loop again), so it needs no lock.
+    """
+
+    __slots__ = ('method', 'start', 'phase', '_phase_start', 'phases')
+
+    def __init__(self, method: str, phase: str):
+        self.method = method
+        self.start = self._phase_start = time.monotonic()
+        self.phase = phase
+        self.phases: Dict[str, float] = {}
+
+    def switch(self, phase: str) -> str:
+        """Charge elapsed time to the current phase, enter ``phase``.
+
+        Returns the phase that was left.
+        """
+        now = time.monotonic()
+        self.phases[self.phase] = (self.phases.get(self.phase, 0.0)
+                                   + now - self._phase_start)
+        left, self.phase, self._phase_start = self.phase, phase, now
+        return left
+
+
+class _MethodStats:
+    __slots__ = ('calls', 'errors', 'in_flight', 'latency', 'phases')
+
+    def __init__(self):
+        self.calls = 0
+        self.errors = 0
+        self.in_flight = 0
+        self.latency = Histogram()
+        self.phases: Dict[str, Histogram] = {}
+
+
+class ServiceMetrics:
+    """Thread-safe registry of per-method call metrics."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._local = threading.local()
+        self._methods: Dict[str, _MethodStats] = {}
+        self._started = time.monotonic()
+
+    def begin(self, method: str, phase: str = 'other') -> MethodCall:
+        """Start timing a call that was just dispatched."""
+        with self._lock:
+            stats = self._methods.get(method)
+            if stats is None:
+                stats = self._methods[method] = _MethodStats()
+            stats.in_flight += 1
+        return MethodCall(method, phase)
+
+    def finish(self, call: Optional[MethodCall], error: bool = False):
+        """Record a call whose reply has been sent."""
+        if call is None:
+            return
+        call.switch(call.phase)
+        total_ms = (time.monotonic() - call.start) * 1000
+        with self._lock:
+            stats = self._methods[call.method]
+            stats.in_flight -= 1
+            stats.calls += 1
+            if error:
+                stats.errors += 1
+            stats.latency.observe(total_ms)
+            for name, seconds in call.phases.items():
+                histogram = stats.phases.get(name)
+                if histogram is None:
+                    histogram = stats.phases[name] = Histogram()
+                histogram.observe(seconds * 1000)
+
+    def bind(self, call: Optional[MethodCall], phase: Optional[str] = None):
+        """Make ``call`` the current thread's call, optionally entering a phase."""
+        self._local.call = call
+        if call is not None and phase is not None:
+            call.switch(phase)
+
+    def unbind(self, phase: Optional[str] = None):
+        """Detach the current thread's call, optionally entering a phase."""
+        call = getattr(self._local, 'call', None)
+        self._local.call = None
+        if call is not None and phase is not None:
+            call.switch(phase)
+
+    @contextmanager
+    def phase(self, name: str):
+        """Charge the enclosed block to phase ``name`` of the current call.
+
+        A no-op outside a method call (e.g. on an operation thread).
+        """
+        call = getattr(self._local, 'call', None)
+        if call is None:
+            yield
+            return
+        outer = call.switch(name)
+        try:
+            yield
+        finally:
+            call.switch(outer)
+
+    def snapshot(self) -> Dict:
+        """Return all counters as a JSON-serializable dict."""
+        with self._lock:
+            methods = {}
+            in_flight = 0
+            for name in sorted(self._methods):
+                stats = self._methods[name]
+                in_flight += stats.in_flight
+                methods[name] = {
+                    'calls': stats.calls,
+                    'errors': stats.errors,
+                    'in_flight': stats.in_flight,
+                    'latency_ms': stats.latency.snapshot(),
+                    'phases_ms': {
+                        phase: stats.phases[phase].snapshot()
+                        for phase in PHASES if phase in stats.phases
+                    },
+                }
+        return {
+            'uptime_s': round(time.monotonic() - self._started, 3),
+            'bucket_bounds_ms': list(LATENCY_BUCKETS_MS),
+            'in_flight': in_flight,
+            'methods': methods,
+        }
@@ -0,0 +1,132 @@
+"""
+Coalescing of operation progress for the D-Bus service
+
+Download and transaction callbacks fire far more often than a progress
+bar can use: a large upgrade reports every chunk of every parallel
+download.  Sending one signal per callback floods the bus and makes the
+PackageKit side redraw for nothing.  :class:`ProgressCoalescer` keeps the
+latest update of each operation and hands it on at most ``rate_hz``
+times a second; a phase change goes out at once so clients never miss
+one, and :meth:`ProgressCoalescer.finish` flushes the last value before
+OperationComplete.
+
+Phases are sent as small integers on OperationProgressV2; the numbering
+is part of the interface and mirrors ``UrpmProgressPhase`` in
+pk-backend-urpm.c.
+"""
+
+import threading
+import time
+from dataclasses import dataclass
+from typing import Callable, Dict, Optional
+
+# Index in this tuple is the wire value; only append.
+PROGRESS_PHASES = (
+    'unknown',
+    'resolving',
+    'downloading',
+    'installing',
+    'removing',
+    'upgrading',
+    'refreshing',
+)
+
+# Maximum number of progress signals per operation and second
+PROGRESS_RATE_HZ = 10
+
+
+def phase_code(phase: str) -> int:
+    """Return the wire value of ``phase`` (0 for unknown phases)."""
+    try:
+        return PROGRESS_PHASES.index(phase)
+    except ValueError:
+        return 0
+
+
+@dataclass
+class ProgressUpdate:
+    """One progress report of an operation."""
+    phase: str
+    package: str = ""
+    current: int = 0
+    total: int = 0
+    bytes_done: int = 0
+    bytes_total: int = 0
+    speed: float = 0.0          # bytes per second, 0 when unknown
+    message: str = ""
+
+
+class _OpState:
+    __slots__ = ('phase', 'last_sent', 'pending', 'armed')
+
+    def __init__(self):
+        self.phase: Optional[str] = None
+        self.last_sent = 0.0
+        self.pending: Optional[ProgressUpdate] = None
+        self.armed = False
+
+
+class ProgressCoalescer:
+    """Rate-limit progress updates per operation, latest value wins.
+
+    Args:
+        emit: Called as ``emit(op_id, update)`` for every update let through.
+        rate_hz: Maximum updates per second and operation.
+        schedule: Called as ``schedule(delay_s, callback)`` to run a
+            deferred flush (the service uses GLib.timeout_add).
+        clock: Monotonic time source (tests).
+    """
+
+    def __init__(self, emit: Callable[[str, ProgressUpdate], None],
+                 rate_hz: float = PROGRESS_RATE_HZ,
+                 schedule: Optional[Callable[[float, Callable[[], None]], None]] = None,
+                 clock: Callable[[], float] = time.monotonic):
+        self._emit = emit
+        self._interval = 1.0 / rate_hz if rate_hz > 0 else 0.0
+        self._schedule = schedule
+        self._clock = clock
+        self._lock = threading.Lock()
+        self._ops: Dict[str, _OpState] = {}
+
+    def update(self, op_id: str, upd: ProgressUpdate):
+        """Report progress; sent now, later or superseded by a newer one."""
+        with self._lock:
+            state = self._ops.get(op_id)
+            if state is None:
+                state = self._ops[op_id] = _OpState()
+            now = self._clock()
+            due = state.last_sent + self._interval
+            if upd.phase != state.phase or now >= due:
+                state.phase = upd.phase
+                state.last_sent = now
+                state.pending = None
+                send = upd
+            else:
+                state.pending = upd
+                send = None
+                if not state.armed and self._schedule is not None:
+                    state.armed = True
+                    delay = due - now
+                    self._schedule(delay, lambda: self._flush(op_id))
+        if send is not None:
+            self._emit(op_id, send)
+
+    def _flush(self, op_id: str):
+        with self._lock:
+            state = self._ops.get(op_id)
+            if state is None:
+                return
+            state.armed = False
+            send, state.pending = state.pending, None
+            if send is not None:
+                state.last_sent = self._clock()
+        if send is not None:
+            self._emit(op_id, send)
+
+    def finish(self, op_id: str):
+        """Send the operation's pending update, if any, and forget it."""
+        with self._lock:
+            state = self._ops.pop(op_id, None)
+            send = state.pending if state is not None else None
+        if send is not None:
+            self._emit(op_id, send)
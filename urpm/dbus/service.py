@@ -8,24 +8,33 @@ Authorization is handled via PolicyKit for all privileged operations.
 Read-only operations (search, info, list updates) require no auth.
 
 Write operations (install, remove, upgrade, refresh) run in a background
-thread and emit OperationProgress/OperationComplete D-Bus signals.
+thread and emit OperationProgress(V2)/OperationComplete D-Bus signals.
 
 Usage:
     urpm-dbus-service          # Run as D-Bus activated service
     urpm-dbus-service --debug  # Run with debug logging
 """
 
+import argparse
+import hashlib
+import itertools
 import json
 import logging
 import os
 import platform
 import signal
-import sys
 import threading
+import time
 import uuid
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Optional
 
+from ..core import cache_stats
+from .metrics import ServiceMetrics
+from .progress import ProgressCoalescer, ProgressUpdate, phase_code
+
 logger = logging.getLogger(__name__)
 
 # D-Bus names
@@ -33,6 +42,242 @@ BUS_NAME = "org.mageia.Urpm.v1"
 OBJECT_PATH = "/org/mageia/Urpm/v1"
 INTERFACE_NAME = "org.mageia.Urpm.v1"
 
+# Read-only methods run on a worker pool so a slow query (file search,
+# full upgrade resolution) does not stall every other client on the bus.
+READ_METHODS = frozenset({
+    "SearchPackages",
+    "GetPackageInfo",
+    "GetPackagesInfo",
+    "ResolvePackages",
+    "SearchFiles",
+    "SearchFilesAny",
+    "GetPackageFiles",
+    "GetPackagesFiles",
+    "GetInstalledPackages",
+    "GetInstalledPackagesPaged",
+    "SearchPackagesV2",
+    "SearchPackagesPrefix",
+    "SearchPackagesPrefixV2",
+    "GetInstalledPackagesV2",
+    "GetInstalledPackagesPagedV2",
+    "ListPackages",
+    "ListPackagesV2",
+    "WhatRequires",
+    "WhatRequiresAny",
+    "WhatProvides",
+    "GetUpdates",
+    "GetUpdateDetails",
+    "GetDataGeneration",
+    "PreviewInstall",
+})
+READ_WORKERS = 4
+
+# Typed (v2) package record: name, version, release, arch, summary,
+# installed.  The *V2 methods return arrays of these instead of a JSON
+# string so clients can walk them without a parse step.
+PACKAGE_RECORD = '(sssssb)'
+
+
+def package_record(pkg: dict) -> tuple:
+    """Convert a package dict to a PACKAGE_RECORD tuple."""
+    return (
+        pkg.get('name') or '',
+        pkg.get('version') or '',
+        pkg.get('release') or '',
+        pkg.get('arch') or '',
+        pkg.get('summary') or '',
+        bool(pkg.get('installed', False)),
+    )
+
+
+# Paged listings: upper bound on one page and how long an unfinished
+# listing keeps its snapshot around
+MAX_PAGE_SIZE = 1000
+PAGE_SNAPSHOT_TTL = 120
+MAX_PAGE_SNAPSHOTS = 8
+
+
+class ResultPager:
+    """Serve a large result list in bounded pages.
+
+    The first call (empty cursor) takes a snapshot of the full list and
+    returns its first page; each page carries an opaque cursor for the next
+    one, so a client walks a consistent listing even if the underlying data
+    changes meanwhile. Snapshots are dropped once their last page has been
+    served, after PAGE_SNAPSHOT_TTL seconds, or when more than
+    MAX_PAGE_SNAPSHOTS listings are open at once (oldest first).
+    """
+
+    def __init__(self, ttl: float = PAGE_SNAPSHOT_TTL,
+                 max_snapshots: int = MAX_PAGE_SNAPSHOTS):
+        self._ttl = ttl
+        self._max_snapshots = max_snapshots
+        self._snapshots = {}  # token -> (created, items)
+        self._lock = threading.Lock()
+
+    def page(self, cursor: str, limit: int, produce) -> dict:
+        """Return one page as {'items', 'cursor', 'offset', 'total'}.
+
+        Args:
+            cursor: '' to start a new listing, else a cursor from a
+                previous page
+            limit: Page size, clamped to 1..MAX_PAGE_SIZE
+            produce: Callable returning the full list (only called for a
+                new listing)
+
+        Raises:
+            ValueError: Unknown, expired or malformed cursor
+        """
+        limit = max(1, min(int(limit) or MAX_PAGE_SIZE, MAX_PAGE_SIZE))
+        now = time.monotonic()
+
+        if not cursor:
+            items = list(produce())
+            token = uuid.uuid4().hex
+            offset = 0
+            with self._lock:
+                self._expire(now)
+                self._snapshots[token] = (now, items)
+                while len(self._snapshots) > self._max_snapshots:
+                    oldest = min(self._snapshots,
+                                 key=lambda t: self._snapshots[t][0])
+                    del self._snapshots[oldest]
+        else:
+            token, _, offset_str = cursor.partition(':')
+            try:
+                offset = int(offset_str)
+            except ValueError:
+                raise ValueError(f"Malformed cursor: {cursor}")
+            with self._lock:
+                self._expire(now)
+                entry = self._snapshots.get(token)
+            cache_stats.record('page_snapshot', entry is not None)
+            if entry is None or offset < 0:
+                raise ValueError(f"Unknown or expired cursor: {cursor}")
+            items = entry[1]
+
+        chunk = items[offset:offset + limit]
+        next_offset = offset + len(chunk)
+        if next_offset < len(items):
+            next_cursor = f"{token}:{next_offset}"
+        else:
+            next_cursor = ''
+            with self._lock:
+                self._snapshots.pop(token, None)
+
+        return {
+            'items': chunk,
+            'cursor': next_cursor,
+            'offset': offset,
+            'total': len(items),
+        }
+
+    def _expire(self, now: float):
+        """Drop snapshots older than the TTL (lock held by caller)."""
+        stale = [t for t, (created, _) in self._snapshots.items()
+                 if now - created > self._ttl]
+        for token in stale:
+            del self._snapshots[token]
+
+
+# Search-as-you-type: default and largest result count, and how many
+# recent queries are answered from memory (and for how long at most)
+DEFAULT_SEARCH_LIMIT = 50
+MAX_SEARCH_LIMIT = 500
+SEARCH_CACHE_SIZE = 64
+SEARCH_CACHE_TTL = 300
+
+# Bus connections whose uid is remembered for search sessions
+SENDER_UID_CACHE_SIZE = 256
+
+# D-Bus error returned to a search replaced by a newer one
+SUPERSEDED_ERROR = 'org.mageia.Urpm.v1.Error.Superseded'
+
+
+class SearchSuperseded(Exception):
+    """A newer search of the same session replaced this one."""
+
+
+class IncrementalSearch:
+    """Supersession and result cache for SearchPackagesPrefix.
+
+    A search box sends one query per keystroke and only the newest one
+    matters.  Each call gets a ticket from :meth:`begin` as it arrives;
+    once a newer call of the same session has begun, the older one
+    stops, still queued or mid-query (through the database's progress
+    handler), and fails with SearchSuperseded.
+
+    The results of the last SEARCH_CACHE_SIZE queries are kept, keyed
+    by the database's search generation, so backspacing and retyping a
+    pattern are answered without a query.
+    """
+
+    def __init__(self, size: int = SEARCH_CACHE_SIZE,
+                 ttl: float = SEARCH_CACHE_TTL):
+        self._size = size
+        self._ttl = ttl
+        self._cache = OrderedDict()   # key -> (created, results)
+        self._latest = {}             # session -> newest ticket
+        self._tickets = itertools.count(1)
+        self._lock = threading.Lock()
+
+    def begin(self, session: str) -> int:
+        """Register a new query of ``session``, superseding older ones."""
+        with self._lock:
+            ticket = next(self._tickets)
+            self._latest[session] = ticket
+        return ticket
+
+    def superseded(self, session: str, ticket: int) -> bool:
+        """True once a newer query of ``session`` has begun."""
+        return self._latest.get(session) != ticket
+
+    def search(self, session: str, ticket: int, generation, pattern: str,
+               search_provides: bool, limit: int, produce) -> list:
+        """Answer one query from the cache or with ``produce``.
+
+        Args:
+            session, ticket: As passed to and returned by :meth:`begin`
+            generation: Database search generation; cached results of
+                another generation are not used
+            pattern, search_provides, limit: The query
+            produce: Callable taking an ``interrupted()`` predicate and
+                returning the results, or None if it was interrupted
+
+        Raises:
+            SearchSuperseded: A newer query of the session has begun
+        """
+        try:
+            if self.superseded(session, ticket):
+                raise SearchSuperseded()
+
+            key = (generation, pattern.strip().lower(),
+                   bool(search_provides), limit)
+            now = time.monotonic()
+            with self._lock:
+                entry = self._cache.get(key)
+                if entry is not None and now - entry[0] <= self._ttl:
+                    self._cache.move_to_end(key)
+                else:
+                    entry = None
+            cache_stats.record('search_results', entry is not None)
+            if entry is not None:
+                return entry[1]
+
+            results = produce(lambda: self.superseded(session, ticket))
+            if results is None:
+                raise SearchSuperseded()
+            with self._lock:
+                self._cache[key] = (now, results)
+                self._cache.move_to_end(key)
+                while len(self._cache) > self._size:
+                    self._cache.popitem(last=False)
+            return results
+        finally:
+            with self._lock:
+                if self._latest.get(session) == ticket:
+                    del self._latest[session]
+
 
 class UrpmDBusService:
     """D-Bus service exposing urpm operations.
@@ -45,7 +290,8 @@ class UrpmDBusService:
     5. Returns result
     """
 
-    def __init__(self):
+    def __init__(self, db_path: str = None):
+        self._db_path = db_path
         self._ops = None
         self._db = None
         self._polkit = None
@@ -55,21 +301,43 @@ class UrpmDBusService:
         self._active_operations = {}
         self._cancel_requested = False
         self._lock = threading.Lock()
+        self._init_lock = threading.Lock()
+        self._pager = ResultPager()
+        self._search = IncrementalSearch()
+        self._sender_uids = OrderedDict()   # bus name -> uid
+        self._uid_waiters = {}              # bus name -> pending callbacks
+        self._metrics = ServiceMetrics()
+        self._progress = ProgressCoalescer(
+            self._send_progress, schedule=self._schedule_progress_flush
+        )
+        self._read_pool = ThreadPoolExecutor(
+            max_workers=READ_WORKERS, thread_name_prefix='urpm-read'
+        )
 
     def _init_core(self):
-        """Lazy-init core components."""
-        if self._db is not None:
+        """Lazy-init core components.
+
+        Read methods run on worker threads, so the first calls may race;
+        self._polkit is assigned last and gates the fast path.
+        """
+        if self._polkit is not None:
             return
 
-        from ..core.database import PackageDatabase
-        from ..core.operations import PackageOperations
-        from ..auth.polkit import PolicyKitBackend
-        from ..auth.audit import AuditLogger
+        with self._init_lock:
+            if self._polkit is not None:
+                return
+
+            from ..core.database import PackageDatabase
+            from ..core.operations import PackageOperations
+            from ..auth.polkit import PolicyKitBackend
+            from ..auth.audit import AuditLogger
 
-        self._db = PackageDatabase()
-        self._audit = AuditLogger()
-        self._ops = PackageOperations(self._db, audit_logger=self._audit)
-        self._polkit = PolicyKitBackend()
+            self._db = PackageDatabase(self._db_path)
+            # One read-only connection per read worker
+            self._db.enable_read_pool(READ_WORKERS)
+            self._audit = AuditLogger()
+            self._ops = PackageOperations(self._db, audit_logger=self._audit)
+            self._polkit = PolicyKitBackend()
 
     def _get_caller_credentials(self, bus, sender):
         """Get caller PID and UID from D-Bus sender."""
@@ -109,28 +377,42 @@ class UrpmDBusService:
 
     def _authorize(self, bus, sender, permission):
         """Authorize a caller for a permission. Returns AuthContext or None."""
-        pid, uid = self._get_caller_credentials(bus, sender)
-        if pid is None:
-            return None
+        with self._metrics.phase('auth'):
+            pid, uid = self._get_caller_credentials(bus, sender)
+            if pid is None:
+                return None
 
-        try:
-            context, denied = self._polkit.create_auth_context(
-                pid, uid, permission
-            )
-            if denied:
-                logger.info(f"Denied {denied} for pid={pid} uid={uid}")
+            try:
+                context, denied = self._polkit.create_auth_context(
+                    pid, uid, permission
+                )
+                if denied:
+                    logger.info(f"Denied {denied} for pid={pid} uid={uid}")
+                    return None
+                return context
+            except Exception as e:
+                logger.error(f"Authorization failed: {e}")
                 return None
-            return context
-        except Exception as e:
-            logger.error(f"Authorization failed: {e}")
-            return None
+
+    def _json(self, obj) -> str:
+        """json.dumps(), charged to the serialize phase of the current call."""
+        with self._metrics.phase('serialize'):
+            return json.dumps(obj)
 
     # =====================================================================
     # D-Bus signal emission
     # =====================================================================
 
-    def _emit_progress(self, op_id, phase, package, current, total, message=""):
-        """Emit OperationProgress signal on the main loop thread."""
+    def _emit_progress(self, op_id, phase, package, current, total, message="",
+                       bytes_done=0, bytes_total=0, speed=0.0):
+        """Report operation progress, coalesced to PROGRESS_RATE_HZ signals."""
+        self._progress.update(op_id, ProgressUpdate(
+            phase, package, current, total,
+            bytes_done, bytes_total, speed, message
+        ))
+
+    def _send_progress(self, op_id, upd):
+        """Emit OperationProgress and OperationProgressV2 on the main loop thread."""
         from gi.repository import GLib
 
         def _emit():
@@ -139,18 +421,43 @@ class UrpmDBusService:
                     None, OBJECT_PATH, INTERFACE_NAME,
                     "OperationProgress",
                     GLib.Variant('(sssuus)', (
-                        op_id, phase, package,
-                        current, total, message
+                        op_id, upd.phase, upd.package,
+                        upd.current, upd.total, upd.message
+                    ))
+                )
+                self._connection.emit_signal(
+                    None, OBJECT_PATH, INTERFACE_NAME,
+                    "OperationProgressV2",
+                    GLib.Variant('(susuuttts)', (
+                        op_id, phase_code(upd.phase), upd.package,
+                        upd.current, upd.total,
+                        max(0, int(upd.bytes_done)),
+                        max(0, int(upd.bytes_total)),
+                        max(0, int(upd.speed)),
+                        upd.message
                     ))
                 )
             return False  # Don't repeat
 
         GLib.idle_add(_emit)
 
+    def _schedule_progress_flush(self, delay, callback):
+        """Run a deferred progress flush on the main loop."""
+        from gi.repository import GLib
+
+        def _flush():
+            callback()
+            return False
+
+        GLib.timeout_add(max(1, int(delay * 1000)), _flush)
+
     def _emit_complete(self, op_id, success, message=""):
         """Emit OperationComplete signal on the main loop thread."""
         from gi.repository import GLib
 
+        # Last progress value first, so clients see it before completion
+        self._progress.finish(op_id)
+
         def _emit():
             if self._connection:
                 self._connection.emit_signal(
@@ -178,7 +485,7 @@ class UrpmDBusService:
         GLib.idle_add(_return)
 
     # =====================================================================
-    # Read-only handlers (synchronous)
+    # Read-only handlers (run on the read worker pool)
     # =====================================================================
 
     def handle_search_packages(self, bus, sender, pattern, search_provides):
@@ -188,11 +495,118 @@ class UrpmDBusService:
             pattern, search_provides=search_provides, limit=200
         )
 
+    def handle_search_packages_prefix(self, bus, sender, pattern,
+                                      search_provides, limit, scope, ticket):
+        """SearchPackagesPrefix(pattern: s, search_provides: b, limit: u,
+        session: s) -> s (JSON)
+
+        Search-as-you-type: ranked, indexed and cut at ``limit``
+        (0 = DEFAULT_SEARCH_LIMIT).  ``scope`` (see _search_session())
+        and ``ticket`` (from IncrementalSearch.begin()) are both taken
+        at dispatch.
+
+        Raises:
+            SearchSuperseded: A newer call of the same session came in
+        """
+        self._init_core()
+        limit = max(1, min(int(limit) or DEFAULT_SEARCH_LIMIT, MAX_SEARCH_LIMIT))
+        return self._search.search(
+            scope, ticket, self._db.search_generation(),
+            pattern, search_provides, limit,
+            lambda interrupted: self._ops.search_packages_prefix(
+                pattern, search_provides=search_provides, limit=limit,
+                interrupted=interrupted
+            )
+        )
+
+    @staticmethod
+    def _search_session(sender, session, uid):
+        """Supersession scope of a prefix search: the client's session
+        string, else its bus connection.
+
+        A session string only groups calls of the same uid, so a client
+        cannot supersede the searches of another user by sending theirs.
+        Without a uid (``None``: the bus could not tell) the call is
+        scoped to its connection.
+        """
+        if session and uid is not None:
+            return f"uid:{uid};session:{session}"
+        return f"sender:{sender}"
+
+    def _with_caller_uid(self, bus, sender, callback):
+        """Call ``callback(uid)`` on the main loop once the uid of
+        ``sender`` is known (None if the bus cannot tell).
+
+        Unique bus names are never reused, so the answer is kept for the
+        last SENDER_UID_CACHE_SIZE connections and a search box costs
+        one GetConnectionUnixUser round trip, not one per keystroke.
+        The round trip is asynchronous; calls of a sender whose lookup
+        is pending wait behind it, so callbacks keep arrival order.
+        """
+        with self._lock:
+            if sender in self._uid_waiters:
+                self._uid_waiters[sender].append(callback)
+                return
+            known = sender in self._sender_uids
+            if known:
+                self._sender_uids.move_to_end(sender)
+                uid = self._sender_uids[sender]
+            else:
+                self._uid_waiters[sender] = [callback]
+        if known:
+            callback(uid)
+            return
+
+        from gi.repository import Gio, GLib
+
+        def _on_reply(bus, result, *_user_data):
+            try:
+                uid = bus.call_finish(result).unpack()[0]
+            except Exception as e:
+                logger.error(f"Cannot get caller uid: {e}")
+                uid = None
+            self._caller_uid_known(sender, uid)
+
+        try:
+            bus.call(
+                'org.freedesktop.DBus',
+                '/org/freedesktop/DBus',
+                'org.freedesktop.DBus',
+                'GetConnectionUnixUser',
+                GLib.Variant('(s)', (sender,)),
+                GLib.VariantType.new('(u)'),
+                Gio.DBusCallFlags.NONE,
+                -1, None, _on_reply,
+            )
+        except Exception as e:
+            logger.error(f"Cannot get caller uid: {e}")
+            self._caller_uid_known(sender, None)
+
+    def _caller_uid_known(self, sender, uid):
+        """Remember the uid of ``sender`` and run its waiting callbacks."""
+        with self._lock:
+            if uid is not None:
+                self._sender_uids[sender] = uid
+                while len(self._sender_uids) > SENDER_UID_CACHE_SIZE:
+                    self._sender_uids.popitem(last=False)
+            waiters = self._uid_waiters.pop(sender, [])
+        for callback in waiters:
+            callback(uid)
+
     def handle_get_package_info(self, bus, sender, identifier):
         """GetPackageInfo(identifier: s) -> s (JSON)"""
         self._init_core()
         return self._ops.get_package_info(identifier)
 
+    def handle_get_packages_info(self, bus, sender, names):
+        """GetPackagesInfo(names: as) -> s (JSON)
+
+        Batched GetPackageInfo: details for every name in one query,
+        in input order; unknown names are omitted.
+        """
+        self._init_core()
+        return self._ops.get_packages_info(list(names))
+
     def handle_resolve_packages(self, bus, sender, names):
         """ResolvePackages(names: as) -> s (JSON)
 
@@ -204,7 +618,7 @@ class UrpmDBusService:
 
         # Use batch method for efficiency
         results = self._ops.resolve_packages(list(names))
-        return json.dumps(results)
+        return self._json(results)
 
     def handle_search_files(self, bus, sender, pattern):
         """SearchFiles(pattern: s) -> s (JSON)
@@ -215,7 +629,20 @@ class UrpmDBusService:
         import json
 
         results = self._ops.search_files(pattern, limit=100)
-        return json.dumps(results)
+        return self._json(results)
+
+    def handle_search_files_any(self, bus, sender, patterns):
+        """SearchFilesAny(patterns: as) -> s (JSON)
+
+        Batched SearchFiles: one scan for all patterns, one entry per
+        owning package.
+        """
+        self._init_core()
+
+        results = self._ops.search_files_any(
+            list(patterns), limit=100 * max(len(patterns), 1)
+        )
+        return self._json(results)
 
     def handle_get_package_files(self, bus, sender, nevra):
         """GetPackageFiles(nevra: s) -> s (JSON)
@@ -226,7 +653,18 @@ class UrpmDBusService:
         import json
 
         files = self._ops.get_package_files(nevra)
-        return json.dumps(files)
+        return self._json(files)
+
+    def handle_get_packages_files(self, bus, sender, nevras):
+        """GetPackagesFiles(nevras: as) -> s (JSON)
+
+        Batched GetPackageFiles: {nevra: [files]} for every requested
+        NEVRA, in one pass over the media file lists.
+        """
+        self._init_core()
+
+        files = self._ops.get_packages_files(list(nevras))
+        return self._json(files)
 
     def handle_get_installed_packages(self, bus, sender):
         """GetInstalledPackages() -> s (JSON)
@@ -237,7 +675,36 @@ class UrpmDBusService:
         import json
 
         packages = self._ops.get_installed_packages()
-        return json.dumps(packages)
+        return self._json(packages)
+
+    def handle_get_installed_packages_paged(self, bus, sender, cursor, limit):
+        """GetInstalledPackagesPaged(cursor: s, limit: u) -> s (JSON)
+
+        Page through installed packages. Start with an empty cursor, then
+        pass back the returned cursor until it comes back empty:
+        {"packages": [...], "cursor": "...", "offset": n, "total": n}
+        """
+        self._init_core()
+
+        page = self._pager.page(cursor, limit,
+                                self._ops.get_installed_packages)
+        page['packages'] = page.pop('items')
+        return page
+
+    def handle_list_packages(self, bus, sender, filters, after_key, page_size):
+        """ListPackages(filters: s, after_key: s, page_size: u) -> s (JSON)
+
+        Page through the available-package catalog. Start with an empty
+        key, then pass back the returned key until it comes back empty:
+        {"packages": [...], "next_key": "..."}
+        """
+        self._init_core()
+
+        page_size = max(1, min(int(page_size) or MAX_PAGE_SIZE, MAX_PAGE_SIZE))
+        packages, next_key = self._ops.list_packages(
+            filters, after_key, page_size
+        )
+        return {'packages': packages, 'next_key': next_key}
 
     def handle_download_packages(self, bus, sender, package_names, directory):
         """DownloadPackages(packages: as, directory: s) -> s (JSON)
@@ -275,7 +742,29 @@ class UrpmDBusService:
         import json
 
         packages = self._ops.whatrequires(package_name)
-        return json.dumps(packages)
+        return self._json(packages)
+
+    def handle_whatrequires_any(self, bus, sender, package_names):
+        """WhatRequiresAny(packages: as) -> s (JSON)
+
+        Batched WhatRequires: packages requiring any of the given
+        packages, each listed once.
+        """
+        self._init_core()
+
+        packages = self._ops.whatrequires_any(list(package_names))
+        return self._json(packages)
+
+    def handle_whatprovides(self, bus, sender, values):
+        """WhatProvides(values: as) -> s (JSON)
+
+        Packages providing any of the given capabilities (indexed
+        lookup, versioned provides and modalias globs included).
+        """
+        self._init_core()
+
+        packages = self._ops.whatprovides(list(values))
+        return self._json(packages)
 
     def handle_install_files(self, bus, sender, rpm_paths):
         """InstallFiles(paths: as) -> s (JSON)
@@ -311,7 +800,8 @@ class UrpmDBusService:
     def handle_get_updates(self, bus, sender):
         """GetUpdates() -> s (JSON)"""
         self._init_core()
-        success, upgrades, problems = self._ops.get_updates()
+        with self._metrics.phase('resolve'):
+            success, upgrades, problems = self._ops.get_updates()
 
         upgrade_dicts = []
         for u in upgrades:
@@ -325,18 +815,47 @@ class UrpmDBusService:
 
         return success, upgrade_dicts, problems
 
+    def handle_get_update_details(self, bus, sender, nevras):
+        """GetUpdateDetails(nevras: as) -> s (JSON)
+
+        Changelog, issue date and restart hint for several update
+        candidates, read from the media hdlists in one pass.
+        """
+        self._init_core()
+
+        details = self._ops.get_update_details(list(nevras))
+        return self._json(details)
+
+    def handle_get_data_generation(self, bus, sender):
+        """GetDataGeneration() -> s
+
+        Opaque token that changes whenever package listings may change
+        (media sync, install or removal).  Clients that cache listings
+        keep it with each entry: a changed token means the entry is
+        stale, even when the change is still in the database's WAL.
+        """
+        self._init_core()
+        return hashlib.sha1(
+            repr(self._db.search_generation()).encode()
+        ).hexdigest()
+
     def handle_preview_install(self, bus, sender, package_names):
         """PreviewInstall(as) -> s (JSON)
 
         Resolve dependencies without downloading or installing.
-        Returns list of packages that would be installed.
+        Returns list of packages that would be installed, and the
+        resolver's per-phase profile.
         """
         self._init_core()
 
         from ..core.resolver import Resolver
+        from ..core.resolution.profile import ResolveProfile
 
-        resolver = Resolver(self._db, arch=platform.machine())
-        result = resolver.resolve_install(list(package_names))
+        profile = ResolveProfile()
+        with self._metrics.phase('resolve'):
+            resolver = Resolver(self._db, arch=platform.machine(),
+                                profile=profile)
+            result = resolver.resolve_install(list(package_names))
 
         to_install = []
         if result.success and result.actions:
@@ -361,8 +880,24 @@ class UrpmDBusService:
             'success': result.success,
             'to_install': to_install,
             'problems': result.problems or [],
+            'profile': profile.to_dict(),
         }
 
+    def handle_get_metrics(self, bus, sender):
+        """GetMetrics() -> s (JSON)
+
+        Per-method call counts and latency histograms split by phase,
+        calls and operations in flight, and cache hit rates.
+        """
+        metrics = self._metrics.snapshot()
+        with self._lock:
+            kinds = list(self._active_operations.values())
+        metrics['operations_in_flight'] = {
+            kind: kinds.count(kind) for kind in sorted(set(kinds))
+        }
+        metrics['caches'] = cache_stats.snapshot()
+        return metrics
+
     # =====================================================================
     # Write handlers (async via thread)
     # =====================================================================
@@ -416,9 +951,12 @@ class UrpmDBusService:
             rpm_paths = list(local_paths)
             if download_items:
                 def dl_progress(name, pkg_num, pkg_total, dl_bytes, dl_total,
-                               item_bytes=None, item_total=None, active_downloads=None):
+                               item_bytes=None, item_total=None, active_downloads=None,
+                               coordinator_speed=0.0):
                     self._emit_progress(
-                        op_id, "downloading", name or "", pkg_num, pkg_total
+                        op_id, "downloading", name or "", pkg_num, pkg_total,
+                        bytes_done=dl_bytes, bytes_total=dl_total,
+                        speed=coordinator_speed or 0.0
                     )
 
                 dl_results, downloaded, cached, _ = self._ops.download_packages(
@@ -578,23 +1116,38 @@ class UrpmDBusService:
                 self._active_operations.pop(op_id, None)
 
     def _run_upgrade(self, op_id, context, invocation):
-        """Upgrade system packages in a background thread."""
+        """Upgrade system packages in a background thread.
+
+        Uses the transaction urpmd prepared (see core.prepared_upgrade)
+        when it is still valid: no resolution, and no download step if
+        its RPMs are all pre-downloaded and verified.
+        """
+        from ..core import prepared_upgrade
         from ..core.resolver import Resolver, TransactionType
         from ..core.operations import InstallOptions
 
         try:
             self._emit_progress(op_id, "resolving", "", 0, 0)
 
-            resolver = Resolver(self._db, arch=platform.machine())
-            result = resolver.resolve_upgrade()
+            arch = platform.machine()
+            resolver = Resolver(self._db, arch=arch)
+            prepared = prepared_upgrade.load(
+                self._db, prepared_upgrade.state_key(self._db, arch)
+            )
+            if prepared is not None:
+                logger.info(f"Using upgrade prepared by urpmd "
+                            f"({len(prepared.actions)} actions)")
+                actions = prepared.actions
+            else:
+                result = resolver.resolve_upgrade()
 
-            if not result.success:
-                problems = "; ".join(result.problems) if result.problems else "Resolution failed"
-                self._emit_complete(op_id, False, problems)
-                self._return_invocation(invocation, False, problems)
-                return
+                if not result.success:
+                    problems = "; ".join(result.problems) if result.problems else "Resolution failed"
+                    self._emit_complete(op_id, False, problems)
+                    self._return_invocation(invocation, False, problems)
+                    return
 
-            actions = result.actions
+                actions = result.actions
             if not actions:
                 msg = "System is up to date"
                 self._emit_complete(op_id, True, msg)
@@ -605,19 +1158,27 @@ class UrpmDBusService:
             upgrade_actions = [a for a in actions if a.action != TransactionType.REMOVE]
             remove_names = [a.name for a in actions if a.action == TransactionType.REMOVE]
 
-            # Build download items for upgrades
-            self._emit_progress(op_id, "downloading", "", 0, len(upgrade_actions))
-            download_items, local_paths = self._ops.build_download_items(
-                actions, resolver
-            )
+            ready = prepared.ready_rpms() if prepared is not None else None
+            if ready is not None:
+                # Pre-downloaded and verified by urpmd, unchanged since
+                download_items, rpm_paths = [], ready
+            else:
+                # Build download items for upgrades
+                self._emit_progress(op_id, "downloading", "", 0, len(upgrade_actions))
+                download_items, local_paths = self._ops.build_download_items(
+                    actions, resolver
+                )
+                rpm_paths = list(local_paths)
 
             # Download
-            rpm_paths = list(local_paths)
             if download_items:
                 def dl_progress(name, pkg_num, pkg_total, dl_bytes, dl_total,
-                               item_bytes=None, item_total=None, active_downloads=None):
+                               item_bytes=None, item_total=None, active_downloads=None,
+                               coordinator_speed=0.0):
                     self._emit_progress(
-                        op_id, "downloading", name or "", pkg_num, pkg_total
+                        op_id, "downloading", name or "", pkg_num, pkg_total,
+                        bytes_done=dl_bytes, bytes_total=dl_total,
+                        speed=coordinator_speed or 0.0
                     )
 
                 dl_results, downloaded, cached, _ = self._ops.download_packages(
@@ -658,6 +1219,7 @@ class UrpmDBusService:
             self._ops.mark_dependencies(resolver, actions)
             self._ops.complete_transaction(transaction_id)
             self._ops.notify_urpmd_cache_invalidate()
+            prepared_upgrade.discard(self._db)
 
             msg = f"Upgraded {len(rpm_paths)} package(s)"
             if remove_names:
@@ -822,6 +1384,10 @@ class UrpmDBusService:
       <arg name="identifier" type="s" direction="in"/>
       <arg name="info" type="s" direction="out"/>
     </method>
+    <method name="GetPackagesInfo">
+      <arg name="names" type="as" direction="in"/>
+      <arg name="packages" type="s" direction="out"/>
+    </method>
     <method name="ResolvePackages">
       <arg name="names" type="as" direction="in"/>
       <arg name="results" type="s" direction="out"/>
@@ -830,13 +1396,69 @@ class UrpmDBusService:
       <arg name="pattern" type="s" direction="in"/>
       <arg name="results" type="s" direction="out"/>
     </method>
+    <method name="SearchFilesAny">
+      <arg name="patterns" type="as" direction="in"/>
+      <arg name="results" type="s" direction="out"/>
+    </method>
     <method name="GetPackageFiles">
       <arg name="nevra" type="s" direction="in"/>
       <arg name="files" type="s" direction="out"/>
     </method>
+    <method name="GetPackagesFiles">
+      <arg name="nevras" type="as" direction="in"/>
+      <arg name="files" type="s" direction="out"/>
+    </method>
     <method name="GetInstalledPackages">
       <arg name="packages" type="s" direction="out"/>
     </method>
+    <method name="GetInstalledPackagesPaged">
+      <arg name="cursor" type="s" direction="in"/>
+      <arg name="limit" type="u" direction="in"/>
+      <arg name="page" type="s" direction="out"/>
+    </method>
+    <method name="SearchPackagesV2">
+      <arg name="pattern" type="s" direction="in"/>
+      <arg name="search_provides" type="b" direction="in"/>
+      <arg name="packages" type="a(sssssb)" direction="out"/>
+    </method>
+    <method name="SearchPackagesPrefix">
+      <arg name="pattern" type="s" direction="in"/>
+      <arg name="search_provides" type="b" direction="in"/>
+      <arg name="limit" type="u" direction="in"/>
+      <arg name="session" type="s" direction="in"/>
+      <arg name="results" type="s" direction="out"/>
+    </method>
+    <method name="SearchPackagesPrefixV2">
+      <arg name="pattern" type="s" direction="in"/>
+      <arg name="search_provides" type="b" direction="in"/>
+      <arg name="limit" type="u" direction="in"/>
+      <arg name="session" type="s" direction="in"/>
+      <arg name="packages" type="a(sssssb)" direction="out"/>
+    </method>
+    <method name="GetInstalledPackagesV2">
+      <arg name="packages" type="a(sssssb)" direction="out"/>
+    </method>
+    <method name="GetInstalledPackagesPagedV2">
+      <arg name="cursor" type="s" direction="in"/>
+      <arg name="limit" type="u" direction="in"/>
+      <arg name="packages" type="a(sssssb)" direction="out"/>
+      <arg name="next_cursor" type="s" direction="out"/>
+      <arg name="offset" type="u" direction="out"/>
+      <arg name="total" type="u" direction="out"/>
+    </method>
+    <method name="ListPackages">
+      <arg name="filters" type="s" direction="in"/>
+      <arg name="after_key" type="s" direction="in"/>
+      <arg name="page_size" type="u" direction="in"/>
+      <arg name="page" type="s" direction="out"/>
+    </method>
+    <method name="ListPackagesV2">
+      <arg name="filters" type="s" direction="in"/>
+      <arg name="after_key" type="s" direction="in"/>
+      <arg name="page_size" type="u" direction="in"/>
+      <arg name="packages" type="a(sssssb)" direction="out"/>
+      <arg name="next_key" type="s" direction="out"/>
+    </method>
     <method name="DownloadPackages">
       <arg name="packages" type="as" direction="in"/>
       <arg name="directory" type="s" direction="in"/>
@@ -846,6 +1468,14 @@ class UrpmDBusService:
       <arg name="package" type="s" direction="in"/>
       <arg name="packages" type="s" direction="out"/>
     </method>
+    <method name="WhatRequiresAny">
+      <arg name="names" type="as" direction="in"/>
+      <arg name="packages" type="s" direction="out"/>
+    </method>
+    <method name="WhatProvides">
+      <arg name="values" type="as" direction="in"/>
+      <arg name="packages" type="s" direction="out"/>
+    </method>
     <method name="InstallFiles">
       <arg name="paths" type="as" direction="in"/>
       <arg name="result" type="s" direction="out"/>
@@ -856,10 +1486,20 @@ class UrpmDBusService:
     <method name="GetUpdates">
       <arg name="result" type="s" direction="out"/>
     </method>
+    <method name="GetUpdateDetails">
+      <arg name="nevras" type="as" direction="in"/>
+      <arg name="details" type="s" direction="out"/>
+    </method>
     <method name="PreviewInstall">
       <arg name="packages" type="as" direction="in"/>
       <arg name="result" type="s" direction="out"/>
     </method>
+    <method name="GetDataGeneration">
+      <arg name="generation" type="s" direction="out"/>
+    </method>
+    <method name="GetMetrics">
+      <arg name="metrics" type="s" direction="out"/>
+    </method>
     <method name="InstallPackages">
       <arg name="packages" type="as" direction="in"/>
       <arg name="options" type="a{{sv}}" direction="in"/>
@@ -889,6 +1529,17 @@ class UrpmDBusService:
       <arg name="total" type="u"/>
       <arg name="message" type="s"/>
     </signal>
+    <signal name="OperationProgressV2">
+      <arg name="operation_id" type="s"/>
+      <arg name="phase" type="u"/>
+      <arg name="package" type="s"/>
+      <arg name="current" type="u"/>
+      <arg name="total" type="u"/>
+      <arg name="bytes_done" type="t"/>
+      <arg name="bytes_total" type="t"/>
+      <arg name="speed_bps" type="t"/>
+      <arg name="message" type="s"/>
+    </signal>
     <signal name="OperationComplete">
       <arg name="operation_id" type="s"/>
       <arg name="success" type="b"/>
@@ -898,64 +1549,302 @@ class UrpmDBusService:
 </node>
 """
 
-    def _on_method_call(self, connection, sender, object_path, interface_name,
-                        method_name, parameters, invocation):
-        """Handle incoming D-Bus method calls."""
+    def _read_method_result(self, connection, sender, method_name, parameters,
+                            search=None):
+        """Run a read-only method and build its reply variant.
+
+        ``search`` is the ``(scope, ticket)`` of a prefix search.
+        """
+        from gi.repository import GLib
+
+        if method_name == "SearchPackages":
+            pattern, search_provides = parameters.unpack()
+            results = self.handle_search_packages(
+                connection, sender, pattern, search_provides
+            )
+            return GLib.Variant('(s)', (self._json(results),))
+
+        elif method_name == "GetPackageInfo":
+            identifier = parameters.unpack()[0]
+            info = self.handle_get_package_info(
+                connection, sender, identifier
+            )
+            return GLib.Variant('(s)', (self._json(info),))
+
+        elif method_name == "GetPackagesInfo":
+            names = parameters.unpack()[0]
+            infos = self.handle_get_packages_info(
+                connection, sender, names
+            )
+            return GLib.Variant('(s)', (self._json(infos),))
+
+        elif method_name == "ResolvePackages":
+            names = parameters.unpack()[0]
+            results = self.handle_resolve_packages(
+                connection, sender, names
+            )
+            return GLib.Variant('(s)', (results,))
+
+        elif method_name == "SearchFiles":
+            pattern = parameters.unpack()[0]
+            results = self.handle_search_files(
+                connection, sender, pattern
+            )
+            return GLib.Variant('(s)', (results,))
+
+        elif method_name == "SearchFilesAny":
+            patterns = parameters.unpack()[0]
+            results = self.handle_search_files_any(
+                connection, sender, patterns
+            )
+            return GLib.Variant('(s)', (results,))
+
+        elif method_name == "GetPackageFiles":
+            nevra = parameters.unpack()[0]
+            files = self.handle_get_package_files(
+                connection, sender, nevra
+            )
+            return GLib.Variant('(s)', (files,))
+
+        elif method_name == "GetPackagesFiles":
+            nevras = parameters.unpack()[0]
+            files = self.handle_get_packages_files(
+                connection, sender, nevras
+            )
+            return GLib.Variant('(s)', (files,))
+
+        elif method_name == "GetInstalledPackages":
+            packages = self.handle_get_installed_packages(
+                connection, sender
+            )
+            return GLib.Variant('(s)', (packages,))
+
+        elif method_name == "GetInstalledPackagesPaged":
+            cursor, limit = parameters.unpack()
+            page = self.handle_get_installed_packages_paged(
+                connection, sender, cursor, limit
+            )
+            return GLib.Variant('(s)', (self._json(page),))
+
+        elif method_name == "SearchPackagesV2":
+            pattern, search_provides = parameters.unpack()
+            results = self.handle_search_packages(
+                connection, sender, pattern, search_provides
+            )
+            with self._metrics.phase('serialize'):
+                return GLib.Variant(f'(a{PACKAGE_RECORD})', (
+                    [package_record(p) for p in results],
+                ))
+
+        elif method_name in ("SearchPackagesPrefix", "SearchPackagesPrefixV2"):
+            pattern, search_provides, limit, _session = parameters.unpack()
+            scope, ticket = search
+            results = self.handle_search_packages_prefix(
+                connection, sender, pattern, search_provides, limit,
+                scope, ticket
+            )
+            if method_name == "SearchPackagesPrefix":
+                return GLib.Variant('(s)', (self._json(results),))
+            with self._metrics.phase('serialize'):
+                return GLib.Variant(f'(a{PACKAGE_RECORD})', (
+                    [package_record(p) for p in results],
+                ))
+
+        elif method_name == "GetInstalledPackagesV2":
+            self._init_core()
+            packages = self._ops.get_installed_packages()
+            with self._metrics.phase('serialize'):
+                return GLib.Variant(f'(a{PACKAGE_RECORD})', (
+                    [package_record(p) for p in packages],
+                ))
+
+        elif method_name == "GetInstalledPackagesPagedV2":
+            cursor, limit = parameters.unpack()
+            page = self.handle_get_installed_packages_paged(
+                connection, sender, cursor, limit
+            )
+            with self._metrics.phase('serialize'):
+                return GLib.Variant(f'(a{PACKAGE_RECORD}suu)', (
+                    [package_record(p) for p in page['packages']],
+                    page['cursor'], page['offset'], page['total'],
+                ))
+
+        elif method_name == "ListPackages":
+            filters, after_key, page_size = parameters.unpack()
+            page = self.handle_list_packages(
+                connection, sender, filters, after_key, page_size
+            )
+            return GLib.Variant('(s)', (self._json(page),))
+
+        elif method_name == "ListPackagesV2":
+            filters, after_key, page_size = parameters.unpack()
+            page = self.handle_list_packages(
+                connection, sender, filters, after_key, page_size
+            )
+            with self._metrics.phase('serialize'):
+                return GLib.Variant(f'(a{PACKAGE_RECORD}s)', (
+                    [package_record(p) for p in page['packages']],
+                    page['next_key'],
+                ))
+
+        elif method_name == "WhatRequires":
+            package = parameters.unpack()[0]
+            packages = self.handle_whatrequires(
+                connection, sender, package
+            )
+            return GLib.Variant('(s)', (packages,))
+
+        elif method_name == "WhatRequiresAny":
+            names = parameters.unpack()[0]
+            packages = self.handle_whatrequires_any(
+                connection, sender, names
+            )
+            return GLib.Variant('(s)', (packages,))
+
+        elif method_name == "WhatProvides":
+            values = parameters.unpack()[0]
+            packages = self.handle_whatprovides(
+                connection, sender, values
+            )
+            return GLib.Variant('(s)', (packages,))
+
+        elif method_name == "GetUpdates":
+            success, upgrades, problems = self.handle_get_updates(
+                connection, sender
+            )
+            result = {
+                'success': success,
+                'upgrades': upgrades,
+                'problems': problems,
+            }
+            return GLib.Variant('(s)', (self._json(result),))
+
+        elif method_name == "GetUpdateDetails":
+            nevras = parameters.unpack()[0]
+            details = self.handle_get_update_details(
+                connection, sender, nevras
+            )
+            return GLib.Variant('(s)', (details,))
+
+        elif method_name == "GetDataGeneration":
+            generation = self.handle_get_data_generation(connection, sender)
+            return GLib.Variant('(s)', (generation,))
+
+        elif method_name == "PreviewInstall":
+            packages = parameters.unpack()[0]
+            result = self.handle_preview_install(
+                connection, sender, packages
+            )
+            return GLib.Variant('(s)', (self._json(result),))
+
+        raise ValueError(f"Not a read method: {method_name}")
+
+    def _run_read_method(self, connection, sender, method_name, parameters,
+                         invocation, call=None, search=None):
+        """Worker-pool entry point for READ_METHODS.
+
+        The reply (or D-Bus error) is handed back to the main loop thread,
+        like _return_invocation does for write operations.  ``call`` is the
+        metrics record started at dispatch; it is finished once the reply
+        has been returned.  A superseded prefix search gets
+        SUPERSEDED_ERROR and does not count as an error.
+        """
+        from gi.repository import GLib
+
+        self._metrics.bind(call, 'db')
+        error_name = 'org.mageia.Urpm.v1.Error'
         try:
-            from gi.repository import GLib
+            reply = self._read_method_result(
+                connection, sender, method_name, parameters, search
+            )
+            error = None
+        except SearchSuperseded:
+            reply, error = None, "Superseded by a newer search"
+            error_name = SUPERSEDED_ERROR
+        except Exception as e:
+            logger.exception(f"Error handling {method_name}")
+            reply, error = None, str(e)
+        finally:
+            self._metrics.unbind('reply')
 
-            if method_name == "SearchPackages":
-                pattern, search_provides = parameters.unpack()
-                results = self.handle_search_packages(
-                    connection, sender, pattern, search_provides
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (json.dumps(results),))
-                )
+        def _return():
+            try:
+                if error is None:
+                    invocation.return_value(reply)
+                else:
+                    invocation.return_dbus_error(error_name, error)
+            except Exception as e:
+                logger.error(f"Failed to return invocation: {e}")
+            self._metrics.finish(
+                call, error=error is not None and error_name != SUPERSEDED_ERROR
+            )
+            return False
 
-            elif method_name == "GetPackageInfo":
-                identifier = parameters.unpack()[0]
-                info = self.handle_get_package_info(
-                    connection, sender, identifier
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (json.dumps(info),))
-                )
+        GLib.idle_add(_return)
 
-            elif method_name == "ResolvePackages":
-                names = parameters.unpack()[0]
-                results = self.handle_resolve_packages(
-                    connection, sender, names
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (results,))
-                )
+    def _dispatch_prefix_search(self, connection, sender, method_name,
+                                parameters, invocation, call):
+        """Queue a prefix search on the read pool.
 
-            elif method_name == "SearchFiles":
-                pattern = parameters.unpack()[0]
-                results = self.handle_search_files(
-                    connection, sender, pattern
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (results,))
-                )
+        Its scope and ticket are taken here, on the main loop and in
+        arrival order, not by the worker.  A session string needs the
+        caller's uid, which may take an asynchronous bus round trip.
+        """
+        session = parameters.unpack()[3]
 
-            elif method_name == "GetPackageFiles":
-                nevra = parameters.unpack()[0]
-                files = self.handle_get_package_files(
-                    connection, sender, nevra
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (files,))
+        def submit(uid):
+            scope = self._search_session(sender, session, uid)
+            ticket = self._search.begin(scope)
+            try:
+                self._read_pool.submit(
+                    self._run_read_method, connection, sender,
+                    method_name, parameters, invocation, call,
+                    (scope, ticket)
                 )
+            except RuntimeError as e:
+                # Pool shut down while the uid lookup was pending
+                invocation.return_dbus_error('org.mageia.Urpm.v1.Error', str(e))
+                self._metrics.finish(call, error=True)
 
-            elif method_name == "GetInstalledPackages":
-                packages = self.handle_get_installed_packages(
-                    connection, sender
+        if session:
+            self._with_caller_uid(connection, sender, submit)
+        else:
+            submit(None)
+
+    def _on_method_call(self, connection, sender, object_path, interface_name,
+                        method_name, parameters, invocation):
+        """Handle incoming D-Bus method calls."""
+        if method_name == "GetMetrics":
+            # Answered inline and not counted, so scraping is cheap and
+            # does not show up in the numbers it reads
+            from gi.repository import GLib
+            metrics = self.handle_get_metrics(connection, sender)
+            invocation.return_value(GLib.Variant('(s)', (json.dumps(metrics),)))
+            return
+
+        if method_name in READ_METHODS:
+            call = self._metrics.begin(method_name, 'queue')
+        else:
+            call = self._metrics.begin(method_name, 'other')
+            self._metrics.bind(call)
+        failed = False
+        try:
+            from gi.repository import GLib
+
+            if method_name in ("SearchPackagesPrefix",
+                               "SearchPackagesPrefixV2"):
+                self._dispatch_prefix_search(
+                    connection, sender, method_name, parameters,
+                    invocation, call
                 )
-                invocation.return_value(
-                    GLib.Variant('(s)', (packages,))
+                call = None     # finished by the worker's reply
+
+            elif method_name in READ_METHODS:
+                self._read_pool.submit(
+                    self._run_read_method, connection, sender,
+                    method_name, parameters, invocation, call
                 )
+                call = None     # finished by the worker's reply
 
             elif method_name == "DownloadPackages":
                 pkg_names, directory = parameters.unpack()
@@ -966,15 +1855,6 @@ class UrpmDBusService:
                     GLib.Variant('(s)', (result,))
                 )
 
-            elif method_name == "WhatRequires":
-                package = parameters.unpack()[0]
-                packages = self.handle_whatrequires(
-                    connection, sender, package
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (packages,))
-                )
-
             elif method_name == "InstallFiles":
                 paths = parameters.unpack()[0]
                 result = self.handle_install_files(
@@ -992,28 +1872,6 @@ class UrpmDBusService:
                     GLib.Variant('(b)', (success,))
                 )
 
-            elif method_name == "GetUpdates":
-                success, upgrades, problems = self.handle_get_updates(
-                    connection, sender
-                )
-                result = {
-                    'success': success,
-                    'upgrades': upgrades,
-                    'problems': problems,
-                }
-                invocation.return_value(
-                    GLib.Variant('(s)', (json.dumps(result),))
-                )
-
-            elif method_name == "PreviewInstall":
-                packages = parameters.unpack()[0]
-                result = self.handle_preview_install(
-                    connection, sender, packages
-                )
-                invocation.return_value(
-                    GLib.Variant('(s)', (json.dumps(result),))
-                )
-
             elif method_name == "InstallPackages":
                 packages, options = parameters.unpack()
                 ret = self.handle_install_packages(
@@ -1066,11 +1924,16 @@ class UrpmDBusService:
                 )
 
         except Exception as e:
+            failed = True
             logger.exception(f"Error handling {method_name}")
             invocation.return_dbus_error(
                 'org.mageia.Urpm.v1.Error',
                 str(e)
             )
+        finally:
+            if call is not None:
+                self._metrics.unbind()
+                self._metrics.finish(call, error=failed)
 
     def run(self, debug: bool = False):
         """Run the D-Bus service (main loop)."""
@@ -1130,6 +1993,7 @@ class UrpmDBusService:
         try:
             self._loop.run()
         finally:
+            self._read_pool.shutdown(wait=False, cancel_futures=True)
             if self._audit:
                 self._audit.close()
             if self._db:
@@ -1139,9 +2003,14 @@ class UrpmDBusService:
 
 def main():
     """Entry point for urpm-dbus-service."""
-    debug = '--debug' in sys.argv
-    service = UrpmDBusService()
-    service.run(debug=debug)
+    parser = argparse.ArgumentParser(prog='urpm-dbus-service')
+    parser.add_argument('--debug', action='store_true')
+    parser.add_argument('--db', metavar='PATH',
+                        help="package database to serve (default: the system one)")
+    args = parser.parse_args()
+
+    service = UrpmDBusService(db_path=args.db)
+    service.run(debug=args.debug)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,70 @@
+#!/usr/bin/python3
+"""Profile the resolver on large synthetic upgrade scenarios.
+
+Resolves each scenario of :mod:`urpm.tests.resolve_scenarios` and prints
+the per-phase profile of the median run (by wall time).  With --json,
+every run's profile is written out so results from several machines or
+releases can be compared.
+
+Usage:
+    python3 -m urpm.tests.bench_resolve [--scale F] [--runs N]
+                                        [--json FILE] [SCENARIO...]
+"""
+
+import argparse
+import json
+import sys
+
+from urpm.core.resolution.profile import ResolveProfile
+from urpm.tests.resolve_scenarios import SCENARIOS
+
+
+def _bench(scenario, scale, runs):
+    reports = []
+    for _ in range(runs):
+        profile = ResolveProfile()
+        result = scenario.run(scale, profile)
+        report = profile.to_dict()
+        report['success'] = result.success
+        report['alternatives'] = len(result.alternatives)
+        reports.append((report, profile))
+    reports.sort(key=lambda rp: rp[0]['total']['wall_ms'])
+    return reports
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('scenarios', nargs='*', metavar='SCENARIO',
+                        help=f"default: all ({', '.join(SCENARIOS)})")
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='multiply package counts (default 1.0)')
+    parser.add_argument('--runs', type=int, default=3)
+    parser.add_argument('--json', metavar='FILE',
+                        help='write every run as JSON')
+    args = parser.parse_args()
+
+    unknown = [name for name in args.scenarios if name not in SCENARIOS]
+    if unknown:
+        parser.error(f"unknown scenario(s): {', '.join(unknown)}")
+
+    results = []
+    for name in args.scenarios or SCENARIOS:
+        scenario = SCENARIOS[name]
+        reports = _bench(scenario, args.scale, max(1, args.runs))
+        report, profile = reports[len(reports) // 2]
+        print(f"== {name}: {scenario.description}")
+        for line in profile.format():
+            print(f"   {line}")
+        print()
+        results.append({'scenario': name, 'scale': args.scale,
+                        'runs': [r for r, _ in reports]})
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(results, f, indent=2)
+            f.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
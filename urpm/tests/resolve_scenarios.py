@@ -0,0 +1,249 @@
+"""Large synthetic upgrade scenarios for resolver profiling.
+
+Each scenario generates an installed set and an update media of
+thousands of packages and resolves them with the real Resolver code
+paths (job creation, ``_solve``, transaction ordering, alternatives).
+Only the pool comes from memory instead of synthesis files and the
+rpmdb, so a scenario is the same problem on every machine and the
+per-phase profiles can be compared across hosts and releases.
+
+Run them with :mod:`urpm.tests.bench_resolve`.  ``test_resolve_profile``
+resolves each one at a small scale.
+"""
+
+import random
+from dataclasses import dataclass
+from typing import Callable, Dict, List, Optional, Tuple
+
+import solv
+
+from urpm.core.resolution.profile import ResolveProfile, phased, profile_phase
+from urpm.core.resolver import Resolution, Resolver, parse_capability
+
+ARCH = 'x86_64'
+OLD = '1-1.mga10'
+NEW = '1-2.mga10'
+NEXT_RELEASE = '2-1.mga11'
+
+Spec = Dict[str, object]
+
+
+def _spec(name: str, evr: str, requires=(), provides=(), obsoletes=()) -> Spec:
+    return {'name': name, 'evr': evr, 'requires': list(requires),
+            'provides': list(provides), 'obsoletes': list(obsoletes)}
+
+
+def _lib(i: int, evr: str, soname: int = 1) -> Spec:
+    suffix = '' if soname == 1 else f'_{soname}'
+    return _spec(f'lib64bench{i}{suffix}', evr,
+                 provides=[f'libbench{i}.so.{soname}()(64bit)'])
+
+
+def _app(j: int, evr: str, libs, requires=()) -> Spec:
+    return _spec(f'bench-app{j}', evr,
+                 requires=['bench-filesystem']
+                 + [f'libbench{i}.so.{soname}()(64bit)' for i, soname in libs]
+                 + list(requires))
+
+
+def _base(evr: str) -> List[Spec]:
+    return [_spec('bench-filesystem', evr)]
+
+
+def _links(rng: random.Random, libs: int) -> List[int]:
+    return rng.sample(range(libs), k=min(libs, rng.randint(1, 4)))
+
+
+def full_upgrade(rng: random.Random, scale: float):
+    """Routine update run: most packages get a new release, and updated
+    applications need the updated version of their libraries."""
+    libs, apps = int(1500 * scale), int(4500 * scale)
+    installed = _base(OLD) + [_lib(i, OLD) for i in range(libs)]
+    available = _base(OLD)
+    links = {j: _links(rng, libs) for j in range(apps)}
+    installed += [_app(j, OLD, [(i, 1) for i in links[j]]) for j in range(apps)]
+
+    updated_libs = {i for i in range(libs) if rng.random() < 0.8}
+    available += [_lib(i, NEW if i in updated_libs else OLD) for i in range(libs)]
+    for j in range(apps):
+        if rng.random() < 0.8:
+            available.append(_app(j, NEW, [(i, 1) for i in links[j]], requires=[
+                f'lib64bench{i} >= {NEW}' for i in links[j] if i in updated_libs]))
+        else:
+            available.append(_app(j, OLD, [(i, 1) for i in links[j]]))
+    return installed, available, None
+
+
+def soname_bump(rng: random.Random, scale: float):
+    """Library transition: new sonames ship as new packages next to the
+    old ones, their users are rebuilt against them, and some packages
+    are renamed through Obsoletes."""
+    libs, apps = int(1000 * scale), int(3000 * scale)
+    installed = _base(OLD) + [_lib(i, OLD) for i in range(libs)]
+    available = _base(OLD) + [_lib(i, OLD) for i in range(libs)]
+    bumped = {i for i in range(libs) if rng.random() < 0.3}
+    available += [_lib(i, NEW, soname=2) for i in sorted(bumped)]
+
+    for j in range(apps):
+        linked = _links(rng, libs)
+        installed.append(_app(j, OLD, [(i, 1) for i in linked]))
+        rebuilt = [(i, 2 if i in bumped else 1) for i in linked]
+        if j % 15 == 0:
+            # Renamed: the new name obsoletes and provides the old one
+            spec = _app(j, NEW, rebuilt)
+            spec['name'] = f'bench-app{j}-ng'
+            spec['provides'].append(f'bench-app{j} = {NEW}')
+            spec['obsoletes'].append(f'bench-app{j} < {NEW}')
+            available.append(spec)
+        elif any(soname == 2 for _, soname in rebuilt):
+            available.append(_app(j, NEW, rebuilt))
+        else:
+            available.append(_app(j, OLD, rebuilt))
+    return installed, available, None
+
+
+def release_upgrade(rng: random.Random, scale: float):
+    """Move to the next release: every package is rebuilt, new
+    dependencies come in, renamed packages obsolete their old names and
+    a few packages are dropped from the distribution."""
+    libs, apps = int(4000 * scale), int(11000 * scale)
+    new_deps = int(1500 * scale)
+    installed = _base(OLD) + [_lib(i, OLD) for i in range(libs)]
+    available = _base(NEXT_RELEASE) + [_lib(i, NEXT_RELEASE) for i in range(libs)]
+    available += [_spec(f'bench-newdep{k}', NEXT_RELEASE, requires=['bench-filesystem'])
+                  for k in range(new_deps)]
+
+    for j in range(apps):
+        linked = [(i, 1) for i in _links(rng, libs)]
+        installed.append(_app(j, OLD, linked))
+        roll = rng.random()
+        if roll < 0.02:
+            continue                      # dropped, stays installed
+        extra = [f'bench-newdep{rng.randrange(new_deps)}'] if roll < 0.3 else []
+        spec = _app(j, NEXT_RELEASE, linked, requires=extra)
+        if roll > 0.97:
+            spec['name'] = f'bench-app{j}-ng'
+            spec['provides'].append(f'bench-app{j} = {NEXT_RELEASE}')
+            spec['obsoletes'].append(f'bench-app{j} < {NEXT_RELEASE}')
+        available.append(spec)
+    return installed, available, None
+
+
+def install_alternatives(rng: random.Random, scale: float):
+    """Install a meta package whose requirements each have several
+    providers, on top of a large installed system."""
+    libs, apps = int(1000 * scale), int(4000 * scale)
+    virtuals = max(1, int(40 * scale))
+    installed = _base(OLD) + [_lib(i, OLD) for i in range(libs)]
+    installed += [_app(j, OLD, [(i, 1) for i in _links(rng, libs)])
+                  for j in range(apps)]
+    available = list(installed)
+    for k in range(virtuals):
+        for variant in 'abc':
+            available.append(_spec(f'bench-impl{k}-{variant}', OLD,
+                                   requires=['bench-filesystem'],
+                                   provides=[f'bench-virtual{k}']))
+    available.append(_spec('task-bench', OLD,
+                           requires=[f'bench-virtual{k}' for k in range(virtuals)]))
+    return installed, available, ['task-bench']
+
+
+@dataclass
+class Scenario:
+    name: str
+    generate: Callable[[random.Random, float],
+                       Tuple[List[Spec], List[Spec], Optional[List[str]]]]
+
+    @property
+    def description(self) -> str:
+        return self.generate.__doc__.split('\n\n')[0].replace('\n', ' ')
+
+    def run(self, scale: float = 1.0, profile: ResolveProfile = None,
+            seed: int = 0) -> Resolution:
+        """Resolve the scenario; full upgrade unless it names packages."""
+        resolver = ScenarioResolver(self, scale, profile, seed)
+        if resolver.request is None:
+            return resolver.resolve_upgrade()
+        return resolver.resolve_install(resolver.request)
+
+
+SCENARIOS = {s.name: s for s in (
+    Scenario('full-upgrade', full_upgrade),
+    Scenario('soname-bump', soname_bump),
+    Scenario('release-upgrade', release_upgrade),
+    Scenario('install-alternatives', install_alternatives),
+)}
+
+
+class _BenchDB:
+    """The little of PackageDatabase that resolving a ready pool reads."""
+
+    def get_held_packages_set(self):
+        return set()
+
+    def whatprovides(self, capability):
+        return []
+
+
+class ScenarioResolver(Resolver):
+    """Resolver whose pool is built from a scenario.
+
+    The specs are generated up front, outside the profile; adding them
+    to the pool stands in for loading synthesis (``pool``) and the
+    installed set for reading the rpmdb (``rpmdb``).
+    """
+
+    def __init__(self, scenario: Scenario, scale: float = 1.0,
+                 profile: ResolveProfile = None, seed: int = 0):
+        super().__init__(_BenchDB(), arch=ARCH, allowed_arches=[ARCH, 'noarch'],
+                         profile=profile)
+        self.installed_specs, self.available_specs, self.request = (
+            scenario.generate(random.Random(seed), scale))
+
+    @phased('pool')
+    def _create_pool(self) -> solv.Pool:
+        pool = solv.Pool()
+        pool.setdisttype(solv.Pool.DISTTYPE_RPM)
+        pool.setarch(self.arch)
+
+        with profile_phase(self, 'rpmdb'):
+            installed = pool.add_repo('@System')
+            installed.appdata = {'type': 'installed'}
+            self._add_specs(pool, installed, self.installed_specs)
+            pool.installed = installed
+            self._installed_count = installed.nsolvables
+
+        repo = pool.add_repo('Bench Updates')
+        repo.appdata = {'type': 'available', 'media': {'name': 'Bench Updates'}}
+        for s in self._add_specs(pool, repo, self.available_specs):
+            self._solvable_to_pkg[s.id] = {
+                'name': s.name, 'evr': s.evr, 'arch': s.arch,
+                'nevra': f'{s.name}-{s.evr}.{s.arch}', 'summary': '',
+                'size': 1000, 'filesize': 1000, 'media_name': repo.name,
+            }
+
+        pool.addfileprovides()
+        pool.createwhatprovides()
+        self._profile_pool(pool)
+        return pool
+
+    @staticmethod
+    def _add_specs(pool: solv.Pool, repo: solv.Repo, specs: List[Spec]):
+        repodata = repo.add_repodata()
+        added = []
+        for spec in specs:
+            s = repo.add_solvable()
+            s.name = spec['name']
+            s.evr = spec['evr']
+            s.arch = ARCH
+            s.add_deparray(solv.SOLVABLE_PROVIDES, pool.rel2id(
+                pool.str2id(s.name), pool.str2id(s.evr), solv.REL_EQ))
+            for dep in spec['provides']:
+                s.add_deparray(solv.SOLVABLE_PROVIDES, parse_capability(pool, dep))
+            for dep in spec['requires']:
+                s.add_deparray(solv.SOLVABLE_REQUIRES, parse_capability(pool, dep))
+            for dep in spec['obsoletes']:
+                s.add_deparray(solv.SOLVABLE_OBSOLETES, parse_capability(pool, dep))
+            added.append(s)
+        repodata.internalize()
+        return added
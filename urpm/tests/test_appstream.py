@@ -0,0 +1,226 @@
+"""Tests for incremental AppStream generation and merge"""
+
+import gzip
+import tempfile
+import xml.etree.ElementTree as ET
+from pathlib import Path
+
+import pytest
+
+from urpm.core.appstream import AppStreamManager
+from urpm.core.database import PackageDatabase
+
+
+@pytest.fixture
+def db(monkeypatch):
+    """Temporary database with mageia_version='9'."""
+    monkeypatch.setattr('urpm.core.config.get_system_version', lambda: '9')
+
+    with tempfile.NamedTemporaryFile(suffix='.db', delete=False) as f:
+        db_path = Path(f.name)
+
+    database = PackageDatabase(db_path)
+    yield database
+
+    database.close()
+    db_path.unlink(missing_ok=True)
+
+
+@pytest.fixture
+def mgr(db):
+    """AppStreamManager writing under a temporary directory."""
+    tmpdir = tempfile.TemporaryDirectory()
+    base = Path(tmpdir.name)
+    manager = AppStreamManager(db, base)
+    manager.catalog_path = base / 'swcatalog' / 'mageia-urpm.xml.gz'
+    yield manager
+    tmpdir.cleanup()
+
+
+def _media(db, name="Core Release"):
+    return db.add_media(
+        name=name,
+        short_name=name.lower().replace(' ', '_'),
+        mageia_version="9",
+        architecture="x86_64",
+        relative_path="core/release"
+    )
+
+
+def _import(db, media_id, *specs):
+    """Import packages given as (name, version, group)."""
+    db.import_packages(iter({
+        'name': name,
+        'version': version,
+        'release': '1.mga9',
+        'epoch': 0,
+        'arch': 'x86_64',
+        'nevra': f'{name}-{version}-1.mga9.x86_64',
+        'summary': f'{name} summary',
+        'description': f'{name} description',
+        'group': group,
+        'provides': [name],
+        'requires': [],
+        'filesize': 1000,
+    } for name, version, group in specs), media_id=media_id)
+
+
+def _catalog_ids(mgr):
+    with gzip.open(mgr.catalog_path, 'rt', encoding='utf-8') as f:
+        root = ET.fromstring(f.read())
+    return sorted(c.findtext('id') for c in root.findall('component'))
+
+
+class TestIncrementalGeneration:
+    """Components are cached per NEVRA and reused."""
+
+    def test_only_apps_are_components(self, db, mgr):
+        media_id = _media(db)
+        _import(db, media_id, ('gimp', '2.10', 'Graphics/Editor'),
+                ('libfoo', '1.0', 'System/Libraries'))
+
+        xml_str, count = mgr.generate_for_media(media_id, "Core Release")
+
+        assert count == 1
+        root = ET.fromstring(xml_str.split('\n', 1)[1])
+        assert root.get('origin') == 'mageia-core-release'
+        assert [c.findtext('pkgname') for c in root.findall('component')] == ['gimp']
+
+    def test_unchanged_packages_are_reused(self, db, mgr):
+        media_id = _media(db)
+        _import(db, media_id, ('gimp', '2.10', 'Graphics/Editor'),
+                ('inkscape', '1.3', 'Graphics/Editor'))
+
+        first = mgr.sync_media_appstream(media_id, "Core Release", "file:///nonexistent")
+        assert (first.fragments_generated, first.fragments_reused) == (2, 0)
+        assert not first.unchanged
+
+        again = mgr.sync_media_appstream(media_id, "Core Release", "file:///nonexistent")
+        assert (again.fragments_generated, again.fragments_reused) == (0, 2)
+        assert again.unchanged
+        assert again.component_count == 2
+
+    def test_new_version_is_generated(self, db, mgr):
+        media_id = _media(db)
+        _import(db, media_id, ('gimp', '2.10', 'Graphics/Editor'),
+                ('inkscape', '1.3', 'Graphics/Editor'))
+        mgr.sync_media_appstream(media_id, "Core Release", "file:///nonexistent")
+
+        _import(db, media_id, ('gimp', '3.0', 'Graphics/Editor'),
+                ('inkscape', '1.3', 'Graphics/Editor'))
+        result = mgr.sync_media_appstream(media_id, "Core Release", "file:///nonexistent")
+
+        # Rebuilt, though the component text (no version in it) is the same
+        assert (result.fragments_generated, result.fragments_reused) == (1, 1)
+        assert result.unchanged
+
+    def test_remove_drops_fragments(self, db, mgr):
+        media_id = _media(db)
+        _import(db, media_id, ('gimp', '2.10', 'Graphics/Editor'))
+        mgr.sync_media_appstream(media_id, "Core Release", "file:///nonexistent")
+        assert mgr.get_fragments_path("Core Release").exists()
+
+        assert mgr.remove_media_appstream("Core Release")
+        assert not mgr.get_fragments_path("Core Release").exists()
+
+
+class TestIncrementalMerge:
+    """Only changed media are re-read, unchanged catalogs are kept."""
+
+    def _sync(self, db, mgr):
+        core = _media(db, "Core Release")
+        extra = _media(db, "Tainted Release")
+        _import(db, core, ('gimp', '2.10', 'Graphics/Editor'))
+        _import(db, extra, ('vlc', '3.0', 'Video/Players'))
+        for media_id, name in ((core, "Core Release"), (extra, "Tainted Release")):
+            mgr.sync_media_appstream(media_id, name, "file:///nonexistent")
+        return core, extra
+
+    def test_merge(self, db, mgr):
+        self._sync(db, mgr)
+        result = mgr.merge_catalogs()
+
+        assert (result.total_components, result.media_count) == (2, 2)
+        assert result.changed
+        assert result.media_reparsed == 2
+        assert _catalog_ids(mgr) == ['gimp.desktop', 'vlc.desktop']
+
+    def test_unchanged_merge_keeps_catalog(self, db, mgr):
+        self._sync(db, mgr)
+        mgr.merge_catalogs()
+        mtime = mgr.catalog_path.stat().st_mtime_ns
+
+        result = mgr.merge_catalogs()
+
+        assert not result.changed
+        assert (result.media_reparsed, result.media_reused) == (0, 2)
+        assert mgr.catalog_path.stat().st_mtime_ns == mtime
+
+    def test_changed_media_is_reread(self, db, mgr):
+        core, _ = self._sync(db, mgr)
+        mgr.merge_catalogs()
+
+        _import(db, core, ('gimp', '2.10', 'Graphics/Editor'),
+                ('krita', '5.2', 'Graphics/Editor'))
+        mgr.sync_media_appstream(core, "Core Release", "file:///nonexistent")
+        result = mgr.merge_catalogs()
+
+        assert result.changed
+        assert (result.media_reparsed, result.media_reused) == (1, 1)
+        assert _catalog_ids(mgr) == ['gimp.desktop', 'krita.desktop', 'vlc.desktop']
+
+    def test_removed_media_leaves_catalog(self, db, mgr):
+        self._sync(db, mgr)
+        mgr.merge_catalogs()
+
+        mgr.remove_media_appstream("Tainted Release")
+        result = mgr.merge_catalogs()
+
+        assert result.changed
+        assert result.media_count == 1
+        assert _catalog_ids(mgr) == ['gimp.desktop']
+
+    def test_merge_all_catalogs_compat(self, db, mgr):
+        self._sync(db, mgr)
+        assert mgr.merge_all_catalogs() == (2, 2)
+
+    def _appstreamcli(self, monkeypatch, returncode):
+        import subprocess
+        calls = []
+
+        def run(cmd, **kwargs):
+            calls.append(cmd)
+            return subprocess.CompletedProcess(cmd, returncode, '', 'failed')
+
+        monkeypatch.setattr(subprocess, 'run', run)
+        return calls
+
+    def test_failed_refresh_stays_pending(self, db, mgr, monkeypatch):
+        self._sync(db, mgr)
+        assert mgr.merge_catalogs().needs_refresh
+
+        self._appstreamcli(monkeypatch, 1)
+        assert not mgr.refresh_system_cache()
+        result = mgr.merge_catalogs()
+        assert not result.changed and result.needs_refresh
+
+        self._appstreamcli(monkeypatch, 0)
+        assert mgr.refresh_system_cache()
+        result = mgr.merge_catalogs()
+        assert not result.changed and not result.needs_refresh
+
+    def test_interrupted_refresh_is_retried(self, db, mgr, monkeypatch):
+        from urpm.core.sync import sync_all_media
+
+        self._sync(db, mgr)
+        # Catalog written, process gone before the refresh
+        mgr.merge_catalogs()
+
+        calls = self._appstreamcli(monkeypatch, 0)
+        monkeypatch.setattr('urpm.core.appstream.AppStreamManager',
+                            lambda db, base_dir: mgr)
+        sync_all_media(db)
+        assert calls == [['appstreamcli', 'refresh-cache', '--force']]
+
+        sync_all_media(db)
+        assert len(calls) == 1
@@ -0,0 +1,326 @@
+"""Tests for RPM cache tracking, usage index and eviction"""
+
+import sqlite3
+import tempfile
+from pathlib import Path
+
+import pytest
+
+from urpm.core import cache as cache_module
+from urpm.core.cache import CacheManager
+from urpm.core.database import PackageDatabase
+from urpm.core.db import cache as cache_db
+
+MEDIA_DIR = 'official/9/x86_64/media/core/release'
+
+
+@pytest.fixture
+def db(monkeypatch):
+    """Temporary database with mageia_version='9'."""
+    monkeypatch.setattr('urpm.core.config.get_system_version', lambda: '9')
+
+    tmpdir = tempfile.TemporaryDirectory()
+    database = PackageDatabase(Path(tmpdir.name) / 'packages.db')
+    yield database
+
+    database.close()
+    tmpdir.cleanup()
+
+
+@pytest.fixture
+def mgr(db, monkeypatch):
+    """CacheManager over a medias/ tree next to the database."""
+    base = db.db_path.parent
+    monkeypatch.setattr('urpm.core.config.get_media_local_path',
+                        lambda media, base_dir: base_dir / 'medias' / MEDIA_DIR)
+    return CacheManager(db, base)
+
+
+def _media(db, name="Core Release", quota_mb=None):
+    media_id = db.add_media(
+        name=name,
+        short_name=name.lower().replace(' ', '_'),
+        mageia_version="9",
+        architecture="x86_64",
+        relative_path="core/release"
+    )
+    if quota_mb:
+        db.update_media_mirror_settings(media_id, quota_mb=quota_mb)
+    return media_id
+
+
+def _rpm(mgr, media_id, name, size=100, accessed=None):
+    """Write an RPM into the media directory and register it."""
+    path = mgr.medias_dir / MEDIA_DIR / name
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(b'x' * size)
+    mgr.register_file(name, media_id, f'{MEDIA_DIR}/{name}')
+    if accessed is not None:
+        mgr.db.conn.execute(
+            "UPDATE cache_files SET last_accessed = ? WHERE filename = ?",
+            (accessed, name))
+        mgr.db.conn.commit()
+    return path
+
+
+def _usage_from_table(db, media_id=None):
+    where, params = ("WHERE media_id = ?", (media_id,)) if media_id else ("", ())
+    row = db.conn.execute(
+        f"SELECT COALESCE(SUM(file_size), 0), COUNT(*) FROM cache_files {where}",
+        params).fetchone()
+    return {'total_size': row[0], 'file_count': row[1]}
+
+
+class TestUsageIndex:
+    """cache_usage follows every write to cache_files."""
+
+    def test_register_and_delete(self, db):
+        media_id = _media(db)
+        db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        db.register_cache_file('b.rpm', media_id, 'b.rpm', 50)
+        assert db.get_cache_usage(media_id) == {'total_size': 150, 'file_count': 2}
+
+        db.delete_cache_file('a.rpm', media_id)
+        assert db.get_cache_usage(media_id) == _usage_from_table(db, media_id)
+        assert db.get_cache_usage() == {'total_size': 50, 'file_count': 1}
+
+    def test_re_register_replaces_size(self, db):
+        media_id = _media(db)
+        first = db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        second = db.register_cache_file('a.rpm', media_id, 'a.rpm', 70)
+        assert first == second
+        assert db.get_cache_usage(media_id) == {'total_size': 70, 'file_count': 1}
+
+    def test_batch_register_and_delete(self, db):
+        core = _media(db)
+        extra = _media(db, "Tainted Release")
+        db.register_cache_files([('a.rpm', core, 'a.rpm', 10),
+                                 ('b.rpm', extra, 'b.rpm', 20)])
+        assert db.get_cache_usage() == {'total_size': 30, 'file_count': 2}
+        assert db.delete_cache_files([('a.rpm', core), ('gone.rpm', core)]) == 1
+        assert db.get_cache_usage(core) == {'total_size': 0, 'file_count': 0}
+        assert db.get_cache_usage(extra) == _usage_from_table(db, extra)
+
+    def test_media_removal_cascades(self, db):
+        media_id = _media(db)
+        db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        db.remove_media("Core Release")
+        assert db.get_cache_usage() == {'total_size': 0, 'file_count': 0}
+
+    def test_unknown_media(self, db):
+        assert db.get_cache_usage(42) == {'total_size': 0, 'file_count': 0}
+
+    def test_v32_usage_is_backfilled(self, db):
+        media_id = _media(db)
+        db.register_cache_files([('a.rpm', media_id, 'a.rpm', 10),
+                                 ('b.rpm', media_id, 'b.rpm', 20)])
+        db.conn.executescript("""
+            DROP TRIGGER cache_usage_insert;
+            DROP TRIGGER cache_usage_delete;
+            DROP TRIGGER cache_usage_update;
+            DROP TABLE cache_usage;
+            UPDATE schema_info SET version = 32;
+        """)
+        db.conn.commit()
+        db_path = db.db_path
+        db.close()
+
+        reopened = PackageDatabase(db_path)
+        try:
+            assert reopened.get_cache_usage(media_id) == {
+                'total_size': 30, 'file_count': 2}
+            reopened.delete_cache_file('a.rpm', media_id)
+            assert reopened.get_cache_usage(media_id) == {
+                'total_size': 20, 'file_count': 1}
+        finally:
+            reopened.close()
+
+
+class TestAccessBuffer:
+    """Access stamps are written in batches."""
+
+    def _accessed(self, db, name):
+        return db.conn.execute(
+            "SELECT last_accessed FROM cache_files WHERE filename = ?",
+            (name,)).fetchone()[0]
+
+    def test_buffered_until_flush(self, db):
+        media_id = _media(db)
+        db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        db.conn.execute("UPDATE cache_files SET last_accessed = 1")
+        db.conn.commit()
+
+        before = db.conn.total_changes
+        for _ in range(5):
+            db.update_cache_file_access('a.rpm', media_id)
+        assert db.conn.total_changes == before
+        assert self._accessed(db, 'a.rpm') == 1
+
+        assert db.flush_cache_file_access() == 1
+        assert self._accessed(db, 'a.rpm') > 1
+        assert db.flush_cache_file_access() == 0
+
+    def test_flushed_when_batch_is_full(self, db, monkeypatch):
+        monkeypatch.setattr(cache_db, 'ACCESS_FLUSH_BATCH', 3)
+        media_id = _media(db)
+        db.register_cache_files([(f'{i}.rpm', media_id, f'{i}.rpm', 1)
+                                 for i in range(3)])
+        db.conn.execute("UPDATE cache_files SET last_accessed = 1")
+        db.conn.commit()
+
+        db.update_cache_file_access('0.rpm', media_id)
+        db.update_cache_file_access('1.rpm')
+        assert self._accessed(db, '0.rpm') == 1
+        db.update_cache_file_access('2.rpm', media_id)
+        assert all(self._accessed(db, f'{i}.rpm') > 1 for i in range(3))
+
+    def test_buffer_only_written_by_another_handle(self, db, monkeypatch):
+        """urpmd's HTTP handlers only buffer; the scheduler's handle
+        writes the stamps."""
+        monkeypatch.setattr(cache_db, 'ACCESS_FLUSH_BATCH', 1)
+        media_id = _media(db)
+        db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        db.conn.execute("UPDATE cache_files SET last_accessed = 1")
+        db.conn.commit()
+
+        db.update_cache_file_access('a.rpm', flush=False)
+        assert self._accessed(db, 'a.rpm') == 1
+
+        other = PackageDatabase(db.db_path)
+        try:
+            assert other.flush_cache_file_access(db.take_cache_file_access()) == 1
+        finally:
+            other.close()
+        assert self._accessed(db, 'a.rpm') > 1
+        assert db.take_cache_file_access() == {}
+
+    def test_eviction_sees_pending_stamps(self, db):
+        media_id = _media(db)
+        db.register_cache_files([('old.rpm', media_id, 'old.rpm', 1),
+                                 ('new.rpm', media_id, 'new.rpm', 1)])
+        db.conn.execute("UPDATE cache_files SET last_accessed = 1 WHERE filename = 'old.rpm'")
+        db.conn.execute("UPDATE cache_files SET last_accessed = 2 WHERE filename = 'new.rpm'")
+        db.conn.commit()
+
+        db.update_cache_file_access('old.rpm', media_id)
+        assert [f['filename'] for f in db.get_files_to_evict(media_id)] == [
+            'new.rpm', 'old.rpm']
+
+    def test_flushed_on_close(self, db):
+        media_id = _media(db)
+        db.register_cache_file('a.rpm', media_id, 'a.rpm', 100)
+        db.conn.execute("UPDATE cache_files SET last_accessed = 1")
+        db.conn.commit()
+        db.update_cache_file_access('a.rpm', media_id)
+        db.close()
+
+        conn = sqlite3.connect(str(db.db_path))
+        try:
+            assert conn.execute(
+                "SELECT last_accessed FROM cache_files").fetchone()[0] > 1
+        finally:
+            conn.close()
+
+
+class TestEviction:
+    """Candidates come in LRU order and stop at the needed bytes."""
+
+    def test_unreferenced_then_least_recent(self, db):
+        media_id = _media(db)
+        db.register_cache_files([(n, media_id, n, 10) for n in ('a', 'b', 'c')])
+        for name, accessed in (('a', 3), ('b', 1), ('c', 2)):
+            db.conn.execute("UPDATE cache_files SET last_accessed = ? WHERE filename = ?",
+                            (accessed, name))
+        db.mark_cache_files_unreferenced(media_id, ['b', 'c'])
+
+        assert [f['filename'] for f in db.get_files_to_evict(media_id)] == ['a', 'b', 'c']
+        assert [f['filename'] for f in db.get_files_to_evict(max_bytes=15)] == ['a', 'b']
+        assert [f['filename'] for f in db.get_files_to_evict(unreferenced_only=True)] == ['a']
+
+    def test_query_uses_eviction_index(self, db):
+        plan = ' '.join(row[3] for row in db.conn.execute("""
+            EXPLAIN QUERY PLAN SELECT * FROM cache_files WHERE media_id = 1
+            ORDER BY is_referenced ASC, last_accessed ASC
+        """))
+        assert 'idx_cache_files_evict_media' in plan
+        assert 'TEMP B-TREE' not in plan
+
+    def test_media_quota(self, db, mgr):
+        media_id = _media(db, quota_mb=1)
+        _rpm(mgr, media_id, 'old.rpm', size=600 * 1024, accessed=1)
+        _rpm(mgr, media_id, 'new.rpm', size=600 * 1024, accessed=2)
+
+        result = mgr.enforce_quotas()
+
+        assert (result['quota_deleted'], result['quota_bytes']) == (1, 600 * 1024)
+        assert not (mgr.medias_dir / MEDIA_DIR / 'old.rpm').exists()
+        assert (mgr.medias_dir / MEDIA_DIR / 'new.rpm').exists()
+        assert mgr.get_media_usage(media_id) == 600 * 1024
+
+    def test_dry_run_keeps_files(self, db, mgr):
+        media_id = _media(db, quota_mb=1)
+        path = _rpm(mgr, media_id, 'big.rpm', size=2 * 1024 * 1024)
+
+        result = mgr.enforce_quotas(dry_run=True)
+
+        assert result['quota_deleted'] == 1
+        assert path.exists()
+        assert mgr.get_media_usage(media_id) == 2 * 1024 * 1024
+
+    def test_unreferenced_removed(self, db, mgr):
+        media_id = _media(db)
+        _rpm(mgr, media_id, 'keep.rpm')
+        gone = _rpm(mgr, media_id, 'gone.rpm')
+        mgr.mark_unreferenced(media_id, ['keep.rpm'])
+
+        result = mgr.enforce_quotas()
+
+        assert (result['unreferenced_deleted'], result['errors']) == (1, [])
+        assert not gone.exists()
+        assert [f['filename'] for f in db.list_cache_files()] == ['keep.rpm']
+
+    def test_evict_for_space(self, db, mgr):
+        media_id = _media(db)
+        first = _rpm(mgr, media_id, 'a.rpm', size=100, accessed=1)
+        _rpm(mgr, media_id, 'b.rpm', size=100, accessed=2)
+
+        assert mgr.evict_for_space(50, media_id=media_id) == (True, 100)
+        assert not first.exists()
+        assert mgr.evict_for_space(500) == (False, 100)
+
+
+class TestReconcile:
+    """The table is brought back in line with the media directories."""
+
+    def test_orphans_and_untracked(self, db, mgr):
+        media_id = _media(db)
+        _rpm(mgr, media_id, 'kept.rpm')
+        _rpm(mgr, media_id, 'deleted.rpm').unlink()
+        (mgr.medias_dir / MEDIA_DIR / 'copied.rpm').write_bytes(b'x' * 30)
+
+        result = mgr.reconcile()
+
+        assert result == {'orphan_records_removed': 1, 'untracked_files_added': 1}
+        assert sorted(f['filename'] for f in db.list_cache_files()) == [
+            'copied.rpm', 'kept.rpm']
+        assert db.get_cache_usage(media_id) == {'total_size': 130, 'file_count': 2}
+
+    def test_moved_file_is_re_registered(self, db, mgr):
+        media_id = _media(db)
+        db.register_cache_file('moved.rpm', media_id, 'elsewhere/moved.rpm', 10)
+        path = mgr.medias_dir / MEDIA_DIR / 'moved.rpm'
+        path.parent.mkdir(parents=True)
+        path.write_bytes(b'x' * 10)
+
+        mgr.reconcile()
+
+        assert [f['file_path'] for f in db.list_cache_files()] == [
+            f'{MEDIA_DIR}/moved.rpm']
+
+    def test_in_sync_is_noop(self, db, mgr):
+        media_id = _media(db)
+        _rpm(mgr, media_id, 'a.rpm')
+        before = db.conn.total_changes
+        assert mgr.reconcile() == {'orphan_records_removed': 0,
+                                   'untracked_files_added': 0}
+        assert db.conn.total_changes == before
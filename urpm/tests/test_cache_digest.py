@@ -0,0 +1,208 @@
+"""Tests for peer cache digests (Bloom filter of served RPMs)"""
+
+import tempfile
+import threading
+from pathlib import Path
+
+import pytest
+
+from urpm.core.cache_digest import CacheDigest
+from urpm.core.peer_client import Peer, PeerClient
+from urpm.daemon.daemon import UrpmDaemon
+from urpm.daemon.server import UrpmdServer
+
+MEDIA_DIR = 'official/10/x86_64/media/core/release'
+
+
+def _names(prefix, n):
+    return [f'{prefix}{i}-1.0-1.mga10.x86_64.rpm' for i in range(n)]
+
+
+class TestCacheDigest:
+    """Bloom filter behaviour and wire format."""
+
+    def test_no_false_negatives(self):
+        names = _names('pkg', 2000)
+        digest = CacheDigest.build(names)
+        assert all(name in digest for name in names)
+
+    def test_false_positive_rate(self):
+        digest = CacheDigest.build(_names('pkg', 2000))
+        others = _names('other', 10000)
+        false_positives = sum(1 for name in others if name in digest)
+        assert false_positives < 300   # target is 1%, allow 3%
+
+    def test_empty(self):
+        digest = CacheDigest.build([])
+        assert 'foo-1.0-1.mga10.x86_64.rpm' not in digest
+
+    def test_round_trip(self):
+        digest = CacheDigest.build(_names('pkg', 100))
+        copy = CacheDigest.from_dict(digest.to_dict())
+        assert copy.id == digest.id
+        assert copy.count == 100
+        assert all(name in copy for name in _names('pkg', 100))
+
+    def test_id_follows_content(self):
+        assert (CacheDigest.build(['a.rpm']).id
+                == CacheDigest.build(['a.rpm']).id)
+        assert (CacheDigest.build(['a.rpm']).id
+                != CacheDigest.build(['b.rpm']).id)
+
+    @pytest.mark.parametrize('data', [
+        {},
+        {'format': 99, 'bits': 1024, 'hashes': 7, 'data': ''},
+        {'format': 1, 'bits': 1024, 'hashes': 7, 'data': 'not base64!'},
+        {'format': 1, 'bits': 4096, 'hashes': 7,
+         'data': CacheDigest.build([]).to_dict()['data']},
+    ])
+    def test_malformed(self, data):
+        assert CacheDigest.from_dict(data) is None
+
+
+@pytest.fixture
+def peer():
+    """A urpmd serving two cached RPMs over HTTP on a free port."""
+    tmpdir = tempfile.TemporaryDirectory()
+    base = Path(tmpdir.name)
+    media = base / 'medias' / MEDIA_DIR
+    media.mkdir(parents=True)
+    for name in ('foo-1.0-1.mga10.x86_64.rpm', 'bar-2.0-1.mga10.x86_64.rpm'):
+        (media / name).write_bytes(b'rpm')
+
+    daemon = UrpmDaemon(db_path=':memory:', base_dir=str(base),
+                        host='127.0.0.1', port=0,
+                        pid_file=str(base / 'urpmd.pid'), dev_mode=True)
+    have_queries = []
+    check_have = daemon.check_have_packages
+
+    def counting_check_have(packages, **kwargs):
+        have_queries.append(list(packages))
+        return check_have(packages, **kwargs)
+
+    daemon.check_have_packages = counting_check_have
+
+    server = UrpmdServer(host='127.0.0.1', port=0)
+    server.start_background(daemon)
+    port = server.server.server_address[1]
+    yield Peer(host='127.0.0.1', port=port), daemon, have_queries
+
+    server.stop()
+    tmpdir.cleanup()
+
+
+class TestDigestConcurrency:
+    """The digest never misses a file indexed before an invalidation."""
+
+    @pytest.fixture
+    def daemon(self, tmp_path):
+        media = tmp_path / 'medias' / MEDIA_DIR
+        media.mkdir(parents=True)
+        (media / 'foo-1.0-1.mga10.x86_64.rpm').write_bytes(b'rpm')
+        return UrpmDaemon(db_path=':memory:', base_dir=str(tmp_path),
+                          host='127.0.0.1', port=0,
+                          pid_file=str(tmp_path / 'urpmd.pid'), dev_mode=True)
+
+    def test_invalidate_during_build(self, daemon, monkeypatch):
+        media = daemon.base_dir / 'medias' / MEDIA_DIR
+        build = daemon._build_rpm_index
+        calls = []
+
+        def racing_build():
+            index = build()
+            if not calls:
+                # A download lands and is announced while this build runs
+                (media / 'baz-3.0-1.mga10.x86_64.rpm').write_bytes(b'rpm')
+                daemon.invalidate_rpm_index()
+            calls.append(index)
+            return index
+
+        monkeypatch.setattr(daemon, '_build_rpm_index', racing_build)
+        digest = daemon.get_cache_digest()
+        assert 'baz-3.0-1.mga10.x86_64.rpm' in digest
+        assert daemon.get_cache_digest() is digest
+        assert 'baz-3.0-1.mga10.x86_64.rpm' in daemon._get_rpm_index()
+
+    def test_concurrent_builds_and_invalidations(self, daemon):
+        media = daemon.base_dir / 'medias' / MEDIA_DIR
+        names = _names('pkg', 40)
+        errors = []
+        done = threading.Event()
+
+        def add_files():
+            for name in names:
+                (media / name).write_bytes(b'rpm')
+                daemon.invalidate_rpm_index()
+            done.set()
+
+        def read_digests():
+            try:
+                while not done.is_set():
+                    daemon.get_cache_digest()
+                    daemon.check_have_packages(names[:3])
+            except Exception as e:
+                errors.append(e)
+
+        readers = [threading.Thread(target=read_digests) for _ in range(4)]
+        for t in readers:
+            t.start()
+        add_files()
+        for t in readers:
+            t.join()
+
+        assert errors == []
+        digest = daemon.get_cache_digest()
+        assert all(name in digest for name in names)
+
+
+class TestPeerQueries:
+    """Clients only confirm digest hits with /api/have."""
+
+    def test_only_hits_are_confirmed(self, peer):
+        p, _, have_queries = peer
+        wanted = ['foo-1.0-1.mga10.x86_64.rpm'] + _names('missing', 200)
+
+        result = PeerClient().query_peers_have([p], wanted)
+
+        assert [info.path for info in result['foo-1.0-1.mga10.x86_64.rpm']] == [
+            f'{MEDIA_DIR}/foo-1.0-1.mga10.x86_64.rpm']
+        assert all(not result[name] for name in wanted[1:])
+        assert len(have_queries) == 1
+        assert 'foo-1.0-1.mga10.x86_64.rpm' in have_queries[0]
+        assert len(have_queries[0]) < 20
+
+    def test_no_hit_no_query(self, peer):
+        p, _, have_queries = peer
+        result = PeerClient().query_peers_have([p], _names('missing', 50))
+        assert all(not infos for infos in result.values())
+        assert have_queries == []
+
+    def test_digest_revalidated_after_invalidation(self, peer):
+        p, daemon, _ = peer
+        client = PeerClient()
+        first = client.get_peer_digest(p)
+        assert client.get_peer_digest(p) is first
+
+        (Path(daemon.base_dir) / 'medias' / MEDIA_DIR
+         / 'baz-3.0-1.mga10.x86_64.rpm').write_bytes(b'rpm')
+        daemon.invalidate_rpm_index()
+        p.cache_digest = daemon.get_cache_digest().id
+
+        second = client.get_peer_digest(p)
+        assert second.id != first.id
+        assert 'baz-3.0-1.mga10.x86_64.rpm' in second
+
+    def test_unchanged_digest_is_kept(self, peer):
+        p, daemon, _ = peer
+        client = PeerClient()
+        first = client.get_peer_digest(p)
+        p.cache_digest = 'announced-elsewhere'
+        assert client.get_peer_digest(p) is first
+
+    def test_peer_without_digest_gets_full_list(self, peer, monkeypatch):
+        p, _, have_queries = peer
+        client = PeerClient()
+        monkeypatch.setattr(client, 'get_peer_digest', lambda peer: None)
+        wanted = _names('missing', 5)
+        client.query_peers_have([p], wanted)
+        assert have_queries == [wanted]
@@ -4,7 +4,7 @@ import pytest
 import sqlite3
 import tempfile
 from pathlib import Path
-from urpm.core.database import PackageDatabase
+from urpm.core.database import PackageDatabase, ReadConnectionPool, _in_list
 
 
 @pytest.fixture
@@ -953,6 +953,281 @@ class TestGetPackageExact:
         ) is None
 
 
+class TestGetPackagesInfo:
+    """Tests for batched get_packages_info()."""
+
+    def _import(self, db):
+        media_id = db.add_media(
+            name="Core Release",
+            short_name="core_release",
+            mageia_version="9",
+            architecture="x86_64",
+            relative_path="core/release"
+        )
+        packages = []
+        for name, version, desc in [
+            ('vim', '9.0', 'Old vim'),
+            ('vim', '9.1', 'New vim'),
+            ('nano', '7.2', 'Small editor'),
+        ]:
+            packages.append({
+                'name': name,
+                'version': version,
+                'release': '1.mga9',
+                'epoch': 0,
+                'arch': 'x86_64',
+                'nevra': f'{name}-{version}-1.mga9.x86_64',
+                'summary': f'{name} summary',
+                'description': desc,
+                'url': f'https://{name}.example.org',
+                'license': 'GPLv2',
+                'provides': [name],
+                'requires': [],
+                'filesize': 1000,
+            })
+        db.import_packages(iter(packages), media_id=media_id)
+
+    def test_returns_latest_in_input_order(self, db):
+        self._import(db)
+        infos = db.get_packages_info(['nano', 'vim'])
+        assert [p['name'] for p in infos] == ['nano', 'vim']
+        assert infos[1]['version'] == '9.1'
+        assert infos[1]['description'] == 'New vim'
+        assert infos[0]['url'] == 'https://nano.example.org'
+        assert infos[0]['license'] == 'GPLv2'
+
+    def test_matches_get_package(self, db):
+        self._import(db)
+        single = db.get_package('vim')
+        batch = db.get_packages_info(['vim'])[0]
+        assert batch['nevra'] == single['nevra']
+        assert 'requires' not in batch
+
+    def test_unknown_and_duplicate_names(self, db):
+        self._import(db)
+        infos = db.get_packages_info(['nosuch', 'VIM', 'vim'])
+        assert [p['name'] for p in infos] == ['vim']
+
+    def test_empty_input(self, db):
+        assert db.get_packages_info([]) == []
+
+
+class TestWhatrequiresAny:
+    """Tests for batched whatrequires_any()."""
+
+    def _import(self, db):
+        packages = []
+        for name, requires in [
+            ('gimp', ['libgtk3', 'babl']),
+            ('inkscape', ['libgtk3']),
+            ('darktable', ['babl']),
+            ('vim', ['ncurses']),
+        ]:
+            packages.append({
+                'name': name,
+                'version': '1.0',
+                'release': '1.mga9',
+                'epoch': 0,
+                'arch': 'x86_64',
+                'nevra': f'{name}-1.0-1.mga9.x86_64',
+                'summary': f'{name} summary',
+                'provides': [name],
+                'requires': requires,
+                'filesize': 1000,
+            })
+        for short in ('core_release', 'core_updates'):
+            media_id = db.add_media(
+                name=short,
+                short_name=short,
+                mageia_version="9",
+                architecture="x86_64",
+                relative_path=short.replace('_', '/')
+            )
+            db.import_packages(iter(packages), media_id=media_id)
+
+    def test_union_deduplicated(self, db):
+        self._import(db)
+        names = [p['name'] for p in db.whatrequires_any(['libgtk3', 'babl'])]
+        assert names == ['darktable', 'gimp', 'inkscape']
+
+    def test_matches_single_lookup(self, db):
+        self._import(db)
+        single = {p['nevra'] for p in db.whatrequires('babl')}
+        batch = {p['nevra'] for p in db.whatrequires_any(['babl', 'babl'])}
+        assert batch == single
+        assert db.whatrequires_any(['babl'])[0]['summary'] == 'darktable summary'
+
+    def test_limit(self, db):
+        self._import(db)
+        assert len(db.whatrequires_any(['libgtk3', 'babl'], limit=1)) == 1
+
+    def test_empty_input(self, db):
+        assert db.whatrequires_any([]) == []
+
+
+class TestWhatprovidesAny:
+    """Tests for whatprovides_any() and the provides-name index."""
+
+    def _import(self, db):
+        media_id = db.add_media(
+            name="Core Release",
+            short_name="core_release",
+            mageia_version="9",
+            architecture="x86_64",
+            relative_path="core/release"
+        )
+        packages = []
+        for name, provides in [
+            ('libfoo1', ['libfoo.so.1()(64bit)', 'libfoo1[== 1.0-1.mga9]']),
+            ('evince', ['mimehandler(application/pdf)', 'evince[== 1.0-1.mga9]']),
+            ('fonts-dejavu', ['font(:lang=en)', 'font(dejavusans)']),
+            ('kmod-e1000', ['modalias(pci:v00008086d0000100Esv*sd*bc*sc*i*)']),
+        ]:
+            packages.append({
+                'name': name,
+                'version': '1.0',
+                'release': '1.mga9',
+                'epoch': 0,
+                'arch': 'x86_64',
+                'nevra': f'{name}-1.0-1.mga9.x86_64',
+                'summary': f'{name} summary',
+                'provides': provides,
+                'requires': [],
+                'filesize': 1000,
+            })
+        db.import_packages(iter(packages), media_id=media_id)
+
+    def test_versioned_provide_matches_bare_name(self, db):
+        self._import(db)
+        result = db.whatprovides_any(['evince'])
+        assert [p['name'] for p in result] == ['evince']
+        assert result[0]['matched_provide'] == 'evince'
+
+    def test_several_capabilities(self, db):
+        self._import(db)
+        result = db.whatprovides_any([
+            'libfoo.so.1()(64bit)', 'font(:lang=en)', 'mimehandler(application/pdf)',
+        ])
+        assert [p['name'] for p in result] == ['evince', 'fonts-dejavu', 'libfoo1']
+        assert all('installed' in p for p in result)
+
+    def test_modalias_glob(self, db):
+        self._import(db)
+        hit = db.whatprovides_any(
+            ['modalias(pci:v00008086d0000100Esv00001028sd00000002bc02sc00i00)'])
+        assert [p['name'] for p in hit] == ['kmod-e1000']
+        miss = db.whatprovides_any(
+            ['modalias(pci:v000010ECd00008139sv00001028sd00000002bc02sc00i00)'])
+        assert miss == []
+
+    def test_unknown_and_empty(self, db):
+        self._import(db)
+        assert db.whatprovides_any(['nosuchcap']) == []
+        assert db.whatprovides_any([]) == []
+
+    def test_provide_name(self):
+        from urpm.core.database import provide_name
+        assert provide_name('foo[== 1.0]') == 'foo'
+        assert provide_name('foo >= 1.0') == 'foo'
+        assert provide_name('font(:lang=en)') == 'font(:lang=en)'
+        assert provide_name('libc.so.6()(64bit)') == 'libc.so.6()(64bit)'
+
+
+class TestIncrementalImport:
+    """Tests for the diffing re-import of a media."""
+
+    def _pkg(self, name, version='1.0', summary=None, requires=()):
+        return {
+            'name': name,
+            'version': version,
+            'release': '1.mga9',
+            'epoch': 0,
+            'arch': 'x86_64',
+            'nevra': f'{name}-{version}-1.mga9.x86_64',
+            'summary': summary or f'{name} summary',
+            'provides': [f'{name}[== {version}-1.mga9]'],
+            'requires': list(requires),
+            'filesize': 1000,
+        }
+
+    def _media(self, db):
+        return db.add_media(
+            name="Core Updates",
+            short_name="core_updates",
+            mageia_version="9",
+            architecture="x86_64",
+            relative_path="core/updates"
+        )
+
+    def _rows(self, db, media_id):
+        return {row['nevra']: row['id'] for row in db.conn.execute(
+            "SELECT id, nevra FROM packages WHERE media_id = ?", (media_id,))}
+
+    def test_unchanged_rows_kept(self, db):
+        media_id = self._media(db)
+        packages = [self._pkg(f'pkg{i}') for i in range(10)]
+        db.import_packages(iter(packages), media_id=media_id)
+        before = self._rows(db, media_id)
+
+        packages.append(self._pkg('newpkg'))
+        assert db.import_packages(iter(packages), media_id=media_id) == 11
+        after = self._rows(db, media_id)
+        assert {n: after[n] for n in before} == before
+        assert 'newpkg-1.0-1.mga9.x86_64' in after
+        assert [p['name'] for p in db.whatprovides_any(['newpkg'])] == ['newpkg']
+
+    def test_obsolete_removed_with_deps(self, db):
+        media_id = self._media(db)
+        db.import_packages(iter([self._pkg('vim', requires=['ncurses']),
+                                 self._pkg('nano')]), media_id=media_id)
+        db.import_packages(iter([self._pkg('nano'),
+                                 self._pkg('vim', '9.1', requires=['ncurses'])]),
+                           media_id=media_id)
+        assert set(self._rows(db, media_id)) == {
+            'nano-1.0-1.mga9.x86_64', 'vim-9.1-1.mga9.x86_64'}
+        assert db.conn.execute(
+            "SELECT COUNT(*) FROM requires").fetchone()[0] == 1
+        assert db.conn.execute(
+            "SELECT COUNT(*) FROM provides").fetchone()[0] == 2
+
+    def test_changed_content_rewritten(self, db):
+        media_id = self._media(db)
+        db.import_packages(iter([self._pkg('vim', requires=['ncurses'])]),
+                           media_id=media_id)
+        pkg_id = self._rows(db, media_id)['vim-1.0-1.mga9.x86_64']
+        db.import_packages(iter([self._pkg('vim', requires=['libacl'])]),
+                           media_id=media_id)
+        assert self._rows(db, media_id)['vim-1.0-1.mga9.x86_64'] == pkg_id
+        assert [r[0] for r in db.conn.execute(
+            "SELECT capability FROM requires WHERE pkg_id = ?", (pkg_id,))] == \
+            ['libacl']
+
+    def test_search_index_follows_small_diff(self, db):
+        media_id = self._media(db)
+        packages = [self._pkg(f'pkg{i}') for i in range(20)]
+        packages.append(self._pkg('vim', summary='Text editor'))
+        db.import_packages(iter(packages), media_id=media_id)
+
+        # One changed summary, one new and one dropped package: below
+        # the rebuild ratio, so the FTS index is updated row by row
+        packages = packages[1:-1] + [self._pkg('vim', summary='Visual editor'),
+                                     self._pkg('emacs', summary='Lisp editor')]
+        db.import_packages(iter(packages), media_id=media_id)
+        assert sorted(p['name'] for p in db.search('editor')) == ['emacs', 'vim']
+        assert db.search('text') == []
+        assert db.search('pkg0') == []
+        db.conn.execute(
+            "INSERT INTO packages_fts(packages_fts) VALUES('integrity-check')")
+
+    def test_no_change_is_noop(self, db):
+        media_id = self._media(db)
+        packages = [self._pkg('vim')]
+        db.import_packages(iter(packages), media_id=media_id)
+        before = db.conn.total_changes
+        db.import_packages(iter(packages), media_id=media_id)
+        assert db.conn.total_changes == before
+
+
 class TestUnregisterCacheFile:
     """Tests for the path-based cache record removal helper used by
     the resilient install pipeline when a corrupt RPM is purged.
@@ -1040,7 +1315,8 @@ class TestSchemaV30Migration:
 
     def test_fresh_db_bootstraps_to_v30(self, db):
         from urpm.core.database import SCHEMA_VERSION
-        assert SCHEMA_VERSION == 30
+        # Pinned to the current version in TestSchemaV31Migration
+        assert SCHEMA_VERSION >= 30
         # Bootstrap path through CREATE TABLE IF NOT EXISTS:
         self._expected_v30_shape(db)
 
@@ -1077,6 +1353,13 @@ class TestSchemaV30Migration:
                 added_time INTEGER NOT NULL,
                 UNIQUE(filename, media_id)
             );
+            CREATE TABLE provides (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                pkg_id INTEGER NOT NULL,
+                capability TEXT NOT NULL,
+                operator TEXT,
+                version TEXT
+            );
             CREATE TABLE schema_info (
                 version INTEGER PRIMARY KEY
             );
@@ -1096,6 +1379,128 @@ class TestSchemaV30Migration:
             db_path.unlink(missing_ok=True)
 
 
+class TestSchemaV31Migration:
+    """Tests for the v30 → v31 schema bump (provides-name index)."""
+
+    def test_fresh_db_bootstraps_to_v31(self, db):
+        from urpm.core.database import SCHEMA_VERSION
+        assert SCHEMA_VERSION >= 31
+        conn = db._get_connection()
+        cols = {r[1] for r in conn.execute("PRAGMA table_info(provides)")}
+        assert "name" in cols
+        idx = conn.execute(
+            "SELECT name FROM sqlite_master "
+            "WHERE type='index' AND name='idx_provides_name'"
+        ).fetchone()
+        assert idx is not None
+
+    def test_v30_provides_are_backfilled(self, monkeypatch):
+        import tempfile
+        import sqlite3
+        from pathlib import Path
+        from urpm.core.database import PackageDatabase, provide_name
+
+        with tempfile.NamedTemporaryFile(suffix='.db', delete=False) as f:
+            db_path = Path(f.name)
+
+        caps = ['foo[== 1.0-1.mga9]', 'libfoo.so.1()(64bit)',
+                'font(:lang=en)', 'bar >= 2', 'baz[*]']
+        raw = sqlite3.connect(str(db_path))
+        raw.executescript("""
+            CREATE TABLE provides (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                pkg_id INTEGER NOT NULL,
+                capability TEXT NOT NULL,
+                operator TEXT,
+                version TEXT
+            );
+            CREATE TABLE schema_info (
+                version INTEGER PRIMARY KEY
+            );
+            INSERT INTO schema_info (version) VALUES (30);
+        """)
+        raw.executemany(
+            "INSERT INTO provides (pkg_id, capability) VALUES (1, ?)",
+            [(c,) for c in caps]
+        )
+        raw.commit()
+        raw.close()
+
+        monkeypatch.setattr(
+            'urpm.core.config.get_system_version', lambda: '10',
+        )
+        db = PackageDatabase(db_path)
+        try:
+            rows = db._get_connection().execute(
+                "SELECT capability, name FROM provides ORDER BY id"
+            ).fetchall()
+            # SQL backfill and import-time helper agree
+            assert [r[1] for r in rows] == [provide_name(c) for c in caps]
+            assert [r[1] for r in rows] == [
+                'foo', 'libfoo.so.1()(64bit)', 'font(:lang=en)', 'bar', 'baz',
+            ]
+        finally:
+            db.close()
+            db_path.unlink(missing_ok=True)
+
+
+class TestSchemaV32Migration:
+    """Tests for the v31 → v32 schema bump (search prefix indexes)."""
+
+    def _assert_v32_shape(self, conn):
+        sql = conn.execute(
+            "SELECT sql FROM sqlite_master WHERE name='packages_fts'"
+        ).fetchone()[0]
+        assert "prefix = '2 3'" in sql
+        assert conn.execute(
+            "SELECT name FROM sqlite_master "
+            "WHERE type='index' AND name='idx_provides_name_lower'"
+        ).fetchone() is not None
+
+    def test_fresh_db_bootstraps_to_v32(self, db):
+        from urpm.core.database import SCHEMA_VERSION
+        assert SCHEMA_VERSION >= 32
+        self._assert_v32_shape(db._get_connection())
+
+    def test_v31_fts_is_rebuilt(self, db):
+        media_id = db.add_media(
+            name="Core Release", short_name="core_release",
+            mageia_version="9", architecture="x86_64",
+            relative_path="core/release"
+        )
+        db.import_packages(iter([{
+            'name': 'firefox', 'version': '1.0', 'release': '1.mga9',
+            'epoch': 0, 'arch': 'x86_64', 'nevra': 'firefox-1.0-1.mga9.x86_64',
+            'summary': 'Web browser', 'provides': ['firefox'],
+            'requires': [], 'filesize': 1000,
+        }]), media_id=media_id)
+
+        # Take the database back to the v31 shape
+        db.conn.executescript("""
+            DROP INDEX idx_provides_name_lower;
+            DROP TABLE packages_fts;
+            CREATE VIRTUAL TABLE packages_fts USING fts5(
+                name, summary, description,
+                content = 'packages', content_rowid = 'id'
+            );
+            INSERT INTO packages_fts(packages_fts) VALUES('rebuild');
+            UPDATE schema_info SET version = 31;
+        """)
+        db.conn.commit()
+        db_path = db.db_path
+        db.close()
+
+        reopened = PackageDatabase(db_path)
+        try:
+            conn = reopened._get_connection()
+            self._assert_v32_shape(conn)
+            assert [p['name'] for p in reopened.search_prefix('web')] == ['firefox']
+            conn.execute(
+                "INSERT INTO packages_fts(packages_fts) VALUES('integrity-check')")
+        finally:
+            reopened.close()
+
+
 class TestSecurityBlacklist:
     """Tests for the iteration-B security blacklist (bug #3)."""
 
@@ -1446,3 +1851,385 @@ class TestReadOnlyKwarg:
             assert any(m['name'] == "Core Release" for m in rows)
         finally:
             db.close()
+
+
+class TestReadPool:
+    """Tests for enable_read_pool() and pooled read queries."""
+
+    def _import(self, db, names=('vim', 'nano', 'emacs')):
+        media_id = db.add_media(
+            name="Core Release",
+            short_name="core_release",
+            mageia_version="9",
+            architecture="x86_64",
+            relative_path="core/release"
+        )
+        db.import_packages(iter([{
+            'name': name,
+            'version': '1.0',
+            'release': '1.mga9',
+            'epoch': 0,
+            'arch': 'x86_64',
+            'nevra': f'{name}-1.0-1.mga9.x86_64',
+            'summary': f'{name} editor',
+            'provides': [name, 'editor'],
+            'requires': ['libc'],
+            'filesize': 1000,
+        } for name in names]), media_id=media_id)
+        return media_id
+
+    def test_queries_use_pooled_connection(self, db):
+        self._import(db)
+        db.enable_read_pool(2)
+        seen = []
+        original = db._read_conn
+
+        def spy():
+            conn = original()
+            seen.append(conn)
+            return conn
+
+        db._read_conn = spy
+        assert [p['name'] for p in db.whatrequires_any(['libc'])] == [
+            'emacs', 'nano', 'vim']
+        assert seen and all(conn is not db.conn for conn in seen)
+        # Lease returned once the call is over
+        assert db._read_conn is spy and original() is db.conn
+
+    def test_results_match_unpooled(self, db):
+        self._import(db)
+        before = (db.get_packages_info(['vim', 'nano']),
+                  [p['nevra'] for p in db.whatprovides_any(['editor'])],
+                  [p['nevra'] for p in db.whatprovides('vim')])
+        db.enable_read_pool(2)
+        after = (db.get_packages_info(['vim', 'nano']),
+                 [p['nevra'] for p in db.whatprovides_any(['editor'])],
+                 [p['nevra'] for p in db.whatprovides('vim')])
+        assert after == before
+
+    def test_reads_not_blocked_by_open_write(self, db):
+        """A pooled reader sees the committed state while a write is open."""
+        self._import(db)
+        db.enable_read_pool(2)
+        writer = db._get_connection()
+        writer.execute("BEGIN IMMEDIATE")
+        writer.execute("DELETE FROM packages WHERE name = 'vim'")
+        try:
+            import threading
+            found = []
+            reader = threading.Thread(
+                target=lambda: found.extend(db.whatprovides('vim')))
+            reader.start()
+            reader.join(timeout=5)
+            assert not reader.is_alive()
+            assert [p['name'] for p in found] == ['vim']
+        finally:
+            writer.rollback()
+
+    def test_own_transaction_stays_on_main_connection(self, db):
+        self._import(db)
+        db.enable_read_pool(2)
+        db.conn.execute("BEGIN")
+        db.conn.execute("DELETE FROM packages WHERE name = 'vim'")
+        try:
+            assert db.whatprovides('vim') == []
+        finally:
+            db.conn.rollback()
+
+    def test_pool_is_bounded(self, tmp_path):
+        opened = []
+
+        def factory():
+            conn = sqlite3.connect(':memory:', check_same_thread=False)
+            opened.append(conn)
+            return conn
+
+        pool = ReadConnectionPool(factory, 2)
+        a, b = pool.acquire(), pool.acquire()
+        import threading
+        got = []
+        waiter = threading.Thread(target=lambda: got.append(pool.acquire()))
+        waiter.start()
+        waiter.join(timeout=0.1)
+        assert waiter.is_alive() and not got
+        pool.release(a)
+        waiter.join(timeout=5)
+        assert got == [a] and len(opened) == 2
+        pool.release(b)
+        pool.release(got[0])
+        pool.close()
+
+    def test_in_list_padding(self):
+        placeholders, params = _in_list(['a', 'b', 'c'])
+        assert placeholders.count('?') == 8
+        assert params == ('a', 'b', 'c') + (None,) * 5
+        assert _in_list(range(9))[0].count('?') == 16
+        assert _in_list(range(600))[0].count('?') == 600
+
+    def test_close_releases_pool(self, db):
+        self._import(db)
+        db.enable_read_pool(2)
+        db.search('vim')
+        db.close()
+        assert db._read_pool is None
+
+
+class TestListPackagesPage:
+    """Tests for the keyset-paginated catalog listing."""
+
+    def _import(self, db):
+        rows = [('vim', '9.0', 'x86_64'), ('vim', '9.1', 'x86_64'),
+                ('nano', '7.2', 'x86_64'), ('nano', '7.2', 'i686'),
+                ('emacs', '29.1', 'x86_64'), ('bash', '5.2', 'x86_64'),
+                ('fonts-dejavu', '2.37', 'noarch')]
+        packages = [{
+            'name': name,
+            'version': version,
+            'release': '1.mga9',
+            'epoch': 0,
+            'arch': arch,
+            'nevra': f'{name}-{version}-1.mga9.{arch}',
+            'summary': f'{name} summary',
+            'provides': [name],
+            'requires': [],
+            'filesize': 1000,
+        } for name, version, arch in rows]
+        for short in ('core_release', 'core_updates'):
+            media_id = db.add_media(
+                name=short,
+                short_name=short,
+                mageia_version="9",
+                architecture="x86_64",
+                relative_path=short.replace('_', '/')
+            )
+            db.import_packages(iter(packages), media_id=media_id)
+
+    def _walk(self, db, limit, **kwargs):
+        pages, key = [], ''
+        while True:
+            packages, key = db.list_packages_page(key, limit, **kwargs)
+            pages.append(packages)
+            if not key:
+                return pages
+
+    def test_pages_cover_catalog_once(self, db):
+        self._import(db)
+        pages = self._walk(db, 2)
+        assert len(pages) == 3
+        nevras = [p['nevra'] for page in pages for p in page]
+        # Duplicate media rows collapse, every NEVRA appears once
+        assert len(nevras) == len(set(nevras)) == 7
+        names = [p['name'] for page in pages for p in page]
+        assert names == sorted(names, key=str.lower)
+
+    def test_page_is_by_name(self, db):
+        self._import(db)
+        packages, key = db.list_packages_page('', 1)
+        assert {p['name'] for p in packages} == {'bash'}
+        assert key == 'bash'
+        packages, _key = db.list_packages_page('fonts-dejavu', 1)
+        assert [p['version'] for p in packages
+                if p['arch'] == 'x86_64'] == ['7.2']
+
+    def test_newest_and_arch_filters(self, db):
+        self._import(db)
+        pages = self._walk(db, 10, newest=True,
+                           arches=['x86_64', 'noarch'])
+        vims = [p['version'] for p in pages[0] if p['name'] == 'vim']
+        assert vims == ['9.1']
+        assert {p['arch'] for p in pages[0]} == {'x86_64', 'noarch'}
+        pages = self._walk(db, 10, arches=['x86_64', 'noarch'],
+                           exclude_arches=True)
+        assert [p['nevra'] for p in pages[0]] == ['nano-7.2-1.mga9.i686']
+
+    def test_empty_catalog(self, db):
+        assert db.list_packages_page('', 10) == ([], '')
+
+    def _installed(self, db, *nevras):
+        db._installed_pkgs_cache = {}
+        for name, version, arch in nevras:
+            nevra = f'{name}-{version}-1.mga9.{arch}'
+            db._installed_pkgs_cache[nevra] = {
+                'name': name, 'epoch': 0, 'version': version,
+                'release': '1.mga9', 'arch': arch, 'nevra': nevra,
+                'summary': f'{name} summary',
+            }
+
+    def test_installed_by_nevra(self, db):
+        self._import(db)
+        self._installed(db, ('vim', '9.0', 'x86_64'))
+        packages, _key = db.list_packages_page('', 10)
+        vims = {p['version']: p['installed'] for p in packages
+                if p['name'] == 'vim'}
+        assert vims == {'9.0': True, '9.1': False}
+
+    def test_installed_filters(self, db):
+        from urpm.core.operations import PackageOperations
+        self._import(db)
+        # foo-1.0 installed, foo-2.0 in a medium
+        media_id = db.get_media('core_updates')['id']
+        db.import_packages(iter([{
+            'name': 'foo', 'version': '2.0', 'release': '1.mga9',
+            'epoch': 0, 'arch': 'x86_64', 'nevra': 'foo-2.0-1.mga9.x86_64',
+            'summary': 'foo summary', 'provides': ['foo'], 'requires': [],
+            'filesize': 1000,
+        }]), media_id=media_id)
+        self._installed(db, ('foo', '1.0', 'x86_64'))
+        ops = PackageOperations(db, base_dir=Path('/nonexistent'))
+
+        def listed(filters):
+            packages, _key = ops.list_packages(filters, '', 10)
+            return [(p['nevra'], p['installed']) for p in packages
+                    if p['name'] == 'foo']
+
+        assert listed('none') == [('foo-2.0-1.mga9.x86_64', False),
+                                  ('foo-1.0-1.mga9.x86_64', True)]
+        assert listed('~installed') == [('foo-2.0-1.mga9.x86_64', False)]
+        assert listed('installed') == [('foo-1.0-1.mga9.x86_64', True)]
+        assert listed('newest') == [('foo-2.0-1.mga9.x86_64', False)]
+
+    def test_installed_only_names_are_paged(self, db):
+        self._import(db)
+        self._installed(db, ('aaa-local', '1.0', 'x86_64'),
+                        ('zzz-local', '1.0', 'x86_64'))
+        pages, key = [], ''
+        while True:
+            packages, key = db.list_packages_page(key, 2, with_installed=True)
+            pages.append(packages)
+            if not key:
+                break
+        names = [p['name'] for page in pages for p in page]
+        assert names[0] == 'aaa-local' and names[-1] == 'zzz-local'
+        assert len({p['nevra'] for page in pages for p in page}) == 9
+        assert all(len({p['name'] for p in page}) <= 2
+                   for page in pages)
+
+
+class TestSearchPrefix:
+    """Tests for the ranked, bounded search-as-you-type query."""
+
+    def _pkg(self, name, summary=None, provides=(), media='9'):
+        return {
+            'name': name,
+            'version': '1.0',
+            'release': f'1.mga{media}',
+            'epoch': 0,
+            'arch': 'x86_64',
+            'nevra': f'{name}-1.0-1.mga{media}.x86_64',
+            'summary': summary or f'{name} package',
+            'provides': [name] + list(provides),
+            'requires': [],
+            'filesize': 1000,
+        }
+
+    def _import(self, db, *packages, name="Core Release"):
+        media_id = db.add_media(
+            name=name, short_name=name.lower().replace(' ', '_'),
+            mageia_version="9", architecture="x86_64",
+            relative_path="core/release"
+        )
+        db.import_packages(iter(packages), media_id=media_id)
+        return media_id
+
+    def _names(self, results):
+        return [p['name'] for p in results]
+
+    def test_ranking_tiers(self, db):
+        self._import(
+            db,
+            self._pkg('firewalld', 'Firewall daemon'),
+            self._pkg('torbrowser', 'Browser built on fire fox'),
+            self._pkg('fire'),
+            self._pkg('firefox', 'Web browser'),
+        )
+        results = db.search_prefix('fire')
+        # exact, name prefix (by name), then summary match
+        assert self._names(results) == ['fire', 'firefox', 'firewalld', 'torbrowser']
+        assert results[-1]['matched_summary'] is True
+        assert 'matched_summary' not in results[1]
+
+    def test_case_insensitive(self, db):
+        self._import(db, self._pkg('GParted'))
+        assert self._names(db.search_prefix('gpa')) == ['GParted']
+        assert self._names(db.search_prefix('GPA')) == ['GParted']
+
+    def test_limit(self, db):
+        self._import(db, *[self._pkg(f'lib{i:02d}') for i in range(30)])
+        results = db.search_prefix('lib', limit=5)
+        assert self._names(results) == ['lib00', 'lib01', 'lib02', 'lib03', 'lib04']
+
+    def test_word_prefixes(self, db):
+        self._import(db, self._pkg('vim', 'Text editor'),
+                     self._pkg('nano', 'Small text viewer'))
+        assert self._names(db.search_prefix('text ed')) == ['vim']
+
+    def test_single_character_skips_fulltext(self, db):
+        self._import(db, self._pkg('vim', 'Editor'), self._pkg('emacs'))
+        assert self._names(db.search_prefix('e')) == ['emacs']
+
+    def test_provides_prefix(self, db):
+        self._import(db, self._pkg('mesa', provides=['libGL.so.1()(64bit)']))
+        assert db.search_prefix('libgl') == []
+        results = db.search_prefix('libgl', search_provides=True)
+        assert self._names(results) == ['mesa']
+        assert results[0]['matched_provide'] == 'libGL.so.1()(64bit)'
+
+    def test_same_nevra_in_two_media(self, db):
+        self._import(db, self._pkg('firefox'), name="Core Release")
+        self._import(db, self._pkg('firefox'), name="Core Updates")
+        assert self._names(db.search_prefix('firefox')) == ['firefox']
+
+    def test_version_filter(self, db):
+        self._import(db, self._pkg('firefox'))
+        media_id = db.add_media(
+            name="Old Release", short_name="old_release",
+            mageia_version="8", architecture="x86_64",
+            relative_path="core/release"
+        )
+        db.import_packages(iter([self._pkg('firefox-esr', media='8')]),
+                           media_id=media_id)
+        assert self._names(db.search_prefix('firef')) == ['firefox']
+
+    def test_interrupted(self, db):
+        self._import(db, self._pkg('firefox'))
+        assert db.search_prefix('fire', interrupted=lambda: True) is None
+        # The progress handler is removed afterwards
+        assert self._names(db.search_prefix('fire')) == ['firefox']
+
+    def test_shared_connection_polled_between_tiers(self, db):
+        self._import(db, *(self._pkg(f'fire{i}') for i in range(300)))
+        calls = []
+
+        def interrupted():
+            calls.append(1)
+            return False
+
+        results = db.search_prefix('fire', limit=500, interrupted=interrupted)
+        assert len(results) == 300
+        # Without a read pool no progress handler is set on the shared
+        # connection: one poll before each tier only
+        assert len(calls) <= 4
+
+    def test_empty_pattern(self, db):
+        self._import(db, self._pkg('firefox'))
+        assert db.search_prefix('  ') == []
+
+    def test_generation_follows_imports(self, db):
+        before = db.search_generation()
+        assert db.search_generation() == before
+        media_id = self._import(db, self._pkg('firefox'))
+        after_import = db.search_generation()
+        assert after_import != before
+        db.update_media_sync_info(media_id, 'md5')
+        assert db.search_generation() != after_import
+
+    def test_generation_follows_rpmdb(self, db, monkeypatch):
+        from urpm.core.resolution import pool
+        monkeypatch.setattr(pool, 'rpmdb_solv_key', lambda: 'a')
+        before = db.search_generation()
+        db._installed_cache = {'firefox'}
+
+        monkeypatch.setattr(pool, 'rpmdb_solv_key', lambda: 'b')
+        assert db.search_generation() != before
+        # Installed flags are read again from the changed rpmdb
+        assert db._installed_cache is None
@@ -0,0 +1,441 @@
+"""Tests for the gi-independent helpers of the D-Bus service.
+
+The service itself needs a system bus and PyGObject; these tests only
+cover the plain-Python pieces it delegates to (result paging, ...).
+"""
+
+import json
+import time
+
+import pytest
+
+from urpm.core import cache_stats
+from urpm.dbus.metrics import Histogram, ServiceMetrics
+from urpm.dbus.progress import (
+    PROGRESS_PHASES, ProgressCoalescer, ProgressUpdate, phase_code,
+)
+from urpm.dbus.service import (
+    MAX_PAGE_SIZE, PACKAGE_RECORD, IncrementalSearch, ResultPager,
+    SearchSuperseded, UrpmDBusService, package_record,
+)
+
+
+def _walk(pager, limit, produce):
+    """Follow cursors until the listing is exhausted, return all pages."""
+    pages = [pager.page('', limit, produce)]
+    while pages[-1]['cursor']:
+        pages.append(pager.page(pages[-1]['cursor'], limit, produce))
+    return pages
+
+
+class TestResultPager:
+    def test_pages_cover_listing_in_order(self):
+        pages = _walk(ResultPager(), 3, lambda: list(range(10)))
+        assert [len(p['items']) for p in pages] == [3, 3, 3, 1]
+        assert [x for p in pages for x in p['items']] == list(range(10))
+        assert all(p['total'] == 10 for p in pages)
+        assert [p['offset'] for p in pages] == [0, 3, 6, 9]
+
+    def test_produce_called_once_per_listing(self):
+        calls = []
+
+        def produce():
+            calls.append(1)
+            return list(range(5))
+
+        _walk(ResultPager(), 2, produce)
+        assert len(calls) == 1
+
+    def test_snapshot_is_stable(self):
+        data = list(range(4))
+        pager = ResultPager()
+        first = pager.page('', 2, lambda: data)
+        data.append(99)
+        second = pager.page(first['cursor'], 2, lambda: data)
+        assert second['items'] == [2, 3]
+        assert second['cursor'] == ''
+
+    def test_empty_listing(self):
+        page = ResultPager().page('', 10, list)
+        assert page == {'items': [], 'cursor': '', 'offset': 0, 'total': 0}
+
+    def test_limit_is_clamped(self):
+        page = ResultPager().page('', 10 ** 6, lambda: range(MAX_PAGE_SIZE + 5))
+        assert len(page['items']) == MAX_PAGE_SIZE
+        page = ResultPager().page('', 0, lambda: range(3))
+        assert len(page['items']) == 3
+
+    def test_finished_cursor_is_forgotten(self):
+        pager = ResultPager()
+        first = pager.page('', 2, lambda: range(4))
+        pager.page(first['cursor'], 2, list)
+        with pytest.raises(ValueError):
+            pager.page(first['cursor'], 2, list)
+
+    def test_unknown_cursor(self):
+        with pytest.raises(ValueError):
+            ResultPager().page('deadbeef:2', 2, list)
+        with pytest.raises(ValueError):
+            ResultPager().page('garbage', 2, list)
+
+    def test_expired_snapshot(self):
+        pager = ResultPager(ttl=-1)
+        first = pager.page('', 1, lambda: range(3))
+        with pytest.raises(ValueError):
+            pager.page(first['cursor'], 1, list)
+
+    def test_oldest_snapshot_evicted(self):
+        pager = ResultPager(max_snapshots=2)
+        a = pager.page('', 1, lambda: range(3))
+        pager.page('', 1, lambda: range(3))
+        pager.page('', 1, lambda: range(3))
+        with pytest.raises(ValueError):
+            pager.page(a['cursor'], 1, list)
+
+    def test_cursor_lookups_counted(self):
+        cache_stats.reset()
+        pager = ResultPager()
+        first = pager.page('', 1, lambda: range(2))
+        pager.page(first['cursor'], 1, list)
+        with pytest.raises(ValueError):
+            pager.page(first['cursor'], 1, list)
+        assert cache_stats.snapshot()['page_snapshot'] == {
+            'hits': 1, 'misses': 1, 'hit_rate': 0.5,
+        }
+
+
+class TestIncrementalSearch:
+    def _search(self, search, session, ticket, pattern, generation=1,
+                produce=None):
+        calls = []
+
+        def default_produce(interrupted):
+            calls.append(pattern)
+            return [{'name': pattern}]
+
+        results = search.search(session, ticket, generation, pattern, False, 50,
+                                produce or default_produce)
+        return results, calls
+
+    def test_repeated_pattern_is_cached(self):
+        search = IncrementalSearch()
+        _, calls = self._search(search, 's', search.begin('s'), 'fire')
+        results, again = self._search(search, 's', search.begin('s'), 'Fire ')
+        assert calls == ['fire'] and again == []
+        assert results == [{'name': 'fire'}]
+
+    def test_new_generation_misses(self):
+        search = IncrementalSearch()
+        self._search(search, 's', search.begin('s'), 'fire', generation=1)
+        _, calls = self._search(search, 's', search.begin('s'), 'fire',
+                                generation=2)
+        assert calls == ['fire']
+
+    def test_oldest_entry_evicted(self):
+        search = IncrementalSearch(size=2)
+        for pattern in ('a', 'b', 'c'):
+            self._search(search, 's', search.begin('s'), pattern)
+        _, calls = self._search(search, 's', search.begin('s'), 'a')
+        assert calls == ['a']
+
+    def test_expired_entry_misses(self):
+        search = IncrementalSearch(ttl=-1)
+        self._search(search, 's', search.begin('s'), 'fire')
+        _, calls = self._search(search, 's', search.begin('s'), 'fire')
+        assert calls == ['fire']
+
+    def test_queued_query_superseded(self):
+        search = IncrementalSearch()
+        old = search.begin('s')
+        new = search.begin('s')
+        with pytest.raises(SearchSuperseded):
+            self._search(search, 's', old, 'fi')
+        results, _ = self._search(search, 's', new, 'fir')
+        assert results == [{'name': 'fir'}]
+
+    def test_running_query_interrupted(self):
+        search = IncrementalSearch()
+        ticket = search.begin('s')
+
+        def produce(interrupted):
+            assert not interrupted()
+            search.begin('s')       # next keystroke arrives
+            assert interrupted()
+            return None
+
+        with pytest.raises(SearchSuperseded):
+            self._search(search, 's', ticket, 'fi', produce=produce)
+
+    def test_sessions_are_independent(self):
+        search = IncrementalSearch()
+        a = search.begin('a')
+        search.begin('b')
+        results, _ = self._search(search, 'a', a, 'fire')
+        assert results == [{'name': 'fire'}]
+
+    def test_finished_sessions_are_forgotten(self):
+        search = IncrementalSearch()
+        for session in ('a', 'b'):
+            self._search(search, session, search.begin(session), 'fire')
+        assert search._latest == {}
+
+    def test_lookups_counted(self):
+        cache_stats.reset()
+        search = IncrementalSearch()
+        self._search(search, 's', search.begin('s'), 'fire')
+        self._search(search, 's', search.begin('s'), 'fire')
+        assert cache_stats.snapshot()['search_results'] == {
+            'hits': 1, 'misses': 1, 'hit_rate': 0.5,
+        }
+
+
+class TestSearchSession:
+    @pytest.fixture
+    def service(self):
+        service = UrpmDBusService()
+        yield service
+        service._read_pool.shutdown()
+
+    def test_session_shared_within_uid(self, service):
+        assert (service._search_session(':1.1', 'pk;gnome-software', 1000)
+                == service._search_session(':1.3', 'pk;gnome-software', 1000))
+
+    def test_other_uid_cannot_supersede(self, service):
+        assert (service._search_session(':1.1', 'pk;gnome-software', 1000)
+                != service._search_session(':1.2', 'pk;gnome-software', 1001))
+
+    def test_unknown_uid_scoped_to_connection(self, service):
+        assert service._search_session(':1.9', 'pk', None) == 'sender::1.9'
+        assert service._search_session(':1.1', '', 1000) == 'sender::1.1'
+
+    def test_known_uid_answers_without_bus(self, service):
+        service._caller_uid_known(':1.1', 1000)
+        seen = []
+        service._with_caller_uid(None, ':1.1', seen.append)
+        assert seen == [1000]
+
+    def test_callbacks_wait_behind_pending_lookup(self, service):
+        seen = []
+        # A lookup for :1.5 is in flight
+        service._uid_waiters[':1.5'] = [lambda uid: seen.append(('a', uid))]
+        service._with_caller_uid(None, ':1.5', lambda uid: seen.append(('b', uid)))
+        assert seen == []
+        service._caller_uid_known(':1.5', 1000)
+        service._with_caller_uid(None, ':1.5', lambda uid: seen.append(('c', uid)))
+        assert seen == [('a', 1000), ('b', 1000), ('c', 1000)]
+
+    def test_failed_lookup_not_remembered(self, service):
+        seen = []
+        service._uid_waiters[':1.6'] = [seen.append]
+        service._caller_uid_known(':1.6', None)
+        assert seen == [None]
+        assert ':1.6' not in service._sender_uids
+
+    def test_scope_taken_once_at_dispatch(self, service, monkeypatch):
+        class Params:
+            def unpack(self):
+                return ('fi', False, 10, 'pk;gnome-software')
+
+        submitted = []
+        monkeypatch.setattr(service._read_pool, 'submit',
+                            lambda *args: submitted.append(args))
+        service._caller_uid_known(':1.1', 1000)
+        service._dispatch_prefix_search(None, ':1.1', 'SearchPackagesPrefix',
+                                        Params(), None, None)
+        scope, ticket = submitted[0][-1]
+        assert scope == 'uid:1000;session:pk;gnome-software'
+        assert not service._search.superseded(scope, ticket)
+
+        # The worker searches under that scope, whatever the bus says now
+        service._sender_uids.clear()
+        seen = []
+        monkeypatch.setattr(service, '_init_core', lambda: None)
+
+        class FakeDb:
+            def search_generation(self):
+                return 1
+
+        class FakeOps:
+            def search_packages_prefix(self, pattern, **kwargs):
+                seen.append(pattern)
+                return [{'name': 'firefox'}]
+
+        service._db, service._ops = FakeDb(), FakeOps()
+        assert service.handle_search_packages_prefix(
+            None, ':1.1', 'fi', False, 10, scope, ticket
+        ) == [{'name': 'firefox'}]
+        assert seen == ['fi']
+
+
+class TestDataGeneration:
+    def test_token_follows_search_generation(self, monkeypatch):
+        service = UrpmDBusService()
+        generation = [(10, ((1, 1, 100, 'md5'),), 'rpmdb-a')]
+
+        class FakeDb:
+            def search_generation(self):
+                return generation[0]
+
+        monkeypatch.setattr(service, '_init_core', lambda: None)
+        service._db = FakeDb()
+        try:
+            before = service.handle_get_data_generation(None, ':1.1')
+            assert isinstance(before, str) and before
+            assert service.handle_get_data_generation(None, ':1.1') == before
+            # A sync still sitting in the WAL already moved the token
+            generation[0] = (10, ((1, 1, 200, 'md5'),), 'rpmdb-a')
+            assert service.handle_get_data_generation(None, ':1.1') != before
+        finally:
+            service._read_pool.shutdown()
+
+
+class TestPackageRecord:
+    def test_fields_in_signature_order(self):
+        pkg = {'name': 'vim', 'version': '9.1', 'release': '1.mga10',
+               'arch': 'x86_64', 'summary': 'Editor', 'installed': 1,
+               'nevra': 'ignored'}
+        assert package_record(pkg) == (
+            'vim', '9.1', '1.mga10', 'x86_64', 'Editor', True
+        )
+        assert len(package_record(pkg)) == len(PACKAGE_RECORD) - 2
+
+    def test_missing_and_null_fields(self):
+        assert package_record({'name': 'x', 'summary': None}) == (
+            'x', '', '', '', '', False
+        )
+
+
+class TestServiceMetrics:
+    def test_histogram_buckets_are_cumulative(self):
+        histogram = Histogram()
+        for ms in (0.5, 3, 3, 40000):
+            histogram.observe(ms)
+        snap = histogram.snapshot()
+        assert snap['count'] == 4
+        assert snap['buckets']['1'] == 1
+        assert snap['buckets']['5'] == 3
+        assert snap['buckets']['30000'] == 3
+        assert snap['buckets']['+Inf'] == 4
+
+    def test_phases_split_the_call(self):
+        metrics = ServiceMetrics()
+        call = metrics.begin('GetUpdates', 'queue')
+        metrics.bind(call, 'db')
+        with metrics.phase('resolve'):
+            time.sleep(0.02)
+            with metrics.phase('serialize'):
+                pass
+        metrics.unbind('reply')
+        metrics.finish(call)
+
+        stats = metrics.snapshot()['methods']['GetUpdates']
+        assert stats['calls'] == 1 and stats['in_flight'] == 0
+        phases = stats['phases_ms']
+        assert list(phases) == ['queue', 'db', 'resolve', 'serialize', 'reply']
+        assert phases['resolve']['sum_ms'] >= 20
+        total = sum(p['sum_ms'] for p in phases.values())
+        assert total == pytest.approx(stats['latency_ms']['sum_ms'], abs=0.01)
+
+    def test_in_flight_and_errors(self):
+        metrics = ServiceMetrics()
+        a = metrics.begin('SearchPackages', 'queue')
+        metrics.begin('SearchPackages', 'queue')
+        snap = metrics.snapshot()
+        assert snap['in_flight'] == 2
+        assert snap['methods']['SearchPackages']['calls'] == 0
+        metrics.finish(a, error=True)
+        stats = metrics.snapshot()['methods']['SearchPackages']
+        assert (stats['calls'], stats['errors'], stats['in_flight']) == (1, 1, 1)
+
+    def test_phase_outside_a_call(self):
+        metrics = ServiceMetrics()
+        with metrics.phase('auth'):
+            pass
+        metrics.finish(None)
+        assert metrics.snapshot()['methods'] == {}
+
+    def test_snapshot_is_json(self):
+        metrics = ServiceMetrics()
+        metrics.finish(metrics.begin('GetMetrics'))
+        assert json.loads(json.dumps(metrics.snapshot()))['methods']
+
+
+class _FakeLoop:
+    """Clock and timeout scheduler for ProgressCoalescer."""
+
+    def __init__(self):
+        self.now = 0.0
+        self.timers = []
+
+    def clock(self):
+        return self.now
+
+    def schedule(self, delay, callback):
+        self.timers.append((self.now + delay, callback))
+
+    def advance(self, seconds):
+        self.now += seconds
+        due = [t for t in self.timers if t[0] <= self.now]
+        self.timers = [t for t in self.timers if t[0] > self.now]
+        for _when, callback in due:
+            callback()
+
+
+class TestProgressCoalescer:
+    def _make(self, rate_hz=10):
+        loop = _FakeLoop()
+        sent = []
+        coalescer = ProgressCoalescer(
+            lambda op_id, upd: sent.append((op_id, upd)),
+            rate_hz=rate_hz, schedule=loop.schedule, clock=loop.clock,
+        )
+        return coalescer, loop, sent
+
+    def test_latest_value_wins(self):
+        coalescer, loop, sent = self._make()
+        for done in range(0, 1000, 10):
+            coalescer.update('op', ProgressUpdate(
+                'downloading', bytes_done=done, bytes_total=1000))
+        # First update goes out, the rest wait for the timer
+        assert [u.bytes_done for _op, u in sent] == [0]
+        assert len(loop.timers) == 1
+        loop.advance(0.1)
+        assert [u.bytes_done for _op, u in sent] == [0, 990]
+        assert loop.timers == []
+
+    def test_rate_limit(self):
+        coalescer, loop, sent = self._make(rate_hz=10)
+        for _ in range(200):
+            coalescer.update('op', ProgressUpdate('installing', current=1))
+            loop.advance(0.005)
+        # One second of updates every 5 ms: about 10 signals, not 200
+        assert 10 <= len(sent) <= 11
+
+    def test_phase_change_is_immediate(self):
+        coalescer, loop, sent = self._make()
+        coalescer.update('op', ProgressUpdate('resolving'))
+        coalescer.update('op', ProgressUpdate('downloading', total=3))
+        coalescer.update('op', ProgressUpdate('installing', total=3))
+        assert [u.phase for _op, u in sent] == [
+            'resolving', 'downloading', 'installing']
+
+    def test_finish_flushes_pending(self):
+        coalescer, loop, sent = self._make()
+        coalescer.update('op', ProgressUpdate('installing', current=0, total=2))
+        coalescer.update('op', ProgressUpdate('installing', current=2, total=2))
+        coalescer.finish('op')
+        assert [u.current for _op, u in sent] == [0, 2]
+        # A timer firing after finish() sends nothing more
+        loop.advance(1)
+        assert len(sent) == 2
+
+    def test_operations_are_independent(self):
+        coalescer, loop, sent = self._make()
+        coalescer.update('a', ProgressUpdate('downloading'))
+        coalescer.update('b', ProgressUpdate('downloading'))
+        assert [op for op, _u in sent] == ['a', 'b']
+
+    def test_phase_codes(self):
+        assert phase_code('unknown') == 0
+        assert phase_code('downloading') == PROGRESS_PHASES.index('downloading')
+        assert phase_code('bogus') == 0
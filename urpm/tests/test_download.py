@@ -239,3 +239,133 @@ class TestDownloadErrorGrammar:
         )
         with pytest.raises(Exception):
             err.message = "y"  # type: ignore[misc]
+
+
+class TestSplitDownload:
+    """Range-split downloads of large packages across several sources."""
+
+    @pytest.fixture
+    def downloader(self, tmp_path, monkeypatch):
+        from urpm.core.settings import get_settings
+        monkeypatch.setattr(get_settings().download, 'split_size_mb', 1)
+        monkeypatch.setattr('urpm.core.download._SPLIT_CHUNK_SIZE', 65536)
+        return Downloader(cache_dir=tmp_path, use_peers=False)
+
+    @staticmethod
+    def _serve(monkeypatch, blob, behaviour=None):
+        """Replace range fetching with in-memory sources.
+
+        ``behaviour`` maps a source name to ``'norange'`` (probe fails
+        like a server ignoring Range) or ``'broken'`` (probe answers,
+        every range then fails).
+        """
+        import os
+        from urpm.core.download import DownloadError, DownloadErrorKind
+        behaviour = behaviour or {}
+        served = {}
+
+        def fetch(self, source, fd, start, end, progress_callback=None,
+                  timeout=30):
+            mode = behaviour.get(source.name)
+            if mode == 'norange':
+                return None, DownloadError(
+                    kind=DownloadErrorKind.HARD_HTTP,
+                    message="byte ranges not supported")
+            if fd is None:
+                return len(blob), None
+            if mode == 'broken':
+                return None, DownloadError(
+                    kind=DownloadErrorKind.TRANSIENT_NETWORK,
+                    message="libcurl error: connection reset")
+            data = blob[start:end + 1]
+            os.pwrite(fd, data, start)
+            if progress_callback:
+                progress_callback(len(data))
+            served[source.name] = served.get(source.name, 0) + len(data)
+            return len(blob), None
+
+        monkeypatch.setattr(Downloader, '_fetch_range', fetch)
+        return served
+
+    @staticmethod
+    def _sources(*names):
+        from urpm.core.download import RangeSource
+        return [RangeSource(name=n, url=f"http://{n}/texlive.rpm",
+                            source_type='server') for n in names]
+
+    @staticmethod
+    def _item():
+        return DownloadItem(name='texlive', version='2025', release='1.mga10',
+                            arch='noarch', media_url='http://mirror/core')
+
+    def test_reassembled_from_several_sources(self, downloader, monkeypatch):
+        import os
+        from urpm.core.download import RPM_MAGIC
+        blob = RPM_MAGIC + os.urandom(1048576 + 5000)
+        served = self._serve(monkeypatch, blob)
+        progress = []
+        result = downloader.download_split(
+            self._item(), self._sources('a', 'b'),
+            progress_callback=lambda done, total: progress.append((done, total)))
+        assert result.success
+        assert result.path.read_bytes() == blob
+        assert sum(served.values()) == len(blob)
+        assert progress[-1] == (len(blob), len(blob))
+
+    def test_failed_ranges_retried_elsewhere(self, downloader, monkeypatch):
+        import os
+        from urpm.core.download import RPM_MAGIC
+        blob = RPM_MAGIC + os.urandom(1048576)
+        served = self._serve(monkeypatch, blob, {'broken': 'broken'})
+        result = downloader.download_split(
+            self._item(), self._sources('broken', 'good'))
+        assert result.success
+        assert result.path.read_bytes() == blob
+        assert served == {'good': len(blob)}
+
+    def test_not_applicable(self, downloader, monkeypatch):
+        import os
+        from urpm.core.download import RPM_MAGIC
+        blob = RPM_MAGIC + os.urandom(1048576)
+        # Only one source answers ranges, whichever comes first
+        self._serve(monkeypatch, blob, {'old': 'norange'})
+        assert downloader.download_split(
+            self._item(), self._sources('old', 'new')) is None
+        assert downloader.download_split(
+            self._item(), self._sources('new', 'old')) is None
+        # Smaller than split_size_mb
+        self._serve(monkeypatch, blob[:1000])
+        assert downloader.download_split(
+            self._item(), self._sources('a', 'b')) is None
+
+    def test_sources_without_ranges_skipped(self, downloader, monkeypatch):
+        import os
+        from urpm.core.download import RPM_MAGIC
+        blob = RPM_MAGIC + os.urandom(1048576)
+        served = self._serve(monkeypatch, blob, {'old': 'norange'})
+        result = downloader.download_split(
+            self._item(), self._sources('a', 'old', 'b'))
+        assert result.success
+        assert set(served) <= {'a', 'b'}
+
+    def test_all_sources_failing(self, downloader, monkeypatch):
+        import os
+        from urpm.core.download import RPM_MAGIC
+        blob = RPM_MAGIC + os.urandom(1048576)
+        self._serve(monkeypatch, blob, {'a': 'broken', 'b': 'broken'})
+        item = self._item()
+        result = downloader.download_split(item, self._sources('a', 'b'))
+        assert not result.success
+        assert 'connection reset' in result.error
+        cache_path = downloader.get_cache_path(item)
+        assert not cache_path.exists()
+        assert not cache_path.with_suffix('.tmp').exists()
+
+    def test_invalid_rpm_rejected(self, downloader, monkeypatch):
+        import os
+        self._serve(monkeypatch, b'<html>' + os.urandom(1048576))
+        item = self._item()
+        result = downloader.download_split(item, self._sources('a', 'b'))
+        assert not result.success
+        assert 'HTML' in result.error
+        assert not downloader.get_cache_path(item).exists()
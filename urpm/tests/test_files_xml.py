@@ -0,0 +1,201 @@
+"""Tests for the files.xml.lzma scanner (urpm.core.files_xml)."""
+
+import lzma
+
+import pytest
+
+from urpm.core.files_xml import (
+    FilesIndex, build_files_index, files_index_path, iter_file_matches,
+    parse_files_xml,
+)
+
+
+FILES_XML = """<?xml version="1.0" encoding="utf-8"?>
+<media_info><files fn="bash-5.2-1.mga9.x86_64">
+/usr/bin/bash
+/etc/bashrc
+</files><files fn="zsh-5.9-1.mga9.x86_64">
+/usr/bin/zsh
+/etc/zshrc
+</files><files fn="vim-9.1-1.mga9.x86_64">
+/usr/bin/vim
+</files></media_info>
+"""
+
+
+@pytest.fixture
+def media_files(tmp_path):
+    path = tmp_path / "files.xml.lzma"
+    with lzma.open(path, 'wb') as fh:
+        fh.write(FILES_XML.encode('utf-8'))
+    return [(path, 'Core Release')]
+
+
+class TestParseFilesXml:
+    def test_yields_every_package(self, media_files):
+        parsed = dict(parse_files_xml(media_files[0][0]))
+        assert parsed['zsh-5.9-1.mga9.x86_64'] == ['/usr/bin/zsh', '/etc/zshrc']
+        assert len(parsed) == 3
+
+
+class TestIterFileMatches:
+    def test_single_pattern(self, media_files):
+        matches = iter_file_matches(media_files, 'zsh')
+        assert [(m.nevra, m.path) for m in matches] == [
+            ('zsh-5.9-1.mga9.x86_64', '/usr/bin/zsh'),
+        ]
+
+    def test_pattern_list_matches_any(self, media_files):
+        matches = iter_file_matches(media_files, ['bash', '/etc/zshrc'])
+        assert [m.path for m in matches] == ['/usr/bin/bash', '/etc/zshrc']
+
+    def test_pattern_list_with_glob(self, media_files):
+        matches = iter_file_matches(media_files, ['/etc/*rc', 'vim'])
+        assert {m.nevra.split('-')[0] for m in matches} == {'bash', 'zsh', 'vim'}
+
+    def test_empty_pattern_list(self, media_files):
+        assert iter_file_matches(media_files, []) == []
+
+    def test_limit_stops_scan(self, media_files):
+        matches = iter_file_matches(media_files, ['/etc/*rc', 'vim'], limit=1)
+        assert len(matches) == 1
+
+
+def _write_media(path, packages):
+    body = ''.join(
+        f'<files fn="{nevra}">\n' + ''.join(f'{p}\n' for p in files) + '</files>'
+        for nevra, files in packages
+    )
+    with lzma.open(path, 'wb') as fh:
+        fh.write(f'<?xml version="1.0" encoding="utf-8"?>\n'
+                 f'<media_info>{body}</media_info>\n'.encode('utf-8'))
+    return path
+
+
+class TestMultiMedia:
+    @pytest.fixture
+    def media(self, tmp_path):
+        return [
+            (_write_media(tmp_path / "updates.xml.lzma", [
+                ('bash-5.3-1.mga9.x86_64', ['/usr/bin/bash']),
+            ]), 'Core Updates'),
+            (_write_media(tmp_path / "release.xml.lzma", [
+                ('bash-5.2-1.mga9.x86_64', ['/usr/bin/bash']),
+                ('zsh-5.9-1.mga9.x86_64', ['/usr/bin/zsh']),
+            ]), 'Core Release'),
+        ]
+
+    def test_merged_in_media_order(self, media):
+        matches = iter_file_matches(media, '/usr/bin/*', all_versions=True)
+        assert [(m.nevra, m.media_name) for m in matches] == [
+            ('bash-5.3-1.mga9.x86_64', 'Core Updates'),
+            ('bash-5.2-1.mga9.x86_64', 'Core Release'),
+            ('zsh-5.9-1.mga9.x86_64', 'Core Release'),
+        ]
+
+    def test_shadowed_matches_do_not_count_toward_limit(self, media):
+        matches = iter_file_matches(media, '/usr/bin/*', limit=2)
+        assert [m.nevra for m in matches] == [
+            'bash-5.3-1.mga9.x86_64', 'zsh-5.9-1.mga9.x86_64',
+        ]
+
+    def test_limit_reached_in_first_media(self, media):
+        matches = iter_file_matches(media, 'bash', limit=1, all_versions=True)
+        assert [m.media_name for m in matches] == ['Core Updates']
+
+    def test_missing_media_skipped(self, media, tmp_path):
+        media.insert(0, (tmp_path / "gone.xml.lzma", 'Gone'))
+        assert len(iter_file_matches(media, 'zsh')) == 1
+
+    def test_without_xzgrep(self, media, monkeypatch):
+        monkeypatch.setenv('PATH', '/nonexistent')
+        matches = iter_file_matches(media, '/usr/bin/*')
+        assert [m.nevra for m in matches] == [
+            'bash-5.3-1.mga9.x86_64', 'zsh-5.9-1.mga9.x86_64',
+        ]
+
+
+class TestFilesIndex:
+    @pytest.fixture
+    def indexed(self, tmp_path, monkeypatch):
+        monkeypatch.setattr('urpm.core.files_xml.FILES_INDEX_RESTART', 2)
+        path = _write_media(tmp_path / "files.xml.lzma", [
+            ('bash-5.2-1.mga9.x86_64', ['/usr/bin/bash', '/etc/bashrc',
+                                        '/usr/share/doc/bash/README']),
+            ('zsh-5.9-1.mga9.x86_64', ['/usr/bin/zsh', '/etc/zshrc',
+                                       '/usr/share/doc/zsh/README']),
+            ('busybox-1.36-1.mga9.x86_64', ['/usr/lib/busybox/bash',
+                                            '/usr/bin/Busybox']),
+        ])
+        build_files_index(path)
+        return path
+
+    def test_lookup_in_file_order(self, indexed):
+        index = FilesIndex.load(indexed)
+        assert [(n, p) for _, n, p in index.lookup(b'bash')] == [
+            (b'bash-5.2-1.mga9.x86_64', b'/usr/bin/bash'),
+            (b'busybox-1.36-1.mga9.x86_64', b'/usr/lib/busybox/bash'),
+        ]
+        assert [p for _, _, p in index.lookup(b'README')] == [
+            b'/usr/share/doc/bash/README', b'/usr/share/doc/zsh/README',
+        ]
+        assert index.lookup(b'nope') == []
+        assert index.lookup(b'zzz') == []
+
+    def test_lookup_case_insensitive(self, indexed):
+        index = FilesIndex.load(indexed)
+        assert [p for _, _, p in index.lookup(b'busybox')] == [b'/usr/bin/Busybox']
+        assert [p for _, _, p in index.lookup(b'BASH', b'/USR/bin')] == [
+            b'/usr/bin/bash',
+        ]
+        assert index.lookup(b'bash', b'/nope') == []
+
+    def test_stale_or_corrupt_index_ignored(self, indexed):
+        import os
+        st = os.stat(indexed)
+        os.utime(indexed, ns=(st.st_atime_ns, st.st_mtime_ns + 10 ** 9))
+        assert FilesIndex.load(indexed) is None
+        files_index_path(indexed).write_bytes(b'garbage')
+        assert FilesIndex.load(indexed) is None
+
+    def test_restart_interval_read_from_header(self, indexed, monkeypatch):
+        # Built with an interval of 2; the current constant does not matter
+        monkeypatch.setattr('urpm.core.files_xml.FILES_INDEX_RESTART', 16)
+        index = FilesIndex.load(indexed)
+        assert [p for _, _, p in index.lookup(b'zshrc')] == [b'/etc/zshrc']
+        assert [p for _, _, p in index.lookup(b'README')] == [
+            b'/usr/share/doc/bash/README', b'/usr/share/doc/zsh/README',
+        ]
+
+    def test_mismatched_restart_interval_rejected(self, indexed):
+        from urpm.core.files_xml import _FILES_INDEX_HEADER
+        path = files_index_path(indexed)
+        data = bytearray(path.read_bytes())
+        header = list(_FILES_INDEX_HEADER.unpack_from(data, 0))
+        header[-1] = 16
+        _FILES_INDEX_HEADER.pack_into(data, 0, *header)
+        path.write_bytes(bytes(data))
+        assert FilesIndex.load(indexed) is None
+
+    def test_search_uses_index(self, indexed, monkeypatch):
+        def no_scan(*args, **kwargs):
+            raise AssertionError("streaming scan with a valid index")
+
+        monkeypatch.setattr('urpm.core.files_xml._iter_matches_in_lzma', no_scan)
+        media = [(indexed, 'Core Release')]
+        assert [m.path for m in iter_file_matches(media, 'bash')] == [
+            '/usr/bin/bash', '/usr/lib/busybox/bash',
+        ]
+        assert [m.nevra for m in iter_file_matches(media, '/usr/bin/zsh')] == [
+            'zsh-5.9-1.mga9.x86_64',
+        ]
+        assert [m.path for m in iter_file_matches(
+            media, ['busybox/bash', 'zshrc'])] == [
+            '/etc/zshrc', '/usr/lib/busybox/bash',
+        ]
+
+    def test_wildcards_stream(self, indexed):
+        media = [(indexed, 'Core Release')]
+        assert {m.path for m in iter_file_matches(media, '/etc/*rc')} == {
+            '/etc/bashrc', '/etc/zshrc',
+        }
@@ -0,0 +1,339 @@
+"""Tests for the hdlist.cz header parser (urpm.core.hdlist)."""
+
+import gzip
+import json
+import struct
+
+import pytest
+
+from urpm.core.hdlist import (
+    RPM_HEADER_MAGIC, RPM_I18NSTRING, RPM_INT32, RPM_STRING, RPM_STRING_ARRAY,
+    RPMTAG_ARCH, RPMTAG_BUILDTIME, RPMTAG_CHANGELOGNAME, RPMTAG_CHANGELOGTEXT,
+    RPMTAG_CHANGELOGTIME, RPMTAG_EPOCH, RPMTAG_NAME, RPMTAG_PROVIDENAME,
+    RPMTAG_RELEASE, RPMTAG_SUMMARY, RPMTAG_VERSION,
+    HdlistIndex, build_hdlist_index, ensure_hdlist_index, find_headers,
+    hdlist_index_path, parse_hdlist,
+)
+
+
+def build_header(name, version='1.0', release='1.mga10', arch='x86_64',
+                 epoch=0, buildtime=1700000000, changelog=(), provides=(),
+                 summary=None):
+    """Serialize a minimal RPM header in hdlist layout."""
+    entries = [
+        (RPMTAG_NAME, RPM_STRING, [name]),
+        (RPMTAG_VERSION, RPM_STRING, [version]),
+        (RPMTAG_RELEASE, RPM_STRING, [release]),
+        (RPMTAG_ARCH, RPM_STRING, [arch]),
+        (RPMTAG_BUILDTIME, RPM_INT32, [buildtime]),
+    ]
+    if epoch:
+        entries.append((RPMTAG_EPOCH, RPM_INT32, [epoch]))
+    if summary:
+        entries.append((RPMTAG_SUMMARY, RPM_I18NSTRING, [summary]))
+    if provides:
+        entries.append((RPMTAG_PROVIDENAME, RPM_STRING_ARRAY, list(provides)))
+    if changelog:
+        entries.append((RPMTAG_CHANGELOGTIME, RPM_INT32, [c[0] for c in changelog]))
+        entries.append((RPMTAG_CHANGELOGNAME, RPM_STRING_ARRAY, [c[1] for c in changelog]))
+        entries.append((RPMTAG_CHANGELOGTEXT, RPM_STRING_ARRAY, [c[2] for c in changelog]))
+
+    index = b''
+    store = b''
+    for tag, typ, values in entries:
+        if typ == RPM_INT32:
+            store += b'\x00' * (-len(store) % 4)
+            data = b''.join(struct.pack('>I', v) for v in values)
+        else:
+            data = b''.join(v.encode() + b'\x00' for v in values)
+        index += struct.pack('>IIII', tag, typ, len(store), len(values))
+        store += data
+    return (RPM_HEADER_MAGIC + b'\x01' + b'\x00' * 4
+            + struct.pack('>II', len(entries), len(store)) + index + store)
+
+
+@pytest.fixture
+def hdlist(tmp_path):
+    path = tmp_path / "hdlist.cz"
+    with gzip.open(path, 'wb') as fh:
+        fh.write(build_header('bash', changelog=[
+            (1700000000, 'Jane Packager <jane@mageia.org> 1.0-1.mga10',
+             '- fix CVE-2026-0001'),
+            (1690000000, 'Joe <joe@mageia.org> 0.9-1.mga10', '- new version'),
+        ]))
+        fh.write(build_header('kernel-desktop', version='6.6.1', epoch=1,
+                              provides=['kernel', 'should-restart:system']))
+        fh.write(build_header('vim', version='9.1'))
+    return path
+
+
+class TestParseHdlist:
+    def test_yields_every_header(self, hdlist):
+        names = [h.name for h in parse_hdlist(hdlist)]
+        assert names == ['bash', 'kernel-desktop', 'vim']
+
+    def test_changelog_newest_first(self, hdlist):
+        bash = next(parse_hdlist(hdlist))
+        assert bash.buildtime == 1700000000
+        assert [c['text'] for c in bash.changelog] == [
+            '- fix CVE-2026-0001', '- new version',
+        ]
+        assert bash.changelog[0]['author'].startswith('Jane Packager')
+
+    def test_no_changelog(self, hdlist):
+        vim = list(parse_hdlist(hdlist))[2]
+        assert vim.changelog == []
+
+
+class TestRPMHeader:
+    def _header(self, **kw):
+        from urpm.core.hdlist import header_from_bytes
+        return header_from_bytes(build_header('bash', **kw))
+
+    def test_string_array_bounded_by_next_entry(self):
+        hdr = self._header(provides=['bash', 'sh', '/bin/sh'])
+        assert hdr.provides == ['bash', 'sh', '/bin/sh']
+        assert hdr.get_string_array(RPMTAG_NAME) == []
+
+    def test_i18n_string(self):
+        assert self._header(summary='The GNU shell').summary == 'The GNU shell'
+
+    def test_int32_array(self):
+        hdr = self._header(changelog=[(3, 'a', 'x'), (2, 'b', 'y'), (1, 'c', 'z')])
+        assert hdr.get_int32_array(RPMTAG_CHANGELOGTIME) == [3, 2, 1]
+        assert hdr.get_int32(RPMTAG_EPOCH) is None
+
+
+class TestFindHeaders:
+    def test_picks_requested_headers(self, hdlist):
+        found = find_headers(hdlist, ['vim-9.1-1.mga10.x86_64',
+                                      'bash-1.0-1.mga10.x86_64'])
+        assert sorted(found) == ['bash-1.0-1.mga10.x86_64',
+                                 'vim-9.1-1.mga10.x86_64']
+        assert found['vim-9.1-1.mga10.x86_64'].version == '9.1'
+
+    def test_matches_with_or_without_epoch(self, hdlist):
+        found = find_headers(hdlist, ['kernel-desktop-6.6.1-1.mga10.x86_64',
+                                      'kernel-desktop-1:6.6.1-1.mga10.x86_64'])
+        assert len(found) == 2
+        assert 'should-restart:system' in found[
+            'kernel-desktop-6.6.1-1.mga10.x86_64'].provides
+
+    def test_unknown_and_empty(self, hdlist):
+        assert find_headers(hdlist, ['nope-1-1.x86_64']) == {}
+        assert find_headers(hdlist, []) == {}
+
+
+class TestHdlistIndex:
+    def test_random_access(self, hdlist):
+        build_hdlist_index(hdlist)
+        index = HdlistIndex.load(hdlist)
+        assert index is not None
+        assert index.get('vim-9.1-1.mga10.x86_64').version == '9.1'
+        assert index.get('nope-1-1.x86_64') is None
+
+    def test_epoch_alias(self, hdlist):
+        build_hdlist_index(hdlist)
+        index = HdlistIndex.load(hdlist)
+        assert 'kernel-desktop-1:6.6.1-1.mga10.x86_64' in index
+        assert index.get('kernel-desktop-6.6.1-1.mga10.x86_64').epoch == 1
+
+    def test_small_blocks(self, hdlist, monkeypatch):
+        monkeypatch.setattr('urpm.core.hdlist.HDLIST_INDEX_BLOCK_SIZE', 1)
+        build_hdlist_index(hdlist)
+        index = HdlistIndex.load(hdlist)
+        found = index.get_many(['bash-1.0-1.mga10.x86_64',
+                                'vim-9.1-1.mga10.x86_64'])
+        assert found['bash-1.0-1.mga10.x86_64'].changelog[0]['text'] == \
+            '- fix CVE-2026-0001'
+        assert found['vim-9.1-1.mga10.x86_64'].name == 'vim'
+
+    def test_find_headers_uses_index(self, hdlist, monkeypatch):
+        build_hdlist_index(hdlist)
+
+        def no_scan(filename):
+            raise AssertionError("full scan with a valid index")
+
+        monkeypatch.setattr('urpm.core.hdlist.parse_hdlist', no_scan)
+        found = find_headers(hdlist, ['bash-1.0-1.mga10.x86_64'])
+        assert list(found) == ['bash-1.0-1.mga10.x86_64']
+
+    def test_stale_index_ignored(self, hdlist):
+        import os
+        build_hdlist_index(hdlist)
+        st = os.stat(hdlist)
+        os.utime(hdlist, ns=(st.st_atime_ns, st.st_mtime_ns + 10 ** 9))
+        assert HdlistIndex.load(hdlist) is None
+        # ensure_hdlist_index() rebuilds it
+        assert ensure_hdlist_index(hdlist) is not None
+
+    def test_missing_or_corrupt_index(self, hdlist):
+        assert HdlistIndex.load(hdlist) is None
+        hdlist_index_path(hdlist).write_bytes(b'garbage')
+        assert HdlistIndex.load(hdlist) is None
+
+    def test_loaded_index_kept_in_memory(self, hdlist, monkeypatch):
+        build_hdlist_index(hdlist)
+        index = HdlistIndex.load(hdlist)
+
+        def no_read(*args):
+            raise AssertionError("NEVRA table parsed again")
+
+        monkeypatch.setattr(HdlistIndex, '_read', classmethod(no_read))
+        assert HdlistIndex.load(hdlist) is index
+
+    def test_rebuilt_index_reloaded(self, hdlist):
+        import os
+        build_hdlist_index(hdlist)
+        index = HdlistIndex.load(hdlist)
+        st = os.stat(hdlist)
+        os.utime(hdlist, ns=(st.st_atime_ns, st.st_mtime_ns + 10 ** 9))
+        build_hdlist_index(hdlist)
+        reloaded = HdlistIndex.load(hdlist)
+        assert reloaded is not None and reloaded is not index
+
+
+class TestGetUpdateDetails:
+    @pytest.fixture
+    def ops(self, hdlist, tmp_path, monkeypatch):
+        pytest.importorskip('pycurl')  # urpm.core.download
+        from urpm.core.operations import PackageOperations
+        ops = PackageOperations(db=None, base_dir=tmp_path)
+        monkeypatch.setattr(ops, '_hdlist_media',
+                            lambda: [(hdlist, 'Core Updates')])
+        build_hdlist_index(hdlist)     # done at sync time
+        return ops
+
+    def test_details_in_request_order(self, ops):
+        details = ops.get_update_details([
+            'kernel-desktop-6.6.1-1.mga10.x86_64',
+            'bash-1.0-1.mga10.x86_64',
+        ])
+        assert [d['nevra'] for d in details] == [
+            'kernel-desktop-6.6.1-1.mga10.x86_64', 'bash-1.0-1.mga10.x86_64',
+        ]
+        kernel, bash = details
+        assert kernel['restart'] == 'system'
+        assert bash['restart'] == 'none'
+        assert bash['issued'] == 1700000000
+        assert bash['media'] == 'Core Updates'
+        assert bash['changelog'][0]['text'] == '- fix CVE-2026-0001'
+
+    def test_unindexed_hdlist_not_scanned(self, ops, hdlist, monkeypatch):
+        hdlist_index_path(hdlist).unlink()
+
+        def no_scan(filename):
+            raise AssertionError("hdlist decompressed on the read path")
+
+        monkeypatch.setattr('urpm.core.hdlist.parse_hdlist', no_scan)
+        monkeypatch.setattr('urpm.core.hdlist.build_hdlist_index', no_scan)
+        details = ops.get_update_details(['bash-1.0-1.mga10.x86_64'])
+        assert details[0]['changelog'] == []
+        assert not hdlist_index_path(hdlist).exists()
+
+    def test_unknown_package(self, ops):
+        assert ops.get_update_details(['nope-1-1.x86_64']) == [{
+            'nevra': 'nope-1-1.x86_64', 'changelog': [], 'issued': 0,
+            'restart': 'none', 'media': '',
+        }]
+
+
+class TestSyncHdlist:
+    """``sync_media`` keeps the hdlist of update media, from a file:// mirror."""
+
+    UPDATES = '10/x86_64/media/core/updates'
+    RELEASE = '10/x86_64/media/core/release'
+
+    @pytest.fixture
+    def mirror(self, hdlist, tmp_path):
+        for path in (self.UPDATES, self.RELEASE):
+            media_info = tmp_path / 'mirror' / path / 'media_info'
+            media_info.mkdir(parents=True)
+            with gzip.open(media_info / 'synthesis.hdlist.cz', 'wb') as fh:
+                fh.write(b"@summary@Shell\n"
+                         b"@info@bash-1.0-1.mga10.x86_64@0@1000@Shells\n")
+            (media_info / 'hdlist.cz').write_bytes(hdlist.read_bytes())
+        return tmp_path / 'mirror'
+
+    @pytest.fixture
+    def base_dir(self, tmp_path, monkeypatch):
+        base_dir = tmp_path / 'urpm'
+        monkeypatch.setattr('urpm.core.sync.get_base_dir',
+                            lambda urpm_root=None: base_dir)
+        return base_dir
+
+    @pytest.fixture
+    def db(self, mirror, tmp_path):
+        from urpm.core.database import PackageDatabase
+        db = PackageDatabase(tmp_path / 'packages.db')
+        server_id = db.add_server('local', 'file', 'localhost',
+                                  base_path=str(mirror))
+        for name, path, update in (('Core Updates', self.UPDATES, True),
+                                   ('Core Release', self.RELEASE, False)):
+            media_id = db.add_media(name, name.lower().replace(' ', '_'),
+                                    '10', 'x86_64', path, update_media=update)
+            db.link_server_media(server_id, media_id)
+        yield db
+        db.close()
+
+    def local_hdlist(self, base_dir, path):
+        return base_dir / 'medias' / 'official' / path / 'media_info' / 'hdlist.cz'
+
+    def test_update_media_hdlist_kept_and_indexed(self, db, base_dir):
+        from urpm.core.sync import sync_media
+        result = sync_media(db, 'Core Updates', force=True, skip_appstream=True)
+        assert result.success and result.hdlist_downloaded
+        hdlist = self.local_hdlist(base_dir, self.UPDATES)
+        assert hdlist.exists()
+        assert HdlistIndex.load(hdlist) is not None
+
+    def test_release_media_has_no_hdlist(self, db, base_dir):
+        from urpm.core.sync import sync_media
+        result = sync_media(db, 'Core Release', force=True, skip_appstream=True)
+        assert result.success and not result.hdlist_downloaded
+        assert not self.local_hdlist(base_dir, self.RELEASE).exists()
+
+    def test_setting_disables_download(self, db, base_dir, monkeypatch):
+        from urpm.core.settings import Settings
+        from urpm.core.sync import sync_media
+        settings = Settings()
+        settings.media.update_hdlist = False
+        monkeypatch.setattr('urpm.core.settings.get_settings', lambda: settings)
+        result = sync_media(db, 'Core Updates', force=True, skip_appstream=True)
+        assert result.success and not result.hdlist_downloaded
+        assert not self.local_hdlist(base_dir, self.UPDATES).exists()
+
+    def test_up_to_date_media_fetches_missing_hdlist(self, db, base_dir,
+                                                     monkeypatch):
+        from urpm.core.sync import sync_media
+        monkeypatch.setattr('urpm.core.sync.check_media_update_needed',
+                            lambda *a, **kw: (False, None))
+        result = sync_media(db, 'Core Updates', skip_appstream=True)
+        assert result.skipped and result.hdlist_downloaded
+        hdlist = self.local_hdlist(base_dir, self.UPDATES)
+        assert HdlistIndex.load(hdlist) is not None
+
+        # Already there: not downloaded again
+        again = sync_media(db, 'Core Updates', skip_appstream=True)
+        assert again.skipped and not again.hdlist_downloaded
+
+    def test_sync_then_get_update_details(self, db, base_dir, monkeypatch):
+        from urpm.core.operations import PackageOperations
+        from urpm.core.sync import sync_media
+        from urpm.dbus.service import UrpmDBusService
+
+        for name in ('Core Release', 'Core Updates'):
+            assert sync_media(db, name, force=True, skip_appstream=True).success
+
+        service = UrpmDBusService()
+        monkeypatch.setattr(service, '_init_core', lambda: None)
+        service._ops = PackageOperations(db, base_dir=base_dir)
+        try:
+            reply = service.handle_get_update_details(
+                None, ':1.1', ['bash-1.0-1.mga10.x86_64'])
+        finally:
+            service._read_pool.shutdown()
+        [bash] = json.loads(reply)
+        assert bash['media'] == 'Core Updates'
+        assert bash['issued'] == 1700000000
+        assert bash['changelog'][0]['text'] == '- fix CVE-2026-0001'
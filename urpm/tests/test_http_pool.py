@@ -0,0 +1,93 @@
+"""Tests for the shared keep-alive connection pool (urpm.core.http_pool)."""
+
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import pytest
+
+pycurl = pytest.importorskip('pycurl')
+
+from urpm.core import http_pool
+from urpm.core.sync import download_file
+
+
+class _Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'   # keep-alive
+    disable_nagle_algorithm = True
+    connections = set()
+
+    def do_GET(self):
+        self.connections.add(self.client_address)
+        if self.path == '/missing':
+            body = b'not found'
+            self.send_response(404)
+        else:
+            body = self.path.encode() * 100
+            self.send_response(200)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, *args):
+        pass
+
+
+@pytest.fixture
+def server():
+    _Handler.connections = set()
+    httpd = ThreadingHTTPServer(('127.0.0.1', 0), _Handler)
+    thread = threading.Thread(target=httpd.serve_forever, daemon=True)
+    thread.start()
+    yield f"http://127.0.0.1:{httpd.server_port}"
+    httpd.shutdown()
+    httpd.server_close()
+
+
+class TestHandles:
+    def test_thread_handle_reused(self):
+        c = http_pool.acquire()
+        http_pool.release(c)
+        again = http_pool.acquire()
+        try:
+            assert again is c
+        finally:
+            http_pool.release(again)
+
+    def test_nested_transfer_gets_own_handle(self):
+        outer = http_pool.acquire()
+        try:
+            inner = http_pool.acquire()
+            assert inner is not outer
+            http_pool.release(inner)
+        finally:
+            http_pool.release(outer)
+        assert http_pool.acquire() is outer
+        http_pool.release(outer)
+
+
+class TestKeepAlive:
+    def test_many_files_one_connection(self, server, tmp_path):
+        for i in range(20):
+            result = download_file(f"{server}/pkg{i}.rpm", tmp_path / f"{i}.rpm")
+            assert result.success
+            assert result.size == len(f"/pkg{i}.rpm") * 100
+        assert len(_Handler.connections) == 1
+
+    def test_shared_between_threads(self, server, tmp_path):
+        download_file(f"{server}/synthesis", tmp_path / "synthesis")
+        worker = threading.Thread(target=download_file,
+                                  args=(f"{server}/pkg.rpm", tmp_path / "pkg.rpm"))
+        worker.start()
+        worker.join()
+        assert (tmp_path / "pkg.rpm").exists()
+        if hasattr(pycurl, 'LOCK_DATA_CONNECT'):
+            assert len(_Handler.connections) == 1
+
+    def test_failure_keeps_existing_file(self, server, tmp_path):
+        dest = tmp_path / "synthesis.hdlist.cz"
+        dest.write_bytes(b'previous')
+        result = download_file(f"{server}/missing", dest)
+        assert not result.success
+        assert result.error == "HTTP 404"
+        assert dest.read_bytes() == b'previous'
+        assert list(tmp_path.iterdir()) == [dest]
@@ -3242,6 +3242,126 @@ def pre_verify_signatures_stub(ri, path):
     return ri.pre_verify_signatures([path])
 
 
+class TestSignaturePipeline:
+    """Tests for :class:`SignaturePipeline`, which pre-verifies RPMs
+    while the rest of the transaction is still downloading."""
+
+    def _rpm(self, tmp_path, name):
+        path = tmp_path / f"{name}-1.0-1.mga10.x86_64.rpm"
+        path.write_bytes(b"\xed\xab\xee\xdb" + b"\x00" * 96)
+        return path
+
+    def _fake_verify(self, monkeypatch, bad=()):
+        from urpm.core import resilient_install as ri
+        calls = []
+
+        def fake(paths, root="/"):
+            calls.append([p.name for p in paths])
+            failed = [ri.FailedRpm(p, "signature", "NOKEY")
+                      for p in paths if p.name in bad]
+            return [p for p in paths if p.name not in bad], failed
+
+        monkeypatch.setattr(ri, 'pre_verify_signatures', fake)
+        return calls
+
+    @pytest.mark.stable
+    def test_submitted_results_are_reused(self, tmp_path, monkeypatch):
+        from urpm.core.resilient_install import SignaturePipeline
+        paths = [self._rpm(tmp_path, n) for n in ("foo", "bar")]
+        calls = self._fake_verify(monkeypatch, bad={paths[1].name})
+
+        pipeline = SignaturePipeline()
+        for path in paths:
+            pipeline.submit(path)
+        valid, failed = pipeline.collect(paths)
+
+        assert valid == [paths[0]]
+        assert [f.path for f in failed] == [paths[1]]
+        # One background call per file, nothing left for collect()
+        assert sorted(calls) == [[paths[1].name], [paths[0].name]]
+
+    @pytest.mark.stable
+    def test_unsubmitted_and_changed_are_verified(self, tmp_path, monkeypatch):
+        from urpm.core.resilient_install import SignaturePipeline
+        foo, bar, baz = (self._rpm(tmp_path, n) for n in ("foo", "bar", "baz"))
+        calls = self._fake_verify(monkeypatch)
+
+        pipeline = SignaturePipeline()
+        pipeline.submit(foo)
+        pipeline.submit(bar)
+        pipeline.close()
+        pipeline._thread.join()
+        # Re-downloaded after verification: the old result is stale
+        bar.write_bytes(b"\xed\xab\xee\xdb" + b"\x01" * 200)
+
+        calls.clear()
+        valid, failed = pipeline.collect([foo, bar, baz])
+
+        assert valid == [foo, bar, baz]
+        assert failed == []
+        assert calls == [[bar.name, baz.name]]
+
+    @pytest.mark.stable
+    def test_other_root_is_verified_again(self, tmp_path, monkeypatch):
+        """Results checked against the host keyring are not reused for
+        an install into another root."""
+        from urpm.core import resilient_install as ri
+        path = self._rpm(tmp_path, "foo")
+        roots = []
+
+        def fake(paths, root="/"):
+            roots.append(root)
+            return list(paths), []
+
+        monkeypatch.setattr(ri, 'pre_verify_signatures', fake)
+        pipeline = ri.SignaturePipeline(root="/")
+        pipeline.submit(path)
+        assert pipeline.collect([path], root=str(tmp_path)) == ([path], [])
+        assert roots == ["/", str(tmp_path)]
+
+    @pytest.mark.stable
+    def test_closed_pipeline_ignores_submit(self, tmp_path, monkeypatch):
+        from urpm.core.resilient_install import SignaturePipeline
+        path = self._rpm(tmp_path, "foo")
+        calls = self._fake_verify(monkeypatch)
+
+        pipeline = SignaturePipeline()
+        pipeline.close()
+        pipeline.submit(path)
+        assert pipeline.collect([path]) == ([path], [])
+        assert calls == [[path.name]]
+
+    @pytest.mark.stable
+    def test_download_packages_feeds_pipeline(self, tmp_path, monkeypatch):
+        """download_packages(verify_ahead=True) submits every finished
+        RPM and leaves the pipeline for resilient_install."""
+        from urpm.core import operations
+        from urpm.core.download import DownloadResult
+        path = self._rpm(tmp_path, "foo")
+        self._fake_verify(monkeypatch)
+
+        class FakeDownloader:
+            def __init__(self, **kwargs):
+                pass
+
+            def download_all(self, items, progress_callback=None,
+                             result_callback=None):
+                results = [DownloadResult(item=None, success=True, path=path),
+                           DownloadResult(item=None, success=False, error="x")]
+                for r in results:
+                    result_callback(r)
+                return results, 1, 0, {}
+
+        monkeypatch.setattr(operations, 'Downloader', FakeDownloader)
+        ops = PackageOperations(db=None, base_dir=tmp_path)
+        ops.download_packages([], verify_ahead=True)
+
+        pipeline = ops._signature_pipeline
+        assert pipeline is not None
+        assert pipeline.collect([path]) == ([path], [])
+        assert str(path) in pipeline._results
+
+
 @pytest.fixture
 def fresh_db(monkeypatch):
     """Throwaway v30 PackageDatabase for the bug-#3 iteration B tests.
@@ -0,0 +1,177 @@
+"""Tests for upgrades prepared by urpmd"""
+
+import os
+import tempfile
+import time
+from pathlib import Path
+
+import pytest
+
+from urpm.core import prepared_upgrade
+from urpm.core.database import PackageDatabase
+from urpm.core.resolver import InstallReason, PackageAction, TransactionType
+
+
+@pytest.fixture
+def db(monkeypatch):
+    """Temporary database whose rpmdb key is fixed."""
+    monkeypatch.setattr('urpm.core.config.get_system_version', lambda: '9')
+    monkeypatch.setattr(prepared_upgrade, '_rpmdb_key', lambda: 'rpmdb-1')
+
+    tmpdir = tempfile.TemporaryDirectory()
+    database = PackageDatabase(Path(tmpdir.name) / 'packages.db')
+    yield database
+
+    database.close()
+    tmpdir.cleanup()
+
+
+def _add_packages(db, *names):
+    media_id = db.add_media(
+        name="Core Updates",
+        short_name="core_updates",
+        mageia_version="9",
+        architecture="x86_64",
+        relative_path="core/updates"
+    )
+    db.import_packages(iter({
+        'name': name,
+        'version': '1.0',
+        'release': '2.mga9',
+        'epoch': 0,
+        'arch': 'x86_64',
+        'nevra': f'{name}-1.0-2.mga9.x86_64',
+        'summary': name,
+        'provides': [name],
+        'requires': [],
+        'filesize': 1000,
+    } for name in names), media_id=media_id)
+
+
+def _actions(*names):
+    return [PackageAction(
+        action=TransactionType.UPGRADE,
+        name=name,
+        evr='1.0-2.mga9',
+        arch='x86_64',
+        nevra=f'{name}-1.0-2.mga9.x86_64',
+        filesize=1000,
+        media_name='Core Updates',
+        reason=InstallReason.EXPLICIT,
+        from_evr='1.0-1.mga9',
+    ) for name in names]
+
+
+def _rpms(db, *names):
+    paths = []
+    for name in names:
+        path = db.db_path.parent / f'{name}-1.0-2.mga9.x86_64.rpm'
+        path.write_bytes(b'rpm')
+        paths.append(path)
+    return paths
+
+
+class TestStateKey:
+    """The key changes with anything the resolution depends on."""
+
+    def test_stable(self, db):
+        _add_packages(db, 'bash')
+        assert (prepared_upgrade.state_key(db, 'x86_64')
+                == prepared_upgrade.state_key(db, 'x86_64'))
+
+    def test_arch(self, db):
+        assert (prepared_upgrade.state_key(db, 'x86_64')
+                != prepared_upgrade.state_key(db, 'aarch64'))
+
+    def test_packages_imported(self, db):
+        before = prepared_upgrade.state_key(db, 'x86_64')
+        _add_packages(db, 'bash')
+        assert prepared_upgrade.state_key(db, 'x86_64') != before
+
+    def test_hold_added(self, db):
+        before = prepared_upgrade.state_key(db, 'x86_64')
+        db.add_hold('bash')
+        assert prepared_upgrade.state_key(db, 'x86_64') != before
+
+    def test_rpmdb_changed(self, db, monkeypatch):
+        before = prepared_upgrade.state_key(db, 'x86_64')
+        monkeypatch.setattr(prepared_upgrade, '_rpmdb_key', lambda: 'rpmdb-2')
+        assert prepared_upgrade.state_key(db, 'x86_64') != before
+
+
+class TestSaveLoad:
+    """Round trip and rejection of stale or unsafe files."""
+
+    def test_round_trip(self, db):
+        actions = _actions('bash', 'zsh')
+        prepared_upgrade.save(db, 'k', actions, [])
+
+        prepared = prepared_upgrade.load(db, 'k')
+        assert prepared is not None
+        assert prepared.actions == actions
+        assert prepared.ready_rpms() is None
+
+    def test_key_mismatch(self, db):
+        prepared_upgrade.save(db, 'k', _actions('bash'), [])
+        assert prepared_upgrade.load(db, 'other') is None
+
+    def test_too_old(self, db):
+        prepared_upgrade.save(db, 'k', _actions('bash'), [])
+        assert prepared_upgrade.load(db, 'k', max_age=-1) is None
+
+    def test_world_writable_ignored(self, db):
+        prepared_upgrade.save(db, 'k', _actions('bash'), [])
+        os.chmod(prepared_upgrade.prepared_path(db), 0o666)
+        assert prepared_upgrade.load(db, 'k') is None
+
+    def test_missing(self, db):
+        assert prepared_upgrade.load(db, 'k') is None
+
+    def test_discard(self, db):
+        prepared_upgrade.save(db, 'k', _actions('bash'), [])
+        prepared_upgrade.discard(db)
+        assert prepared_upgrade.load(db, 'k') is None
+        prepared_upgrade.discard(db)
+
+
+class TestReadyRpms:
+    """Pre-verified RPMs are only reused while untouched."""
+
+    def test_all_verified(self, db):
+        paths = _rpms(db, 'bash', 'zsh')
+        prepared_upgrade.save(db, 'k', _actions('bash', 'zsh'), paths)
+
+        prepared = prepared_upgrade.load(db, 'k')
+        assert sorted(prepared.ready_rpms()) == sorted(str(p) for p in paths)
+
+    def test_partial(self, db):
+        paths = _rpms(db, 'bash')
+        prepared_upgrade.save(db, 'k', _actions('bash', 'zsh'), paths)
+        assert prepared_upgrade.load(db, 'k').ready_rpms() is None
+
+    def test_removes_not_counted(self, db):
+        actions = _actions('bash') + [PackageAction(
+            action=TransactionType.REMOVE, name='old', evr='1-1',
+            arch='noarch', nevra='old-1-1.noarch')]
+        paths = _rpms(db, 'bash')
+        prepared_upgrade.save(db, 'k', actions, paths)
+        assert prepared_upgrade.load(db, 'k').ready_rpms() == [str(paths[0])]
+
+    def test_rpm_modified(self, db):
+        paths = _rpms(db, 'bash')
+        prepared_upgrade.save(db, 'k', _actions('bash'), paths)
+        paths[0].write_bytes(b'tampered')
+        assert prepared_upgrade.load(db, 'k').ready_rpms() is None
+
+    def test_rpm_touched(self, db):
+        paths = _rpms(db, 'bash')
+        prepared_upgrade.save(db, 'k', _actions('bash'), paths)
+        later = time.time() + 10
+        os.utime(paths[0], (later, later))
+        assert prepared_upgrade.load(db, 'k').ready_rpms() is None
+
+    def test_rpm_deleted(self, db):
+        paths = _rpms(db, 'bash')
+        prepared_upgrade.save(db, 'k', _actions('bash'), paths)
+        paths[0].unlink()
+        assert prepared_upgrade.load(db, 'k').ready_rpms() is None
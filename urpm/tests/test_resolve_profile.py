@@ -0,0 +1,181 @@
+"""Tests for the per-phase resolver profile"""
+
+import itertools
+
+import pytest
+
+from urpm.core import resolver as resolver_module
+from urpm.core.resolution import profile as profile_module
+from urpm.core.resolution.profile import ResolveProfile, phased
+
+
+@pytest.fixture
+def clock(monkeypatch):
+    """Every sample advances wall and CPU by 1 s and blocks/RSS by 10."""
+    ticks = itertools.count()
+
+    def sample():
+        t = next(ticks)
+        return (float(t), t / 2, t * 10, t * 10)
+
+    monkeypatch.setattr(profile_module, '_sample', sample)
+
+
+class _Resolver:
+    """Stand-in carrying a profile, as Resolver does."""
+
+    def __init__(self, profile):
+        self.profile = profile
+
+    @phased('other')
+    def resolve(self):
+        self.create_pool()
+        self.profile.mark('solve')
+        self.profile.mark(None)
+
+    @phased('pool')
+    def create_pool(self):
+        pass
+
+
+class TestResolveProfile:
+    """Phases are charged their own time and add up to the total."""
+
+    def test_nested_phases_are_exclusive(self, clock):
+        profile = ResolveProfile()
+        with profile.phase('pool'):
+            with profile.phase('rpmdb'):
+                pass
+
+        report = profile.to_dict()
+        assert report['phases']['pool'] == {
+            'calls': 1, 'wall_ms': 2000.0, 'cpu_ms': 1000.0,
+            'alloc_blocks': 20, 'rss_kb': 20}
+        assert report['phases']['rpmdb']['wall_ms'] == 1000.0
+        assert report['total']['wall_ms'] == 3000.0
+
+    def test_mark_relabels_until_phase_ends(self, clock):
+        profile = ResolveProfile()
+        with profile.phase('other'):
+            profile.mark('jobs')
+            profile.mark('solve')
+        with profile.phase('other'):
+            pass
+
+        phases = profile.to_dict()['phases']
+        assert list(phases) == ['jobs', 'solve', 'other']
+        assert phases['jobs']['wall_ms'] == 1000.0
+        assert phases['solve']['wall_ms'] == 1000.0
+        assert (phases['other']['calls'], phases['other']['wall_ms']) == (2, 2000.0)
+
+    def test_mark_none_returns_to_phase(self, clock):
+        profile = ResolveProfile()
+        _Resolver(profile).resolve()
+
+        phases = profile.to_dict()['phases']
+        assert list(phases) == ['pool', 'solve', 'other']
+        assert phases['solve'] == {'calls': 1, 'wall_ms': 1000.0, 'cpu_ms': 500.0,
+                                   'alloc_blocks': 10, 'rss_kb': 10}
+        # Before create_pool, between it and the mark, and after mark(None)
+        assert phases['other']['wall_ms'] == 3000.0
+
+    def test_mark_outside_phase_is_ignored(self, clock):
+        profile = ResolveProfile()
+        profile.mark('jobs')
+        assert profile.to_dict()['phases'] == {}
+
+    def test_counts_and_format(self, clock):
+        profile = ResolveProfile()
+        with profile.phase('solve'):
+            profile.count(solvables=10, jobs=2)
+
+        lines = profile.format()
+        assert lines[0].split() == ['phase', 'calls', 'wall', 'ms', 'cpu', 'ms',
+                                    'blocks', 'rss', 'KiB']
+        assert lines[1].split() == ['solve', '1', '1000.0', '500.0', '10', '10']
+        assert lines[2].split() == ['total', '1000.0', '500.0', '10', '10']
+        assert lines[3] == 'solvables=10, jobs=2'
+
+    def test_no_profile_is_noop(self):
+        resolver = _Resolver(None)
+        assert resolver.create_pool() is None
+
+    def test_real_sample(self):
+        profile = ResolveProfile()
+        with profile.phase('pool'):
+            blocks = [object() for _ in range(1000)]
+        stats = profile.to_dict()['phases']['pool']
+        assert stats['wall_ms'] >= 0 and stats['cpu_ms'] >= 0
+        assert stats['alloc_blocks'] > 0
+        del blocks
+
+
+class TestSolverDebug:
+    """The CLI profile survives the --debug setup of each command."""
+
+    @pytest.fixture(autouse=True)
+    def reset(self, monkeypatch):
+        monkeypatch.setattr(resolver_module, '_solver_debug',
+                            resolver_module.SolverDebug())
+        monkeypatch.setattr(resolver_module, 'DEBUG_RESOLVER',
+                            resolver_module.DEBUG_RESOLVER)
+
+    def test_profile_kept_across_reconfiguration(self):
+        resolver_module.set_solver_debug(profile=True)
+        profile = resolver_module.get_solver_debug().profile
+        assert profile is not None
+
+        resolver_module.set_solver_debug(enabled=True, timing=True)
+        assert resolver_module.get_solver_debug().profile is profile
+
+    def test_resolver_uses_global_profile(self):
+        resolver_module.set_solver_debug(profile=True)
+        resolver = resolver_module.Resolver(None, allowed_arches=['x86_64'])
+        assert resolver.profile is resolver_module.get_solver_debug().profile
+
+        own = ResolveProfile()
+        assert resolver_module.Resolver(None, allowed_arches=['x86_64'],
+                                        profile=own).profile is own
+
+    def test_log_profile(self, capsys):
+        resolver_module.set_solver_debug(profile=True)
+        debug = resolver_module.get_solver_debug()
+        with debug.profile.phase('solve'):
+            pass
+        debug.log_profile()
+        err = capsys.readouterr().err.splitlines()
+        assert err[0].startswith('[PROFILE] phase')
+        assert err[1].startswith('[PROFILE] solve')
+
+
+class TestScenarios:
+    """The benchmark scenarios resolve, with every phase recorded."""
+
+    @pytest.fixture(autouse=True)
+    def real_solv(self):
+        solv = pytest.importorskip('solv')
+        if not hasattr(solv, 'Solver'):
+            pytest.skip('libsolv bindings not available')
+
+    @pytest.mark.parametrize('name', ['full-upgrade', 'soname-bump', 'release-upgrade'])
+    def test_upgrade(self, name):
+        from urpm.tests.resolve_scenarios import SCENARIOS
+
+        profile = ResolveProfile()
+        result = SCENARIOS[name].run(scale=0.05, profile=profile)
+
+        assert result.success, result.problems
+        assert result.actions
+        report = profile.to_dict()
+        assert {'pool', 'rpmdb', 'jobs', 'solve', 'order', 'other'} <= set(report['phases'])
+        assert report['counts']['actions'] == len(result.actions)
+        assert report['counts']['installed'] > 0
+
+    def test_alternatives(self):
+        from urpm.tests.resolve_scenarios import SCENARIOS
+
+        profile = ResolveProfile()
+        result = SCENARIOS['install-alternatives'].run(scale=0.05, profile=profile)
+
+        assert result.alternatives
+        assert 'alternatives' in profile.to_dict()['phases']
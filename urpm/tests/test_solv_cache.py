@@ -0,0 +1,181 @@
+"""Tests for the resolver's .solv repo caches (urpm.core.resolution.pool)."""
+
+import gzip
+import os
+
+import pytest
+
+solv = pytest.importorskip('solv')
+
+from urpm.core.resolution import pool as pool_mod
+from urpm.core.resolution.pool import (
+    add_rpmdb_cached, add_synthesis, load_synthesis_cached, rpmdb_solv_key,
+    synthesis_solv_path, write_synthesis_solv,
+)
+
+
+SYNTHESIS = (
+    "@provides@bash[== 5.2-1.mga10]\n"
+    "@summary@The GNU Bourne Again shell\n"
+    "@info@bash-5.2-1.mga10.x86_64@0@4000000@Shells\n"
+    "@provides@vim[== 9.1-1.mga10]\n"
+    "@requires@bash\n"
+    "@summary@Vi IMproved\n"
+    "@info@vim-9.1-1.mga10.x86_64@0@3000000@Editors\n"
+)
+
+
+@pytest.fixture
+def synthesis(tmp_path):
+    path = tmp_path / "synthesis.hdlist.cz"
+    with gzip.open(path, 'wb') as fh:
+        fh.write(SYNTHESIS.encode())
+    return path
+
+
+def _repo():
+    pool = solv.Pool()
+    pool.setdisttype(solv.Pool.DISTTYPE_RPM)
+    return pool.add_repo("Core Release")
+
+
+def _names(repo):
+    return sorted(s.name for s in repo.solvables)
+
+
+class TestSynthesisSolvCache:
+    def test_built_then_reused(self, synthesis):
+        md5 = 'a' * 32
+        first = _repo()
+        assert load_synthesis_cached(first, synthesis, md5) is False
+        assert synthesis_solv_path(synthesis, md5).exists()
+
+        second = _repo()
+        assert load_synthesis_cached(second, synthesis, md5) is True
+        assert _names(second) == _names(first) == ['bash', 'vim']
+
+    def test_new_md5_replaces_cache(self, synthesis):
+        load_synthesis_cached(_repo(), synthesis, 'a' * 32)
+        assert load_synthesis_cached(_repo(), synthesis, 'b' * 32) is False
+        assert [p.name for p in synthesis.parent.glob('*.solv')] == [
+            synthesis_solv_path(synthesis, 'b' * 32).name,
+        ]
+
+    def test_corrupt_cache_falls_back(self, synthesis):
+        synthesis_solv_path(synthesis, None).write_bytes(b'garbage')
+        repo = _repo()
+        assert load_synthesis_cached(repo, synthesis, None) is False
+        assert _names(repo) == ['bash', 'vim']
+        # Rewritten with valid content
+        assert load_synthesis_cached(_repo(), synthesis, None) is True
+
+    def test_prebuilt_at_sync(self, synthesis):
+        write_synthesis_solv(synthesis, 'c' * 32)
+        assert load_synthesis_cached(_repo(), synthesis, 'c' * 32) is True
+
+
+class _RpmdbRepo:
+    """Repo whose rpmdb loaders read a synthesis instead of the rpmdb."""
+
+    def __init__(self, synthesis):
+        self.repo = _repo()
+        self.synthesis = synthesis
+        self.calls = []
+
+    def add_rpmdb(self):
+        self.calls.append('add_rpmdb')
+        add_synthesis(self.repo, self.synthesis)
+
+    def add_rpmdb_reffp(self, ref):
+        self.calls.append('add_rpmdb_reffp')
+        add_synthesis(self.repo, self.synthesis)
+
+    def __getattr__(self, name):
+        return getattr(self.repo, name)
+
+
+class TestRpmdbSolvCache:
+    @pytest.fixture
+    def cache_dir(self, tmp_path):
+        path = tmp_path / "cache"
+        path.mkdir()
+        return path
+
+    def _key(self, monkeypatch, key):
+        monkeypatch.setattr(pool_mod, 'rpmdb_solv_key', lambda: key)
+
+    def test_built_then_reused(self, synthesis, cache_dir, monkeypatch):
+        self._key(monkeypatch, 'a1')
+        first = _RpmdbRepo(synthesis)
+        assert add_rpmdb_cached(first, cache_dir) is False
+        assert first.calls == ['add_rpmdb']
+        assert (cache_dir / "rpmdb-a1.solv").exists()
+
+        second = _RpmdbRepo(synthesis)
+        assert add_rpmdb_cached(second, cache_dir) is True
+        assert second.calls == []
+        assert _names(second) == _names(first) == ['bash', 'vim']
+
+    def test_stale_key_uses_previous_as_reference(self, synthesis, cache_dir,
+                                                  monkeypatch):
+        self._key(monkeypatch, 'a1')
+        add_rpmdb_cached(_RpmdbRepo(synthesis), cache_dir)
+
+        self._key(monkeypatch, 'b2')
+        repo = _RpmdbRepo(synthesis)
+        assert add_rpmdb_cached(repo, cache_dir) is False
+        assert repo.calls == ['add_rpmdb_reffp']
+        assert sorted(p.name for p in cache_dir.iterdir()) == ['rpmdb-b2.solv']
+
+    def test_unknown_key_not_cached(self, synthesis, cache_dir, monkeypatch):
+        self._key(monkeypatch, None)
+        repo = _RpmdbRepo(synthesis)
+        assert add_rpmdb_cached(repo, cache_dir) is False
+        assert repo.calls == ['add_rpmdb']
+        assert list(cache_dir.iterdir()) == []
+
+    @pytest.mark.skipif(os.geteuid() == 0, reason="root ignores permissions")
+    def test_read_only_dir(self, synthesis, cache_dir, monkeypatch):
+        self._key(monkeypatch, 'a1')
+        cache_dir.chmod(0o555)
+        try:
+            repo = _RpmdbRepo(synthesis)
+            assert add_rpmdb_cached(repo, cache_dir) is False
+            assert _names(repo) == ['bash', 'vim']
+            assert list(cache_dir.iterdir()) == []
+        finally:
+            cache_dir.chmod(0o755)
+
+    def test_cache_readable_by_others(self, synthesis, cache_dir, monkeypatch):
+        self._key(monkeypatch, 'a1')
+        add_rpmdb_cached(_RpmdbRepo(synthesis), cache_dir)
+        assert (cache_dir / "rpmdb-a1.solv").stat().st_mode & 0o777 == 0o644
+
+
+class TestRpmdbSolvKey:
+    @pytest.fixture
+    def dbpath(self, tmp_path, monkeypatch):
+        path = tmp_path / "rpm"
+        path.mkdir()
+        monkeypatch.setattr(pool_mod, 'HAS_RPM', False)
+        monkeypatch.setattr(pool_mod, 'DEFAULT_RPMDB_DIR', str(path))
+        return path
+
+    def _touch(self, path, mtime_ns):
+        path.write_bytes(b'')
+        os.utime(path, ns=(mtime_ns, mtime_ns))
+
+    def test_newest_file(self, dbpath):
+        self._touch(dbpath / "rpmdb.sqlite", 0x1000)
+        self._touch(dbpath / "rpmdb.sqlite-wal", 0x2000)
+        assert rpmdb_solv_key() == '2000'
+
+    def test_shm_ignored(self, dbpath):
+        self._touch(dbpath / "rpmdb.sqlite", 0x1000)
+        self._touch(dbpath / "rpmdb.sqlite-shm", 0x9000)
+        assert rpmdb_solv_key() == '1000'
+
+    def test_missing_or_empty(self, dbpath):
+        assert rpmdb_solv_key() is None
+        dbpath.rmdir()
+        assert rpmdb_solv_key() is None
@@ -1,7 +1,13 @@
 """Tests for synthesis parser"""
 
+import gzip
+import shutil
+import subprocess
+
 import pytest
-from urpm.core.synthesis import parse_nevra, parse_dependency
+from urpm.core.synthesis import (
+    _split_synthesis_line, parse_dependency, parse_nevra, parse_synthesis,
+)
 
 
 class TestParseNevra:
@@ -57,3 +63,76 @@ class TestParseDependency:
         assert name == "python"
         assert op == "=="
         assert ver == "3.11"
+
+
+class TestSplitSynthesisLine:
+    """Tests for @-splitting of synthesis lines."""
+
+    def test_plain_line(self):
+        assert _split_synthesis_line("@summary@A shell") == ['', 'summary', 'A shell']
+
+    def test_at_inside_parentheses_kept(self):
+        parts = _split_synthesis_line(
+            "@provides@bundled(npm(@xterm/addon-canvas))@libc.so.6()(64bit)")
+        assert parts == ['', 'provides', 'bundled(npm(@xterm/addon-canvas))',
+                         'libc.so.6()(64bit)']
+
+    def test_empty_fields(self):
+        assert _split_synthesis_line("@provides@@foo@") == ['', 'provides', '', 'foo']
+        assert _split_synthesis_line("") == []
+
+    def test_unbalanced_close_stops_splitting(self):
+        assert _split_synthesis_line("@a)@b@c") == ['', 'a)@b@c']
+
+
+class TestParseSynthesis:
+    """Tests for whole-file synthesis parsing."""
+
+    def test_tags_attach_to_next_info(self, tmp_path):
+        path = tmp_path / "synthesis.hdlist.cz"
+        with gzip.open(path, 'wb') as fh:
+            fh.write(b"@provides@bash[== 5.2-1.mga10]@sh\n"
+                     b"@requires@libc.so.6()(64bit)\n"
+                     b"@summary@The GNU Bourne Again shell\n"
+                     b"@filesize@1500000\n"
+                     b"@info@bash-5.2-1.mga10.x86_64@0@4000000@Shells\n"
+                     b"@summary@Vi IMproved\n"
+                     b"@info@vim-9.1-1.mga10.x86_64@1@3000000@Editors\n")
+        bash, vim = parse_synthesis(path)
+        assert bash['provides'] == ['bash[== 5.2-1.mga10]', 'sh']
+        assert bash['requires'] == ['libc.so.6()(64bit)']
+        assert bash['filesize'] == 1500000
+        assert bash['size'] == 4000000
+        assert vim['provides'] == [] and vim['epoch'] == 1
+        assert vim['summary'] == 'Vi IMproved'
+
+
+class TestStreamingDecompression:
+    """zstd synthesis is decompressed incrementally, not into memory."""
+
+    @pytest.fixture
+    def zstd_synthesis(self, tmp_path):
+        if not shutil.which('zstd'):
+            pytest.skip("zstd not installed")
+        plain = tmp_path / "synthesis.hdlist"
+        plain.write_bytes(b"".join(
+            b"@summary@Package %d\n@info@pkg%d-1.0-1.mga10.x86_64@0@1000@Misc\n"
+            % (i, i) for i in range(5000)))
+        path = tmp_path / "synthesis.hdlist.cz"
+        subprocess.run(['zstd', '-q', str(plain), '-o', str(path)], check=True)
+        return path
+
+    def test_zstd_synthesis(self, zstd_synthesis):
+        names = [p['name'] for p in parse_synthesis(zstd_synthesis)]
+        assert len(names) == 5000
+        assert names[0] == 'pkg0' and names[-1] == 'pkg4999'
+
+    def test_early_close(self, zstd_synthesis):
+        from urpm.core.compression import decompress_stream
+        with decompress_stream(zstd_synthesis) as stream:
+            assert stream.readline() == b"@summary@Package 0\n"
+        assert stream.closed
+        # Abandoning the generator releases the decompressor as well
+        packages = parse_synthesis(zstd_synthesis)
+        assert next(packages)['name'] == 'pkg0'
+        packages.close()